@@ -6,6 +6,7 @@
 #include <a0/inline.h>
 
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -36,6 +37,66 @@ a0_err_t a0_dealloc(a0_alloc_t alloc, a0_buf_t buf) {
   return A0_OK;
 }
 
+// Ready-made allocators.
+//
+// Each one serves requests out of memory reserved at init, and falls back to
+// malloc when a request doesn't fit. Once the number of buffers in flight
+// settles, reads make no heap allocations.
+//
+// The allocators don't grow. Buffers from the fallback are freed on dealloc.
+
+/// A pool of fixed-size blocks.
+///
+/// Thread-safe. Blocks may be released in any order, from any thread.
+typedef struct a0_alloc_pool_s {
+  uint8_t* _slab;
+  size_t _block_size;
+  size_t _num_blocks;
+  // Free list links, by block index.
+  uint32_t* _next;
+  // Tag in the upper half, index + 1 of the first free block in the lower.
+  uint64_t _free;
+} a0_alloc_pool_t;
+
+/// Requests larger than block_size are served by malloc.
+a0_err_t a0_alloc_pool_init(a0_alloc_pool_t*, size_t block_size, size_t num_blocks);
+/// Fails with EBUSY while blocks are in use.
+a0_err_t a0_alloc_pool_close(a0_alloc_pool_t*);
+a0_err_t a0_alloc_pool_allocator(a0_alloc_pool_t*, a0_alloc_t* out);
+
+/// A ring buffer, for buffers released in the order they were allocated.
+///
+/// Lock-free, with one thread allocating and releases ordered among
+/// themselves. A reader with an executor releases this way.
+typedef struct a0_alloc_ring_s {
+  uint8_t* _buf;
+  size_t _size;
+  // Bytes ever allocated, and ever released.
+  uint64_t _head;
+  uint64_t _tail;
+} a0_alloc_ring_t;
+
+a0_err_t a0_alloc_ring_init(a0_alloc_ring_t*, size_t size);
+/// Fails with EBUSY while buffers are in use.
+a0_err_t a0_alloc_ring_close(a0_alloc_ring_t*);
+a0_err_t a0_alloc_ring_allocator(a0_alloc_ring_t*, a0_alloc_t* out);
+
+/// A bump arena, rewound whenever every buffer has been released.
+///
+/// Not thread-safe. Each thread keeps its own, for buffers that don't outlive
+/// a short scope, like a callback of a reader without an executor.
+typedef struct a0_alloc_bump_s {
+  uint8_t* _buf;
+  size_t _size;
+  size_t _off;
+  size_t _live;
+} a0_alloc_bump_t;
+
+a0_err_t a0_alloc_bump_init(a0_alloc_bump_t*, size_t size);
+/// Fails with EBUSY while buffers are in use.
+a0_err_t a0_alloc_bump_close(a0_alloc_bump_t*);
+a0_err_t a0_alloc_bump_allocator(a0_alloc_bump_t*, a0_alloc_t* out);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,95 @@
+/**
+ * \file cursor.h
+ * \rst
+ *
+ * A cursor is a named position on a topic, kept in shared memory alongside
+ * it. It holds the sequence number of the last packet its consumer finished
+ * with, so a consumer that restarts can resume where it left off.
+ *
+ * A topic's cursors live together in a small table, in a file of their own.
+ * Opening a cursor claims a slot in the table, under the table lock.
+ * Committing and loading a position are single atomic operations, with no
+ * lock.
+ *
+ * Readers can commit to a cursor as they go. See the **cursor** reader option.
+ *
+ * Anyone with the table open can list every cursor, to see how far behind
+ * each consumer is.
+ *
+ * \endrst
+ */
+
+#ifndef A0_CURSOR_H
+#define A0_CURSOR_H
+
+#include <a0/err.h>
+#include <a0/file.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \addtogroup CURSOR
+ *  @{
+ */
+
+/// Number of cursors a table can hold.
+#define A0_CURSOR_MAX 32
+/// Longest cursor name, including the terminating null.
+#define A0_CURSOR_NAME_MAX 48
+
+typedef struct a0_cursor_topic_s {
+  const char* name;
+} a0_cursor_topic_t;
+
+typedef struct a0_cursor_table_s {
+  a0_file_t _file;
+} a0_cursor_table_t;
+
+/// A committed position. Points into the table, which must outlive it.
+typedef struct a0_cursor_s {
+  uint64_t* _seq;
+} a0_cursor_t;
+
+/// A cursor, as listed by a0_cursor_table_list.
+typedef struct a0_cursor_info_s {
+  char name[A0_CURSOR_NAME_MAX];
+  /// Sequence number last committed. Zero if never committed.
+  uint64_t seq;
+} a0_cursor_info_t;
+
+/// Opens the cursor table of the topic, creating it if needed.
+a0_err_t a0_cursor_table_init(a0_cursor_table_t*, a0_cursor_topic_t);
+a0_err_t a0_cursor_table_close(a0_cursor_table_t*);
+
+/// Opens the cursor with the given name, claiming a slot if it doesn't exist.
+///
+/// Fails with A0_ERR_INVALID_ARG if the name is empty or too long, and with
+/// ENOSPC if every slot is taken.
+a0_err_t a0_cursor_open(a0_cursor_table_t*, const char* name, a0_cursor_t* out);
+
+/// Frees the slot of the cursor with the given name.
+///
+/// Fails with A0_ERR_NOT_FOUND if there is none. Cursors opened on it must not
+/// be used after.
+a0_err_t a0_cursor_remove(a0_cursor_table_t*, const char* name);
+
+/// Lists every cursor in the table.
+a0_err_t a0_cursor_table_list(a0_cursor_table_t*, a0_cursor_info_t out[A0_CURSOR_MAX], size_t* out_cnt);
+
+/// Records the sequence number of the last packet processed. Lock-free.
+a0_err_t a0_cursor_commit(a0_cursor_t, uint64_t seq);
+
+/// Reads the sequence number last committed. Zero if never committed. Lock-free.
+a0_err_t a0_cursor_load(a0_cursor_t, uint64_t* seq);
+
+/** @}*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // A0_CURSOR_H
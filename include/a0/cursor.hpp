@@ -0,0 +1,44 @@
+#pragma once
+
+#include <a0/c_wrap.hpp>
+#include <a0/cursor.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace a0 {
+
+struct CursorTopic {
+  std::string name;
+
+  CursorTopic() = default;
+
+  CursorTopic(const char* name)  // NOLINT(google-explicit-constructor)
+      : CursorTopic(std::string(name)) {}
+
+  CursorTopic(std::string name)  // NOLINT(google-explicit-constructor)
+      : name{std::move(name)} {}
+};
+
+/// A committed position. See a0_cursor_t.
+///
+/// Keeps its table open.
+struct Cursor : details::CppWrap<a0_cursor_t> {
+  void commit(uint64_t seq);
+  /// Zero if never committed.
+  uint64_t load();
+};
+
+/// The cursors of a topic. See cursor.h.
+struct CursorTable : details::CppWrap<a0_cursor_table_t> {
+  CursorTable() = default;
+  explicit CursorTable(CursorTopic);
+
+  Cursor open(const std::string& name);
+  void remove(const std::string& name);
+  /// Position of every cursor, by name.
+  std::map<std::string, uint64_t> list();
+};
+
+}  // namespace a0
@@ -0,0 +1,100 @@
+/**
+ * \file executor.h
+ * \rst
+ *
+ * A pool of worker threads that callbacks are posted to.
+ *
+ * Work is posted to a **strand**. Tasks on one strand run one at a time, in the
+ * order they were posted. Different strands run in parallel.
+ *
+ * Each worker keeps a queue of strands with pending tasks. Idle workers steal
+ * strands from busy ones. A strand with many pending tasks yields its worker
+ * after a burst, so one busy strand can't starve the others.
+ *
+ * Readers take an executor through their options. See reader.h.
+ *
+ * \endrst
+ */
+
+#ifndef A0_EXECUTOR_H
+#define A0_EXECUTOR_H
+
+#include <a0/callback.h>
+#include <a0/err.h>
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct a0_executor_worker_s a0_executor_worker_t;
+
+typedef struct a0_executor_s {
+  a0_executor_worker_t* _workers;
+  size_t _num_workers;
+  // Round-robin target for posts from outside the pool.
+  size_t _next_worker;
+  // Strands waiting in worker queues.
+  uint32_t _pending;
+  size_t _strand_cnt;
+
+  pthread_mutex_t _mu;
+  pthread_cond_t _cnd;
+  uint32_t _idle_cnt;
+  bool _shutdown;
+} a0_executor_t;
+
+/// Starts the worker threads. Zero uses one per online CPU.
+a0_err_t a0_executor_init(a0_executor_t*, size_t num_threads);
+
+/// Runs the remaining tasks, then stops the worker threads.
+///
+/// Fails with EBUSY while strands are open. May not be called from a worker.
+a0_err_t a0_executor_close(a0_executor_t*);
+
+/// A unit of work. The executor doesn't own the task.
+///
+/// The task is unlinked before the callback runs, so the callback may free it.
+typedef struct a0_executor_task_s {
+  a0_callback_t callback;
+  struct a0_executor_task_s* _next;
+} a0_executor_task_t;
+
+/// An ordered queue of tasks, run on the executor.
+typedef struct a0_executor_strand_s {
+  a0_executor_t* _executor;
+  pthread_mutex_t _mu;
+  pthread_cond_t _cnd;
+  a0_executor_task_t* _head;
+  a0_executor_task_t* _tail;
+  // Queued in, or held by, a worker.
+  bool _scheduled;
+  // Thread running a task of this strand, if any.
+  uint32_t _runner;
+} a0_executor_strand_t;
+
+a0_err_t a0_executor_strand_init(a0_executor_strand_t*, a0_executor_t*);
+
+/// Waits for posted tasks to finish.
+///
+/// Fails with EDEADLK if called from one of the strand's own tasks.
+a0_err_t a0_executor_strand_close(a0_executor_strand_t*);
+
+/// Whether the calling thread is running one of the strand's tasks.
+bool a0_executor_strand_in_task(a0_executor_strand_t*);
+
+/// Queues the task. It must remain valid until its callback runs.
+a0_err_t a0_executor_post_task(a0_executor_strand_t*, a0_executor_task_t*);
+
+/// Queues the callback, in a task allocated by the executor.
+a0_err_t a0_executor_post(a0_executor_strand_t*, a0_callback_t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // A0_EXECUTOR_H
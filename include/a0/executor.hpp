@@ -0,0 +1,19 @@
+#pragma once
+
+#include <a0/c_wrap.hpp>
+#include <a0/executor.h>
+
+#include <cstddef>
+
+namespace a0 {
+
+/// A pool of worker threads that reader callbacks run on. See a0_executor_t.
+///
+/// Readers hold a reference to their executor.
+struct Executor : details::CppWrap<a0_executor_t> {
+  Executor() = default;
+  /// Zero uses one thread per online CPU.
+  explicit Executor(size_t num_threads);
+};
+
+}  // namespace a0
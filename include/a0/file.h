@@ -36,6 +36,45 @@
  *
  * **create_options** can also be used to set **mode**.
  *
+ * Huge Pages
+ * ----------
+ *
+ * Large arenas span many pages, and readers scanning them can thrash the TLB.
+ *
+ * Set **open_options.huge_pages** to request transparent huge pages for the
+ * mapping. This requires shmem huge pages to be enabled, for example
+ * **\/sys/kernel/mm/transparent_hugepage/shmem_enabled** set to **advise**.
+ * If they are unavailable, the file is mapped with normal pages.
+ *
+ * Files created on a hugetlbfs mount, for example by pointing **A0_ROOT** at
+ * one, always use huge pages. Their size is rounded up to a multiple of the
+ * huge page size.
+ *
+ * Residency
+ * ---------
+ *
+ * The first touch of each page in the arena takes a page fault. Real-time
+ * processes can make the arena resident before the first publish:
+ *
+ * * **populate**: map with MAP_POPULATE.
+ * * **prefault**: touch every page of the arena after mapping.
+ * * **mlock**: lock the mapping into memory, either immediately or as pages
+ *   are faulted in.
+ *
+ * Locking may fail if it exceeds RLIMIT_MEMLOCK, in which case the open fails.
+ *
+ * Growth
+ * ------
+ *
+ * A file can start small and grow under load. Set **open_options.max_size** to
+ * map more address space than the file currently uses, then call
+ * a0_file_grow to extend the file in place. Processes that mapped enough see
+ * the new space without remapping.
+ *
+ * Transports check the arena size against their mapping whenever they lock.
+ * A connection whose mapping is too small maps the file again, larger. The
+ * smaller mappings stay valid until the file is closed.
+ *
  * Usage
  * -----
  *
@@ -108,6 +147,16 @@ typedef struct a0_file_create_options_s {
   mode_t dir_mode;
 } a0_file_create_options_t;
 
+/// How to lock the mapping into memory.
+typedef enum a0_file_mlock_e {
+  /// Do not lock.
+  A0_FILE_MLOCK_NONE,
+  /// Fault in and lock the whole mapping on open.
+  A0_FILE_MLOCK_NOW,
+  /// Lock pages as they are faulted in. Uses MLOCK_ONFAULT.
+  A0_FILE_MLOCK_ONFAULT,
+} a0_file_mlock_t;
+
 /// Options for opening files.
 typedef struct a0_file_open_options_s {
   /// If SHARED or EXCLUSIVE, mmaps with MAP_SHARED.
@@ -122,6 +171,22 @@ typedef struct a0_file_open_options_s {
   /// It is unspecified whether changes made to the file are visible in
   /// the mapped region.
   a0_arena_mode_t arena_mode;
+  /// Request transparent huge pages for the mapping, with madvise(MADV_HUGEPAGE).
+  ///
+  /// Ignored if huge pages are unavailable.
+  bool huge_pages;
+  /// Map with MAP_POPULATE, reading the file into memory ahead of use.
+  bool populate;
+  /// Touch every page of the mapping after opening.
+  bool prefault;
+  /// Lock the mapping into memory.
+  a0_file_mlock_t mlock;
+  /// Size to map, if larger than the file. Lets the file grow in place,
+  /// with a0_file_grow, up to this size.
+  ///
+  /// Other processes need not map as much. Their transports remap when
+  /// they find the arena has grown.
+  off_t max_size;
 } a0_file_open_options_t;
 
 /// File options.
@@ -149,6 +214,9 @@ typedef struct a0_file_s {
   stat_t stat;
   /// Arena mapping into the file.
   a0_arena_t arena;
+
+  // Size of the mapping. May extend past the end of the file.
+  size_t _map_size;
 } a0_file_t;
 
 /// Open a file at the given path.
@@ -166,6 +234,14 @@ a0_err_t a0_file_open(
 /// Closes a file. The file still exists.
 a0_err_t a0_file_close(a0_file_t*);
 
+/// Grows the file to at least the given size, within its mapping.
+///
+/// The arena grows in place. If another process already grew the file
+/// further, the arena picks up that size instead. Files never shrink.
+///
+/// Fails with ENOMEM if the size exceeds the mapping. See max_size.
+a0_err_t a0_file_grow(a0_file_t*, off_t size);
+
 typedef struct a0_file_iter_s {
   char _path[PATH_MAX + 1];
   size_t _path_len;
@@ -27,6 +27,16 @@ struct File : details::CppWrap<a0_file_t> {
     struct OpenOptions {
       /// ...
       a0_arena_mode_t arena_mode;
+      /// Request transparent huge pages for the mapping.
+      bool huge_pages;
+      /// Map with MAP_POPULATE.
+      bool populate;
+      /// Touch every page of the mapping after opening.
+      bool prefault;
+      /// Lock the mapping into memory.
+      a0_file_mlock_t mlock;
+      /// Size to map, if larger than the file. Lets the file grow in place.
+      off_t max_size;
     } open_options;
 
     /// Default file creation options.
@@ -56,6 +66,9 @@ struct File : details::CppWrap<a0_file_t> {
   /// File state.
   stat_t stat() const;
 
+  /// Grows the file to at least the given size, within its mapping.
+  void grow(size_t);
+
   /// Removes the specified file.
   static void remove(string_view path);
   /// Removes the specified file or directory, including all subdirectories.
@@ -41,6 +41,7 @@ extern "C" {
 #endif
 
 typedef struct a0_writer_s a0_writer_t;
+typedef struct a0_writer_reservation_s a0_writer_reservation_t;
 
 /** \addtogroup MIDDLEWARE
  *  @{
@@ -60,6 +61,10 @@ typedef struct a0_middleware_chain_node_s {
   a0_writer_t* _curr;
   a0_writer_t* _head;
   a0_transport_locked_t _tlk;
+  // Lock shared by a batch of writes. NULL outside of a0_writer_write_batch.
+  a0_transport_locked_t* _batch_tlk;
+  // Frame left uncommitted and locked. NULL outside of a0_writer_reserve.
+  a0_writer_reservation_t* _reservation;
 } a0_middleware_chain_node_t;
 
 typedef struct a0_middleware_chain_s {
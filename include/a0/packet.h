@@ -249,9 +249,27 @@ a0_err_t a0_packet_header_iterator_next_match(a0_packet_header_iterator_t*, cons
 
 /// Serializes the packet to the allocated location.
 ///
+/// A payload with NULL data and a nonzero size reserves the payload space
+/// without writing it.
+///
 /// **Note**: the header order will NOT be retained.
 a0_err_t a0_packet_serialize(a0_packet_t, a0_alloc_t, a0_flat_packet_t* out);
 
+/// Serializes the packet, reusing an earlier serialization of it.
+///
+/// prev_fpkt must be the serialization of prev_pkt, and pkt must be prev_pkt
+/// with zero or more headers blocks prepended. The prepended headers are
+/// written and everything else is copied from prev_fpkt as is. The result is
+/// identical to a0_packet_serialize(pkt, ...).
+///
+/// Returns A0_ERR_INVALID_ARG, and allocates nothing, if pkt has a different
+/// id or payload, or its headers do not lead back to prev_pkt's.
+a0_err_t a0_packet_reserialize(a0_packet_t pkt,
+                               a0_packet_t prev_pkt,
+                               a0_flat_packet_t prev_fpkt,
+                               a0_alloc_t,
+                               a0_flat_packet_t* out);
+
 /// Deserializes the flat packet into a normal packet.
 a0_err_t a0_packet_deserialize(a0_flat_packet_t, a0_alloc_t, a0_packet_t* out_pkt, a0_buf_t* out_buf);
 
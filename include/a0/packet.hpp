@@ -34,6 +34,10 @@ struct Packet : details::CppWrap<a0_packet_t> {
          string_view payload,
          tag_ref_t);
 
+  /// Wraps a C packet. The payload is not copied.
+  ///
+  /// With a deleter, the headers are not copied either, and both must stay
+  /// valid until the deleter runs. Without one, the headers are copied.
   Packet(a0_packet_t, std::function<void(a0_packet_t*)> deleter);
 
   /// Packet unique identifier.
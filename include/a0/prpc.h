@@ -9,6 +9,7 @@
 #include <a0/map.h>
 #include <a0/packet.h>
 #include <a0/reader.h>
+#include <a0/thread_attr.h>
 #include <a0/writer.h>
 
 #include <stdbool.h>
@@ -22,6 +23,13 @@ typedef struct a0_prpc_topic_s {
   const a0_file_options_t* file_opts;
 } a0_prpc_topic_t;
 
+typedef struct a0_prpc_options_s {
+  /// Attributes of the thread that reads connections, or progress.
+  a0_thread_attr_t thread_attr;
+} a0_prpc_options_t;
+
+extern const a0_prpc_options_t A0_PRPC_OPTIONS_DEFAULT;
+
 ////////////
 // Server //
 ////////////
@@ -52,6 +60,12 @@ a0_err_t a0_prpc_server_init(a0_prpc_server_t*,
                              a0_alloc_t,
                              a0_prpc_connection_callback_t onconnect,
                              a0_packet_id_callback_t oncancel);
+a0_err_t a0_prpc_server_init_options(a0_prpc_server_t*,
+                                     a0_prpc_topic_t,
+                                     a0_alloc_t,
+                                     a0_prpc_connection_callback_t onconnect,
+                                     a0_packet_id_callback_t oncancel,
+                                     a0_prpc_options_t);
 a0_err_t a0_prpc_server_close(a0_prpc_server_t*);
 // Note: do NOT respond with the request packet. The ids MUST be unique!
 a0_err_t a0_prpc_server_send(a0_prpc_connection_t, a0_packet_t, bool done);
@@ -75,6 +89,7 @@ typedef struct a0_prpc_client_s {
 } a0_prpc_client_t;
 
 a0_err_t a0_prpc_client_init(a0_prpc_client_t*, a0_prpc_topic_t, a0_alloc_t);
+a0_err_t a0_prpc_client_init_options(a0_prpc_client_t*, a0_prpc_topic_t, a0_alloc_t, a0_prpc_options_t);
 a0_err_t a0_prpc_client_close(a0_prpc_client_t*);
 a0_err_t a0_prpc_client_connect(a0_prpc_client_t*, a0_packet_t, a0_prpc_progress_callback_t);
 // Note: use the same packet that was provided to a0_prpc_connect.
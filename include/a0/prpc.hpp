@@ -6,11 +6,13 @@
 #include <a0/prpc.h>
 #include <a0/pubsub.h>
 #include <a0/reader.hpp>
+#include <a0/thread_attr.hpp>
 
 #include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <future>
+#include <utility>
 
 namespace a0 {
 
@@ -29,6 +31,11 @@ struct PrpcTopic {
       : name{std::move(name)}, file_opts{file_opts} {}
 };
 
+struct PrpcOptions {
+  /// Attributes of the reader thread.
+  ThreadAttr thread_attr;
+};
+
 struct PrpcServer;
 
 struct PrpcConnection : details::CppWrap<a0_prpc_connection_t> {
@@ -48,15 +55,23 @@ struct PrpcConnection : details::CppWrap<a0_prpc_connection_t> {
 
 struct PrpcServer : details::CppWrap<a0_prpc_server_t> {
   PrpcServer() = default;
+  PrpcServer(
+      PrpcTopic topic,
+      std::function<void(PrpcConnection)> onconnection,
+      std::function<void(string_view /* id */)> oncancel)
+      : PrpcServer(std::move(topic), PrpcOptions(), std::move(onconnection), std::move(oncancel)) {}
   PrpcServer(
       PrpcTopic,
+      PrpcOptions,
       std::function<void(PrpcConnection)> onconnection,
       std::function<void(string_view /* id */)> oncancel);
 };
 
 struct PrpcClient : details::CppWrap<a0_prpc_client_t> {
   PrpcClient() = default;
-  explicit PrpcClient(PrpcTopic);
+  explicit PrpcClient(PrpcTopic topic)
+      : PrpcClient(std::move(topic), PrpcOptions()) {}
+  PrpcClient(PrpcTopic, PrpcOptions);
 
   void connect(Packet, std::function<void(Packet, bool /* done */)>);
   void connect(std::unordered_multimap<std::string, std::string> headers,
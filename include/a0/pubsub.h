@@ -17,6 +17,9 @@ extern "C" {
 typedef struct a0_pubsub_topic_s {
   const char* name;
   const a0_file_options_t* file_opts;
+  /// Transport options used if the topic is created. Existing topics keep theirs.
+  /// NULL means A0_TRANSPORT_OPTIONS_DEFAULT.
+  const a0_transport_options_t* transport_opts;
 } a0_pubsub_topic_t;
 
 ///////////////
@@ -31,6 +34,8 @@ typedef struct a0_publisher_s {
 a0_err_t a0_publisher_init(a0_publisher_t*, a0_pubsub_topic_t);
 a0_err_t a0_publisher_close(a0_publisher_t*);
 a0_err_t a0_publisher_pub(a0_publisher_t*, a0_packet_t);
+/// Reserves a packet within the topic. See a0_writer_reserve.
+a0_err_t a0_publisher_reserve(a0_publisher_t*, a0_packet_t, size_t payload_size, a0_writer_reservation_t*);
 a0_err_t a0_publisher_writer(a0_publisher_t*, a0_writer_t**);
 
 ////////////////
@@ -54,6 +59,10 @@ a0_err_t a0_subscriber_sync_zc_can_read(a0_subscriber_sync_zc_t*, bool*);
 a0_err_t a0_subscriber_sync_zc_read(a0_subscriber_sync_zc_t*, a0_zero_copy_callback_t);
 a0_err_t a0_subscriber_sync_zc_read_blocking(a0_subscriber_sync_zc_t*, a0_zero_copy_callback_t);
 a0_err_t a0_subscriber_sync_zc_read_blocking_timeout(a0_subscriber_sync_zc_t*, a0_time_mono_t*, a0_zero_copy_callback_t);
+a0_err_t a0_subscriber_sync_zc_read_batch(a0_subscriber_sync_zc_t*, size_t max_cnt, a0_zero_copy_callback_t, size_t* out_cnt);
+a0_err_t a0_subscriber_sync_zc_read_batch_blocking(a0_subscriber_sync_zc_t*, size_t max_cnt, a0_zero_copy_callback_t, size_t* out_cnt);
+a0_err_t a0_subscriber_sync_zc_read_batch_blocking_timeout(a0_subscriber_sync_zc_t*, a0_time_mono_t*, size_t max_cnt, a0_zero_copy_callback_t, size_t* out_cnt);
+a0_err_t a0_subscriber_sync_zc_stats(a0_subscriber_sync_zc_t*, a0_reader_stats_t*);
 
 // Synchronous allocated version.
 
@@ -73,6 +82,10 @@ a0_err_t a0_subscriber_sync_can_read(a0_subscriber_sync_t*, bool*);
 a0_err_t a0_subscriber_sync_read(a0_subscriber_sync_t*, a0_packet_t*);
 a0_err_t a0_subscriber_sync_read_blocking(a0_subscriber_sync_t*, a0_packet_t*);
 a0_err_t a0_subscriber_sync_read_blocking_timeout(a0_subscriber_sync_t*, a0_time_mono_t*, a0_packet_t*);
+a0_err_t a0_subscriber_sync_read_batch(a0_subscriber_sync_t*, a0_packet_t*, size_t max_cnt, size_t* out_cnt);
+a0_err_t a0_subscriber_sync_read_batch_blocking(a0_subscriber_sync_t*, a0_packet_t*, size_t max_cnt, size_t* out_cnt);
+a0_err_t a0_subscriber_sync_read_batch_blocking_timeout(a0_subscriber_sync_t*, a0_time_mono_t*, a0_packet_t*, size_t max_cnt, size_t* out_cnt);
+a0_err_t a0_subscriber_sync_stats(a0_subscriber_sync_t*, a0_reader_stats_t*);
 
 // Threaded zero-copy version.
 
@@ -86,8 +99,18 @@ a0_err_t a0_subscriber_zc_init(a0_subscriber_zc_t*,
                                a0_reader_options_t,
                                a0_zero_copy_callback_t);
 
+/// Runs on the given multiplexer, rather than its own thread. See a0_reader_zc_init_mux.
+a0_err_t a0_subscriber_zc_init_mux(a0_subscriber_zc_t*,
+                                   a0_reader_mux_t*,
+                                   a0_pubsub_topic_t,
+                                   a0_reader_options_t,
+                                   a0_zero_copy_callback_t);
+
 a0_err_t a0_subscriber_zc_close(a0_subscriber_zc_t*);
 
+/// Snapshot of the reader's counters. See a0_reader_zc_stats.
+a0_err_t a0_subscriber_zc_stats(a0_subscriber_zc_t*, a0_reader_stats_t*);
+
 // Threaded allocated version.
 
 typedef struct a0_subscriber_s {
@@ -101,8 +124,26 @@ a0_err_t a0_subscriber_init(a0_subscriber_t*,
                             a0_reader_options_t,
                             a0_packet_callback_t);
 
+/// Runs on the given multiplexer, rather than its own thread. See a0_reader_zc_init_mux.
+a0_err_t a0_subscriber_init_mux(a0_subscriber_t*,
+                                a0_reader_mux_t*,
+                                a0_pubsub_topic_t,
+                                a0_alloc_t,
+                                a0_reader_options_t,
+                                a0_packet_callback_t);
+
+a0_err_t a0_subscriber_init_batch(a0_subscriber_t*,
+                                  a0_pubsub_topic_t,
+                                  a0_alloc_t,
+                                  a0_reader_options_t,
+                                  size_t max_cnt,
+                                  a0_packet_batch_callback_t);
+
 a0_err_t a0_subscriber_close(a0_subscriber_t*);
 
+/// Snapshot of the reader's counters. See a0_reader_zc_stats.
+a0_err_t a0_subscriber_stats(a0_subscriber_t*, a0_reader_stats_t*);
+
 #ifdef __cplusplus
 }
 #endif
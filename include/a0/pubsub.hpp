@@ -5,6 +5,7 @@
 #include <a0/packet.hpp>
 #include <a0/pubsub.h>
 #include <a0/reader.hpp>
+#include <a0/transport.hpp>
 #include <a0/writer.hpp>
 
 #include <cstddef>
@@ -15,6 +16,8 @@ namespace a0 {
 struct PubSubTopic {
   std::string name;
   File::Options file_opts{File::Options::DEFAULT};
+  /// Transport options used if the topic is created. Existing topics keep theirs.
+  Transport::Options transport_opts{Transport::Options::DEFAULT};
 
   PubSubTopic() = default;
 
@@ -39,6 +42,14 @@ struct Publisher : details::CppWrap<a0_publisher_t> {
   void pub(string_view payload) {
     pub({}, payload);
   }
+
+  /// Reserves a packet with the given headers and payload size.
+  Writer::Reservation reserve(std::unordered_multimap<std::string, std::string> headers,
+                              size_t payload_size);
+  Writer::Reservation reserve(size_t payload_size) {
+    return reserve({}, payload_size);
+  }
+
   Writer writer();
 };
 
@@ -59,6 +70,13 @@ struct SubscriberSyncZeroCopy : details::CppWrap<a0_subscriber_sync_zc_t> {
   void read(std::function<void(TransportLocked, FlatPacket)>);
   void read_blocking(std::function<void(TransportLocked, FlatPacket)>);
   void read_blocking(TimeMono, std::function<void(TransportLocked, FlatPacket)>);
+
+  /// See ReaderSyncZeroCopy::read_batch.
+  size_t read_batch(size_t max_cnt, std::function<void(TransportLocked, FlatPacket)>);
+  size_t read_batch_blocking(size_t max_cnt, std::function<void(TransportLocked, FlatPacket)>);
+  size_t read_batch_blocking(TimeMono, size_t max_cnt, std::function<void(TransportLocked, FlatPacket)>);
+
+  Reader::Stats stats();
 };
 
 struct SubscriberSync : details::CppWrap<a0_subscriber_sync_t> {
@@ -82,6 +100,13 @@ struct SubscriberSync : details::CppWrap<a0_subscriber_sync_t> {
   Packet read();
   Packet read_blocking();
   Packet read_blocking(TimeMono);
+
+  /// See ReaderSync::read_batch.
+  std::vector<Packet> read_batch(size_t max_cnt);
+  std::vector<Packet> read_batch_blocking(size_t max_cnt);
+  std::vector<Packet> read_batch_blocking(TimeMono, size_t max_cnt);
+
+  Reader::Stats stats();
 };
 
 struct SubscriberZeroCopy : details::CppWrap<a0_subscriber_zc_t> {
@@ -96,6 +121,9 @@ struct SubscriberZeroCopy : details::CppWrap<a0_subscriber_zc_t> {
       : SubscriberZeroCopy(topic, Reader::Options(iter), fn) {}
   SubscriberZeroCopy(PubSubTopic topic, Reader::Init init, Reader::Iter iter, std::function<void(TransportLocked, FlatPacket)> fn)
       : SubscriberZeroCopy(topic, Reader::Options(init, iter), fn) {}
+
+  /// May be called from any thread.
+  Reader::Stats stats();
 };
 
 struct Subscriber : details::CppWrap<a0_subscriber_t> {
@@ -111,9 +139,20 @@ struct Subscriber : details::CppWrap<a0_subscriber_t> {
   Subscriber(PubSubTopic topic, Reader::Init init, Reader::Iter iter, std::function<void(Packet)> fn)
       : Subscriber(topic, Reader::Options(init, iter), fn) {}
 
+  /// Passes up to max_cnt packets at a time. See a0_reader_init_batch.
+  Subscriber(PubSubTopic, Reader::Options, size_t max_cnt, std::function<void(std::vector<Packet>)>);
+
+  /// Runs on the given multiplexer, rather than its own thread. See a0_subscriber_init_mux.
+  Subscriber(ReaderMux, PubSubTopic, Reader::Options, std::function<void(Packet)>);
+  Subscriber(ReaderMux mux, PubSubTopic topic, std::function<void(Packet)> fn)
+      : Subscriber(mux, topic, Reader::Options(), fn) {}
+
   // Deprecated.
   Subscriber(PubSubTopic topic, a0_reader_init_t init, a0_reader_iter_t iter, std::function<void(Packet)> fn)
       : Subscriber(topic, Reader::Init(init), Reader::Iter(iter), fn) {}
+
+  /// May be called from any thread.
+  Reader::Stats stats();
 };
 
 }  // namespace a0
@@ -24,11 +24,63 @@
  * * **INIT_AWAIT_NEW** (default): Start with messages written after the creation of the reader.
  * * **INIT_MOST_RECENT**: Start with the most recently written message. Useful for state and configuration. But be careful, this can be quite old!
  * * **INIT_OLDEST**: Start with the oldest message still in available in the transport.
+ * * **INIT_AT_SEQ**: Start with the message with the given transport sequence number. If it has been evicted, start with the oldest message. If it has not been written yet, wait for it.
+ * * **INIT_AT_TIME**: Start with the first message stamped, by its a0_time_mono header, at or after the given time. If there is none yet, start with the next message written. Useful to replay the last few seconds.
  *
  * An optional **ITER** can be added to specify how to continue reading messages. After each callback:
  *
  * * **ITER_NEXT** (default): grab the sequentially next message. When you don't want to miss a thing.
  * * **ITER_NEWEST**: grab the newest available unread message. When you want to keep up with the firehose.
+ * * **ITER_LATEST_PER_KEY**: grab the newest unread message of each key, oldest first. The key is the value of the
+ *   **conflate_key** header. When a topic carries the state of many entities and you only want the current one of each.
+ *   Unread frames are scanned under the transport lock, so these readers are never optimistic.
+ *
+ * An optional **optimistic** flag makes reads lock-free. Readers snapshot the
+ * transport state, copy the packet out of the arena, and retry if a writer
+ * committed in the meantime. The transport lock is only taken to sleep when
+ * there is nothing to read.
+ *
+ * .. note::
+ *
+ *   In optimistic mode, zero-copy callbacks receive a copy of the packet and
+ *   an unlocked transport. The transport must not be used within the callback.
+ *
+ * An optional **lease** flag runs callbacks without the transport lock. The
+ * reader leases the packet's frame, so writers are only held up if they need
+ * to evict that frame, as decided by the topic's lease policy. If every lease
+ * on the topic is taken, the callback runs under the lock as usual.
+ *
+ * .. note::
+ *
+ *   With leases, zero-copy callbacks receive an unlocked transport. The
+ *   transport must not be used within the callback. Synchronous reads return
+ *   A0_ERR_EVICTED if a writer evicted the packet anyway.
+ *
+ * An optional **spin_ns** budget makes readers busy-poll for new packets before
+ * sleeping. This trades a core for lower latency.
+ *
+ * An optional **filter** on packet headers is checked against each frame in
+ * place. Frames that don't match are skipped before they are copied or
+ * deserialized, and are never seen by the callback.
+ *
+ * An optional **executor** moves callbacks of threaded readers onto a shared
+ * worker pool. The reader thread copies packets out and posts them to its own
+ * strand, so a reader's packets are still delivered in order, while different
+ * readers run in parallel. Closing the reader waits for posted packets to be
+ * delivered. See executor.h.
+ *
+ * Every reader counts the packets it delivers, and the frames it lost because
+ * writers evicted them first. On each delivery it also measures how far it is
+ * behind the writers, in frames, bytes, and time. An optional **lag**
+ * threshold calls back when the reader falls too far behind.
+ *
+ * An optional **cursor** makes the reader restartable. After each packet is
+ * delivered and its callback returns, the reader commits the packet's sequence
+ * number to the cursor. A new reader on a cursor that has been committed to
+ * resumes with the packet after, as with INIT_AT_SEQ, whatever its **init**.
+ * With an executor, the commit follows the callback on the executor. With
+ * a0_reader_init_batch, the last packet of each batch is committed once the
+ * batch callback returns. See cursor.h.
  *
  * \endrst
  */
@@ -38,14 +90,21 @@
 
 #include <a0/alloc.h>
 #include <a0/arena.h>
+#include <a0/buf.h>
 #include <a0/callback.h>
+#include <a0/cursor.h>
 #include <a0/err.h>
 #include <a0/event.h>
+#include <a0/executor.h>
 #include <a0/packet.h>
+#include <a0/thread_attr.h>
+#include <a0/time.h>
 #include <a0/transport.h>
 
 #include <pthread.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -59,6 +118,8 @@ typedef enum a0_reader_init_s {
   A0_INIT_OLDEST,
   A0_INIT_MOST_RECENT,
   A0_INIT_AWAIT_NEW,
+  A0_INIT_AT_SEQ,
+  A0_INIT_AT_TIME,
 } a0_reader_init_t;
 
 /** @}*/
@@ -70,13 +131,149 @@ typedef enum a0_reader_init_s {
 typedef enum a0_reader_iter_s {
   A0_ITER_NEXT,
   A0_ITER_NEWEST,
+  A0_ITER_LATEST_PER_KEY,
 } a0_reader_iter_t;
 
 /** @}*/
 
+/** \addtogroup READER_FILTER
+ *  @{
+ */
+
+typedef enum a0_reader_filter_op_s {
+  /// A header with the key is present.
+  A0_FILTER_KEY_EXISTS,
+  /// A header with the key has exactly the given value.
+  A0_FILTER_KEY_EQUALS,
+  /// A header with the key has a value starting with the given prefix.
+  A0_FILTER_VAL_PREFIX,
+} a0_reader_filter_op_t;
+
+typedef struct a0_reader_filter_clause_s {
+  a0_reader_filter_op_t op;
+  const char* key;
+  /// Unused with A0_FILTER_KEY_EXISTS.
+  const char* val;
+} a0_reader_filter_clause_t;
+
+/// Selects packets by header. An empty filter matches everything.
+///
+/// The clauses are not copied, and must outlive the reader.
+typedef struct a0_reader_filter_s {
+  const a0_reader_filter_clause_t* clauses;
+  size_t num_clauses;
+  /// Match if any clause matches, rather than all of them.
+  bool any;
+} a0_reader_filter_t;
+
+/** @}*/
+
+/** \addtogroup READER_STATS
+ *  @{
+ */
+
+typedef struct a0_reader_stats_s {
+  /// Packets passed to callbacks, or returned by reads.
+  uint64_t delivered;
+  /// Frames evicted before the reader got to them.
+  /// Only counted with A0_ITER_NEXT. Frames evicted before the first read are not counted.
+  /// Also counts frames an optimistic reader thread could not copy out, for lack of memory.
+  uint64_t dropped;
+  /// Frames committed after the last delivered packet, when it was delivered.
+  uint64_t lag_frames;
+  /// Arena bytes spanned by those frames.
+  uint64_t lag_bytes;
+  /// Age of the last delivered packet, from its a0_time_mono header, when
+  /// the stats were taken. Zero if the header is missing, or if the packet
+  /// was evicted before the stats were taken and no ns lag threshold is set.
+  uint64_t lag_ns;
+  /// Packets a writer evicted while a callback read them under a lease.
+  /// Anything the callback read from them may be corrupt.
+  uint64_t evicted;
+  /// Packets delivered under the lock because every lease was taken.
+  uint64_t unleased;
+} a0_reader_stats_t;
+
+typedef struct a0_reader_lag_callback_s {
+  void* user_data;
+  void (*fn)(void* user_data, a0_reader_stats_t);
+} a0_reader_lag_callback_t;
+
+/// Limits on how far a reader may fall behind. Zero disables a limit.
+typedef struct a0_reader_lag_threshold_s {
+  uint64_t frames;
+  uint64_t bytes;
+  /// Packet age is only measured on delivery if this is set.
+  uint64_t ns;
+  /// Called when a delivery first reaches any limit, before the packet is
+  /// passed on. Called again only once the lag has dropped below every limit.
+  ///
+  /// Runs on the thread that delivers packets, under the same conditions as
+  /// packet callbacks.
+  a0_reader_lag_callback_t onlag;
+} a0_reader_lag_threshold_t;
+
+// Bookkeeping behind a0_reader_stats_t.
+typedef struct a0_reader_counters_s {
+  a0_reader_stats_t stats;
+  // Sequence number of the last frame read, delivered or not.
+  uint64_t last_seq;
+  bool lagging;
+  // The last frame delivered. Its write time is looked up when stats are
+  // taken, unless a ns lag threshold needed it on delivery.
+  uint64_t delivered_seq;
+  size_t delivered_off;
+  // Write time of the last delivered packet, in ns. Zero if not yet known.
+  uint64_t written_ns;
+  // The reader's own connection. Lookups only read its arena and frame
+  // format, which don't change after init.
+  a0_transport_t* transport;
+} a0_reader_counters_t;
+
+// Frames left to deliver with A0_ITER_LATEST_PER_KEY.
+typedef struct a0_reader_conflate_s {
+  // Copy of opts.conflate_key.
+  char* key;
+  // Newest frame of each key found by the last scan, oldest first.
+  uint64_t* seqs;
+  size_t cnt;
+  size_t cap;
+  size_t idx;
+  // Newest frame the last scan looked at.
+  uint64_t end_seq;
+} a0_reader_conflate_t;
+
+/** @}*/
+
 typedef struct a0_reader_options_s {
   a0_reader_init_t init;
   a0_reader_iter_t iter;
+  /// Read without taking the transport lock. See above.
+  bool optimistic;
+  /// Sequence number to start at, with A0_INIT_AT_SEQ.
+  uint64_t seq;
+  /// Time to start at, with A0_INIT_AT_TIME.
+  a0_time_mono_t time;
+  /// Nanoseconds to busy-poll for new packets before blocking.
+  /// A0_TRANSPORT_SPIN_FOREVER never blocks.
+  int64_t spin_ns;
+  /// Lease packets and run callbacks unlocked. See above.
+  bool lease;
+  /// Skip packets that don't match. See above.
+  a0_reader_filter_t filter;
+  /// Run callbacks of a0_reader_t on this pool. See above.
+  /// Other readers ignore it.
+  a0_executor_t* executor;
+  /// Attributes of the reader thread: affinity, scheduling, stack size, and name.
+  /// Readers without a thread of their own ignore them.
+  a0_thread_attr_t thread_attr;
+  /// Call back when the reader falls behind. See above.
+  a0_reader_lag_threshold_t lag;
+  /// Header that groups packets, with A0_ITER_LATEST_PER_KEY.
+  /// Packets without it form one group. Copied by the reader.
+  const char* conflate_key;
+  /// Resume from, and commit to, this cursor. See above.
+  a0_cursor_t cursor;
 } a0_reader_options_t;
 
 extern const a0_reader_options_t A0_READER_OPTIONS_DEFAULT;
@@ -95,6 +292,9 @@ typedef struct a0_reader_sync_zc_s {
   a0_transport_t _transport;
   a0_reader_options_t _opts;
   bool _first_read_done;
+  a0_buf_t _optimistic_buf;
+  a0_reader_counters_t _counters;
+  a0_reader_conflate_t _conflate;
 } a0_reader_sync_zc_t;
 
 /// ...
@@ -117,6 +317,28 @@ a0_err_t a0_reader_sync_zc_read_blocking(a0_reader_sync_zc_t*, a0_zero_copy_call
 /// ...
 a0_err_t a0_reader_sync_zc_read_blocking_timeout(a0_reader_sync_zc_t*, a0_time_mono_t*, a0_zero_copy_callback_t);
 
+/// Reads up to max_cnt packets, under a single lock hold.
+///
+/// The callback runs once per packet. Reading stops early when no more packets
+/// are available. SIZE_MAX reads everything available.
+///
+/// out_cnt, if not NULL, is set to the number of packets read. Fails with
+/// A0_ERR_AGAIN if none are available.
+a0_err_t a0_reader_sync_zc_read_batch(a0_reader_sync_zc_t*, size_t max_cnt, a0_zero_copy_callback_t, size_t* out_cnt);
+
+/// Waits for a packet, then reads up to max_cnt packets as a0_reader_sync_zc_read_batch.
+a0_err_t a0_reader_sync_zc_read_batch_blocking(a0_reader_sync_zc_t*, size_t max_cnt, a0_zero_copy_callback_t, size_t* out_cnt);
+
+/// Waits for a packet, then reads up to max_cnt packets as a0_reader_sync_zc_read_batch.
+a0_err_t a0_reader_sync_zc_read_batch_blocking_timeout(a0_reader_sync_zc_t*,
+                                                       a0_time_mono_t*,
+                                                       size_t max_cnt,
+                                                       a0_zero_copy_callback_t,
+                                                       size_t* out_cnt);
+
+/// Snapshot of the reader's counters.
+a0_err_t a0_reader_sync_zc_stats(a0_reader_sync_zc_t*, a0_reader_stats_t*);
+
 /** @}*/
 
 /** \addtogroup READER_SYNC
@@ -149,24 +371,104 @@ a0_err_t a0_reader_sync_read_blocking(a0_reader_sync_t*, a0_packet_t*);
 /// ...
 a0_err_t a0_reader_sync_read_blocking_timeout(a0_reader_sync_t*, a0_time_mono_t*, a0_packet_t*);
 
+/// Reads up to max_cnt packets into the given array, under a single lock hold.
+///
+/// Each packet is allocated separately. See a0_reader_sync_zc_read_batch.
+a0_err_t a0_reader_sync_read_batch(a0_reader_sync_t*, a0_packet_t*, size_t max_cnt, size_t* out_cnt);
+
+/// Waits for a packet, then reads up to max_cnt packets as a0_reader_sync_read_batch.
+a0_err_t a0_reader_sync_read_batch_blocking(a0_reader_sync_t*, a0_packet_t*, size_t max_cnt, size_t* out_cnt);
+
+/// Waits for a packet, then reads up to max_cnt packets as a0_reader_sync_read_batch.
+a0_err_t a0_reader_sync_read_batch_blocking_timeout(a0_reader_sync_t*,
+                                                    a0_time_mono_t*,
+                                                    a0_packet_t*,
+                                                    size_t max_cnt,
+                                                    size_t* out_cnt);
+
+/// Snapshot of the reader's counters.
+a0_err_t a0_reader_sync_stats(a0_reader_sync_t*, a0_reader_stats_t*);
+
+/** @}*/
+
+/** \addtogroup READER_ZC
+ *  @{
+ */
+
+typedef struct a0_reader_zc_s a0_reader_zc_t;
+
+/** @}*/
+
+/** \addtogroup READER_MUX
+ *  @{
+ */
+
+/// A single thread that waits on, and runs the callbacks of, many readers.
+///
+/// Readers attached to a multiplexer don't own a thread. The thread sleeps in
+/// futex_waitv (Linux 5.16+) on up to 127 transports at once. Transports beyond
+/// that, or all of them on older kernels, are polled every millisecond.
+///
+/// Callbacks run one at a time, on the multiplexer thread. A busy reader yields
+/// to the others after a burst of packets.
+typedef struct a0_reader_mux_s {
+  pthread_mutex_t _mu;
+  a0_reader_zc_t** _readers;
+  size_t _reader_cnt;
+  size_t _reader_cap;
+  // Reader whose callback is running, if any.
+  a0_reader_zc_t* _dispatching;
+  // Threads waiting for _mu to attach or detach.
+  uint32_t _pending;
+
+  // Futex word. Changed to wake the thread.
+  uint32_t _wake;
+  bool _shutdown;
+  // Cleared if the kernel lacks futex_waitv.
+  bool _waitv;
+
+  pthread_t _thread;
+  uint32_t _thread_id;
+  a0_event_t _thread_start_event;
+} a0_reader_mux_t;
+
+/// Starts the multiplexer thread.
+a0_err_t a0_reader_mux_init(a0_reader_mux_t*);
+
+/// Stops the multiplexer thread.
+///
+/// Fails with EBUSY while readers are attached. May not be called from within a callback.
+a0_err_t a0_reader_mux_close(a0_reader_mux_t*);
+
 /** @}*/
 
 /** \addtogroup READER_ZC
  *  @{
  */
 
-typedef struct a0_reader_zc_s {
+struct a0_reader_zc_s {
   a0_transport_t _transport;
   bool _started_empty;
 
   a0_reader_options_t _opts;
 
   a0_zero_copy_callback_t _onpacket;
+  a0_buf_t _optimistic_buf;
+  a0_reader_counters_t _counters;
+  a0_reader_conflate_t _conflate;
 
   pthread_t _thread;
   uint32_t _thread_id;
   a0_event_t _thread_start_event;
-} a0_reader_zc_t;
+
+  // Set if attached to a multiplexer rather than owning a thread.
+  a0_reader_mux_t* _mux;
+  uint32_t* _mux_word;
+  uint32_t _mux_seen;
+  bool _mux_dirty;
+  bool _mux_first_done;
+  bool _mux_registered;
+};
 
 /// ...
 a0_err_t a0_reader_zc_init(a0_reader_zc_t*,
@@ -174,19 +476,53 @@ a0_err_t a0_reader_zc_init(a0_reader_zc_t*,
                            a0_reader_options_t,
                            a0_zero_copy_callback_t);
 
+/// Initializes a reader that runs on the given multiplexer, rather than its own thread.
+///
+/// The multiplexer must outlive the reader. Multiplexed readers ignore the
+/// optimistic and spin_ns options.
+a0_err_t a0_reader_zc_init_mux(a0_reader_zc_t*,
+                               a0_reader_mux_t*,
+                               a0_arena_t,
+                               a0_reader_options_t,
+                               a0_zero_copy_callback_t);
+
 /// May not be called from within a callback.
+///
+/// A multiplexed reader may be closed from the callback of another reader on
+/// the same multiplexer, but not from its own.
 a0_err_t a0_reader_zc_close(a0_reader_zc_t*);
 
+/// Snapshot of the reader's counters. May be called from any thread.
+///
+/// Each counter is read on its own, so a snapshot taken mid-delivery may mix
+/// two deliveries.
+a0_err_t a0_reader_zc_stats(a0_reader_zc_t*, a0_reader_stats_t*);
+
 /** @}*/
 
 /** \addtogroup READER
  *  @{
  */
 
+typedef struct a0_packet_batch_callback_s {
+  void* user_data;
+  void (*fn)(void* user_data, a0_packet_t*, size_t cnt);
+} a0_packet_batch_callback_t;
+
 typedef struct a0_reader_s {
   a0_reader_zc_t _reader_zc;
   a0_alloc_t _alloc;
   a0_packet_callback_t _onpacket;
+
+  a0_packet_batch_callback_t _onbatch;
+  size_t _batch_max;
+  a0_packet_t* _batch_pkts;
+  a0_buf_t* _batch_bufs;
+  size_t _batch_cnt;
+  size_t _batch_cap;
+
+  a0_executor_strand_t _strand;
+  a0_cursor_t _cursor;
 } a0_reader_t;
 
 /// ...
@@ -196,9 +532,39 @@ a0_err_t a0_reader_init(a0_reader_t*,
                         a0_reader_options_t,
                         a0_packet_callback_t);
 
+/// Initializes a reader that runs on the given multiplexer. See a0_reader_zc_init_mux.
+a0_err_t a0_reader_init_mux(a0_reader_t*,
+                            a0_reader_mux_t*,
+                            a0_arena_t,
+                            a0_alloc_t,
+                            a0_reader_options_t,
+                            a0_packet_callback_t);
+
+/// Initializes a reader that passes packets to the callback in batches.
+///
+/// Packets that are already available when the reader wakes up are collected,
+/// up to max_cnt, and passed together. The transport is unlocked once per
+/// batch rather than once per packet. Each batch has at least one packet.
+///
+/// Optimistic readers, and readers with A0_ITER_NEWEST or A0_ITER_LATEST_PER_KEY, pass one packet at a time.
+///
+/// Batches can't be posted to an executor. Fails with A0_ERR_INVALID_ARG if one is set.
+a0_err_t a0_reader_init_batch(a0_reader_t*,
+                              a0_arena_t,
+                              a0_alloc_t,
+                              a0_reader_options_t,
+                              size_t max_cnt,
+                              a0_packet_batch_callback_t);
+
 /// ...
+///
+/// With an executor, waits for posted packets to be delivered. Fails with
+/// EDEADLK if called from one of the reader's own callbacks.
 a0_err_t a0_reader_close(a0_reader_t*);
 
+/// Snapshot of the reader's counters. See a0_reader_zc_stats.
+a0_err_t a0_reader_stats(a0_reader_t*, a0_reader_stats_t*);
+
 /** @}*/
 
 /// ...
@@ -2,29 +2,115 @@
 
 #include <a0/arena.hpp>
 #include <a0/c_wrap.hpp>
+#include <a0/cursor.hpp>
+#include <a0/executor.hpp>
 #include <a0/packet.hpp>
 #include <a0/reader.h>
+#include <a0/thread_attr.hpp>
+#include <a0/time.hpp>
 #include <a0/transport.hpp>
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <memory>
+#include <string>
+#include <vector>
 
 namespace a0 {
 
+/// Runs the callbacks of many readers on one thread. See a0_reader_mux_t.
+///
+/// Readers hold a reference to their multiplexer.
+struct ReaderMux : details::CppWrap<a0_reader_mux_t> {
+  ReaderMux();
+};
+
 struct Reader : details::CppWrap<a0_reader_t> {
   enum struct Init {
     OLDEST = A0_INIT_OLDEST,
     MOST_RECENT = A0_INIT_MOST_RECENT,
     AWAIT_NEW = A0_INIT_AWAIT_NEW,
+    AT_SEQ = A0_INIT_AT_SEQ,
+    AT_TIME = A0_INIT_AT_TIME,
   };
 
   enum struct Iter {
     NEXT = A0_ITER_NEXT,
     NEWEST = A0_ITER_NEWEST,
+    LATEST_PER_KEY = A0_ITER_LATEST_PER_KEY,
+  };
+
+  /// Selects packets by header. See a0_reader_filter_t.
+  struct Filter {
+    enum struct Op {
+      KEY_EXISTS = A0_FILTER_KEY_EXISTS,
+      KEY_EQUALS = A0_FILTER_KEY_EQUALS,
+      VAL_PREFIX = A0_FILTER_VAL_PREFIX,
+    };
+
+    struct Clause {
+      Op op;
+      std::string key;
+      std::string val;
+    };
+
+    /// C view of the clauses. Shared by copies, and kept alive by readers.
+    std::shared_ptr<a0_reader_filter_t> c;
+
+    /// Matches everything.
+    Filter() = default;
+    /// Matches if all clauses match, or any of them if any is set.
+    Filter(std::vector<Clause>, bool any = false);
+
+    static Filter key_exists(std::string key);
+    static Filter key_equals(std::string key, std::string val);
+    static Filter val_prefix(std::string key, std::string prefix);
+  };
+
+  /// Reader counters. See a0_reader_stats_t.
+  using Stats = a0_reader_stats_t;
+
+  /// Limits on how far a reader may fall behind. See a0_reader_lag_threshold_t.
+  struct LagThreshold {
+    /// C view of the threshold. Shared by copies, and kept alive by readers.
+    std::shared_ptr<a0_reader_lag_threshold_t> c;
+
+    /// No limits.
+    LagThreshold() = default;
+    /// Zero disables a limit. onlag runs on the thread delivering packets.
+    LagThreshold(uint64_t frames, uint64_t bytes, uint64_t ns, std::function<void(Stats)> onlag);
   };
 
   struct Options {
     Init init;
     Iter iter;
+    /// Read without taking the transport lock.
+    bool optimistic;
+    /// Sequence number to start at, with Init::AT_SEQ.
+    uint64_t seq;
+    /// Time to start at, with Init::AT_TIME.
+    TimeMono time;
+    /// Nanoseconds to busy-poll for new packets before blocking.
+    /// A0_TRANSPORT_SPIN_FOREVER never blocks.
+    int64_t spin_ns;
+    /// Lease packets and run callbacks without the transport lock.
+    bool lease;
+    /// Skip packets that don't match, without copying them.
+    Filter filter;
+    /// Run callbacks of Reader and Subscriber on this pool.
+    /// Packets of each reader stay in order.
+    Executor executor;
+    /// Attributes of the reader thread.
+    ThreadAttr thread_attr;
+    /// Call back when the reader falls behind.
+    LagThreshold lag;
+    /// Header that groups packets, with Iter::LATEST_PER_KEY.
+    /// Empty puts every packet in one group.
+    std::string conflate_key;
+    /// Resume from, and commit to, this cursor.
+    /// The reader keeps its table open.
+    Cursor cursor;
     static Options DEFAULT;
 
     Options()
@@ -51,13 +137,27 @@ struct Reader : details::CppWrap<a0_reader_t> {
       : Reader(arena, Options(iter), fn) {}
   Reader(Arena arena, Init init, Iter iter, std::function<void(Packet)> fn)
       : Reader(arena, Options(init, iter), fn) {}
+
+  /// Passes up to max_cnt packets at a time. See a0_reader_init_batch.
+  Reader(Arena, Options, size_t max_cnt, std::function<void(std::vector<Packet>)>);
+
+  /// Runs on the given multiplexer, rather than its own thread. See a0_reader_init_mux.
+  Reader(ReaderMux, Arena, Options, std::function<void(Packet)>);
+  Reader(ReaderMux mux, Arena arena, std::function<void(Packet)> fn)
+      : Reader(mux, arena, Options(), fn) {}
+
+  /// Snapshot of the reader's counters. May be called from any thread.
+  Stats stats();
 };
 
 static const Reader::Init& INIT_OLDEST = Reader::Init::OLDEST;
 static const Reader::Init& INIT_MOST_RECENT = Reader::Init::MOST_RECENT;
 static const Reader::Init& INIT_AWAIT_NEW = Reader::Init::AWAIT_NEW;
+static const Reader::Init& INIT_AT_SEQ = Reader::Init::AT_SEQ;
+static const Reader::Init& INIT_AT_TIME = Reader::Init::AT_TIME;
 static const Reader::Iter& ITER_NEXT = Reader::Iter::NEXT;
 static const Reader::Iter& ITER_NEWEST = Reader::Iter::NEWEST;
+static const Reader::Iter& ITER_LATEST_PER_KEY = Reader::Iter::LATEST_PER_KEY;
 
 struct ReaderSyncZeroCopy : details::CppWrap<a0_reader_sync_zc_t> {
   ReaderSyncZeroCopy() = default;
@@ -76,6 +176,15 @@ struct ReaderSyncZeroCopy : details::CppWrap<a0_reader_sync_zc_t> {
   void read(std::function<void(TransportLocked, FlatPacket)>);
   void read_blocking(std::function<void(TransportLocked, FlatPacket)>);
   void read_blocking(TimeMono, std::function<void(TransportLocked, FlatPacket)>);
+
+  /// Reads up to max_cnt packets under a single lock hold.
+  /// Returns the number read, which is zero if none are available.
+  size_t read_batch(size_t max_cnt, std::function<void(TransportLocked, FlatPacket)>);
+  /// Waits for a packet, then reads up to max_cnt packets.
+  size_t read_batch_blocking(size_t max_cnt, std::function<void(TransportLocked, FlatPacket)>);
+  size_t read_batch_blocking(TimeMono, size_t max_cnt, std::function<void(TransportLocked, FlatPacket)>);
+
+  Reader::Stats stats();
 };
 
 struct ReaderSync : details::CppWrap<a0_reader_sync_t> {
@@ -95,6 +204,17 @@ struct ReaderSync : details::CppWrap<a0_reader_sync_t> {
   Packet read();
   Packet read_blocking();
   Packet read_blocking(TimeMono);
+
+  /// Reads up to max_cnt packets under a single lock hold.
+  /// Returns an empty list if none are available.
+  ///
+  /// Space for max_cnt packets is reserved up front. Use a modest bound.
+  std::vector<Packet> read_batch(size_t max_cnt);
+  /// Waits for a packet, then reads up to max_cnt packets.
+  std::vector<Packet> read_batch_blocking(size_t max_cnt);
+  std::vector<Packet> read_batch_blocking(TimeMono, size_t max_cnt);
+
+  Reader::Stats stats();
 };
 
 struct ReaderZeroCopy : details::CppWrap<a0_reader_zc_t> {
@@ -109,6 +229,9 @@ struct ReaderZeroCopy : details::CppWrap<a0_reader_zc_t> {
       : ReaderZeroCopy(arena, Reader::Options(iter), fn) {}
   ReaderZeroCopy(Arena arena, Reader::Init init, Reader::Iter iter, std::function<void(TransportLocked, FlatPacket)> fn)
       : ReaderZeroCopy(arena, Reader::Options(init, iter), fn) {}
+
+  /// Snapshot of the reader's counters. May be called from any thread.
+  Reader::Stats stats();
 };
 
 void read_random_access(Arena, size_t off, std::function<void(TransportLocked, FlatPacket)>);
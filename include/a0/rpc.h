@@ -9,6 +9,7 @@
 #include <a0/map.h>
 #include <a0/packet.h>
 #include <a0/reader.h>
+#include <a0/thread_attr.h>
 #include <a0/writer.h>
 
 #ifdef __cplusplus
@@ -20,6 +21,13 @@ typedef struct a0_rpc_topic_s {
   const a0_file_options_t* file_opts;
 } a0_rpc_topic_t;
 
+typedef struct a0_rpc_options_s {
+  /// Attributes of the thread that reads requests, or responses.
+  a0_thread_attr_t thread_attr;
+} a0_rpc_options_t;
+
+extern const a0_rpc_options_t A0_RPC_OPTIONS_DEFAULT;
+
 ////////////
 // Server //
 ////////////
@@ -50,6 +58,12 @@ a0_err_t a0_rpc_server_init(a0_rpc_server_t*,
                             a0_alloc_t,
                             a0_rpc_request_callback_t onrequest,
                             a0_packet_id_callback_t oncancel);
+a0_err_t a0_rpc_server_init_options(a0_rpc_server_t*,
+                                    a0_rpc_topic_t,
+                                    a0_alloc_t,
+                                    a0_rpc_request_callback_t onrequest,
+                                    a0_packet_id_callback_t oncancel,
+                                    a0_rpc_options_t);
 a0_err_t a0_rpc_server_close(a0_rpc_server_t*);
 
 // Note: do NOT respond with the request packet. The ids MUST be unique!
@@ -69,6 +83,7 @@ typedef struct a0_rpc_client_s {
 } a0_rpc_client_t;
 
 a0_err_t a0_rpc_client_init(a0_rpc_client_t*, a0_rpc_topic_t, a0_alloc_t);
+a0_err_t a0_rpc_client_init_options(a0_rpc_client_t*, a0_rpc_topic_t, a0_alloc_t, a0_rpc_options_t);
 a0_err_t a0_rpc_client_close(a0_rpc_client_t*);
 
 a0_err_t a0_rpc_client_send(a0_rpc_client_t*, a0_packet_t, a0_packet_callback_t);
@@ -6,11 +6,13 @@
 #include <a0/pubsub.h>
 #include <a0/reader.hpp>
 #include <a0/rpc.h>
+#include <a0/thread_attr.hpp>
 
 #include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <future>
+#include <utility>
 
 namespace a0 {
 
@@ -29,6 +31,11 @@ struct RpcTopic {
       : name{std::move(name)}, file_opts{file_opts} {}
 };
 
+struct RpcOptions {
+  /// Attributes of the reader thread.
+  ThreadAttr thread_attr;
+};
+
 struct RpcServer;
 
 struct RpcRequest : details::CppWrap<a0_rpc_request_t> {
@@ -47,15 +54,23 @@ struct RpcRequest : details::CppWrap<a0_rpc_request_t> {
 
 struct RpcServer : details::CppWrap<a0_rpc_server_t> {
   RpcServer() = default;
+  RpcServer(
+      RpcTopic topic,
+      std::function<void(RpcRequest)> onrequest,
+      std::function<void(string_view /* id */)> oncancel)
+      : RpcServer(std::move(topic), RpcOptions(), std::move(onrequest), std::move(oncancel)) {}
   RpcServer(
       RpcTopic,
+      RpcOptions,
       std::function<void(RpcRequest)> onrequest,
       std::function<void(string_view /* id */)> oncancel);
 };
 
 struct RpcClient : details::CppWrap<a0_rpc_client_t> {
   RpcClient() = default;
-  explicit RpcClient(RpcTopic);
+  explicit RpcClient(RpcTopic topic)
+      : RpcClient(std::move(topic), RpcOptions()) {}
+  RpcClient(RpcTopic, RpcOptions);
 
   void send(Packet, std::function<void(Packet)>);
   void send(std::unordered_multimap<std::string, std::string> headers,
@@ -0,0 +1,34 @@
+#ifndef A0_THREAD_ATTR_H
+#define A0_THREAD_ATTR_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Attributes of a thread created by alephzero, such as a reader thread.
+///
+/// A zero-initialized struct keeps the system defaults.
+typedef struct a0_thread_attr_s {
+  /// CPUs the thread may run on. Leaves the affinity alone if num_cpus is zero.
+  /// Only read while the thread is created.
+  const int* cpus;
+  size_t num_cpus;
+  /// Scheduling policy, such as SCHED_FIFO, and its priority.
+  /// SCHED_OTHER inherits the policy of the creating thread.
+  ///
+  /// Real-time policies usually need CAP_SYS_NICE. Without it, creation fails with EPERM.
+  int sched_policy;
+  int sched_priority;
+  /// Zero uses the default stack size.
+  size_t stack_size;
+  /// Truncated to 15 characters. NULL keeps the inherited name.
+  const char* name;
+} a0_thread_attr_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // A0_THREAD_ATTR_H
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <a0/thread_attr.h>
+
+#include <sched.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace a0 {
+
+/// Attributes of a thread created by alephzero. See a0_thread_attr_t.
+struct ThreadAttr {
+  /// CPUs the thread may run on. Empty leaves the affinity alone.
+  std::vector<int> cpus;
+  /// Scheduling policy, such as SCHED_FIFO, and its priority.
+  /// SCHED_OTHER inherits the policy of the creating thread.
+  int sched_policy{SCHED_OTHER};
+  int sched_priority{0};
+  /// Zero uses the default stack size.
+  size_t stack_size{0};
+  /// Truncated to 15 characters. Empty keeps the inherited name.
+  std::string name;
+};
+
+}  // namespace a0
@@ -46,7 +46,7 @@
  * Since frames are organized in a linked-list format, iteration and access follows
  * from standard linked-list api.
  * You MUST begin by setting the pointer to an existing node via
- * a0_transport_jump_head or a0_transport_jump_tail.
+ * a0_transport_jump_head, a0_transport_jump_tail, or a0_transport_jump_seq.
  * Afterwards, you may proceed via a0_transport_prev and a0_transport_next.
  * To check if a previous or next exist, you may use the a0_transport_has_prev
  * and a0_transport_has_next.
@@ -74,13 +74,24 @@
  * a0_transport_alloc. This will return a frame pointing into the arena. Once
  * the frame written to, the user MUST call a0_transport_commit.
  *
- * There should only be one outstanding allocation before a commit. Multiple
- * allocations before a commit may result in lost sequence numbers based on
- * the current consistency model.
+ * Multiple allocations may be outstanding before a commit. They all become
+ * visible together, with a single notification, when the commit occurs.
+ * a0_transport_alloc_batch reserves several frames at once.
  *
  * Allocation may cause eviction, even if not committed. To see if an allocation
  * would cause an eviction, use a0_transport_alloc_evicts.
  *
+ * All frames evicted by a single allocation are removed together, before the
+ * evicted space is reused. The eviction is published immediately, but frames
+ * that have not yet been committed are not.
+ *
+ * Batches
+ * -------
+ *
+ * a0_transport_batch_begin defers commits and unlocks on a locked transport
+ * until a0_transport_batch_end. This lets a series of independent writers
+ * share a single lock, commit, and notification.
+ *
  * Frame Structure
  * ---------------
  *
@@ -88,6 +99,44 @@
  * The header has a pointer to the next and previous element, as well as a
  * sequence number, and data size.
  *
+ * Topics of small messages may instead be created with the compact frame
+ * format, through a0_transport_init_options. Compact headers hold 32-bit
+ * relative offsets and sizes, and frames are only 8-byte aligned. The format
+ * is recorded in the transport header, and is kept for the life of the arena.
+ *
+ * Compact frames cannot be accessed as a0_transport_frame_t.
+ * a0_transport_frame_view decodes the current frame in either format, and
+ * a0_transport_allocator allocates in either format.
+ *
+ * Seeking
+ * -------
+ *
+ * Frames are only linked to their neighbors. To seek by sequence number
+ * without walking the list, the transport keeps a sparse index of frame
+ * offsets, one for every 64th sequence number, in a table at the end of the
+ * arena. The table takes one 8-byte entry per 64 of the smallest frames the
+ * arena could hold, about 0.3% of the arena.
+ *
+ * a0_transport_jump_seq looks up the indexed frame at or before the target
+ * and steps forward from it, so a seek costs the same in any size arena.
+ *
+ * Arenas too small to hold 256 empty frames have no index. Resizing the
+ * arena moves the table to the new end, and rebuilds it from the live frames.
+ *
+ * Fixed Slots
+ * -----------
+ *
+ * Topics where every message has the same bounded size may be created with
+ * fixed slots, through the slot_size option. The workspace is divided into
+ * equal slots, and frame seq always lives in slot (seq - 1) % slot count.
+ * Allocation and eviction are O(1), and a0_transport_jump_seq computes the
+ * frame address directly rather than walking the list.
+ *
+ * Frames larger than the slot size fail with A0_ERR_FRAME_LARGE. The slot
+ * count is fixed at creation. Growing the arena does not add slots, and the
+ * arena cannot be shrunk below the last slot. Publishers do not grow topics
+ * with fixed slots.
+ *
  * Notifications
  * -------------
  *
@@ -98,6 +147,22 @@
  * The predicate is checked immediately, then whenever the transport is unlocked
  * following a commit or eviction.
  *
+ * Waiters register themselves in the transport header. Commits made while
+ * nobody is waiting do not enter the kernel.
+ *
+ * A waiter that needs a particular frame, such as the next one, may say so
+ * with a0_transport_wait_seq. Such waiters are queued by sequence number, and
+ * a commit only wakes the queues of the frames it added. Evictions and
+ * commits short of the frame leave them asleep.
+ *
+ * For lower latency, at the cost of a core, a transport connection may be set
+ * to busy-poll for new commits before blocking, with a0_transport_set_spin.
+ *
+ * To wait on several transports at once, without the lock, a waiter may
+ * register with a0_transport_wake_register and sleep on each transport's wake
+ * word, for example with futex_waitv. The word changes on every commit, and
+ * commits wake it while anyone is registered.
+ *
  * Consistency
  * -----------
  *
@@ -108,6 +173,45 @@
  * free the lock for the next user. Because of the double-buffered state, the
  * transport is always consistent.
  *
+ * Optimistic Reads
+ * ----------------
+ *
+ * Readers may skip the lock entirely with a0_transport_optimistic_begin.
+ *
+ * Every commit is bracketed by a sequence counter in the transport header.
+ * An optimistic read snapshots the committed state, reads whatever it needs,
+ * and then checks with a0_transport_optimistic_end that no commit occurred in
+ * the meantime. If one did, A0_ERR_AGAIN is returned and everything read must
+ * be discarded and retried.
+ *
+ * Frame contents may be overwritten while an optimistic read is in progress.
+ * Only copy data out of the arena during an optimistic read, and only trust
+ * the copy once the read has been validated.
+ *
+ * Leases
+ * ------
+ *
+ * A reader may lease the current frame with a0_transport_lease, then unlock
+ * the transport while it works with the frame in place. Leases are recorded
+ * in the transport header, and up to A0_TRANSPORT_MAX_LEASES may be held at
+ * once. Taking a lease fails with A0_ERR_AGAIN when all are held.
+ *
+ * The lease policy, chosen when the transport is created, decides what an
+ * allocation does when it would evict a leased frame:
+ *
+ * * **BLOCK** (default): Wait until the lease is released.
+ * * **FAIL**: Fail with A0_ERR_AGAIN.
+ * * **OVERWRITE**: Evict the frame anyway. Releasing the lease reports
+ *   A0_ERR_EVICTED, and anything read from the frame must be discarded.
+ *
+ * Each lease is owned through a robust mutex, so a lease held by a thread
+ * that has died is ignored, whichever process or PID namespace it was in.
+ * Allocations never wait on leases held by their own thread, and evict those
+ * frames instead. An allocation that would have to wait with uncommitted
+ * frames pending fails with A0_ERR_AGAIN, since waiting unlocks the transport.
+ *
+ * A lease must be released by the thread that took it.
+ *
  * \endrst
  */
 
@@ -132,8 +236,20 @@ extern "C" {
  *  @{
  */
 
+/// Committed state of the transport. Internal. Exposed for sizing.
+typedef struct a0_transport_state_s {
+  uint64_t seq_low;
+  uint64_t seq_high;
+  size_t off_head;
+  size_t off_tail;
+  size_t high_water_mark;
+} a0_transport_state_t;
+
 typedef struct a0_transport_s {
   a0_arena_t _arena;
+  // The part of the arena this connection has mapped. Starts as the arena's
+  // buffer, and moves to a larger mapping if another process grows the arena.
+  a0_buf_t _map;
 
   // Connection pointer info.
   uint64_t _seq;
@@ -144,6 +260,24 @@ typedef struct a0_transport_s {
 
   // Whether the transport has shutdown the notification mechanism.
   bool _shutdown;
+
+  // Time to busy-poll before blocking in a wait.
+  int64_t _spin_ns;
+
+  // Optimistic read info.
+  bool _optimistic;
+  uint32_t _optimistic_seqlock;
+  a0_transport_state_t _optimistic_state;
+
+  // Whether a commit was published without notifying waiters.
+  bool _notify_pending;
+
+  // Batch info.
+  bool _batch;
+  a0_transport_state_t _batch_state;
+
+  // Whether frames use the compact format. Read from the header on init.
+  bool _compact;
 } a0_transport_t;
 
 typedef struct a0_transport_frame_hdr_s {
@@ -166,6 +300,60 @@ typedef struct a0_transport_frame_s {
   uint8_t data[];
 } a0_transport_frame_t;
 
+/// Frame header formats. Chosen when the transport is created.
+typedef enum a0_transport_frame_format_e {
+  /// Headers of 64-bit absolute offsets. Frames are max-aligned.
+  A0_TRANSPORT_FRAME_FORMAT_DEFAULT = 0,
+  /// Headers of 32-bit relative offsets and sizes, with an implicit offset.
+  /// Frames are 8-byte aligned. The arena is limited to INT32_MAX bytes.
+  A0_TRANSPORT_FRAME_FORMAT_COMPACT = 1,
+} a0_transport_frame_format_t;
+
+/// How allocations treat leased frames. Chosen when the transport is created.
+typedef enum a0_transport_lease_policy_e {
+  /// Wait until the lease is released.
+  A0_TRANSPORT_LEASE_BLOCK = 0,
+  /// Fail with A0_ERR_AGAIN.
+  A0_TRANSPORT_LEASE_FAIL = 1,
+  /// Evict the frame, and report it when the lease is released.
+  A0_TRANSPORT_LEASE_OVERWRITE = 2,
+} a0_transport_lease_policy_t;
+
+/// Number of leases that may be held on a transport at once.
+#define A0_TRANSPORT_MAX_LEASES 16
+
+/// Options for creating a transport.
+///
+/// These will not change an existing transport.
+typedef struct a0_transport_options_s {
+  /// Frame header format.
+  a0_transport_frame_format_t frame_format;
+  /// If nonzero, frames are kept in fixed slots, each holding up to this many
+  /// bytes of data.
+  size_t slot_size;
+  /// How allocations treat leased frames.
+  a0_transport_lease_policy_t lease_policy;
+} a0_transport_options_t;
+
+/// Default transport creation options.
+///
+/// Default frame format, with variable-size frames, blocking on leases.
+extern const a0_transport_options_t A0_TRANSPORT_OPTIONS_DEFAULT;
+
+/// A reader's hold on a frame. See a0_transport_lease.
+typedef struct a0_transport_lease_s {
+  uint64_t _seq;
+  uint32_t _idx;
+} a0_transport_lease_t;
+
+/// A frame's header and data, decoded from either frame format.
+typedef struct a0_transport_frame_view_s {
+  /// Decoded frame header.
+  a0_transport_frame_hdr_t hdr;
+  /// Frame data, within the arena.
+  a0_buf_t data;
+} a0_transport_frame_view_t;
+
 /// Wrapper around a transport, used to "strongly" type unique-access.
 typedef struct a0_transport_locked_s {
   /// Wrapped transport.
@@ -174,6 +362,14 @@ typedef struct a0_transport_locked_s {
 
 /// Creates or connects to the transport in the given arena.
 a0_err_t a0_transport_init(a0_transport_t*, a0_arena_t);
+/// Creates or connects to the transport in the given arena.
+///
+/// A new transport is created with the given options. NULL means
+/// A0_TRANSPORT_OPTIONS_DEFAULT. An existing transport keeps the options it
+/// was created with.
+///
+/// Fails with A0_ERR_INVALID_ARG if the options do not fit the arena.
+a0_err_t a0_transport_init_options(a0_transport_t*, a0_arena_t, const a0_transport_options_t*);
 
 /// Locks the transport.
 a0_err_t a0_transport_lock(a0_transport_t*, a0_transport_locked_t* lk_out);
@@ -182,6 +378,22 @@ a0_err_t a0_transport_lock(a0_transport_t*, a0_transport_locked_t* lk_out);
 /// The locked_transport object is invalid afterwards.
 a0_err_t a0_transport_unlock(a0_transport_locked_t);
 
+/// Begins a lock-free read of the transport.
+///
+/// The committed state is snapshotted without taking the lock. Only
+/// non-mutating access functions may be used with the returned object.
+///
+/// The read MUST be completed with a0_transport_optimistic_end.
+a0_err_t a0_transport_optimistic_begin(a0_transport_t*, a0_transport_locked_t* lk_out);
+/// Checks whether a writer has committed since the optimistic read began.
+///
+/// Returns A0_ERR_AGAIN if the data read so far may be inconsistent.
+a0_err_t a0_transport_optimistic_validate(a0_transport_locked_t);
+/// Ends an optimistic read.
+///
+/// Returns A0_ERR_AGAIN if the data read may be inconsistent and must be discarded.
+a0_err_t a0_transport_optimistic_end(a0_transport_locked_t);
+
 /// Shuts down the notification mechanism and waits for all waiters to return.
 a0_err_t a0_transport_shutdown(a0_transport_locked_t);
 
@@ -207,6 +419,14 @@ a0_err_t a0_transport_jump_head(a0_transport_locked_t);
 ///
 /// Note that this is inclusive.
 a0_err_t a0_transport_jump_tail(a0_transport_locked_t);
+/// Moves the user's transport pointer to the frame with the given sequence number.
+///
+/// Starts from the closest indexed frame, and steps forward at most 63 frames.
+/// Without an index, walks from whichever of the oldest frame, the newest
+/// frame, or the current pointer is closest.
+///
+/// Fails with A0_ERR_RANGE if the frame is not available.
+a0_err_t a0_transport_jump_seq(a0_transport_locked_t, uint64_t seq);
 /// Checks whether a newer frame exists than that at the current
 /// user's transport pointer.
 a0_err_t a0_transport_has_next(a0_transport_locked_t, bool*);
@@ -222,6 +442,14 @@ a0_err_t a0_transport_has_prev(a0_transport_locked_t, bool*);
 /// Step the user's transport pointer backward by one frame.
 a0_err_t a0_transport_step_prev(a0_transport_locked_t);
 
+/// Spin budget that never falls back to blocking.
+#define A0_TRANSPORT_SPIN_FOREVER INT64_MAX
+
+/// Sets how long waits on this connection busy-poll for a commit before blocking.
+///
+/// Zero, the default, blocks immediately. A0_TRANSPORT_SPIN_FOREVER never blocks.
+a0_err_t a0_transport_set_spin(a0_transport_t*, int64_t spin_ns);
+
 /// Wait until the given predicate is satisfied.
 ///
 /// The predicate is checked when an unlock event occurs following a commit or eviction.
@@ -232,6 +460,31 @@ a0_err_t a0_transport_wait(a0_transport_locked_t, a0_predicate_t);
 /// The predicate is checked when an unlock event occurs following a commit or eviction.
 a0_err_t a0_transport_timedwait(a0_transport_locked_t, a0_predicate_t, a0_time_mono_t*);
 
+/// Wait until the given predicate is satisfied, where it cannot be before
+/// frame seq is committed.
+///
+/// Commits that leave seq_high below seq do not wake the caller.
+a0_err_t a0_transport_wait_seq(a0_transport_locked_t, uint64_t seq, a0_predicate_t);
+
+/// Wait until the given predicate is satisfied or the timeout expires, where
+/// the predicate cannot be satisfied before frame seq is committed.
+///
+/// Commits that leave seq_high below seq do not wake the caller.
+a0_err_t a0_transport_timedwait_seq(a0_transport_locked_t, uint64_t seq, a0_predicate_t, a0_time_mono_t*);
+
+/// Futex word that changes on every commit. May be read without the lock.
+///
+/// Sleeping on it only works while registered with a0_transport_wake_register.
+a0_err_t a0_transport_wake_word(a0_transport_t*, uint32_t** out);
+
+/// Asks committers to wake the wake word, until unregistered.
+///
+/// Register, then check the word for changes, then sleep. No commit is missed.
+a0_err_t a0_transport_wake_register(a0_transport_t*);
+
+/// Undoes a0_transport_wake_register.
+a0_err_t a0_transport_wake_unregister(a0_transport_t*);
+
 /// Predicate that is satisfied when the transport is empty.
 a0_predicate_t a0_transport_empty_pred(a0_transport_locked_t*);
 /// Predicate that is satisfied when the transport is not empty.
@@ -239,16 +492,38 @@ a0_predicate_t a0_transport_nonempty_pred(a0_transport_locked_t*);
 /// Predicate that is satisfied when a newer frame exists than one at the current pointer.
 a0_predicate_t a0_transport_has_next_pred(a0_transport_locked_t*);
 
+/// Leases the frame at the current transport pointer.
+///
+/// The frame will not be evicted, subject to the lease policy, until the
+/// lease is released. The transport may be unlocked in the meantime.
+///
+/// Fails with A0_ERR_AGAIN if every lease is in use.
+a0_err_t a0_transport_lease(a0_transport_locked_t, a0_transport_lease_t* lease_out);
+/// Releases a lease taken with a0_transport_lease.
+///
+/// Fails with A0_ERR_EVICTED if the frame was evicted while leased.
+a0_err_t a0_transport_lease_release(a0_transport_locked_t, a0_transport_lease_t);
+
 /// Returns the earliest available sequence number.
 a0_err_t a0_transport_seq_low(a0_transport_locked_t, uint64_t* out);
 
 /// Returns the latest available sequence number.
 a0_err_t a0_transport_seq_high(a0_transport_locked_t, uint64_t* out);
 
+/// Returns the data capacity of each fixed slot. Zero for variable-size frames.
+a0_err_t a0_transport_slot_size(a0_transport_locked_t, size_t* out);
+
 /// Accesses the frame within the arena, at the current transport pointer.
 ///
 /// Caller does NOT own `frame_out->data` and should not clean it up!
+///
+/// Fails with A0_ERR_INVALID_ARG for compact frames.
 a0_err_t a0_transport_frame(a0_transport_locked_t, a0_transport_frame_t** frame_out);
+/// Decodes the frame at the current transport pointer.
+///
+/// Works with every frame format.
+/// Caller does NOT own `view_out->data` and should not clean it up!
+a0_err_t a0_transport_frame_view(a0_transport_locked_t, a0_transport_frame_view_t* view_out);
 
 /// Allocates a new frame within the arena.
 ///
@@ -262,20 +537,56 @@ a0_err_t a0_transport_frame(a0_transport_locked_t, a0_transport_frame_t** frame_
 ///     If an alloc evicts an old frame, that frame is lost, even if no
 ///     commit call is issued.
 /// \endrst
+///
+/// Fails with A0_ERR_INVALID_ARG for compact frames. Use a0_transport_allocator.
 a0_err_t a0_transport_alloc(a0_transport_locked_t, size_t, a0_transport_frame_t** frame_out);
 /// Checks whether an alloc call would evict.
 a0_err_t a0_transport_alloc_evicts(a0_transport_locked_t, size_t, bool*);
+/// Allocates a frame for each of the given sizes.
+///
+/// Caller does NOT own `frames_out[i]->data` and should not clean it up!
+///
+/// The frames become visible together on the next commit. Fails with
+/// A0_ERR_FRAME_LARGE, and allocates nothing, if the frames do not fit
+/// in the arena together.
+///
+/// Fails with A0_ERR_INVALID_ARG for compact frames.
+a0_err_t a0_transport_alloc_batch(a0_transport_locked_t, const size_t* sizes, size_t cnt, a0_transport_frame_t** frames_out);
 /// Creates an allocator that allocates within the transport.
+///
+/// Works with every frame format.
 a0_err_t a0_transport_allocator(a0_transport_locked_t*, a0_alloc_t*);
 /// Commits the allocated frames.
 a0_err_t a0_transport_commit(a0_transport_locked_t);
 
+/// Begins a batch on the locked transport.
+///
+/// Until a0_transport_batch_end, a0_transport_commit only marks the allocated
+/// frames as ready, and a0_transport_unlock only discards frames allocated
+/// since the last commit. The lock is held throughout.
+a0_err_t a0_transport_batch_begin(a0_transport_locked_t);
+/// Ends the batch, committing all ready frames with a single notification.
+///
+/// The transport remains locked.
+a0_err_t a0_transport_batch_end(a0_transport_locked_t);
+
 /// Returns the arena space in use.
 a0_err_t a0_transport_used_space(a0_transport_locked_t, size_t*);
+/// Counts the frames committed after the transport pointer, and the arena
+/// bytes they span, including frame headers and padding.
+///
+/// Optimistic readers get A0_ERR_AGAIN if a frame was overwritten mid-read.
+a0_err_t a0_transport_lag(a0_transport_locked_t, uint64_t* frames, size_t* bytes);
 /// Resizes the underlying arena. Fails with A0_ERR_INVALID_ARG if this would delete active data.
+///
+/// Fails with ENOMEM if the arena would extend past this connection's mapping.
+/// Other connections map the new size when they next lock.
 a0_err_t a0_transport_resize(a0_transport_locked_t, size_t);
 
 /// Clears the transport.
+///
+/// Every frame is dropped, even if leased. Outstanding leases are released
+/// with A0_ERR_EVICTED.
 a0_err_t a0_transport_clear(a0_transport_locked_t);
 
 /** @}*/
@@ -9,35 +9,45 @@
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <vector>
 
 namespace a0 {
 
 using Frame = a0_transport_frame_t;
+using FrameView = a0_transport_frame_view_t;
+using Lease = a0_transport_lease_t;
 
 struct TransportLocked : details::CppWrap<a0_transport_locked_t> {
   bool empty() const;
   uint64_t seq_low() const;
   uint64_t seq_high() const;
+  size_t slot_size() const;
 
   size_t used_space() const;
   void resize(size_t);
 
   bool iter_valid() const;
   Frame* frame() const;
+  FrameView frame_view() const;
 
   void jump(size_t off);
   void jump_head();
   void jump_tail();
+  void jump_seq(uint64_t seq);
   bool has_next() const;
   void step_next();
   bool has_prev() const;
   void step_prev();
 
   Frame* alloc(size_t);
+  std::vector<Frame*> alloc_batch(std::vector<size_t>);
   bool alloc_evicts(size_t) const;
 
   void commit();
 
+  Lease lease();
+  void lease_release(Lease);
+
   void clear();
 
   void wait(std::function<bool()>);
@@ -46,10 +56,34 @@ struct TransportLocked : details::CppWrap<a0_transport_locked_t> {
 };
 
 struct Transport : details::CppWrap<a0_transport_t> {
+  enum struct FrameFormat {
+    DEFAULT = A0_TRANSPORT_FRAME_FORMAT_DEFAULT,
+    COMPACT = A0_TRANSPORT_FRAME_FORMAT_COMPACT,
+  };
+
+  enum struct LeasePolicy {
+    BLOCK = A0_TRANSPORT_LEASE_BLOCK,
+    FAIL = A0_TRANSPORT_LEASE_FAIL,
+    OVERWRITE = A0_TRANSPORT_LEASE_OVERWRITE,
+  };
+
+  struct Options {
+    FrameFormat frame_format;
+    /// Non-zero selects the fixed-slot ring. See a0_transport_options_t.
+    size_t slot_size;
+    /// How allocations treat leased frames.
+    LeasePolicy lease_policy;
+
+    static Options DEFAULT;
+  };
+
   Transport() = default;
   explicit Transport(Arena);
+  Transport(Arena, Options);
 
   TransportLocked lock();
+
+  void set_spin(std::chrono::nanoseconds);
 };
 
 }  // namespace a0
@@ -14,10 +14,15 @@
 #define A0_WRITER_H
 
 #include <a0/arena.h>
+#include <a0/buf.h>
 #include <a0/err.h>
 #include <a0/inline.h>
 #include <a0/middleware.h>
 #include <a0/packet.h>
+#include <a0/transport.h>
+
+#include <stdbool.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -27,6 +32,19 @@ extern "C" {
  *  @{
  */
 
+typedef struct a0_writer_options_s {
+  /// Serialize each packet into a thread-local staging buffer before taking
+  /// the transport lock. Under the lock, the staged bytes are copied into the
+  /// arena, along with any headers added by locked middleware.
+  ///
+  /// Shortens the critical section for large packets, at the cost of an extra
+  /// copy. Locked middleware that replaces the payload, such as
+  /// a0_json_mergepatch, falls back to serializing under the lock.
+  bool staged;
+} a0_writer_options_t;
+
+extern const a0_writer_options_t A0_WRITER_OPTIONS_DEFAULT;
+
 struct a0_writer_s {
   a0_middleware_t _action;
   a0_writer_t* _next;
@@ -34,10 +52,42 @@ struct a0_writer_s {
 
 /// Initializes a writer.
 a0_err_t a0_writer_init(a0_writer_t*, a0_arena_t);
+/// Initializes a writer with the given options.
+a0_err_t a0_writer_init_options(a0_writer_t*, a0_arena_t, a0_writer_options_t);
 /// Closes the given writer.
 a0_err_t a0_writer_close(a0_writer_t*);
 /// Serializes the given packet into the writer's arena.
 a0_err_t a0_writer_write(a0_writer_t*, a0_packet_t);
+/// Serializes the given packets into the writer's arena.
+///
+/// Each packet runs through the middleware chain, but the transport is locked
+/// only once, and the packets become visible together with a single notification.
+/// Stops at the first error. Packets before it are still written.
+a0_err_t a0_writer_write_batch(a0_writer_t*, a0_packet_t*, size_t);
+
+/// A packet reserved within the writer's arena.
+struct a0_writer_reservation_s {
+  /// The payload bytes, within the arena. Filled in by the caller.
+  a0_buf_t payload;
+
+  a0_transport_locked_t _tlk;
+};
+
+/// Reserves a packet within the writer's arena, without a payload copy.
+///
+/// The packet runs through the middleware chain as usual. Its payload is
+/// replaced by payload_size uninitialized bytes, which the caller fills in
+/// through reservation->payload before calling a0_writer_reservation_commit.
+/// Middleware that reads or replaces the payload, such as
+/// a0_json_mergepatch, is not supported.
+///
+/// The transport stays locked until the reservation is committed or aborted,
+/// by the same thread. Readers and other writers wait meanwhile.
+a0_err_t a0_writer_reserve(a0_writer_t*, a0_packet_t, size_t payload_size, a0_writer_reservation_t*);
+/// Publishes the reserved packet and releases the transport lock.
+a0_err_t a0_writer_reservation_commit(a0_writer_reservation_t*);
+/// Discards the reserved packet and releases the transport lock.
+a0_err_t a0_writer_reservation_abort(a0_writer_reservation_t*);
 
 /// Modifies the writer to include the given middleware.
 ///
@@ -1,22 +1,55 @@
 #pragma once
 
 #include <a0/arena.hpp>
+#include <a0/buf.hpp>
 #include <a0/c_wrap.hpp>
 #include <a0/middleware.hpp>
 #include <a0/packet.hpp>
 #include <a0/writer.h>
 
+#include <cstddef>
 #include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace a0 {
 
 struct Writer : details::CppWrap<a0_writer_t> {
+  struct Options {
+    /// Serialize packets before taking the transport lock.
+    bool staged;
+    static Options DEFAULT;
+  };
+
+  /// A packet reserved within the arena. See a0_writer_reserve.
+  ///
+  /// Aborted on destruction, unless committed.
+  struct Reservation : details::CppWrap<a0_writer_reservation_t> {
+    /// The payload bytes, within the arena.
+    Buf payload();
+    /// Publishes the packet.
+    void commit();
+    /// Discards the packet.
+    void abort();
+  };
+
   Writer() = default;
   explicit Writer(Arena);
+  Writer(Arena, Options);
 
   void write(Packet);
   void write(string_view sv) { write(Packet(sv, ref)); }
 
+  void write_batch(std::vector<Packet>);
+
+  /// Reserves a packet with the given headers and payload size.
+  Reservation reserve(std::unordered_multimap<std::string, std::string> headers,
+                      size_t payload_size);
+  Reservation reserve(size_t payload_size) {
+    return reserve({}, payload_size);
+  }
+
   void push(Middleware);
   Writer wrap(Middleware);
 };
@@ -0,0 +1,285 @@
+#include <a0/alloc.h>
+#include <a0/buf.h>
+#include <a0/empty.h>
+#include <a0/err.h>
+#include <a0/inline.h>
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "err_macro.h"
+
+// Alignment of every buffer handed out. Matches malloc.
+#define A0_ALLOC_ALIGN 16
+
+// Rounds up to the alignment. Empty requests still take space, so every
+// buffer has a distinct address within the reserved memory.
+A0_STATIC_INLINE
+size_t a0_alloc_align(size_t size) {
+  if (!size) {
+    size = 1;
+  }
+  return (size + A0_ALLOC_ALIGN - 1) & ~(size_t)(A0_ALLOC_ALIGN - 1);
+}
+
+A0_STATIC_INLINE
+bool a0_alloc_owns(uint8_t* mem, size_t size, a0_buf_t buf) {
+  return buf.data >= mem && buf.data < mem + size;
+}
+
+A0_STATIC_INLINE
+a0_err_t a0_alloc_fallback(size_t size, a0_buf_t* out) {
+  uint8_t* data = (uint8_t*)malloc(size ? size : 1);
+  if (!data) {
+    return A0_MAKE_SYSERR(ENOMEM);
+  }
+  *out = (a0_buf_t){data, size};
+  return A0_OK;
+}
+
+// Pool.
+
+a0_err_t a0_alloc_pool_init(a0_alloc_pool_t* pool, size_t block_size, size_t num_blocks) {
+  if (!block_size || !num_blocks || num_blocks >= UINT32_MAX) {
+    return A0_ERR_INVALID_ARG;
+  }
+  block_size = a0_alloc_align(block_size);
+  if (num_blocks > SIZE_MAX / block_size) {
+    return A0_ERR_INVALID_ARG;
+  }
+
+  *pool = (a0_alloc_pool_t)A0_EMPTY;
+  pool->_slab = (uint8_t*)malloc(block_size * num_blocks);
+  pool->_next = (uint32_t*)malloc(num_blocks * sizeof(uint32_t));
+  if (!pool->_slab || !pool->_next) {
+    free(pool->_slab);
+    free(pool->_next);
+    return A0_MAKE_SYSERR(ENOMEM);
+  }
+  pool->_block_size = block_size;
+  pool->_num_blocks = num_blocks;
+
+  // Links hold index + 1. Zero ends the list.
+  for (size_t i = 0; i < num_blocks; i++) {
+    pool->_next[i] = (uint32_t)(i + 2);
+  }
+  pool->_next[num_blocks - 1] = 0;
+  pool->_free = 1;
+
+  return A0_OK;
+}
+
+a0_err_t a0_alloc_pool_close(a0_alloc_pool_t* pool) {
+  size_t num_free = 0;
+  for (uint32_t link = (uint32_t)pool->_free; link; link = pool->_next[link - 1]) {
+    num_free++;
+  }
+  if (num_free != pool->_num_blocks) {
+    return A0_MAKE_SYSERR(EBUSY);
+  }
+
+  free(pool->_slab);
+  free(pool->_next);
+  *pool = (a0_alloc_pool_t)A0_EMPTY;
+  return A0_OK;
+}
+
+// The free list is a stack. Every update bumps the tag, so a pop can't succeed
+// against a list that changed under it, even if the same block is back on top.
+
+A0_STATIC_INLINE
+a0_err_t a0_alloc_pool_alloc(void* user_data, size_t size, a0_buf_t* out) {
+  a0_alloc_pool_t* pool = (a0_alloc_pool_t*)user_data;
+  if (size > pool->_block_size) {
+    return a0_alloc_fallback(size, out);
+  }
+
+  uint64_t old = __atomic_load_n(&pool->_free, __ATOMIC_ACQUIRE);
+  while ((uint32_t)old) {
+    uint32_t idx = (uint32_t)old - 1;
+    uint64_t tag = (old >> 32) + 1;
+    uint32_t next = __atomic_load_n(&pool->_next[idx], __ATOMIC_RELAXED);
+    if (__atomic_compare_exchange_n(&pool->_free, &old, (tag << 32) | next, true, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+      *out = (a0_buf_t){pool->_slab + idx * pool->_block_size, size};
+      return A0_OK;
+    }
+  }
+
+  // Exhausted.
+  return a0_alloc_fallback(size, out);
+}
+
+A0_STATIC_INLINE
+a0_err_t a0_alloc_pool_dealloc(void* user_data, a0_buf_t buf) {
+  a0_alloc_pool_t* pool = (a0_alloc_pool_t*)user_data;
+  if (!a0_alloc_owns(pool->_slab, pool->_block_size * pool->_num_blocks, buf)) {
+    free(buf.data);
+    return A0_OK;
+  }
+
+  uint32_t idx = (uint32_t)((size_t)(buf.data - pool->_slab) / pool->_block_size);
+  uint64_t old = __atomic_load_n(&pool->_free, __ATOMIC_RELAXED);
+  uint64_t tag;
+  do {
+    tag = (old >> 32) + 1;
+    __atomic_store_n(&pool->_next[idx], (uint32_t)old, __ATOMIC_RELAXED);
+  } while (!__atomic_compare_exchange_n(&pool->_free, &old, (tag << 32) | (idx + 1), true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+  return A0_OK;
+}
+
+a0_err_t a0_alloc_pool_allocator(a0_alloc_pool_t* pool, a0_alloc_t* out) {
+  *out = (a0_alloc_t){
+      .user_data = pool,
+      .alloc = a0_alloc_pool_alloc,
+      .dealloc = a0_alloc_pool_dealloc,
+  };
+  return A0_OK;
+}
+
+// Ring.
+//
+// Each buffer is preceded by a header with the number of bytes it spans,
+// including any padding skipped at the end of the ring. Releasing a buffer
+// advances the tail past it.
+
+#define A0_ALLOC_RING_HDR A0_ALLOC_ALIGN
+
+a0_err_t a0_alloc_ring_init(a0_alloc_ring_t* ring, size_t size) {
+  size &= ~(size_t)(A0_ALLOC_ALIGN - 1);
+  if (size < 2 * A0_ALLOC_RING_HDR) {
+    return A0_ERR_INVALID_ARG;
+  }
+
+  *ring = (a0_alloc_ring_t)A0_EMPTY;
+  ring->_buf = (uint8_t*)malloc(size);
+  if (!ring->_buf) {
+    return A0_MAKE_SYSERR(ENOMEM);
+  }
+  ring->_size = size;
+  return A0_OK;
+}
+
+a0_err_t a0_alloc_ring_close(a0_alloc_ring_t* ring) {
+  if (ring->_head != __atomic_load_n(&ring->_tail, __ATOMIC_ACQUIRE)) {
+    return A0_MAKE_SYSERR(EBUSY);
+  }
+
+  free(ring->_buf);
+  *ring = (a0_alloc_ring_t)A0_EMPTY;
+  return A0_OK;
+}
+
+A0_STATIC_INLINE
+a0_err_t a0_alloc_ring_alloc(void* user_data, size_t size, a0_buf_t* out) {
+  a0_alloc_ring_t* ring = (a0_alloc_ring_t*)user_data;
+  if (size > ring->_size) {
+    return a0_alloc_fallback(size, out);
+  }
+
+  size_t need = A0_ALLOC_RING_HDR + a0_alloc_align(size);
+  uint64_t head = ring->_head;
+  size_t pos = head % ring->_size;
+  // Buffers don't wrap. Skip to the start if this one doesn't fit the end.
+  size_t pad = pos + need > ring->_size ? ring->_size - pos : 0;
+  uint64_t span = pad + need;
+
+  uint64_t tail = __atomic_load_n(&ring->_tail, __ATOMIC_ACQUIRE);
+  if (need > ring->_size || head + span - tail > ring->_size) {
+    return a0_alloc_fallback(size, out);
+  }
+
+  uint8_t* hdr = ring->_buf + (pos + pad) % ring->_size;
+  *(uint64_t*)hdr = span;
+  __atomic_store_n(&ring->_head, head + span, __ATOMIC_RELAXED);
+
+  *out = (a0_buf_t){hdr + A0_ALLOC_RING_HDR, size};
+  return A0_OK;
+}
+
+A0_STATIC_INLINE
+a0_err_t a0_alloc_ring_dealloc(void* user_data, a0_buf_t buf) {
+  a0_alloc_ring_t* ring = (a0_alloc_ring_t*)user_data;
+  if (!a0_alloc_owns(ring->_buf, ring->_size, buf)) {
+    free(buf.data);
+    return A0_OK;
+  }
+
+  uint64_t span = *(uint64_t*)(buf.data - A0_ALLOC_RING_HDR);
+  __atomic_fetch_add(&ring->_tail, span, __ATOMIC_RELEASE);
+  return A0_OK;
+}
+
+a0_err_t a0_alloc_ring_allocator(a0_alloc_ring_t* ring, a0_alloc_t* out) {
+  *out = (a0_alloc_t){
+      .user_data = ring,
+      .alloc = a0_alloc_ring_alloc,
+      .dealloc = a0_alloc_ring_dealloc,
+  };
+  return A0_OK;
+}
+
+// Bump.
+
+a0_err_t a0_alloc_bump_init(a0_alloc_bump_t* bump, size_t size) {
+  if (!size) {
+    return A0_ERR_INVALID_ARG;
+  }
+
+  *bump = (a0_alloc_bump_t)A0_EMPTY;
+  bump->_buf = (uint8_t*)malloc(size);
+  if (!bump->_buf) {
+    return A0_MAKE_SYSERR(ENOMEM);
+  }
+  bump->_size = size;
+  return A0_OK;
+}
+
+a0_err_t a0_alloc_bump_close(a0_alloc_bump_t* bump) {
+  if (bump->_live) {
+    return A0_MAKE_SYSERR(EBUSY);
+  }
+
+  free(bump->_buf);
+  *bump = (a0_alloc_bump_t)A0_EMPTY;
+  return A0_OK;
+}
+
+A0_STATIC_INLINE
+a0_err_t a0_alloc_bump_alloc(void* user_data, size_t size, a0_buf_t* out) {
+  a0_alloc_bump_t* bump = (a0_alloc_bump_t*)user_data;
+  if (size > bump->_size || a0_alloc_align(size) > bump->_size - bump->_off) {
+    return a0_alloc_fallback(size, out);
+  }
+
+  *out = (a0_buf_t){bump->_buf + bump->_off, size};
+  bump->_off += a0_alloc_align(size);
+  bump->_live++;
+  return A0_OK;
+}
+
+A0_STATIC_INLINE
+a0_err_t a0_alloc_bump_dealloc(void* user_data, a0_buf_t buf) {
+  a0_alloc_bump_t* bump = (a0_alloc_bump_t*)user_data;
+  if (!a0_alloc_owns(bump->_buf, bump->_size, buf)) {
+    free(buf.data);
+    return A0_OK;
+  }
+
+  if (!--bump->_live) {
+    bump->_off = 0;
+  }
+  return A0_OK;
+}
+
+a0_err_t a0_alloc_bump_allocator(a0_alloc_bump_t* bump, a0_alloc_t* out) {
+  *out = (a0_alloc_t){
+      .user_data = bump,
+      .alloc = a0_alloc_bump_alloc,
+      .dealloc = a0_alloc_bump_dealloc,
+  };
+  return A0_OK;
+}
@@ -13,6 +13,16 @@ void a0_barrier() {
   __sync_synchronize();
 }
 
+// Hint to the cpu that this is a busy-wait loop.
+A0_STATIC_INLINE
+void a0_cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
 #define a0_atomic_fetch_add(P, V) __atomic_fetch_add((P), (V), __ATOMIC_RELAXED)
 #define a0_atomic_add_fetch(P, V) __atomic_add_fetch((P), (V), __ATOMIC_RELAXED)
 
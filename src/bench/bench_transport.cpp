@@ -4,8 +4,29 @@
 #include <a0.h>
 #include <picobench/picobench.hpp>
 
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
 static const char BENCH_FILE[] = "bench.a0";
 
+// Counts heap allocations, to check readers make none per message in steady
+// state. operator new goes through malloc too.
+static std::atomic<size_t> heap_allocs{0};
+
+extern "C" void* __libc_malloc(size_t);
+
+extern "C" void* malloc(size_t size) {
+  heap_allocs.fetch_add(1, std::memory_order_relaxed);
+  return __libc_malloc(size);
+}
+
+// Heap allocations per message, by benchmark. Printed after the suite.
+static std::map<std::string, double> allocs_per_msg;
+
 template <typename T>
 A0_STATIC_INLINE void use(const T& t) {
   asm volatile(""
@@ -149,7 +170,7 @@ bench_fn_t bench_a0_alloc(int msg_size) {
     a0_transport_lock(&fixture.transport, &lk);
     for (auto&& _ : s) {
       use(_);
-      a0_transport_frame_t frame;
+      a0_transport_frame_t* frame;
       a0_transport_alloc(lk, msg_size, &frame);
     }
     a0_transport_unlock(lk);
@@ -167,14 +188,349 @@ bench_fn_t bench_a0_alloc_memcpy(int msg_size) {
     a0_transport_lock(&fixture.transport, &lk);
     for (auto&& _ : s) {
       use(_);
-      a0_transport_frame_t frame;
+      a0_transport_frame_t* frame;
       a0_transport_alloc(lk, msg_size, &frame);
-      memcpy(frame.data, src.data(), msg_size);
+      memcpy(frame->data, src.data(), msg_size);
     }
     a0_transport_unlock(lk);
   };
 }
 
+// The arena fits only one large frame. Each iteration writes one large frame,
+// which evicts a full arena of small frames at once, then refills the arena
+// with small frames.
+bench_fn_t bench_a0_evict(int small_size, int large_size) {
+  return [small_size, large_size](picobench::state& s) {
+    std::vector<uint8_t> arena_data(4096 + sizeof(a0_transport_frame_hdr_t) + large_size);
+    a0_arena_t arena = {
+        .buf = {arena_data.data(), arena_data.size()},
+        .mode = A0_ARENA_MODE_SHARED,
+    };
+    a0_transport_t transport;
+    a0_transport_init(&transport, arena);
+
+    a0_transport_locked_t lk;
+    a0_transport_lock(&transport, &lk);
+
+    // Count how many small frames fill the arena.
+    a0_transport_frame_t* frame;
+    int num_small = 0;
+    bool evicts = false;
+    while (!evicts) {
+      a0_transport_alloc(lk, small_size, &frame);
+      a0_transport_commit(lk);
+      a0_transport_alloc_evicts(lk, small_size, &evicts);
+      num_small++;
+    }
+
+    for (auto&& _ : s) {
+      use(_);
+      a0_transport_alloc(lk, large_size, &frame);
+      a0_transport_commit(lk);
+      for (int i = 0; i < num_small; i++) {
+        a0_transport_alloc(lk, small_size, &frame);
+        a0_transport_commit(lk);
+      }
+    }
+    a0_transport_unlock(lk);
+  };
+}
+
+// Fills a file-backed arena with frames, then each iteration walks every frame
+// and touches its data.
+bench_fn_t bench_a0_scan(size_t arena_size, int msg_size, bool huge_pages) {
+  return [arena_size, msg_size, huge_pages](picobench::state& s) {
+    a0_file_options_t opts = A0_FILE_OPTIONS_DEFAULT;
+    opts.create_options.size = arena_size;
+    opts.open_options.huge_pages = huge_pages;
+
+    a0_file_t file;
+    a0_file_remove(BENCH_FILE);
+    a0_file_open(BENCH_FILE, &opts, &file);
+
+    a0_transport_t transport;
+    a0_transport_init(&transport, file.arena);
+
+    a0_transport_locked_t lk;
+    a0_transport_lock(&transport, &lk);
+
+    a0_transport_frame_t* frame;
+    bool evicts = false;
+    while (!evicts) {
+      a0_transport_alloc(lk, msg_size, &frame);
+      memset(frame->data, 1, msg_size);
+      a0_transport_commit(lk);
+      a0_transport_alloc_evicts(lk, msg_size, &evicts);
+    }
+
+    for (auto&& _ : s) {
+      use(_);
+      uint64_t sum = 0;
+      a0_transport_jump_head(lk);
+      while (true) {
+        a0_transport_frame(lk, &frame);
+        for (size_t i = 0; i < frame->hdr.data_size; i += 64) {
+          sum += frame->data[i];
+        }
+        bool has_next;
+        a0_transport_has_next(lk, &has_next);
+        if (!has_next) {
+          break;
+        }
+        a0_transport_step_next(lk);
+      }
+      use(sum);
+    }
+
+    a0_transport_unlock(lk);
+    a0_file_close(&file);
+    a0_file_remove(BENCH_FILE);
+  };
+}
+
+// Offsets of the contended header fields, within a 320 byte header.
+struct HdrLayout {
+  size_t mtx_off;
+  size_t cnd_off;
+  size_t state_off;
+};
+
+// The 0.3 layout packed the mutex, condition, and state into 144 bytes.
+static const HdrLayout kHdrLayout03 = {16, 40, 48};
+// The 0.4 layout gives each its own cache line.
+static const HdrLayout kHdrLayout04 = {64, 128, 200};
+
+// Each iteration locks, updates the committed state, and bumps the condition,
+// as a commit does. Meanwhile, num_pollers threads repeatedly read the
+// condition, as readers do before blocking on it.
+bench_fn_t bench_a0_hdr_contention(HdrLayout layout, int num_pollers) {
+  return [layout, num_pollers](picobench::state& s) {
+    alignas(64) uint8_t hdr[320] = {};
+    a0_mtx_t* mtx = (a0_mtx_t*)(hdr + layout.mtx_off);
+    a0_cnd_t* cnd = (a0_cnd_t*)(hdr + layout.cnd_off);
+    a0_transport_state_t* state = (a0_transport_state_t*)(hdr + layout.state_off);
+
+    std::atomic<bool> done{false};
+    std::vector<std::thread> pollers;
+    for (int i = 0; i < num_pollers; i++) {
+      pollers.emplace_back([&]() {
+        uint32_t sum = 0;
+        while (!done.load(std::memory_order_relaxed)) {
+          sum += __atomic_load_n(cnd, __ATOMIC_ACQUIRE);
+        }
+        use(sum);
+      });
+    }
+
+    for (auto&& _ : s) {
+      use(_);
+      use(a0_mtx_lock(mtx));
+      state->seq_high++;
+      state->off_tail += 64;
+      state->high_water_mark = state->off_tail;
+      __atomic_add_fetch(cnd, 1, __ATOMIC_RELEASE);
+      a0_mtx_unlock(mtx);
+    }
+
+    done = true;
+    for (auto&& t : pollers) {
+      t.join();
+    }
+  };
+}
+
+enum BenchAllocKind {
+  BENCH_ALLOC_MALLOC,
+  BENCH_ALLOC_POOL,
+  BENCH_ALLOC_RING,
+  BENCH_ALLOC_BUMP,
+};
+
+// Room for the deserialized headers, on top of the payload.
+static const size_t kDeserializeSlack = 1024;
+
+struct BenchAlloc {
+  BenchAlloc(BenchAllocKind kind, size_t msg_size)
+      : kind{kind} {
+    size_t block_size = msg_size + kDeserializeSlack;
+    switch (kind) {
+      case BENCH_ALLOC_MALLOC: {
+        alloc = {
+            .user_data = nullptr,
+            .alloc = [](void*, size_t size, a0_buf_t* out) {
+              *out = {(uint8_t*)malloc(size), size};
+              return A0_OK;
+            },
+            .dealloc = [](void*, a0_buf_t buf) {
+              free(buf.data);
+              return A0_OK;
+            },
+        };
+        break;
+      }
+      case BENCH_ALLOC_POOL: {
+        a0_alloc_pool_init(&pool, block_size, 4);
+        a0_alloc_pool_allocator(&pool, &alloc);
+        break;
+      }
+      case BENCH_ALLOC_RING: {
+        a0_alloc_ring_init(&ring, 4 * block_size);
+        a0_alloc_ring_allocator(&ring, &alloc);
+        break;
+      }
+      case BENCH_ALLOC_BUMP: {
+        a0_alloc_bump_init(&bump, block_size);
+        a0_alloc_bump_allocator(&bump, &alloc);
+        break;
+      }
+    }
+  }
+
+  ~BenchAlloc() {
+    switch (kind) {
+      case BENCH_ALLOC_MALLOC: {
+        break;
+      }
+      case BENCH_ALLOC_POOL: {
+        a0_alloc_pool_close(&pool);
+        break;
+      }
+      case BENCH_ALLOC_RING: {
+        a0_alloc_ring_close(&ring);
+        break;
+      }
+      case BENCH_ALLOC_BUMP: {
+        a0_alloc_bump_close(&bump);
+        break;
+      }
+    }
+  }
+
+  // Allocates with alloc, remembering the buffer to release it later.
+  a0_alloc_t recording() {
+    return {
+        .user_data = this,
+        .alloc = [](void* user_data, size_t size, a0_buf_t* out) {
+          auto* self = (BenchAlloc*)user_data;
+          a0_err_t err = a0_alloc(self->alloc, size, out);
+          self->last = *out;
+          return err;
+        },
+        .dealloc = nullptr,
+    };
+  }
+
+  BenchAllocKind kind;
+  a0_alloc_t alloc;
+  a0_buf_t last;
+  a0_alloc_pool_t pool;
+  a0_alloc_ring_t ring;
+  a0_alloc_bump_t bump;
+};
+
+// Fills the bench file with num_msgs packets, as a writer would.
+static void bench_fill(int msg_size, int num_msgs, a0_file_t* file) {
+  a0_file_options_t opts = A0_FILE_OPTIONS_DEFAULT;
+  opts.create_options.size = (off_t)num_msgs * (msg_size + kDeserializeSlack);
+  a0_file_remove(BENCH_FILE);
+  a0_file_open(BENCH_FILE, &opts, file);
+
+  a0_writer_t writer;
+  a0_writer_init(&writer, file->arena);
+  std::string payload(msg_size, 0);
+  for (int i = 0; i < num_msgs; i++) {
+    a0_packet_t pkt;
+    a0_packet_init(&pkt);
+    pkt.payload = {(uint8_t*)payload.data(), payload.size()};
+    a0_writer_write(&writer, pkt);
+  }
+  a0_writer_close(&writer);
+}
+
+// Each iteration deserializes a packet, as a reader does, then releases it.
+bench_fn_t bench_a0_deserialize(std::string name, BenchAllocKind kind, int msg_size) {
+  return [name, kind, msg_size](picobench::state& s) {
+    std::string payload(msg_size, 0);
+    a0_packet_t pkt;
+    a0_packet_init(&pkt);
+    pkt.payload = {(uint8_t*)payload.data(), payload.size()};
+    a0_flat_packet_t fpkt;
+    a0_packet_serialize(pkt, BenchAlloc(BENCH_ALLOC_MALLOC, 0).alloc, &fpkt);
+
+    BenchAlloc bench_alloc(kind, msg_size);
+    size_t start = heap_allocs.load();
+    for (auto&& _ : s) {
+      use(_);
+      a0_packet_t out;
+      a0_buf_t buf;
+      a0_packet_deserialize(fpkt, bench_alloc.alloc, &out, &buf);
+      use(out);
+      a0_dealloc(bench_alloc.alloc, buf);
+    }
+    allocs_per_msg[name] = (double)(heap_allocs.load() - start) / s.iterations();
+
+    free(fpkt.buf.data);
+  };
+}
+
+// Each iteration reads a packet from a sync reader, then releases it.
+bench_fn_t bench_a0_reader_sync(std::string name, BenchAllocKind kind, int msg_size) {
+  return [name, kind, msg_size](picobench::state& s) {
+    a0_file_t file;
+    bench_fill(msg_size, s.iterations(), &file);
+
+    BenchAlloc bench_alloc(kind, msg_size);
+    a0_reader_options_t opts = A0_READER_OPTIONS_DEFAULT;
+    opts.init = A0_INIT_OLDEST;
+    a0_reader_sync_t reader;
+    a0_reader_sync_init(&reader, file.arena, bench_alloc.recording(), opts);
+
+    size_t start = heap_allocs.load();
+    for (auto&& _ : s) {
+      use(_);
+      a0_packet_t pkt;
+      a0_reader_sync_read(&reader, &pkt);
+      use(pkt);
+      a0_dealloc(bench_alloc.alloc, bench_alloc.last);
+    }
+    allocs_per_msg[name] = (double)(heap_allocs.load() - start) / s.iterations();
+
+    a0_reader_sync_close(&reader);
+    a0_file_close(&file);
+    a0_file_remove(BENCH_FILE);
+  };
+}
+
+// Each iteration reads a packet through the C++ ReaderSync, which takes its
+// buffers from a pool. The Packet itself is one allocation.
+bench_fn_t bench_cpp_reader_sync(std::string name, int msg_size) {
+  return [name, msg_size](picobench::state& s) {
+    a0_file_t file;
+    bench_fill(msg_size, s.iterations(), &file);
+
+    {
+      a0::ReaderSync reader(a0::File(BENCH_FILE), a0::INIT_OLDEST);
+      size_t start = heap_allocs.load();
+      for (auto&& _ : s) {
+        use(_);
+        use(reader.read());
+      }
+      allocs_per_msg[name] = (double)(heap_allocs.load() - start) / s.iterations();
+    }
+
+    a0_file_close(&file);
+    a0_file_remove(BENCH_FILE);
+  };
+}
+
+static void print_allocs_per_msg() {
+  for (auto&& elem : allocs_per_msg) {
+    printf("%-24s %.2f heap allocs/msg\n", elem.first.c_str(), elem.second);
+  }
+  printf("\n");
+  allocs_per_msg.clear();
+}
+
 int main() {
   struct suite {
     std::string name;
@@ -208,4 +564,56 @@ int main() {
 
     r.run();
   }
+
+  picobench::runner r;
+  r.set_suite("large msg evicting small msgs");
+  r.add_benchmark("64B msgs, 64kB msg", bench_a0_evict(64, 64 * 1024)).iterations({(int)1e3});
+  r.add_benchmark("64B msgs, 1MB msg", bench_a0_evict(64, 1024 * 1024)).iterations({100});
+  r.add_benchmark("1kB msgs, 1MB msg", bench_a0_evict(1024, 1024 * 1024)).iterations({(int)1e3});
+  r.run();
+
+  picobench::runner scan_r;
+  scan_r.set_suite("full arena scan, 256MB arena, 1kB msgs");
+  scan_r.add_benchmark("4kB pages", bench_a0_scan(256 * 1024 * 1024, 1024, false)).iterations({20});
+  scan_r.add_benchmark("huge pages", bench_a0_scan(256 * 1024 * 1024, 1024, true)).iterations({20});
+  scan_r.run();
+
+  picobench::runner hdr_r;
+  hdr_r.set_suite("header contention, 3 readers polling cnd");
+  hdr_r.add_benchmark("0.3 layout", bench_a0_hdr_contention(kHdrLayout03, 3)).iterations({(int)1e6});
+  hdr_r.add_benchmark("0.4 layout", bench_a0_hdr_contention(kHdrLayout04, 3)).iterations({(int)1e6});
+  hdr_r.run();
+
+  struct alloc_suite {
+    std::string name;
+    BenchAllocKind kind;
+  };
+  std::vector<alloc_suite> alloc_suites;
+  alloc_suites.push_back({"malloc", BENCH_ALLOC_MALLOC});
+  alloc_suites.push_back({"pool", BENCH_ALLOC_POOL});
+  alloc_suites.push_back({"ring", BENCH_ALLOC_RING});
+  alloc_suites.push_back({"bump", BENCH_ALLOC_BUMP});
+
+  for (int msg_size : {64, 1024}) {
+    picobench::runner alloc_r;
+    auto alloc_group = std::to_string(msg_size) + "B msgs : reader allocators";
+    alloc_r.set_suite(alloc_group.c_str());
+    // The runner keeps the names by pointer.
+    std::vector<std::string> names;
+    names.reserve(2 * alloc_suites.size());
+    for (auto&& alloc_suite : alloc_suites) {
+      names.push_back("deserialize " + alloc_suite.name);
+      alloc_r.add_benchmark(names.back().c_str(), bench_a0_deserialize(names.back(), alloc_suite.kind, msg_size))
+          .iterations({(int)1e6});
+    }
+    for (auto&& alloc_suite : alloc_suites) {
+      names.push_back("reader_sync " + alloc_suite.name);
+      alloc_r.add_benchmark(names.back().c_str(), bench_a0_reader_sync(names.back(), alloc_suite.kind, msg_size))
+          .iterations({(int)1e4});
+    }
+    alloc_r.add_benchmark("cpp ReaderSync", bench_cpp_reader_sync("cpp ReaderSync", msg_size))
+        .iterations({(int)1e4});
+    alloc_r.run();
+    print_allocs_per_msg();
+  }
 }
@@ -1,9 +1,27 @@
 #pragma once
 
+#include <a0/cursor.h>
+#include <a0/cursor.hpp>
+#include <a0/executor.h>
+#include <a0/executor.hpp>
 #include <a0/file.h>
 #include <a0/file.hpp>
 #include <a0/reader.h>
 #include <a0/reader.hpp>
+#include <a0/thread_attr.h>
+#include <a0/thread_attr.hpp>
+#include <a0/time.h>
+#include <a0/time.hpp>
+#include <a0/transport.h>
+#include <a0/transport.hpp>
+#include <a0/writer.h>
+#include <a0/writer.hpp>
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "c_wrap.hpp"
 
 namespace a0 {
 namespace {  // NOLINT(google-build-namespaces)
@@ -17,16 +35,118 @@ inline a0_file_options_t c_fileopts(File::Options opts) {
       },
       .open_options = {
           .arena_mode = opts.open_options.arena_mode,
+          .huge_pages = opts.open_options.huge_pages,
+          .populate = opts.open_options.populate,
+          .prefault = opts.open_options.prefault,
+          .mlock = opts.open_options.mlock,
+          .max_size = opts.open_options.max_size,
       },
   };
 }
 
-inline a0_reader_options_t c_readeropts(Reader::Options opts) {
+inline a0_transport_options_t c_transportopts(Transport::Options opts) {
+  return a0_transport_options_t{
+      .frame_format = (a0_transport_frame_format_t)opts.frame_format,
+      .slot_size = opts.slot_size,
+      .lease_policy = (a0_transport_lease_policy_t)opts.lease_policy,
+  };
+}
+
+// The result points into attr, which must outlive it.
+inline a0_thread_attr_t c_threadattr(const ThreadAttr& attr) {
+  return a0_thread_attr_t{
+      .cpus = attr.cpus.data(),
+      .num_cpus = attr.cpus.size(),
+      .sched_policy = attr.sched_policy,
+      .sched_priority = attr.sched_priority,
+      .stack_size = attr.stack_size,
+      .name = attr.name.empty() ? nullptr : attr.name.c_str(),
+  };
+}
+
+inline ThreadAttr cpp_threadattr(a0_thread_attr_t c_attr) {
+  ThreadAttr attr;
+  attr.cpus.assign(c_attr.cpus, c_attr.cpus + c_attr.num_cpus);
+  attr.sched_policy = c_attr.sched_policy;
+  attr.sched_priority = c_attr.sched_priority;
+  attr.stack_size = c_attr.stack_size;
+  attr.name = c_attr.name ? c_attr.name : "";
+  return attr;
+}
+
+// The result points into opts, which must outlive it.
+inline a0_reader_options_t c_readeropts(const Reader::Options& opts) {
   return {
       .init = (a0_reader_init_t)opts.init,
       .iter = (a0_reader_iter_t)opts.iter,
+      .optimistic = opts.optimistic,
+      .seq = opts.seq,
+      .time = opts.time.c ? *opts.time.c : a0_time_mono_t{},
+      .spin_ns = opts.spin_ns,
+      .lease = opts.lease,
+      // The reader must keep opts.filter alive.
+      .filter = opts.filter.c ? *opts.filter.c : a0_reader_filter_t{nullptr, 0, false},
+      // The reader must keep opts.executor alive.
+      .executor = opts.executor.c.get(),
+      .thread_attr = c_threadattr(opts.thread_attr),
+      // The reader must keep opts.lag alive.
+      .lag = opts.lag.c ? *opts.lag.c : a0_reader_lag_threshold_t{0, 0, 0, {nullptr, nullptr}},
+      // Copied by the reader.
+      .conflate_key = opts.conflate_key.empty() ? nullptr : opts.conflate_key.c_str(),
+      // The reader must keep opts.cursor alive.
+      .cursor = opts.cursor.c ? *opts.cursor.c : a0_cursor_t{nullptr},
   };
 }
 
+inline Reader::Filter cpp_readerfilter(a0_reader_filter_t c_filter) {
+  if (!c_filter.num_clauses) {
+    return Reader::Filter();
+  }
+  std::vector<Reader::Filter::Clause> clauses;
+  for (size_t i = 0; i < c_filter.num_clauses; i++) {
+    const a0_reader_filter_clause_t& clause = c_filter.clauses[i];
+    clauses.push_back({(Reader::Filter::Op)clause.op, clause.key, clause.val ? clause.val : ""});
+  }
+  return Reader::Filter(std::move(clauses), c_filter.any);
+}
+
+inline Reader::LagThreshold cpp_readerlag(a0_reader_lag_threshold_t c_lag) {
+  if (!c_lag.onlag.fn) {
+    return Reader::LagThreshold();
+  }
+  return Reader::LagThreshold(c_lag.frames, c_lag.bytes, c_lag.ns, [c_lag](Reader::Stats stats) {
+    c_lag.onlag.fn(c_lag.onlag.user_data, stats);
+  });
+}
+
+inline Reader::Options cpp_readeropts(a0_reader_options_t c_opts) {
+  // Every field is set explicitly. This is used to initialize DEFAULT.
+  Reader::Options opts((Reader::Init)c_opts.init, (Reader::Iter)c_opts.iter);
+  opts.optimistic = c_opts.optimistic;
+  opts.seq = c_opts.seq;
+  opts.time = cpp_wrap<TimeMono>(c_opts.time);
+  opts.spin_ns = c_opts.spin_ns;
+  opts.lease = c_opts.lease;
+  opts.filter = cpp_readerfilter(c_opts.filter);
+  opts.executor = c_opts.executor ? cpp_wrap<Executor>(c_opts.executor) : Executor();
+  opts.thread_attr = cpp_threadattr(c_opts.thread_attr);
+  opts.lag = cpp_readerlag(c_opts.lag);
+  opts.conflate_key = c_opts.conflate_key ? c_opts.conflate_key : "";
+  opts.cursor = c_opts.cursor._seq ? cpp_wrap<Cursor>(c_opts.cursor) : Cursor();
+  return opts;
+}
+
+inline a0_writer_options_t c_writeropts(Writer::Options opts) {
+  return a0_writer_options_t{
+      .staged = opts.staged,
+  };
+}
+
+inline Writer::Options cpp_writeropts(a0_writer_options_t c_opts) {
+  Writer::Options opts;
+  opts.staged = c_opts.staged;
+  return opts;
+}
+
 }  // namespace
 }  // namespace a0
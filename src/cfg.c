@@ -48,8 +48,12 @@ a0_err_t a0_cfg_close(a0_cfg_t* cfg) {
 a0_err_t a0_cfg_read(a0_cfg_t* cfg,
                      a0_alloc_t alloc,
                      a0_packet_t* out) {
+  a0_reader_options_t opts = A0_READER_OPTIONS_DEFAULT;
+  opts.init = A0_INIT_MOST_RECENT;
+  opts.iter = A0_ITER_NEXT;
+
   a0_reader_sync_t reader_sync;
-  A0_RETURN_ERR_ON_ERR(a0_reader_sync_init(&reader_sync, cfg->_file.arena, alloc, (a0_reader_options_t){A0_INIT_MOST_RECENT, A0_ITER_NEXT}));
+  A0_RETURN_ERR_ON_ERR(a0_reader_sync_init(&reader_sync, cfg->_file.arena, alloc, opts));
   a0_err_t err = a0_reader_sync_read(&reader_sync, out);
   a0_reader_sync_close(&reader_sync);
   return err;
@@ -65,8 +69,12 @@ a0_err_t a0_cfg_read_blocking_timeout(a0_cfg_t* cfg,
                                       a0_alloc_t alloc,
                                       a0_time_mono_t* timeout,
                                       a0_packet_t* out) {
+  a0_reader_options_t opts = A0_READER_OPTIONS_DEFAULT;
+  opts.init = A0_INIT_MOST_RECENT;
+  opts.iter = A0_ITER_NEXT;
+
   a0_reader_sync_t reader_sync;
-  A0_RETURN_ERR_ON_ERR(a0_reader_sync_init(&reader_sync, cfg->_file.arena, alloc, (a0_reader_options_t){A0_INIT_MOST_RECENT, A0_ITER_NEXT}));
+  A0_RETURN_ERR_ON_ERR(a0_reader_sync_init(&reader_sync, cfg->_file.arena, alloc, opts));
   a0_err_t err = a0_reader_sync_read_blocking_timeout(&reader_sync, timeout, out);
   a0_reader_sync_close(&reader_sync);
   return err;
@@ -112,11 +120,15 @@ a0_err_t a0_cfg_watcher_init(a0_cfg_watcher_t* cw,
                              a0_packet_callback_t onpacket) {
   A0_RETURN_ERR_ON_ERR(a0_cfg_topic_open(topic, &cw->_file));
 
+  a0_reader_options_t opts = A0_READER_OPTIONS_DEFAULT;
+  opts.init = A0_INIT_MOST_RECENT;
+  opts.iter = A0_ITER_NEWEST;
+
   a0_err_t err = a0_reader_init(
       &cw->_reader,
       cw->_file.arena,
       alloc,
-      (a0_reader_options_t){A0_INIT_MOST_RECENT, A0_ITER_NEWEST},
+      opts,
       onpacket);
   if (err) {
     a0_file_close(&cw->_file);
@@ -19,6 +19,8 @@
 
 #include "c_opts.hpp"
 #include "c_wrap.hpp"
+#include "err_macro.h"
+#include "packet_pool.hpp"
 
 #ifdef A0_EXT_NLOHMANN
 
@@ -134,7 +136,8 @@ void Cfg::update_var() {
 namespace {
 
 struct CfgWatcherImpl {
-  std::vector<uint8_t> data;
+  // Buffer of the packet being delivered.
+  a0_buf_t buf;
   std::function<void(Packet)> onpacket;
 
 #ifdef A0_EXT_NLOHMANN
@@ -161,8 +164,8 @@ CfgWatcher::CfgWatcher(
             .user_data = impl,
             .alloc = [](void* user_data, size_t size, a0_buf_t* out) {
               auto* impl = (CfgWatcherImpl*)user_data;
-              impl->data.resize(size);
-              *out = {impl->data.data(), size};
+              A0_RETURN_ERR_ON_ERR(a0_alloc(packet_pool(), size, out));
+              impl->buf = *out;
               return A0_OK;
             },
             .dealloc = nullptr,
@@ -172,9 +175,7 @@ CfgWatcher::CfgWatcher(
             .user_data = impl,
             .fn = [](void* user_data, a0_packet_t pkt) {
               auto* impl = (CfgWatcherImpl*)user_data;
-              auto data = std::make_shared<std::vector<uint8_t>>();
-              std::swap(*data, impl->data);
-              impl->onpacket(Packet(pkt, [data](a0_packet_t*) {}));
+              impl->onpacket(pooled_packet(pkt, impl->buf));
             }};
 
         return a0_cfg_watcher_init(c, c_topic, alloc, c_onpacket);
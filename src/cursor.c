@@ -0,0 +1,145 @@
+#include <a0/cursor.h>
+#include <a0/empty.h>
+#include <a0/env.h>
+#include <a0/err.h>
+#include <a0/file.h>
+#include <a0/inline.h>
+#include <a0/mtx.h>
+#include <a0/topic.h>
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "atomic.h"
+#include "err_macro.h"
+
+// Shared layout. A new file is zero-filled, which is an unlocked mutex and
+// an empty table. An empty name marks a free slot.
+typedef struct a0_cursor_slot_s {
+  char name[A0_CURSOR_NAME_MAX];
+  uint64_t seq;
+  uint8_t _pad[8];
+} a0_cursor_slot_t;
+
+typedef struct a0_cursor_table_hdr_s {
+  a0_mtx_t mtx;
+  uint8_t _pad[64 - sizeof(a0_mtx_t)];
+  a0_cursor_slot_t slots[A0_CURSOR_MAX];
+} a0_cursor_table_hdr_t;
+
+// Slots fill a cache line each, so commits of different readers don't
+// false-share.
+_Static_assert(sizeof(a0_cursor_slot_t) == 64, "Unexpected cursor binary representation.");
+
+A0_STATIC_INLINE
+a0_cursor_table_hdr_t* a0_cursor_table_hdr(a0_cursor_table_t* table) {
+  return (a0_cursor_table_hdr_t*)table->_file.arena.buf.data;
+}
+
+a0_err_t a0_cursor_table_init(a0_cursor_table_t* table, a0_cursor_topic_t topic) {
+  a0_file_options_t opts = A0_FILE_OPTIONS_DEFAULT;
+  opts.create_options.size = sizeof(a0_cursor_table_hdr_t);
+  A0_RETURN_ERR_ON_ERR(a0_topic_open(a0_env_topic_tmpl_cursor(), topic.name, &opts, &table->_file));
+
+  if (table->_file.arena.buf.size < sizeof(a0_cursor_table_hdr_t)) {
+    a0_file_close(&table->_file);
+    return A0_ERR_BAD_TOPIC;
+  }
+  return A0_OK;
+}
+
+a0_err_t a0_cursor_table_close(a0_cursor_table_t* table) {
+  return a0_file_close(&table->_file);
+}
+
+// The table stays consistent if a holder dies, so the lock can be taken over.
+A0_STATIC_INLINE
+a0_err_t a0_cursor_table_lock(a0_cursor_table_hdr_t* hdr) {
+  a0_err_t err = a0_mtx_lock(&hdr->mtx);
+  return a0_mtx_lock_successful(err) ? A0_OK : err;
+}
+
+A0_STATIC_INLINE
+a0_cursor_slot_t* a0_cursor_find(a0_cursor_table_hdr_t* hdr, const char* name) {
+  for (size_t i = 0; i < A0_CURSOR_MAX; i++) {
+    if (!strncmp(hdr->slots[i].name, name, A0_CURSOR_NAME_MAX)) {
+      return &hdr->slots[i];
+    }
+  }
+  return NULL;
+}
+
+a0_err_t a0_cursor_open(a0_cursor_table_t* table, const char* name, a0_cursor_t* out) {
+  size_t len = strlen(name);
+  if (!len || len >= A0_CURSOR_NAME_MAX) {
+    return A0_ERR_INVALID_ARG;
+  }
+
+  a0_cursor_table_hdr_t* hdr = a0_cursor_table_hdr(table);
+  A0_RETURN_ERR_ON_ERR(a0_cursor_table_lock(hdr));
+
+  a0_cursor_slot_t* slot = a0_cursor_find(hdr, name);
+  if (!slot) {
+    // Claim a free slot. It starts with no position.
+    slot = a0_cursor_find(hdr, "");
+    if (slot) {
+      a0_atomic_store(&slot->seq, 0);
+      memcpy(slot->name, name, len + 1);
+    }
+  }
+
+  a0_mtx_unlock(&hdr->mtx);
+
+  if (!slot) {
+    return A0_MAKE_SYSERR(ENOSPC);
+  }
+  *out = (a0_cursor_t){&slot->seq};
+  return A0_OK;
+}
+
+a0_err_t a0_cursor_remove(a0_cursor_table_t* table, const char* name) {
+  if (!*name) {
+    return A0_ERR_INVALID_ARG;
+  }
+
+  a0_cursor_table_hdr_t* hdr = a0_cursor_table_hdr(table);
+  A0_RETURN_ERR_ON_ERR(a0_cursor_table_lock(hdr));
+
+  a0_cursor_slot_t* slot = a0_cursor_find(hdr, name);
+  if (slot) {
+    memset(slot->name, 0, sizeof(slot->name));
+  }
+
+  a0_mtx_unlock(&hdr->mtx);
+  return slot ? A0_OK : A0_ERR_NOT_FOUND;
+}
+
+a0_err_t a0_cursor_table_list(a0_cursor_table_t* table, a0_cursor_info_t out[A0_CURSOR_MAX], size_t* out_cnt) {
+  a0_cursor_table_hdr_t* hdr = a0_cursor_table_hdr(table);
+  A0_RETURN_ERR_ON_ERR(a0_cursor_table_lock(hdr));
+
+  *out_cnt = 0;
+  for (size_t i = 0; i < A0_CURSOR_MAX; i++) {
+    a0_cursor_slot_t* slot = &hdr->slots[i];
+    if (slot->name[0]) {
+      a0_cursor_info_t* info = &out[(*out_cnt)++];
+      memcpy(info->name, slot->name, sizeof(info->name));
+      info->seq = a0_atomic_load(&slot->seq);
+    }
+  }
+
+  a0_mtx_unlock(&hdr->mtx);
+  return A0_OK;
+}
+
+a0_err_t a0_cursor_commit(a0_cursor_t cursor, uint64_t seq) {
+  a0_atomic_store(cursor._seq, seq);
+  return A0_OK;
+}
+
+a0_err_t a0_cursor_load(a0_cursor_t cursor, uint64_t* seq) {
+  *seq = a0_atomic_load(cursor._seq);
+  return A0_OK;
+}
@@ -0,0 +1,68 @@
+#include <a0/cursor.h>
+#include <a0/cursor.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "c_wrap.hpp"
+
+namespace a0 {
+
+void Cursor::commit(uint64_t seq) {
+  CHECK_C;
+  check(a0_cursor_commit(*c, seq));
+}
+
+uint64_t Cursor::load() {
+  CHECK_C;
+  uint64_t seq;
+  check(a0_cursor_load(*c, &seq));
+  return seq;
+}
+
+CursorTable::CursorTable(CursorTopic topic) {
+  set_c(
+      &c,
+      [&](a0_cursor_table_t* c) {
+        a0_cursor_topic_t c_topic{topic.name.c_str()};
+        return a0_cursor_table_init(c, c_topic);
+      },
+      a0_cursor_table_close);
+}
+
+Cursor CursorTable::open(const std::string& name) {
+  CHECK_C;
+  a0_cursor_t c_cursor;
+  check(a0_cursor_open(&*c, name.c_str(), &c_cursor));
+
+  // The cursor points into the table.
+  auto table = c;
+  Cursor cursor;
+  cursor.c = std::shared_ptr<a0_cursor_t>(new a0_cursor_t(c_cursor), [table](a0_cursor_t* c_cursor) {
+    delete c_cursor;
+  });
+  return cursor;
+}
+
+void CursorTable::remove(const std::string& name) {
+  CHECK_C;
+  check(a0_cursor_remove(&*c, name.c_str()));
+}
+
+std::map<std::string, uint64_t> CursorTable::list() {
+  CHECK_C;
+  a0_cursor_info_t infos[A0_CURSOR_MAX];
+  size_t cnt;
+  check(a0_cursor_table_list(&*c, infos, &cnt));
+
+  std::map<std::string, uint64_t> cursors;
+  for (size_t i = 0; i < cnt; i++) {
+    cursors[infos[i].name] = infos[i].seq;
+  }
+  return cursors;
+}
+
+}  // namespace a0
@@ -18,6 +18,9 @@ const char* a0_env_topic() {
 const char* a0_env_topic_tmpl_cfg() {
   return envdef("A0_TOPIC_TMPL_CFG", "{topic}.cfg.a0");
 }
+const char* a0_env_topic_tmpl_cursor() {
+  return envdef("A0_TOPIC_TMPL_CURSOR", "{topic}.cursor");
+}
 const char* a0_env_topic_tmpl_deadman() {
   return envdef("A0_TOPIC_TMPL_DEADMAN", "{topic}.deadman");
 }
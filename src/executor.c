@@ -0,0 +1,364 @@
+#include <a0/callback.h>
+#include <a0/empty.h>
+#include <a0/err.h>
+#include <a0/executor.h>
+#include <a0/inline.h>
+#include <a0/thread_local.h>
+#include <a0/tid.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "atomic.h"
+#include "err_macro.h"
+
+// Tasks a strand may run before yielding its worker to other strands.
+#define A0_EXECUTOR_BURST 16
+
+struct a0_executor_worker_s {
+  a0_executor_t* executor;
+  size_t idx;
+  pthread_t thread;
+
+  // Ring of strands waiting to run.
+  // The owner takes from the front. Thieves take from the back.
+  pthread_mutex_t mu;
+  a0_executor_strand_t** ring;
+  size_t head;
+  size_t cnt;
+  size_t cap;
+};
+
+// Worker running on this thread, if any.
+static A0_THREAD_LOCAL a0_executor_worker_t* a0_executor_current_worker = NULL;
+
+A0_STATIC_INLINE
+bool a0_executor_on_worker(a0_executor_t* ex) {
+  return a0_executor_current_worker && a0_executor_current_worker->executor == ex;
+}
+
+A0_STATIC_INLINE
+void a0_executor_worker_push(a0_executor_worker_t* w, a0_executor_strand_t* strand) {
+  pthread_mutex_lock(&w->mu);
+  if (w->cnt == w->cap) {
+    size_t cap = w->cap ? 2 * w->cap : 16;
+    a0_executor_strand_t** ring = (a0_executor_strand_t**)malloc(cap * sizeof(a0_executor_strand_t*));
+    for (size_t i = 0; i < w->cnt; i++) {
+      ring[i] = w->ring[(w->head + i) % w->cap];
+    }
+    free(w->ring);
+    w->ring = ring;
+    w->head = 0;
+    w->cap = cap;
+  }
+  w->ring[(w->head + w->cnt) % w->cap] = strand;
+  w->cnt++;
+  pthread_mutex_unlock(&w->mu);
+}
+
+A0_STATIC_INLINE
+a0_executor_strand_t* a0_executor_worker_pop(a0_executor_worker_t* w) {
+  a0_executor_strand_t* strand = NULL;
+  pthread_mutex_lock(&w->mu);
+  if (w->cnt) {
+    strand = w->ring[w->head];
+    w->head = (w->head + 1) % w->cap;
+    w->cnt--;
+  }
+  pthread_mutex_unlock(&w->mu);
+  return strand;
+}
+
+A0_STATIC_INLINE
+a0_executor_strand_t* a0_executor_worker_steal(a0_executor_worker_t* w) {
+  a0_executor_strand_t* strand = NULL;
+  pthread_mutex_lock(&w->mu);
+  if (w->cnt) {
+    w->cnt--;
+    strand = w->ring[(w->head + w->cnt) % w->cap];
+  }
+  pthread_mutex_unlock(&w->mu);
+  return strand;
+}
+
+A0_STATIC_INLINE
+void a0_executor_schedule(a0_executor_t* ex, a0_executor_strand_t* strand) {
+  // Work posted from a worker stays local, until someone steals it.
+  a0_executor_worker_t* w = a0_executor_current_worker;
+  if (!a0_executor_on_worker(ex)) {
+    w = &ex->_workers[a0_atomic_fetch_add(&ex->_next_worker, 1) % ex->_num_workers];
+  }
+
+  a0_atomic_add_fetch(&ex->_pending, 1);
+  a0_executor_worker_push(w, strand);
+
+  // Pairs with the barrier in a0_executor_worker_main.
+  // Either the idle worker sees the pending strand, or we see the idle worker.
+  a0_barrier();
+  if (a0_atomic_load(&ex->_idle_cnt)) {
+    pthread_mutex_lock(&ex->_mu);
+    pthread_cond_signal(&ex->_cnd);
+    pthread_mutex_unlock(&ex->_mu);
+  }
+}
+
+A0_STATIC_INLINE
+void a0_executor_run_strand(a0_executor_strand_t* strand) {
+  a0_executor_t* ex = strand->_executor;
+  const uint32_t tid = a0_tid();
+
+  pthread_mutex_lock(&strand->_mu);
+  for (size_t i = 0; strand->_head && i < A0_EXECUTOR_BURST; i++) {
+    a0_executor_task_t* task = strand->_head;
+    strand->_head = task->_next;
+    if (!strand->_head) {
+      strand->_tail = NULL;
+    }
+    strand->_runner = tid;
+    pthread_mutex_unlock(&strand->_mu);
+
+    a0_callback_call(task->callback);
+
+    pthread_mutex_lock(&strand->_mu);
+    strand->_runner = 0;
+  }
+
+  if (!strand->_head) {
+    // The strand may be freed as soon as it's unlocked.
+    strand->_scheduled = false;
+    pthread_cond_broadcast(&strand->_cnd);
+    pthread_mutex_unlock(&strand->_mu);
+    return;
+  }
+  pthread_mutex_unlock(&strand->_mu);
+
+  // Still busy. Requeue behind the other strands.
+  a0_executor_schedule(ex, strand);
+}
+
+// Runs one strand from this worker's queue, or one stolen from another worker.
+A0_STATIC_INLINE
+bool a0_executor_worker_run_one(a0_executor_worker_t* w) {
+  a0_executor_t* ex = w->executor;
+  a0_executor_strand_t* strand = a0_executor_worker_pop(w);
+  for (size_t i = 1; !strand && i < ex->_num_workers; i++) {
+    strand = a0_executor_worker_steal(&ex->_workers[(w->idx + i) % ex->_num_workers]);
+  }
+  if (!strand) {
+    return false;
+  }
+
+  a0_atomic_add_fetch(&ex->_pending, -1);
+  a0_executor_run_strand(strand);
+  return true;
+}
+
+A0_STATIC_INLINE
+void* a0_executor_worker_main(void* data) {
+  a0_executor_worker_t* w = (a0_executor_worker_t*)data;
+  a0_executor_t* ex = w->executor;
+  a0_executor_current_worker = w;
+
+  while (true) {
+    if (a0_executor_worker_run_one(w)) {
+      continue;
+    }
+
+    pthread_mutex_lock(&ex->_mu);
+    a0_atomic_add_fetch(&ex->_idle_cnt, 1);
+    a0_barrier();
+    bool done = false;
+    if (!a0_atomic_load(&ex->_pending)) {
+      if (ex->_shutdown) {
+        done = true;
+      } else {
+        pthread_cond_wait(&ex->_cnd, &ex->_mu);
+      }
+    }
+    a0_atomic_add_fetch(&ex->_idle_cnt, -1);
+    pthread_mutex_unlock(&ex->_mu);
+
+    if (done) {
+      break;
+    }
+  }
+
+  a0_executor_current_worker = NULL;
+  return NULL;
+}
+
+A0_STATIC_INLINE
+void a0_executor_join(a0_executor_t* ex, size_t started) {
+  pthread_mutex_lock(&ex->_mu);
+  ex->_shutdown = true;
+  pthread_cond_broadcast(&ex->_cnd);
+  pthread_mutex_unlock(&ex->_mu);
+
+  for (size_t i = 0; i < started; i++) {
+    pthread_join(ex->_workers[i].thread, NULL);
+  }
+  for (size_t i = 0; i < ex->_num_workers; i++) {
+    pthread_mutex_destroy(&ex->_workers[i].mu);
+    free(ex->_workers[i].ring);
+  }
+  free(ex->_workers);
+  ex->_workers = NULL;
+
+  pthread_cond_destroy(&ex->_cnd);
+  pthread_mutex_destroy(&ex->_mu);
+}
+
+a0_err_t a0_executor_init(a0_executor_t* ex, size_t num_threads) {
+  if (!num_threads) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    num_threads = cpus > 0 ? (size_t)cpus : 1;
+  }
+
+  *ex = (a0_executor_t)A0_EMPTY;
+  ex->_workers = (a0_executor_worker_t*)calloc(num_threads, sizeof(a0_executor_worker_t));
+  if (!ex->_workers) {
+    return A0_MAKE_SYSERR(ENOMEM);
+  }
+  ex->_num_workers = num_threads;
+  pthread_mutex_init(&ex->_mu, NULL);
+  pthread_cond_init(&ex->_cnd, NULL);
+
+  for (size_t i = 0; i < num_threads; i++) {
+    ex->_workers[i].executor = ex;
+    ex->_workers[i].idx = i;
+    pthread_mutex_init(&ex->_workers[i].mu, NULL);
+  }
+
+  for (size_t i = 0; i < num_threads; i++) {
+    int err = pthread_create(&ex->_workers[i].thread, NULL, a0_executor_worker_main, &ex->_workers[i]);
+    if (err) {
+      a0_executor_join(ex, i);
+      return A0_MAKE_SYSERR(err);
+    }
+  }
+
+  return A0_OK;
+}
+
+a0_err_t a0_executor_close(a0_executor_t* ex) {
+  if (a0_executor_on_worker(ex)) {
+    return A0_MAKE_SYSERR(EDEADLK);
+  }
+
+  pthread_mutex_lock(&ex->_mu);
+  bool busy = ex->_strand_cnt;
+  pthread_mutex_unlock(&ex->_mu);
+  if (busy) {
+    return A0_MAKE_SYSERR(EBUSY);
+  }
+
+  a0_executor_join(ex, ex->_num_workers);
+  return A0_OK;
+}
+
+a0_err_t a0_executor_strand_init(a0_executor_strand_t* strand, a0_executor_t* ex) {
+  *strand = (a0_executor_strand_t)A0_EMPTY;
+  strand->_executor = ex;
+  pthread_mutex_init(&strand->_mu, NULL);
+  pthread_cond_init(&strand->_cnd, NULL);
+
+  pthread_mutex_lock(&ex->_mu);
+  ex->_strand_cnt++;
+  pthread_mutex_unlock(&ex->_mu);
+
+  return A0_OK;
+}
+
+a0_err_t a0_executor_strand_close(a0_executor_strand_t* strand) {
+  a0_executor_t* ex = strand->_executor;
+  const bool on_worker = a0_executor_on_worker(ex);
+
+  if (a0_executor_strand_in_task(strand)) {
+    return A0_MAKE_SYSERR(EDEADLK);
+  }
+
+  pthread_mutex_lock(&strand->_mu);
+  while (strand->_scheduled) {
+    if (!on_worker) {
+      pthread_cond_wait(&strand->_cnd, &strand->_mu);
+      continue;
+    }
+    // The strand may be queued behind us, on this very worker. Help out, rather than wait.
+    pthread_mutex_unlock(&strand->_mu);
+    if (!a0_executor_worker_run_one(a0_executor_current_worker)) {
+      sched_yield();
+    }
+    pthread_mutex_lock(&strand->_mu);
+  }
+  pthread_mutex_unlock(&strand->_mu);
+
+  pthread_cond_destroy(&strand->_cnd);
+  pthread_mutex_destroy(&strand->_mu);
+
+  pthread_mutex_lock(&ex->_mu);
+  ex->_strand_cnt--;
+  pthread_mutex_unlock(&ex->_mu);
+
+  *strand = (a0_executor_strand_t)A0_EMPTY;
+  return A0_OK;
+}
+
+bool a0_executor_strand_in_task(a0_executor_strand_t* strand) {
+  pthread_mutex_lock(&strand->_mu);
+  bool in_task = strand->_runner == a0_tid();
+  pthread_mutex_unlock(&strand->_mu);
+  return in_task;
+}
+
+a0_err_t a0_executor_post_task(a0_executor_strand_t* strand, a0_executor_task_t* task) {
+  task->_next = NULL;
+
+  pthread_mutex_lock(&strand->_mu);
+  if (strand->_tail) {
+    strand->_tail->_next = task;
+  } else {
+    strand->_head = task;
+  }
+  strand->_tail = task;
+
+  const bool schedule = !strand->_scheduled;
+  strand->_scheduled = true;
+  pthread_mutex_unlock(&strand->_mu);
+
+  if (schedule) {
+    a0_executor_schedule(strand->_executor, strand);
+  }
+  return A0_OK;
+}
+
+typedef struct a0_executor_owned_task_s {
+  a0_executor_task_t task;
+  a0_callback_t callback;
+} a0_executor_owned_task_t;
+
+A0_STATIC_INLINE
+a0_err_t a0_executor_owned_task_run(void* user_data) {
+  a0_executor_owned_task_t* owned = (a0_executor_owned_task_t*)user_data;
+  a0_err_t err = a0_callback_call(owned->callback);
+  free(owned);
+  return err;
+}
+
+a0_err_t a0_executor_post(a0_executor_strand_t* strand, a0_callback_t callback) {
+  a0_executor_owned_task_t* owned = (a0_executor_owned_task_t*)malloc(sizeof(a0_executor_owned_task_t));
+  if (!owned) {
+    return A0_MAKE_SYSERR(ENOMEM);
+  }
+  owned->callback = callback;
+  owned->task.callback = (a0_callback_t){
+      .user_data = owned,
+      .fn = a0_executor_owned_task_run,
+  };
+  return a0_executor_post_task(strand, &owned->task);
+}
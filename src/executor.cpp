@@ -0,0 +1,19 @@
+#include <a0/executor.h>
+#include <a0/executor.hpp>
+
+#include <cstddef>
+
+#include "c_wrap.hpp"
+
+namespace a0 {
+
+Executor::Executor(size_t num_threads) {
+  set_c(
+      &c,
+      [&](a0_executor_t* c) {
+        return a0_executor_init(c, num_threads);
+      },
+      a0_executor_close);
+}
+
+}  // namespace a0
@@ -11,6 +11,7 @@
 #include <fcntl.h>
 #include <libgen.h>
 #include <limits.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -18,9 +19,11 @@
 #include <string.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/vfs.h>
 #include <unistd.h>
 
 #include "err_macro.h"
+#include "file_map.h"
 
 #ifdef DEBUG
 #include "ref_cnt.h"
@@ -122,6 +125,21 @@ a0_err_t a0_open(const char* path, a0_file_open_options_t opts, a0_file_t* file)
   return err;
 }
 
+#ifndef HUGETLBFS_MAGIC
+#define HUGETLBFS_MAGIC 0x958458f6
+#endif
+
+// Files on hugetlbfs must be sized in whole huge pages.
+A0_STATIC_INLINE
+off_t a0_fit_size(int fd, off_t size) {
+  struct statfs fs;
+  if (fstatfs(fd, &fs) == -1 || fs.f_type != HUGETLBFS_MAGIC || fs.f_bsize <= 0) {
+    return size;
+  }
+  off_t page = fs.f_bsize;
+  return (size + page - 1) / page * page;
+}
+
 A0_STATIC_INLINE
 a0_err_t a0_mktmp(const char* dir, a0_file_create_options_t opts, a0_file_t* file) {
   char* path;
@@ -137,7 +155,7 @@ a0_err_t a0_mktmp(const char* dir, a0_file_create_options_t opts, a0_file_t* fil
   file->path = path;
 
   if (fchmod(file->fd, opts.mode) == -1 ||
-      ftruncate(file->fd, opts.size) == -1 ||
+      ftruncate(file->fd, a0_fit_size(file->fd, opts.size)) == -1 ||
       fstat(file->fd, &file->stat) == -1) {
     a0_err_t err = A0_MAKE_SYSERR(errno);
 
@@ -165,38 +183,242 @@ a0_err_t a0_tmp_move(a0_file_t* file, const char* path) {
   return err;
 }
 
+// Faults in every page of the arena, without changing its contents.
 A0_STATIC_INLINE
-a0_err_t a0_mmap(a0_file_t* file, const a0_file_open_options_t* open_options) {
-  file->arena.mode = open_options->arena_mode;
-  file->arena.buf.size = file->stat.st_size;
+void a0_prefault(a0_arena_t arena, size_t page_size) {
+  for (size_t off = 0; off < arena.buf.size; off += page_size) {
+    uint8_t* ptr = arena.buf.data + off;
+    if (arena.mode == A0_ARENA_MODE_READONLY) {
+      // A write would trigger a private copy of the page.
+      (void)*(volatile uint8_t*)ptr;
+    } else {
+      // Write fault, so the page is mapped writable. Adding zero atomically
+      // is safe against concurrent writers in other processes.
+      __atomic_fetch_add(ptr, 0, __ATOMIC_RELAXED);
+    }
+  }
+}
 
+A0_STATIC_INLINE
+a0_err_t a0_mlock(a0_buf_t buf, a0_file_mlock_t mode) {
+  if (mode == A0_FILE_MLOCK_NOW) {
+    A0_RETURN_SYSERR_ON_MINUS_ONE(mlock(buf.data, buf.size));
+  } else if (mode == A0_FILE_MLOCK_ONFAULT) {
+#ifdef MLOCK_ONFAULT
+    A0_RETURN_SYSERR_ON_MINUS_ONE(mlock2(buf.data, buf.size, MLOCK_ONFAULT));
+#else
+    return A0_MAKE_SYSERR(ENOTSUP);
+#endif
+  }
+  return A0_OK;
+}
+
+// Maps map_size bytes of the file, and applies the open options to the
+// first size bytes, which the file must cover.
+A0_STATIC_INLINE
+a0_err_t a0_mmap_fd(int fd, size_t map_size, size_t size, const a0_file_open_options_t* open_options, uint8_t** out) {
   int mmap_flags = MAP_SHARED;
   if (open_options->arena_mode == A0_ARENA_MODE_READONLY) {
     mmap_flags = MAP_PRIVATE;
   }
+  if (open_options->populate) {
+    mmap_flags |= MAP_POPULATE;
+  }
 
-  file->arena.buf.data = (uint8_t*)mmap(
+  uint8_t* data = (uint8_t*)mmap(
       /* addr   = */ 0,
-      /* len    = */ file->arena.buf.size,
+      /* len    = */ map_size,
       /* prot   = */ PROT_READ | PROT_WRITE,
       /* flags  = */ mmap_flags,
-      /* fd     = */ file->fd,
+      /* fd     = */ fd,
       /* offset = */ 0);
-  if ((intptr_t)file->arena.buf.data == -1) {
-    file->arena.buf = (a0_buf_t)A0_EMPTY;
+  if ((intptr_t)data == -1) {
     return A0_MAKE_SYSERR(errno);
   }
+  a0_arena_t arena = {{data, size}, open_options->arena_mode};
+
+#ifdef MADV_HUGEPAGE
+  if (open_options->huge_pages) {
+    // Best effort. Fails if the kernel lacks transparent huge page support.
+    madvise(arena.buf.data, arena.buf.size, MADV_HUGEPAGE);
+  }
+#endif
+
+  if (open_options->prefault) {
+    a0_prefault(arena, sysconf(_SC_PAGESIZE));
+  }
+
+  a0_err_t err = a0_mlock(arena.buf, open_options->mlock);
+  if (err) {
+    munmap(data, map_size);
+    return err;
+  }
+  *out = data;
+  return A0_OK;
+}
+
+// Every mapping of every open file in the process.
+//
+// A connection that finds the arena grew past its mapping maps the file again,
+// larger. The smaller mappings cannot be unmapped until the file is closed,
+// since other connections, and robust mutex lists, may still point into them.
+typedef struct a0_file_mapping_s {
+  struct a0_file_mapping_s* next;
+  a0_buf_t buf;
+} a0_file_mapping_t;
+
+typedef struct a0_file_mappings_s {
+  struct a0_file_mappings_s* next;
+  int fd;
+  a0_file_open_options_t open_options;
+  // The first mapping is the one made on open.
+  a0_file_mapping_t* head;
+} a0_file_mappings_t;
+
+static pthread_mutex_t a0_file_mappings_mu = PTHREAD_MUTEX_INITIALIZER;
+static a0_file_mappings_t* a0_file_mappings = NULL;
+
+A0_STATIC_INLINE
+a0_err_t a0_file_mappings_add(a0_file_t* file, const a0_file_open_options_t* open_options) {
+  a0_file_mappings_t* mappings = (a0_file_mappings_t*)malloc(sizeof(a0_file_mappings_t));
+  a0_file_mapping_t* mapping = (a0_file_mapping_t*)malloc(sizeof(a0_file_mapping_t));
+  if (!mappings || !mapping) {
+    free(mappings);
+    free(mapping);
+    return A0_MAKE_SYSERR(ENOMEM);
+  }
+  *mapping = (a0_file_mapping_t){NULL, {file->arena.buf.data, file->_map_size}};
+  *mappings = (a0_file_mappings_t){NULL, file->fd, *open_options, mapping};
+
+  pthread_mutex_lock(&a0_file_mappings_mu);
+  mappings->next = a0_file_mappings;
+  a0_file_mappings = mappings;
+  pthread_mutex_unlock(&a0_file_mappings_mu);
+  return A0_OK;
+}
+
+// Unmaps every mapping but the one made on open.
+A0_STATIC_INLINE
+void a0_file_mappings_del(a0_file_t* file) {
+  pthread_mutex_lock(&a0_file_mappings_mu);
+  a0_file_mappings_t** it = &a0_file_mappings;
+  while (*it && (*it)->head->buf.data != file->arena.buf.data) {
+    it = &(*it)->next;
+  }
+  a0_file_mappings_t* mappings = *it;
+  if (mappings) {
+    *it = mappings->next;
+  }
+  pthread_mutex_unlock(&a0_file_mappings_mu);
+
+  if (!mappings) {
+    return;
+  }
+  a0_file_mapping_t* mapping = mappings->head;
+  while (mapping) {
+    a0_file_mapping_t* next = mapping->next;
+    if (mapping != mappings->head) {
+      munmap(mapping->buf.data, mapping->buf.size);
+    }
+    free(mapping);
+    mapping = next;
+  }
+  free(mappings);
+}
+
+A0_STATIC_INLINE
+a0_err_t a0_file_map_fit_locked(a0_buf_t* map, size_t size) {
+  a0_file_mappings_t* mappings = a0_file_mappings;
+  for (; mappings; mappings = mappings->next) {
+    a0_file_mapping_t* mapping = mappings->head;
+    while (mapping && mapping->buf.data != map->data) {
+      mapping = mapping->next;
+    }
+    if (mapping) {
+      break;
+    }
+  }
+  if (!mappings) {
+    return A0_MAKE_SYSERR(ENOMEM);
+  }
 
+  // Another connection may already have mapped enough.
+  for (a0_file_mapping_t* mapping = mappings->head; mapping; mapping = mapping->next) {
+    if (mapping->buf.size >= size) {
+      *map = (a0_buf_t){mapping->buf.data, size};
+      return A0_OK;
+    }
+  }
+
+  stat_t st;
+  A0_RETURN_SYSERR_ON_MINUS_ONE(fstat(mappings->fd, &st));
+  if ((size_t)st.st_size < size) {
+    return A0_MAKE_SYSERR(ENOMEM);
+  }
+  size_t map_size = st.st_size;
+  if (mappings->open_options.max_size > st.st_size) {
+    map_size = mappings->open_options.max_size;
+  }
+
+  a0_file_mapping_t* mapping = (a0_file_mapping_t*)malloc(sizeof(a0_file_mapping_t));
+  if (!mapping) {
+    return A0_MAKE_SYSERR(ENOMEM);
+  }
+  a0_err_t err = a0_mmap_fd(mappings->fd, map_size, st.st_size, &mappings->open_options, &mapping->buf.data);
+  if (err) {
+    free(mapping);
+    return err;
+  }
+  mapping->buf.size = map_size;
+  // Keep the original mapping first.
+  mapping->next = mappings->head->next;
+  mappings->head->next = mapping;
+
+  *map = (a0_buf_t){mapping->buf.data, size};
   return A0_OK;
 }
 
+a0_err_t a0_file_map_fit(a0_buf_t* map, size_t size) {
+  pthread_mutex_lock(&a0_file_mappings_mu);
+  a0_err_t err = a0_file_map_fit_locked(map, size);
+  pthread_mutex_unlock(&a0_file_mappings_mu);
+  return err;
+}
+
+A0_STATIC_INLINE
+a0_err_t a0_mmap(a0_file_t* file, const a0_file_open_options_t* open_options) {
+  file->arena.mode = open_options->arena_mode;
+  file->arena.buf.size = file->stat.st_size;
+
+  // Map past the end of the file, so that it can grow in place. Pages past the
+  // end become accessible, in every process, once the file is extended.
+  file->_map_size = file->arena.buf.size;
+  if (open_options->max_size > file->stat.st_size) {
+    file->_map_size = open_options->max_size;
+  }
+
+  a0_err_t err = a0_mmap_fd(file->fd, file->_map_size, file->arena.buf.size, open_options, &file->arena.buf.data);
+  if (err) {
+    file->arena.buf = (a0_buf_t)A0_EMPTY;
+    return err;
+  }
+
+  err = a0_file_mappings_add(file, open_options);
+  if (err) {
+    munmap(file->arena.buf.data, file->_map_size);
+    file->arena.buf = (a0_buf_t)A0_EMPTY;
+  }
+  return err;
+}
+
 A0_STATIC_INLINE
 a0_err_t a0_munmap(a0_file_t* file) {
   if (!file->arena.buf.data) {
     return A0_MAKE_SYSERR(EBADF);
   }
 
-  A0_RETURN_SYSERR_ON_MINUS_ONE(munmap(file->arena.buf.data, file->arena.buf.size));
+  a0_file_mappings_del(file);
+  A0_RETURN_SYSERR_ON_MINUS_ONE(munmap(file->arena.buf.data, file->_map_size));
   file->arena.buf = (a0_buf_t)A0_EMPTY;
 
   return A0_OK;
@@ -213,6 +435,11 @@ const a0_file_options_t A0_FILE_OPTIONS_DEFAULT = {
     },
     .open_options = {
         .arena_mode = A0_ARENA_MODE_SHARED,
+        .huge_pages = false,
+        .populate = false,
+        .prefault = false,
+        .mlock = A0_FILE_MLOCK_NONE,
+        .max_size = 0,
     },
 };
 
@@ -259,6 +486,7 @@ a0_err_t a0_do_open(
 
     err = a0_tmp_move(file, path);
     if (err) {
+      a0_munmap(file);
       close(file->fd);
       file->fd = 0;
       file->path = NULL;
@@ -333,6 +561,31 @@ a0_err_t a0_file_close(a0_file_t* file) {
   return a0_munmap(file);
 }
 
+a0_err_t a0_file_grow(a0_file_t* file, off_t size) {
+  if (!file->path || !file->arena.buf.data) {
+    return A0_MAKE_SYSERR(EBADF);
+  }
+  if (file->arena.mode == A0_ARENA_MODE_READONLY) {
+    return A0_MAKE_SYSERR(EPERM);
+  }
+
+  // Another process may have grown the file already. Never shrink it.
+  stat_t st;
+  A0_RETURN_SYSERR_ON_MINUS_ONE(fstat(file->fd, &st));
+  off_t want = size > st.st_size ? a0_fit_size(file->fd, size) : st.st_size;
+  if ((size_t)want > file->_map_size) {
+    return A0_MAKE_SYSERR(ENOMEM);
+  }
+  if (want > st.st_size) {
+    A0_RETURN_SYSERR_ON_MINUS_ONE(ftruncate(file->fd, want));
+    A0_RETURN_SYSERR_ON_MINUS_ONE(fstat(file->fd, &st));
+  }
+
+  file->stat = st;
+  file->arena.buf.size = st.st_size;
+  return A0_OK;
+}
+
 a0_err_t a0_file_iter_init(a0_file_iter_t* iter, const char* path) {
   char* abspath;
   A0_RETURN_ERR_ON_ERR(a0_abspath(path, &abspath));
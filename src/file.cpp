@@ -26,6 +26,11 @@ File::Options File::Options::DEFAULT = {
     },
     .open_options = {
         .arena_mode = A0_FILE_OPTIONS_DEFAULT.open_options.arena_mode,
+        .huge_pages = A0_FILE_OPTIONS_DEFAULT.open_options.huge_pages,
+        .populate = A0_FILE_OPTIONS_DEFAULT.open_options.populate,
+        .prefault = A0_FILE_OPTIONS_DEFAULT.open_options.prefault,
+        .mlock = A0_FILE_OPTIONS_DEFAULT.open_options.mlock,
+        .max_size = A0_FILE_OPTIONS_DEFAULT.open_options.max_size,
     },
 };
 
@@ -85,6 +90,11 @@ stat_t File::stat() const {
   return c->stat;
 }
 
+void File::grow(size_t size) {
+  CHECK_C;
+  check(a0_file_grow(&*c, size));
+}
+
 void File::remove(string_view path) {
   auto err = a0_file_remove(path.data());
   // Ignore "No such file or directory" errors.
@@ -0,0 +1,24 @@
+#ifndef A0_SRC_FILE_MAP_H
+#define A0_SRC_FILE_MAP_H
+
+#include <a0/buf.h>
+#include <a0/err.h>
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Makes sure at least size bytes are mapped at map, which must be a mapping
+// of an open file. If the mapping is too small, map is moved to a larger
+// mapping of the same file. Every mapping stays valid until the file is closed.
+//
+// Fails with ENOMEM if map is not a file mapping, or the file is smaller than size.
+a0_err_t a0_file_map_fit(a0_buf_t* map, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // A0_SRC_FILE_MAP_H
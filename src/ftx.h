@@ -73,6 +73,44 @@ a0_err_t a0_ftx_broadcast(a0_ftx_t* ftx) {
   return a0_ftx_wake(ftx, INT_MAX);
 }
 
+// futex_waitv, Linux 5.16+. Older headers don't name it.
+#ifndef SYS_futex_waitv
+#define SYS_futex_waitv 449
+#endif
+
+// Most futexes a single futex_waitv call can wait on.
+#define A0_FTX_WAITV_MAX 128
+
+// Matches struct futex_waitv, for 32-bit shared futexes.
+typedef struct a0_ftx_waitv_s {
+  uint64_t val;
+  uint64_t uaddr;
+  uint32_t flags;
+  uint32_t _reserved;
+} a0_ftx_waitv_t;
+
+A0_STATIC_INLINE
+void a0_ftx_waitv_set(a0_ftx_waitv_t* waiter, a0_ftx_t* ftx, uint32_t confirm_val) {
+  // FUTEX2_SIZE_U32. Not private, since the words may be in shared memory.
+  *waiter = (a0_ftx_waitv_t){confirm_val, (uintptr_t)ftx, 0x02, 0};
+}
+
+// Waits until any of the futexes is woken, or no longer holds its value.
+// Fails with ENOSYS on kernels without futex_waitv.
+A0_STATIC_INLINE
+a0_err_t a0_ftx_waitv(a0_ftx_waitv_t* waiters, uint32_t cnt, const a0_time_mono_t* timeout) {
+  if (!timeout) {
+    A0_RETURN_SYSERR_ON_MINUS_ONE(syscall(SYS_futex_waitv, waiters, cnt, 0, NULL, 0));
+    return A0_OK;
+  }
+
+  // Unlike FUTEX_WAIT, the timeout is absolute, on the given clock.
+  timespec_t ts_mono;
+  A0_RETURN_ERR_ON_ERR(a0_clock_convert(CLOCK_BOOTTIME, timeout->ts, CLOCK_MONOTONIC, &ts_mono));
+  A0_RETURN_SYSERR_ON_MINUS_ONE(syscall(SYS_futex_waitv, waiters, cnt, 0, &ts_mono, CLOCK_MONOTONIC));
+  return A0_OK;
+}
+
 A0_STATIC_INLINE
 a0_err_t a0_ftx_lock_pi(a0_ftx_t* ftx, const a0_time_mono_t* timeout) {
   if (!timeout) {
@@ -139,6 +139,16 @@ void a0_log_listener_callback(void* data, a0_packet_t pkt) {
   }
 }
 
+// Levels are matched by name, most severe first. A listener at a given level
+// takes the prefix of this list up to it.
+static const a0_reader_filter_clause_t LOG_LEVEL_CLAUSES[] = {
+    {A0_FILTER_KEY_EQUALS, LOG_LEVEL, "CRIT"},
+    {A0_FILTER_KEY_EQUALS, LOG_LEVEL, "ERR"},
+    {A0_FILTER_KEY_EQUALS, LOG_LEVEL, "WARN"},
+    {A0_FILTER_KEY_EQUALS, LOG_LEVEL, "INFO"},
+    {A0_FILTER_KEY_EQUALS, LOG_LEVEL, "DBG"},
+};
+
 a0_err_t a0_log_listener_init(a0_log_listener_t* log_list,
                               a0_log_topic_t topic,
                               a0_alloc_t alloc,
@@ -149,6 +159,16 @@ a0_err_t a0_log_listener_init(a0_log_listener_t* log_list,
   log_list->_onmsg = onmsg;
   A0_RETURN_ERR_ON_ERR(a0_log_topic_open(topic, &log_list->_file));
 
+  // Skip lower levels before they are copied out. A filter from the caller
+  // takes precedence; the callback still checks the level.
+  if (!opts.filter.num_clauses && level < A0_LOG_LEVEL_MAX) {
+    opts.filter = (a0_reader_filter_t){
+        .clauses = LOG_LEVEL_CLAUSES,
+        .num_clauses = (size_t)level + 1,
+        .any = true,
+    };
+  }
+
   a0_err_t err = a0_reader_init(
       &log_list->_reader,
       log_list->_file.arena,
@@ -10,14 +10,18 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "c_opts.hpp"
 #include "c_wrap.hpp"
+#include "packet_pool.hpp"
+#include "queued_alloc.hpp"
 
 namespace a0 {
 
@@ -65,7 +69,9 @@ void Logger::dbg(Packet pkt) {
 namespace {
 
 struct LogListenerImpl {
-  std::vector<uint8_t> data;
+  // Packet buffers, in read order. See queued_alloc.hpp.
+  std::mutex data_mu;
+  std::deque<a0_buf_t> data;
   std::function<void(Packet)> onpacket;
 };
 
@@ -84,29 +90,18 @@ LogListener::LogListener(
         auto cfo = c_fileopts(topic.file_opts);
         a0_log_topic_t c_topic{topic.name.c_str(), &cfo};
 
-        a0_alloc_t alloc = {
-            .user_data = impl,
-            .alloc = [](void* user_data, size_t size, a0_buf_t* out) {
-              auto* impl = (LogListenerImpl*)user_data;
-              impl->data.resize(size);
-              *out = {impl->data.data(), size};
-              return A0_OK;
-            },
-            .dealloc = nullptr,
-        };
+        a0_alloc_t alloc = queued_alloc(impl);
 
         a0_packet_callback_t c_onpacket = {
             .user_data = impl,
             .fn = [](void* user_data, a0_packet_t pkt) {
               auto* impl = (LogListenerImpl*)user_data;
-              auto data = std::make_shared<std::vector<uint8_t>>();
-              std::swap(*data, impl->data);
-              impl->onpacket(Packet(pkt, [data](a0_packet_t*) {}));
+              impl->onpacket(queued_packet(impl, pkt));
             }};
 
         return a0_log_listener_init(c, c_topic, alloc, (a0_log_level_t)lvl, c_readeropts(opts), c_onpacket);
       },
-      [](a0_log_listener_t* c, LogListenerImpl*) {
+      [opts](a0_log_listener_t* c, LogListenerImpl*) {
         a0_log_listener_close(c);
       });
 }
@@ -85,7 +85,7 @@ a0_err_t a0_packet_serialize(a0_packet_t pkt, a0_alloc_t alloc, a0_flat_packet_t
   a0_packet_stats_t stats;
   A0_RETURN_ERR_ON_ERR(a0_packet_stats(pkt, &stats));
 
-  a0_alloc(alloc, stats.serial_size, out);
+  A0_RETURN_ERR_ON_ERR(a0_alloc(alloc, stats.serial_size, out));
 
   // Write pointer into index.
   size_t idx_off = 0;
@@ -133,13 +133,110 @@ a0_err_t a0_packet_serialize(a0_packet_t pkt, a0_alloc_t alloc, a0_flat_packet_t
   memcpy(out->data + idx_off, &off, sizeof(size_t));
 
   // Payload content.
-  if (pkt.payload.size) {
+  if (pkt.payload.data && pkt.payload.size) {
     memcpy(out->data + off, pkt.payload.data, pkt.payload.size);
   }
 
   return A0_OK;
 }
 
+a0_err_t a0_packet_reserialize(a0_packet_t pkt,
+                               a0_packet_t prev_pkt,
+                               a0_flat_packet_t prev_fpkt,
+                               a0_alloc_t alloc,
+                               a0_flat_packet_t* out_fpkt) {
+  if (memcmp(pkt.id, prev_pkt.id, sizeof(a0_uuid_t)) ||
+      pkt.payload.data != prev_pkt.payload.data ||
+      pkt.payload.size != prev_pkt.payload.size) {
+    return A0_ERR_INVALID_ARG;
+  }
+
+  // Find the previous headers behind the prepended blocks.
+  a0_packet_headers_block_t* prev_block = &pkt.headers_block;
+  size_t new_num_hdrs = 0;
+  size_t new_content_size = 0;
+  while (prev_block->headers != prev_pkt.headers_block.headers ||
+         prev_block->size != prev_pkt.headers_block.size ||
+         prev_block->next_block != prev_pkt.headers_block.next_block) {
+    for (size_t i = 0; i < prev_block->size; i++) {
+      new_content_size += strlen(prev_block->headers[i].key) + 1;
+      new_content_size += strlen(prev_block->headers[i].val) + 1;
+    }
+    new_num_hdrs += prev_block->size;
+    prev_block = prev_block->next_block;
+    if (!prev_block) {
+      return A0_ERR_INVALID_ARG;
+    }
+  }
+
+  a0_packet_stats_t prev_stats;
+  A0_RETURN_ERR_ON_ERR(a0_flat_packet_stats(prev_fpkt, &prev_stats));
+  size_t prev_idx_size = prev_stats.serial_size - prev_stats.content_size;
+  size_t num_hdrs = prev_stats.num_hdrs + new_num_hdrs;
+
+  a0_buf_t unused_out;
+  a0_buf_t* out = &unused_out;
+  if (out_fpkt) {
+    out = &out_fpkt->buf;
+  }
+
+  A0_RETURN_ERR_ON_ERR(a0_alloc(
+      alloc,
+      prev_stats.serial_size + 2 * new_num_hdrs * sizeof(size_t) + new_content_size,
+      out));
+
+  // Write pointer into index.
+  size_t idx_off = 0;
+
+  // Write pointer into content.
+  size_t off = prev_idx_size + 2 * new_num_hdrs * sizeof(size_t);
+
+  // ID.
+  memcpy(out->data + idx_off, pkt.id, sizeof(a0_uuid_t));
+  idx_off += sizeof(a0_uuid_t);
+
+  // Number of headers.
+  memcpy(out->data + idx_off, &num_hdrs, sizeof(size_t));
+  idx_off += sizeof(size_t);
+
+  // Prepended headers, in the same order a0_packet_serialize would write them.
+  for (a0_packet_headers_block_t* block = &pkt.headers_block;
+       block != prev_block;
+       block = block->next_block) {
+    for (size_t i = 0; i < block->size; i++) {
+      a0_packet_header_t* hdr = &block->headers[i];
+
+      memcpy(out->data + idx_off, &off, sizeof(size_t));
+      idx_off += sizeof(size_t);
+      memcpy(out->data + off, hdr->key, strlen(hdr->key) + 1);
+      off += strlen(hdr->key) + 1;
+
+      memcpy(out->data + idx_off, &off, sizeof(size_t));
+      idx_off += sizeof(size_t);
+      memcpy(out->data + off, hdr->val, strlen(hdr->val) + 1);
+      off += strlen(hdr->val) + 1;
+    }
+  }
+
+  // Previous header and payload offsets, moved past the new content.
+  size_t shift = off - prev_idx_size;
+  size_t prev_idx_off = sizeof(a0_uuid_t) + sizeof(size_t);
+  for (size_t i = 0; i < 2 * prev_stats.num_hdrs + 1; i++) {
+    size_t prev_off;
+    memcpy(&prev_off, prev_fpkt.buf.data + prev_idx_off, sizeof(size_t));
+    prev_idx_off += sizeof(size_t);
+
+    prev_off += shift;
+    memcpy(out->data + idx_off, &prev_off, sizeof(size_t));
+    idx_off += sizeof(size_t);
+  }
+
+  // Previous content.
+  memcpy(out->data + off, prev_fpkt.buf.data + prev_idx_size, prev_stats.content_size);
+
+  return A0_OK;
+}
+
 a0_err_t a0_packet_deserialize(a0_flat_packet_t fpkt, a0_alloc_t alloc, a0_packet_t* out_pkt, a0_buf_t* out_buf) {
   a0_buf_t in = fpkt.buf;
   memcpy(out_pkt->id, in.data, sizeof(a0_uuid_t));
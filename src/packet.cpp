@@ -1,3 +1,4 @@
+#include <a0/alloc.h>
 #include <a0/buf.h>
 #include <a0/err.h>
 #include <a0/packet.h>
@@ -9,6 +10,7 @@
 #include <cstring>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -16,13 +18,28 @@
 
 #include "c_wrap.hpp"
 #include "err_macro.h"
+#include "packet_pool.hpp"
 
 namespace a0 {
 namespace {
 
-struct PacketImpl {
-  std::unordered_multimap<std::string, std::string> cpp_hdrs;
+// The C packet is the base, so headers() can find the rest from Packet::c.
+// Everything lives in one allocation.
+struct PacketImpl : a0_packet_t {
+  std::function<void(a0_packet_t*)> deleter;
   std::vector<a0_packet_header_t> c_hdrs;
+  // Packets wrapping a C packet build this on first use.
+  std::once_flag cpp_hdrs_once;
+  std::unordered_multimap<std::string, std::string> cpp_hdrs;
+
+  PacketImpl()
+      : a0_packet_t{} {}
+
+  ~PacketImpl() {
+    if (deleter) {
+      deleter(this);
+    }
+  }
 };
 
 std::shared_ptr<a0_packet_t> make_cpp_packet(
@@ -30,50 +47,44 @@ std::shared_ptr<a0_packet_t> make_cpp_packet(
     std::unordered_multimap<std::string, std::string> hdrs,
     string_view payload_view,
     std::function<void(a0_packet_t*)> deleter) {
-  std::shared_ptr<a0_packet_t> c;
-  set_c_impl<PacketImpl>(
-      &c,
-      [&](a0_packet_t* c, PacketImpl* impl) {
-        // Handle id.
-
-        if (id.empty()) {
-          // Create a new ID.
-          A0_RETURN_ERR_ON_ERR(a0_packet_init(&*c));
-        } else if (id.size() == A0_UUID_SIZE) {
-          memcpy(c->id, id.data(), sizeof(a0_uuid_t));
-        } else {
-          return A0_ERR_INVALID_ARG;
-        }
-
-        // Handle headers.
-
-        impl->cpp_hdrs = std::move(hdrs);
-
-        for (const auto& elem : impl->cpp_hdrs) {
-          impl->c_hdrs.push_back(a0_packet_header_t{
-              .key = elem.first.c_str(),
-              .val = elem.second.c_str(),
-          });
-        }
-
-        c->headers_block = {
-            .headers = impl->c_hdrs.data(),
-            .size = impl->c_hdrs.size(),
-            .next_block = nullptr,
-        };
-
-        // Handle payload.
-
-        c->payload = as_buf(payload_view);
-
-        return A0_OK;
-      },
-      [deleter](a0_packet_t* c, PacketImpl*) {
-        if (deleter) {
-          deleter(c);
-        }
-      });
-  return c;
+  auto impl = std::make_shared<PacketImpl>();
+  impl->deleter = std::move(deleter);
+
+  // Handle id.
+
+  if (id.empty()) {
+    // Create a new ID.
+    check(a0_packet_init(impl.get()));
+  } else if (id.size() == A0_UUID_SIZE) {
+    memcpy(impl->id, id.data(), sizeof(a0_uuid_t));
+  } else {
+    check(A0_ERR_INVALID_ARG);
+  }
+
+  // Handle headers.
+
+  std::call_once(impl->cpp_hdrs_once, [&]() {
+    impl->cpp_hdrs = std::move(hdrs);
+  });
+
+  for (const auto& elem : impl->cpp_hdrs) {
+    impl->c_hdrs.push_back(a0_packet_header_t{
+        .key = elem.first.c_str(),
+        .val = elem.second.c_str(),
+    });
+  }
+
+  impl->headers_block = {
+      .headers = impl->c_hdrs.data(),
+      .size = impl->c_hdrs.size(),
+      .next_block = nullptr,
+  };
+
+  // Handle payload.
+
+  impl->payload = as_buf(payload_view);
+
+  return impl;
 }
 
 }  // namespace
@@ -108,20 +119,45 @@ Packet::Packet(std::unordered_multimap<std::string, std::string> headers,
 }
 
 Packet::Packet(a0_packet_t pkt, std::function<void(a0_packet_t*)> deleter) {
-  std::unordered_multimap<std::string, std::string> hdrs;
-
-  a0_packet_header_iterator_t iter;
-  a0_packet_header_iterator_init(&iter, &pkt);
-  a0_packet_header_t hdr;
-  while (!a0_packet_header_iterator_next(&iter, &hdr)) {
-    hdrs.insert({hdr.key, hdr.val});
+  // Without a deleter, nothing keeps the headers alive. Copy them now.
+  if (!deleter) {
+    std::unordered_multimap<std::string, std::string> hdrs;
+
+    a0_packet_header_iterator_t iter;
+    a0_packet_header_iterator_init(&iter, &pkt);
+    a0_packet_header_t hdr;
+    while (!a0_packet_header_iterator_next(&iter, &hdr)) {
+      hdrs.insert({hdr.key, hdr.val});
+    }
+
+    c = make_cpp_packet(
+        pkt.id,
+        std::move(hdrs),
+        string_view((char*)pkt.payload.data, pkt.payload.size),
+        nullptr);
+    return;
   }
 
-  c = make_cpp_packet(
-      pkt.id,
-      std::move(hdrs),
-      string_view((char*)pkt.payload.data, pkt.payload.size),
-      deleter);
+  // Headers stay where they are, kept alive by the deleter.
+  auto impl = std::make_shared<PacketImpl>();
+  static_cast<a0_packet_t&>(*impl) = pkt;
+  impl->deleter = std::move(deleter);
+  c = impl;
+}
+
+a0_alloc_t packet_pool() {
+  static constexpr size_t kBlockSize = 4096;
+  static constexpr size_t kNumBlocks = 64;
+
+  // Never closed. Packets may still be freed during static destruction.
+  static a0_alloc_t* alloc = []() {
+    auto* pool = new a0_alloc_pool_t;
+    check(a0_alloc_pool_init(pool, kBlockSize, kNumBlocks));
+    auto* alloc = new a0_alloc_t;
+    a0_alloc_pool_allocator(pool, alloc);
+    return alloc;
+  }();
+  return *alloc;
 }
 
 string_view Packet::id() const {
@@ -131,7 +167,15 @@ string_view Packet::id() const {
 
 const std::unordered_multimap<std::string, std::string>& Packet::headers() const {
   CHECK_C;
-  const auto* impl = c_impl<PacketImpl>(&c);
+  auto* impl = static_cast<PacketImpl*>(c.get());
+  std::call_once(impl->cpp_hdrs_once, [impl]() {
+    a0_packet_header_iterator_t iter;
+    a0_packet_header_iterator_init(&iter, impl);
+    a0_packet_header_t hdr;
+    while (!a0_packet_header_iterator_next(&iter, &hdr)) {
+      impl->cpp_hdrs.insert({hdr.key, hdr.val});
+    }
+  });
   return impl->cpp_hdrs;
 }
 
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <a0/alloc.h>
+#include <a0/buf.h>
+#include <a0/err.h>
+#include <a0/packet.h>
+#include <a0/packet.hpp>
+
+namespace a0 {
+
+// Buffers for the packets C++ readers and subscribers hand out.
+//
+// Every reader in the process shares one pool. Packets may outlive their
+// reader, and return their buffer when freed.
+//
+// Requests larger than a block, or made while every block is in use, are
+// served by malloc. Defined in packet.cpp.
+a0_alloc_t packet_pool();
+
+namespace {  // NOLINT(google-build-namespaces)
+
+// Wraps the packet with the pool buffer it was deserialized into.
+inline Packet pooled_packet(a0_packet_t pkt, a0_buf_t buf) {
+  return Packet(pkt, [buf](a0_packet_t*) {
+    a0_dealloc(packet_pool(), buf);
+  });
+}
+
+}  // namespace
+}  // namespace a0
@@ -30,6 +30,10 @@ static const char PRPC_TYPE_CANCEL[] = "cancel";
 
 static const char CONN_ID[] = "a0_conn_id";
 
+const a0_prpc_options_t A0_PRPC_OPTIONS_DEFAULT = {
+    .thread_attr = {NULL, 0, 0, 0, 0, NULL},
+};
+
 A0_STATIC_INLINE
 a0_err_t a0_prpc_topic_open(a0_prpc_topic_t topic, a0_file_t* file) {
   return a0_topic_open(a0_env_topic_tmpl_prpc(), topic.name, topic.file_opts, file);
@@ -66,6 +70,15 @@ a0_err_t a0_prpc_server_init(a0_prpc_server_t* server,
                              a0_alloc_t alloc,
                              a0_prpc_connection_callback_t onconnect,
                              a0_packet_id_callback_t oncancel) {
+  return a0_prpc_server_init_options(server, topic, alloc, onconnect, oncancel, A0_PRPC_OPTIONS_DEFAULT);
+}
+
+a0_err_t a0_prpc_server_init_options(a0_prpc_server_t* server,
+                                     a0_prpc_topic_t topic,
+                                     a0_alloc_t alloc,
+                                     a0_prpc_connection_callback_t onconnect,
+                                     a0_packet_id_callback_t oncancel,
+                                     a0_prpc_options_t opts) {
   server->_onconnect = onconnect;
   server->_oncancel = oncancel;
 
@@ -90,7 +103,11 @@ a0_err_t a0_prpc_server_init(a0_prpc_server_t* server,
       &server->_connection_reader,
       server->_file.arena,
       alloc,
-      (a0_reader_options_t){A0_INIT_AWAIT_NEW, A0_ITER_NEXT},
+      (a0_reader_options_t){
+          .init = A0_INIT_AWAIT_NEW,
+          .iter = A0_ITER_NEXT,
+          .thread_attr = opts.thread_attr,
+      },
       (a0_packet_callback_t){
           .user_data = server,
           .fn = a0_prpc_server_onpacket,
@@ -175,6 +192,13 @@ void a0_prpc_client_onpacket(void* user_data, a0_packet_t pkt) {
 a0_err_t a0_prpc_client_init(a0_prpc_client_t* client,
                              a0_prpc_topic_t topic,
                              a0_alloc_t alloc) {
+  return a0_prpc_client_init_options(client, topic, alloc, A0_PRPC_OPTIONS_DEFAULT);
+}
+
+a0_err_t a0_prpc_client_init_options(a0_prpc_client_t* client,
+                                     a0_prpc_topic_t topic,
+                                     a0_alloc_t alloc,
+                                     a0_prpc_options_t opts) {
   // Outstanding connections must be initialized before the response reader to avoid a race condition.
 
   A0_RETURN_ERR_ON_ERR(a0_map_init(
@@ -213,7 +237,11 @@ a0_err_t a0_prpc_client_init(a0_prpc_client_t* client,
       &client->_progress_reader,
       client->_file.arena,
       alloc,
-      (a0_reader_options_t){A0_INIT_AWAIT_NEW, A0_ITER_NEXT},
+      (a0_reader_options_t){
+          .init = A0_INIT_AWAIT_NEW,
+          .iter = A0_ITER_NEXT,
+          .thread_attr = opts.thread_attr,
+      },
       (a0_packet_callback_t){
           .user_data = client,
           .fn = a0_prpc_client_onpacket,
@@ -61,6 +61,7 @@ struct PrpcServerImpl {
 
 PrpcServer::PrpcServer(
     PrpcTopic topic,
+    PrpcOptions opts,
     std::function<void(PrpcConnection)> onconnect,
     std::function<void(string_view /* id */)> oncancel) {
   set_c_impl<PrpcServerImpl>(
@@ -105,7 +106,8 @@ PrpcServer::PrpcServer(
               impl->oncancel(id);
             }};
 
-        return a0_prpc_server_init(c, c_topic, alloc, c_onconnect, c_oncancel);
+        a0_prpc_options_t c_opts{c_threadattr(opts.thread_attr)};
+        return a0_prpc_server_init_options(c, c_topic, alloc, c_onconnect, c_oncancel, c_opts);
       },
       [](a0_prpc_server_t* c, PrpcServerImpl*) {
         a0_prpc_server_close(c);
@@ -123,7 +125,7 @@ struct PrpcClientImpl {
 
 }  // namespace
 
-PrpcClient::PrpcClient(PrpcTopic topic) {
+PrpcClient::PrpcClient(PrpcTopic topic, PrpcOptions opts) {
   set_c_impl<PrpcClientImpl>(
       &c,
       [&](a0_prpc_client_t* c, PrpcClientImpl* impl) {
@@ -141,7 +143,8 @@ PrpcClient::PrpcClient(PrpcTopic topic) {
             .dealloc = nullptr,
         };
 
-        return a0_prpc_client_init(c, c_topic, alloc);
+        a0_prpc_options_t c_opts{c_threadattr(opts.thread_attr)};
+        return a0_prpc_client_init_options(c, c_topic, alloc, c_opts);
       },
       [](a0_prpc_client_t* c, PrpcClientImpl*) {
         a0_prpc_client_close(c);
@@ -9,6 +9,7 @@
 #include <a0/reader.h>
 #include <a0/time.h>
 #include <a0/topic.h>
+#include <a0/transport.h>
 #include <a0/writer.h>
 
 #include <stdbool.h>
@@ -17,7 +18,16 @@
 
 A0_STATIC_INLINE
 a0_err_t a0_pubsub_topic_open(a0_pubsub_topic_t topic, a0_file_t* file) {
-  return a0_topic_open(a0_env_topic_tmpl_pubsub(), topic.name, topic.file_opts, file);
+  A0_RETURN_ERR_ON_ERR(a0_topic_open(a0_env_topic_tmpl_pubsub(), topic.name, topic.file_opts, file));
+
+  // Whoever opens a new topic first formats it.
+  a0_transport_t transport;
+  a0_err_t err = a0_transport_init_options(&transport, file->arena, topic.transport_opts);
+  if (err) {
+    a0_file_close(file);
+    return err;
+  }
+  return A0_OK;
 }
 
 /////////////////
@@ -49,8 +59,56 @@ a0_err_t a0_publisher_close(a0_publisher_t* pub) {
   return A0_OK;
 }
 
+// Doubles the topic file, within its mapping, to make room for a large packet.
+// Topics with fixed slots cannot fit a larger packet in any arena.
+A0_STATIC_INLINE
+a0_err_t a0_publisher_grow(a0_publisher_t* pub) {
+  a0_file_t* file = &pub->_file;
+  if (file->arena.buf.size >= file->_map_size) {
+    return A0_ERR_FRAME_LARGE;
+  }
+
+  a0_transport_t transport;
+  A0_RETURN_ERR_ON_ERR(a0_transport_init(&transport, file->arena));
+
+  // The transport lock serializes growth across publishers.
+  a0_transport_locked_t tlk;
+  A0_RETURN_ERR_ON_ERR(a0_transport_lock(&transport, &tlk));
+
+  size_t slot_size;
+  a0_transport_slot_size(tlk, &slot_size);
+  if (slot_size) {
+    a0_transport_unlock(tlk);
+    return A0_ERR_FRAME_LARGE;
+  }
+
+  size_t size = 2 * file->arena.buf.size;
+  if (size > file->_map_size) {
+    size = file->_map_size;
+  }
+  a0_err_t err = a0_file_grow(file, size);
+  if (!err) {
+    err = a0_transport_resize(tlk, file->arena.buf.size);
+  }
+
+  a0_transport_unlock(tlk);
+  return err;
+}
+
 a0_err_t a0_publisher_pub(a0_publisher_t* pub, a0_packet_t pkt) {
-  return a0_writer_write(&pub->_writer, pkt);
+  a0_err_t err = a0_writer_write(&pub->_writer, pkt);
+  while (err == A0_ERR_FRAME_LARGE && !a0_publisher_grow(pub)) {
+    err = a0_writer_write(&pub->_writer, pkt);
+  }
+  return err;
+}
+
+a0_err_t a0_publisher_reserve(a0_publisher_t* pub, a0_packet_t pkt, size_t payload_size, a0_writer_reservation_t* out) {
+  a0_err_t err = a0_writer_reserve(&pub->_writer, pkt, payload_size, out);
+  while (err == A0_ERR_FRAME_LARGE && !a0_publisher_grow(pub)) {
+    err = a0_writer_reserve(&pub->_writer, pkt, payload_size, out);
+  }
+  return err;
 }
 
 a0_err_t a0_publisher_writer(a0_publisher_t* pub, a0_writer_t** out) {
@@ -103,6 +161,22 @@ a0_err_t a0_subscriber_sync_zc_read_blocking_timeout(a0_subscriber_sync_zc_t* su
   return a0_reader_sync_zc_read_blocking_timeout(&sub_sync_zc->_reader_sync_zc, timeout, onpacket);
 }
 
+a0_err_t a0_subscriber_sync_zc_read_batch(a0_subscriber_sync_zc_t* sub_sync_zc, size_t max_cnt, a0_zero_copy_callback_t onpacket, size_t* out_cnt) {
+  return a0_reader_sync_zc_read_batch(&sub_sync_zc->_reader_sync_zc, max_cnt, onpacket, out_cnt);
+}
+
+a0_err_t a0_subscriber_sync_zc_read_batch_blocking(a0_subscriber_sync_zc_t* sub_sync_zc, size_t max_cnt, a0_zero_copy_callback_t onpacket, size_t* out_cnt) {
+  return a0_reader_sync_zc_read_batch_blocking(&sub_sync_zc->_reader_sync_zc, max_cnt, onpacket, out_cnt);
+}
+
+a0_err_t a0_subscriber_sync_zc_read_batch_blocking_timeout(a0_subscriber_sync_zc_t* sub_sync_zc, a0_time_mono_t* timeout, size_t max_cnt, a0_zero_copy_callback_t onpacket, size_t* out_cnt) {
+  return a0_reader_sync_zc_read_batch_blocking_timeout(&sub_sync_zc->_reader_sync_zc, timeout, max_cnt, onpacket, out_cnt);
+}
+
+a0_err_t a0_subscriber_sync_zc_stats(a0_subscriber_sync_zc_t* sub_sync_zc, a0_reader_stats_t* out) {
+  return a0_reader_sync_zc_stats(&sub_sync_zc->_reader_sync_zc, out);
+}
+
 // Synchronous allocated version.
 
 a0_err_t a0_subscriber_sync_init(a0_subscriber_sync_t* sub_sync,
@@ -146,6 +220,22 @@ a0_err_t a0_subscriber_sync_read_blocking_timeout(a0_subscriber_sync_t* sub_sync
   return a0_reader_sync_read_blocking_timeout(&sub_sync->_reader_sync, timeout, pkt);
 }
 
+a0_err_t a0_subscriber_sync_read_batch(a0_subscriber_sync_t* sub_sync, a0_packet_t* pkts, size_t max_cnt, size_t* out_cnt) {
+  return a0_reader_sync_read_batch(&sub_sync->_reader_sync, pkts, max_cnt, out_cnt);
+}
+
+a0_err_t a0_subscriber_sync_read_batch_blocking(a0_subscriber_sync_t* sub_sync, a0_packet_t* pkts, size_t max_cnt, size_t* out_cnt) {
+  return a0_reader_sync_read_batch_blocking(&sub_sync->_reader_sync, pkts, max_cnt, out_cnt);
+}
+
+a0_err_t a0_subscriber_sync_read_batch_blocking_timeout(a0_subscriber_sync_t* sub_sync, a0_time_mono_t* timeout, a0_packet_t* pkts, size_t max_cnt, size_t* out_cnt) {
+  return a0_reader_sync_read_batch_blocking_timeout(&sub_sync->_reader_sync, timeout, pkts, max_cnt, out_cnt);
+}
+
+a0_err_t a0_subscriber_sync_stats(a0_subscriber_sync_t* sub_sync, a0_reader_stats_t* out) {
+  return a0_reader_sync_stats(&sub_sync->_reader_sync, out);
+}
+
 // Threaded zero-copy version.
 
 a0_err_t a0_subscriber_zc_init(a0_subscriber_zc_t* sub_zc,
@@ -167,12 +257,37 @@ a0_err_t a0_subscriber_zc_init(a0_subscriber_zc_t* sub_zc,
   return A0_OK;
 }
 
+a0_err_t a0_subscriber_zc_init_mux(a0_subscriber_zc_t* sub_zc,
+                                   a0_reader_mux_t* mux,
+                                   a0_pubsub_topic_t topic,
+                                   a0_reader_options_t opts,
+                                   a0_zero_copy_callback_t onpacket) {
+  A0_RETURN_ERR_ON_ERR(a0_pubsub_topic_open(topic, &sub_zc->_file));
+
+  a0_err_t err = a0_reader_zc_init_mux(
+      &sub_zc->_reader_zc,
+      mux,
+      sub_zc->_file.arena,
+      opts,
+      onpacket);
+  if (err) {
+    a0_file_close(&sub_zc->_file);
+    return err;
+  }
+
+  return A0_OK;
+}
+
 a0_err_t a0_subscriber_zc_close(a0_subscriber_zc_t* sub_zc) {
   a0_reader_zc_close(&sub_zc->_reader_zc);
   a0_file_close(&sub_zc->_file);
   return A0_OK;
 }
 
+a0_err_t a0_subscriber_zc_stats(a0_subscriber_zc_t* sub_zc, a0_reader_stats_t* out) {
+  return a0_reader_zc_stats(&sub_zc->_reader_zc, out);
+}
+
 // Threaded allocated version.
 
 a0_err_t a0_subscriber_init(a0_subscriber_t* sub,
@@ -196,8 +311,58 @@ a0_err_t a0_subscriber_init(a0_subscriber_t* sub,
   return A0_OK;
 }
 
+a0_err_t a0_subscriber_init_mux(a0_subscriber_t* sub,
+                                a0_reader_mux_t* mux,
+                                a0_pubsub_topic_t topic,
+                                a0_alloc_t alloc,
+                                a0_reader_options_t opts,
+                                a0_packet_callback_t onpacket) {
+  A0_RETURN_ERR_ON_ERR(a0_pubsub_topic_open(topic, &sub->_file));
+
+  a0_err_t err = a0_reader_init_mux(
+      &sub->_reader,
+      mux,
+      sub->_file.arena,
+      alloc,
+      opts,
+      onpacket);
+  if (err) {
+    a0_file_close(&sub->_file);
+    return err;
+  }
+
+  return A0_OK;
+}
+
+a0_err_t a0_subscriber_init_batch(a0_subscriber_t* sub,
+                                  a0_pubsub_topic_t topic,
+                                  a0_alloc_t alloc,
+                                  a0_reader_options_t opts,
+                                  size_t max_cnt,
+                                  a0_packet_batch_callback_t onbatch) {
+  A0_RETURN_ERR_ON_ERR(a0_pubsub_topic_open(topic, &sub->_file));
+
+  a0_err_t err = a0_reader_init_batch(
+      &sub->_reader,
+      sub->_file.arena,
+      alloc,
+      opts,
+      max_cnt,
+      onbatch);
+  if (err) {
+    a0_file_close(&sub->_file);
+    return err;
+  }
+
+  return A0_OK;
+}
+
 a0_err_t a0_subscriber_close(a0_subscriber_t* sub) {
   a0_reader_close(&sub->_reader);
   a0_file_close(&sub->_file);
   return A0_OK;
 }
+
+a0_err_t a0_subscriber_stats(a0_subscriber_t* sub, a0_reader_stats_t* out) {
+  return a0_reader_stats(&sub->_reader, out);
+}
@@ -17,14 +17,21 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "c_opts.hpp"
 #include "c_wrap.hpp"
+#include "err_macro.h"
+#include "packet_pool.hpp"
+#include "queued_alloc.hpp"
+#include "read_batch.hpp"
 
 namespace a0 {
 
@@ -33,7 +40,12 @@ Publisher::Publisher(PubSubTopic topic) {
       &c,
       [&](a0_publisher_t* c) {
         auto cfo = c_fileopts(topic.file_opts);
-        a0_pubsub_topic_t c_topic{topic.name.c_str(), &cfo};
+        auto cto = c_transportopts(topic.transport_opts);
+        a0_pubsub_topic_t c_topic{
+            topic.name.c_str(),
+            &cfo,
+            &cto,
+        };
         return a0_publisher_init(c, c_topic);
       },
       a0_publisher_close);
@@ -44,6 +56,22 @@ void Publisher::pub(Packet pkt) {
   check(a0_publisher_pub(&*c, *pkt.c));
 }
 
+Writer::Reservation Publisher::reserve(
+    std::unordered_multimap<std::string, std::string> headers,
+    size_t payload_size) {
+  CHECK_C;
+  auto save = c;
+  Packet pkt(std::move(headers), "");
+  return make_cpp<Writer::Reservation>(
+      [&](a0_writer_reservation_t* c) {
+        return a0_publisher_reserve(&*save, *pkt.c, payload_size, c);
+      },
+      [save](a0_writer_reservation_t* c) {
+        // Fails harmlessly if already committed or aborted.
+        a0_writer_reservation_abort(c);
+      });
+}
+
 Writer Publisher::writer() {
   CHECK_C;
   auto save = c;
@@ -61,10 +89,15 @@ SubscriberSyncZeroCopy::SubscriberSyncZeroCopy(PubSubTopic topic, Reader::Option
       &c,
       [&](a0_subscriber_sync_zc_t* c) {
         auto cfo = c_fileopts(topic.file_opts);
-        a0_pubsub_topic_t c_topic{topic.name.c_str(), &cfo};
+        auto cto = c_transportopts(topic.transport_opts);
+        a0_pubsub_topic_t c_topic{
+            topic.name.c_str(),
+            &cfo,
+            &cto,
+        };
         return a0_subscriber_sync_zc_init(c, c_topic, c_readeropts(opts));
       },
-      [](a0_subscriber_sync_zc_t* c) {
+      [opts](a0_subscriber_sync_zc_t* c) {
         a0_subscriber_sync_zc_close(c);
       });
 }
@@ -101,10 +134,45 @@ void SubscriberSyncZeroCopy::read_blocking(TimeMono timeout, std::function<void(
   check(a0_subscriber_sync_zc_read_blocking_timeout(&*c, &*timeout.c, SubscriberSyncZeroCopy_callback(&fn)));
 }
 
+size_t SubscriberSyncZeroCopy::read_batch(size_t max_cnt, std::function<void(TransportLocked, FlatPacket)> fn) {
+  CHECK_C;
+  size_t cnt;
+  a0_err_t err = a0_subscriber_sync_zc_read_batch(&*c, max_cnt, SubscriberSyncZeroCopy_callback(&fn), &cnt);
+  if (err != A0_ERR_AGAIN) {
+    check(err);
+  }
+  return cnt;
+}
+
+size_t SubscriberSyncZeroCopy::read_batch_blocking(size_t max_cnt, std::function<void(TransportLocked, FlatPacket)> fn) {
+  CHECK_C;
+  size_t cnt;
+  check(a0_subscriber_sync_zc_read_batch_blocking(&*c, max_cnt, SubscriberSyncZeroCopy_callback(&fn), &cnt));
+  return cnt;
+}
+
+size_t SubscriberSyncZeroCopy::read_batch_blocking(TimeMono timeout, size_t max_cnt, std::function<void(TransportLocked, FlatPacket)> fn) {
+  CHECK_C;
+  size_t cnt;
+  check(a0_subscriber_sync_zc_read_batch_blocking_timeout(&*c, &*timeout.c, max_cnt, SubscriberSyncZeroCopy_callback(&fn), &cnt));
+  return cnt;
+}
+
+Reader::Stats SubscriberSyncZeroCopy::stats() {
+  CHECK_C;
+  Reader::Stats out;
+  check(a0_subscriber_sync_zc_stats(&*c, &out));
+  return out;
+}
+
 namespace {
 
 struct SubscriberSyncImpl {
-  std::vector<uint8_t> data;
+  // Buffer of the last read.
+  a0_buf_t buf;
+  // Batch reads allocate each packet separately.
+  bool batching{false};
+  std::vector<a0_buf_t> batch_bufs;
 };
 
 }  // namespace
@@ -114,21 +182,15 @@ SubscriberSync::SubscriberSync(PubSubTopic topic, Reader::Options opts) {
       &c,
       [&](a0_subscriber_sync_t* c, SubscriberSyncImpl* impl) {
         auto cfo = c_fileopts(topic.file_opts);
-        a0_pubsub_topic_t c_topic{topic.name.c_str(), &cfo};
-
-        a0_alloc_t alloc = {
-            .user_data = impl,
-            .alloc = [](void* user_data, size_t size, a0_buf_t* out) {
-              auto* impl = (SubscriberSyncImpl*)user_data;
-              impl->data.resize(size);
-              *out = {impl->data.data(), size};
-              return A0_OK;
-            },
-            .dealloc = nullptr,
+        auto cto = c_transportopts(topic.transport_opts);
+        a0_pubsub_topic_t c_topic{
+            topic.name.c_str(),
+            &cfo,
+            &cto,
         };
-        return a0_subscriber_sync_init(c, c_topic, alloc, c_readeropts(opts));
+        return a0_subscriber_sync_init(c, c_topic, read_batch_alloc(impl), c_readeropts(opts));
       },
-      [](a0_subscriber_sync_t* c, SubscriberSyncImpl*) {
+      [opts](a0_subscriber_sync_t* c, SubscriberSyncImpl*) {
         a0_subscriber_sync_close(c);
       });
 }
@@ -140,36 +202,55 @@ bool SubscriberSync::can_read() {
   return ret;
 }
 
-A0_STATIC_INLINE
-Packet SubscriberSync_read(SubscriberSyncImpl* impl, std::function<a0_err_t(a0_packet_t*)> fn) {
-  a0_packet_t pkt;
-  check(fn(&pkt));
-  auto data = std::make_shared<std::vector<uint8_t>>();
-  std::swap(*data, impl->data);
-  return Packet(pkt, [data](a0_packet_t*) {});
-}
-
 Packet SubscriberSync::read() {
   CHECK_C;
-  return SubscriberSync_read(c_impl<SubscriberSyncImpl>(&c), [&](a0_packet_t* pkt) {
+  return read_one_impl(c_impl<SubscriberSyncImpl>(&c), [&](a0_packet_t* pkt) {
     return a0_subscriber_sync_read(&*c, pkt);
   });
 }
 
 Packet SubscriberSync::read_blocking() {
   CHECK_C;
-  return SubscriberSync_read(c_impl<SubscriberSyncImpl>(&c), [&](a0_packet_t* pkt) {
+  return read_one_impl(c_impl<SubscriberSyncImpl>(&c), [&](a0_packet_t* pkt) {
     return a0_subscriber_sync_read_blocking(&*c, pkt);
   });
 }
 
 Packet SubscriberSync::read_blocking(TimeMono timeout) {
   CHECK_C;
-  return SubscriberSync_read(c_impl<SubscriberSyncImpl>(&c), [&](a0_packet_t* pkt) {
+  return read_one_impl(c_impl<SubscriberSyncImpl>(&c), [&](a0_packet_t* pkt) {
     return a0_subscriber_sync_read_blocking_timeout(&*c, &*timeout.c, pkt);
   });
 }
 
+std::vector<Packet> SubscriberSync::read_batch(size_t max_cnt) {
+  CHECK_C;
+  return read_batch_impl(c_impl<SubscriberSyncImpl>(&c), max_cnt, [&](a0_packet_t* pkts, size_t* cnt) {
+    return a0_subscriber_sync_read_batch(&*c, pkts, max_cnt, cnt);
+  });
+}
+
+std::vector<Packet> SubscriberSync::read_batch_blocking(size_t max_cnt) {
+  CHECK_C;
+  return read_batch_impl(c_impl<SubscriberSyncImpl>(&c), max_cnt, [&](a0_packet_t* pkts, size_t* cnt) {
+    return a0_subscriber_sync_read_batch_blocking(&*c, pkts, max_cnt, cnt);
+  });
+}
+
+std::vector<Packet> SubscriberSync::read_batch_blocking(TimeMono timeout, size_t max_cnt) {
+  CHECK_C;
+  return read_batch_impl(c_impl<SubscriberSyncImpl>(&c), max_cnt, [&](a0_packet_t* pkts, size_t* cnt) {
+    return a0_subscriber_sync_read_batch_blocking_timeout(&*c, &*timeout.c, pkts, max_cnt, cnt);
+  });
+}
+
+Reader::Stats SubscriberSync::stats() {
+  CHECK_C;
+  Reader::Stats out;
+  check(a0_subscriber_sync_stats(&*c, &out));
+  return out;
+}
+
 namespace {
 
 struct SubscriberZeroCopyImpl {
@@ -188,7 +269,12 @@ SubscriberZeroCopy::SubscriberZeroCopy(
         impl->onpacket = std::move(onpacket);
 
         auto cfo = c_fileopts(topic.file_opts);
-        a0_pubsub_topic_t c_topic{topic.name.c_str(), &cfo};
+        auto cto = c_transportopts(topic.transport_opts);
+        a0_pubsub_topic_t c_topic{
+            topic.name.c_str(),
+            &cfo,
+            &cto,
+        };
 
         a0_zero_copy_callback_t c_onpacket = {
             .user_data = impl,
@@ -199,15 +285,24 @@ SubscriberZeroCopy::SubscriberZeroCopy(
 
         return a0_subscriber_zc_init(c, c_topic, c_readeropts(opts), c_onpacket);
       },
-      [](a0_subscriber_zc_t* c, SubscriberZeroCopyImpl*) {
+      [opts](a0_subscriber_zc_t* c, SubscriberZeroCopyImpl*) {
         a0_subscriber_zc_close(c);
       });
 }
 
+Reader::Stats SubscriberZeroCopy::stats() {
+  CHECK_C;
+  Reader::Stats out;
+  check(a0_subscriber_zc_stats(&*c, &out));
+  return out;
+}
+
 namespace {
 
 struct SubscriberImpl {
-  std::vector<uint8_t> data;
+  // Packet buffers, in read order. See queued_alloc.hpp.
+  std::mutex data_mu;
+  std::deque<a0_buf_t> data;
   std::function<void(Packet)> onpacket;
 };
 
@@ -223,33 +318,128 @@ Subscriber::Subscriber(
         impl->onpacket = std::move(onpacket);
 
         auto cfo = c_fileopts(topic.file_opts);
-        a0_pubsub_topic_t c_topic{topic.name.c_str(), &cfo};
+        auto cto = c_transportopts(topic.transport_opts);
+        a0_pubsub_topic_t c_topic{
+            topic.name.c_str(),
+            &cfo,
+            &cto,
+        };
+
+        a0_alloc_t alloc = queued_alloc(impl);
+
+        a0_packet_callback_t c_onpacket = {
+            .user_data = impl,
+            .fn = [](void* user_data, a0_packet_t pkt) {
+              auto* impl = (SubscriberImpl*)user_data;
+              impl->onpacket(queued_packet(impl, pkt));
+            }};
+
+        return a0_subscriber_init(c, c_topic, alloc, c_readeropts(opts), c_onpacket);
+      },
+      [opts](a0_subscriber_t* c, SubscriberImpl*) {
+        a0_subscriber_close(c);
+      });
+}
+
+Subscriber::Subscriber(
+    ReaderMux mux,
+    PubSubTopic topic,
+    Reader::Options opts,
+    std::function<void(Packet)> onpacket) {
+  check(__PRETTY_FUNCTION__, &mux);
+  set_c_impl<SubscriberImpl>(
+      &c,
+      [&](a0_subscriber_t* c, SubscriberImpl* impl) {
+        impl->onpacket = std::move(onpacket);
+
+        auto cfo = c_fileopts(topic.file_opts);
+        auto cto = c_transportopts(topic.transport_opts);
+        a0_pubsub_topic_t c_topic{
+            topic.name.c_str(),
+            &cfo,
+            &cto,
+        };
+
+        a0_alloc_t alloc = queued_alloc(impl);
+
+        a0_packet_callback_t c_onpacket = {
+            .user_data = impl,
+            .fn = [](void* user_data, a0_packet_t pkt) {
+              auto* impl = (SubscriberImpl*)user_data;
+              impl->onpacket(queued_packet(impl, pkt));
+            }};
+
+        return a0_subscriber_init_mux(c, &*mux.c, c_topic, alloc, c_readeropts(opts), c_onpacket);
+      },
+      [mux, opts](a0_subscriber_t* c, SubscriberImpl*) {
+        a0_subscriber_close(c);
+      });
+}
+
+namespace {
+
+struct SubscriberBatchImpl {
+  // Packet buffers, in read order. Handed over to the Packets in each batch.
+  std::vector<a0_buf_t> data;
+  std::function<void(std::vector<Packet>)> onbatch;
+};
+
+}  // namespace
+
+Subscriber::Subscriber(
+    PubSubTopic topic,
+    Reader::Options opts,
+    size_t max_cnt,
+    std::function<void(std::vector<Packet>)> onbatch) {
+  set_c_impl<SubscriberBatchImpl>(
+      &c,
+      [&](a0_subscriber_t* c, SubscriberBatchImpl* impl) {
+        impl->onbatch = std::move(onbatch);
+
+        auto cfo = c_fileopts(topic.file_opts);
+        auto cto = c_transportopts(topic.transport_opts);
+        a0_pubsub_topic_t c_topic{
+            topic.name.c_str(),
+            &cfo,
+            &cto,
+        };
 
         a0_alloc_t alloc = {
             .user_data = impl,
             .alloc = [](void* user_data, size_t size, a0_buf_t* out) {
-              auto* impl = (SubscriberImpl*)user_data;
-              impl->data.resize(size);
-              *out = {impl->data.data(), size};
+              auto* impl = (SubscriberBatchImpl*)user_data;
+              A0_RETURN_ERR_ON_ERR(a0_alloc(packet_pool(), size, out));
+              impl->data.push_back(*out);
               return A0_OK;
             },
             .dealloc = nullptr,
         };
 
-        a0_packet_callback_t c_onpacket = {
+        a0_packet_batch_callback_t c_onbatch = {
             .user_data = impl,
-            .fn = [](void* user_data, a0_packet_t pkt) {
-              auto* impl = (SubscriberImpl*)user_data;
-              auto data = std::make_shared<std::vector<uint8_t>>();
-              std::swap(*data, impl->data);
-              impl->onpacket(Packet(pkt, [data](a0_packet_t*) {}));
+            .fn = [](void* user_data, a0_packet_t* pkts, size_t cnt) {
+              auto* impl = (SubscriberBatchImpl*)user_data;
+              std::vector<Packet> batch;
+              batch.reserve(cnt);
+              for (size_t i = 0; i < cnt; i++) {
+                batch.push_back(pooled_packet(pkts[i], impl->data[i]));
+              }
+              impl->data.erase(impl->data.begin(), impl->data.begin() + cnt);
+              impl->onbatch(std::move(batch));
             }};
 
-        return a0_subscriber_init(c, c_topic, alloc, c_readeropts(opts), c_onpacket);
+        return a0_subscriber_init_batch(c, c_topic, alloc, c_readeropts(opts), max_cnt, c_onbatch);
       },
-      [](a0_subscriber_t* c, SubscriberImpl*) {
+      [opts](a0_subscriber_t* c, SubscriberBatchImpl*) {
         a0_subscriber_close(c);
       });
 }
 
+Reader::Stats Subscriber::stats() {
+  CHECK_C;
+  Reader::Stats out;
+  check(a0_subscriber_stats(&*c, &out));
+  return out;
+}
+
 }  // namespace a0
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <a0/alloc.h>
+#include <a0/buf.h>
+#include <a0/err.h>
+#include <a0/packet.h>
+#include <a0/packet.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#include "err_macro.h"
+#include "packet_pool.hpp"
+
+namespace a0 {
+namespace {  // NOLINT(google-build-namespaces)
+
+// Helpers for threaded readers, subscribers, and listeners.
+//
+// With an executor, the reader thread copies packets out before earlier
+// callbacks have run. Each packet gets its own buffer from the pool, and
+// callbacks claim them in read order.
+//
+// Impl has the members:
+//   std::mutex data_mu;
+//   std::deque<a0_buf_t> data;
+
+template <typename Impl>
+a0_alloc_t queued_alloc(Impl* impl) {
+  return {
+      .user_data = impl,
+      .alloc = [](void* user_data, size_t size, a0_buf_t* out) {
+        auto* impl = (Impl*)user_data;
+        A0_RETURN_ERR_ON_ERR(a0_alloc(packet_pool(), size, out));
+        std::unique_lock<std::mutex> lk{impl->data_mu};
+        impl->data.push_back(*out);
+        return A0_OK;
+      },
+      .dealloc = nullptr,
+  };
+}
+
+// Wraps the packet with the buffer it was allocated into.
+template <typename Impl>
+Packet queued_packet(Impl* impl, a0_packet_t pkt) {
+  a0_buf_t buf;
+  {
+    std::unique_lock<std::mutex> lk{impl->data_mu};
+    buf = impl->data.front();
+    impl->data.pop_front();
+  }
+  return pooled_packet(pkt, buf);
+}
+
+}  // namespace
+}  // namespace a0
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <a0/alloc.h>
+#include <a0/buf.h>
+#include <a0/err.h>
+#include <a0/packet.h>
+#include <a0/packet.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "c_wrap.hpp"
+#include "err_macro.h"
+#include "packet_pool.hpp"
+
+namespace a0 {
+namespace {  // NOLINT(google-build-namespaces)
+
+// Helpers for sync readers and subscribers with batch reads.
+//
+// Impl has the members:
+//   a0_buf_t buf;
+//   bool batching;
+//   std::vector<a0_buf_t> batch_bufs;
+
+// Runs a read, wrapping the packet with its buffer.
+template <typename Impl>
+Packet read_one_impl(Impl* impl, std::function<a0_err_t(a0_packet_t*)> fn) {
+  a0_packet_t pkt;
+  check(fn(&pkt));
+  return pooled_packet(pkt, impl->buf);
+}
+
+// Runs a batch read, with every packet owning its own buffer.
+template <typename Impl>
+std::vector<Packet> read_batch_impl(Impl* impl, size_t max_cnt, std::function<a0_err_t(a0_packet_t*, size_t*)> fn) {
+  std::vector<a0_packet_t> pkts(max_cnt);
+  impl->batching = true;
+  impl->batch_bufs.clear();
+
+  size_t cnt = 0;
+  a0_err_t err = fn(pkts.data(), &cnt);
+  impl->batching = false;
+
+  std::vector<Packet> ret;
+  ret.reserve(cnt);
+  for (size_t i = 0; i < cnt; i++) {
+    ret.push_back(pooled_packet(pkts[i], impl->batch_bufs[i]));
+  }
+  // Buffers of packets that didn't make it into the batch.
+  for (size_t i = cnt; i < impl->batch_bufs.size(); i++) {
+    a0_dealloc(packet_pool(), impl->batch_bufs[i]);
+  }
+  impl->batch_bufs.clear();
+
+  if (err != A0_ERR_AGAIN) {
+    check(err);
+  }
+  return ret;
+}
+
+// Allocates from the pool, recording the buffer for the read in progress.
+template <typename Impl>
+a0_alloc_t read_batch_alloc(Impl* impl) {
+  return {
+      .user_data = impl,
+      .alloc = [](void* user_data, size_t size, a0_buf_t* out) {
+        auto* impl = (Impl*)user_data;
+        A0_RETURN_ERR_ON_ERR(a0_alloc(packet_pool(), size, out));
+        if (impl->batching) {
+          impl->batch_bufs.push_back(*out);
+        } else {
+          impl->buf = *out;
+        }
+        return A0_OK;
+      },
+      .dealloc = nullptr,
+  };
+}
+
+}  // namespace
+}  // namespace a0
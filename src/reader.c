@@ -1,10 +1,14 @@
 #include <a0/alloc.h>
 #include <a0/arena.h>
 #include <a0/buf.h>
+#include <a0/cmp.h>
+#include <a0/cursor.h>
 #include <a0/empty.h>
 #include <a0/err.h>
 #include <a0/event.h>
+#include <a0/executor.h>
 #include <a0/inline.h>
+#include <a0/map.h>
 #include <a0/packet.h>
 #include <a0/reader.h>
 #include <a0/tid.h>
@@ -14,10 +18,19 @@
 
 #include <errno.h>
 #include <pthread.h>
+#include <sched.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
+#include "atomic.h"
+#include "clock.h"
 #include "err_macro.h"
+#include "ftx.h"
+#include "thread.h"
+#include "tsan.h"
 
 #ifdef DEBUG
 #include "ref_cnt.h"
@@ -26,20 +39,597 @@
 const a0_reader_options_t A0_READER_OPTIONS_DEFAULT = {
     .init = A0_INIT_AWAIT_NEW,
     .iter = A0_ITER_NEXT,
+    .optimistic = false,
+    .seq = 0,
+    .time = {{0, 0}},
+    .spin_ns = 0,
+    .lease = false,
+    .filter = {NULL, 0, false},
+    .executor = NULL,
+    .thread_attr = {NULL, 0, 0, 0, 0, NULL},
+    .lag = {0, 0, 0, {NULL, NULL}},
+    .conflate_key = NULL,
+    .cursor = {NULL},
 };
 
+// Optimistic reads copy the frame out of the arena before validating.
+// The copy buffer is grown as needed and reused across reads.
+A0_NO_TSAN
+static a0_err_t a0_reader_optimistic_copy(a0_transport_locked_t tlk, a0_buf_t* copy_buf, a0_flat_packet_t* out) {
+  // The frame may be overwritten at any time. The view reads the size once
+  // and bounds it by the arena.
+  a0_transport_frame_view_t frame;
+  A0_RETURN_ERR_ON_ERR(a0_transport_frame_view(tlk, &frame));
+  size_t size = frame.data.size;
+
+  if (copy_buf->size < size) {
+    uint8_t* data = (uint8_t*)realloc(copy_buf->data, size);
+    if (!data) {
+      return A0_MAKE_SYSERR(ENOMEM);
+    }
+    *copy_buf = (a0_buf_t){data, size};
+  }
+  memcpy(copy_buf->data, frame.data.data, size);
+
+  *out = (a0_flat_packet_t){{copy_buf->data, size}};
+  return A0_OK;
+}
+
+// Whether the frame to start at, with A0_INIT_AT_SEQ, has been written.
+A0_STATIC_INLINE
+a0_err_t a0_reader_init_seq_ready(a0_transport_locked_t tlk, uint64_t seq, bool* out) {
+  bool empty;
+  A0_RETURN_ERR_ON_ERR(a0_transport_empty(tlk, &empty));
+  uint64_t seq_high;
+  A0_RETURN_ERR_ON_ERR(a0_transport_seq_high(tlk, &seq_high));
+  *out = !empty && seq_high >= seq;
+  return A0_OK;
+}
+
+// Moves to the frame to start at, with A0_INIT_AT_SEQ.
+// Falls back to the oldest frame if the requested one was evicted.
+A0_STATIC_INLINE
+a0_err_t a0_reader_jump_init_seq(a0_transport_locked_t tlk, uint64_t seq) {
+  bool ready;
+  A0_RETURN_ERR_ON_ERR(a0_reader_init_seq_ready(tlk, seq, &ready));
+  if (!ready) {
+    return A0_ERR_AGAIN;
+  }
+
+  uint64_t seq_low;
+  A0_RETURN_ERR_ON_ERR(a0_transport_seq_low(tlk, &seq_low));
+  return a0_transport_jump_seq(tlk, seq < seq_low ? seq_low : seq);
+}
+
+// Whether the reader starts at a sequence number. With A0_INIT_AT_TIME, the
+// sequence number is found when the reader is created.
+A0_STATIC_INLINE
+bool a0_reader_starts_at_seq(a0_reader_options_t opts) {
+  return opts.init == A0_INIT_AT_SEQ || opts.init == A0_INIT_AT_TIME;
+}
+
+// Whether the frame at the transport pointer was stamped before the given time.
+// Frames without an a0_time_mono header count as older.
+A0_STATIC_INLINE
+bool a0_reader_frame_before(a0_transport_locked_t tlk, a0_time_mono_t time) {
+  a0_transport_frame_view_t frame;
+  a0_transport_frame_view(tlk, &frame);
+  a0_flat_packet_t fpkt = {frame.data};
+
+  a0_flat_packet_header_iterator_t iter;
+  a0_packet_header_t hdr;
+  a0_time_mono_t written;
+  a0_flat_packet_header_iterator_init(&iter, &fpkt);
+  if (a0_flat_packet_header_iterator_next_match(&iter, A0_TIME_MONO, &hdr) ||
+      a0_time_mono_parse(hdr.val, &written)) {
+    return true;
+  }
+  return written.ts.tv_sec < time.ts.tv_sec ||
+         (written.ts.tv_sec == time.ts.tv_sec && written.ts.tv_nsec < time.ts.tv_nsec);
+}
+
+// Sequence number of the first frame stamped at or after the given time, or
+// of the next frame to be written if there is none.
+//
+// Frames are stamped in the order they are written, so this is a binary
+// search. Only a logarithmic number of headers are parsed. The transport
+// pointer is left in place.
+A0_STATIC_INLINE
+uint64_t a0_reader_time_seq(a0_transport_locked_t tlk, a0_time_mono_t time) {
+  uint64_t seq_low;
+  uint64_t seq_high;
+  a0_transport_seq_low(tlk, &seq_low);
+  a0_transport_seq_high(tlk, &seq_high);
+  bool empty;
+  a0_transport_empty(tlk, &empty);
+  if (empty) {
+    return seq_high + 1;
+  }
+
+  uint64_t prev_seq = tlk.transport->_seq;
+  size_t prev_off = tlk.transport->_off;
+
+  uint64_t lo = seq_low;
+  uint64_t hi = seq_high + 1;
+  while (lo < hi) {
+    uint64_t mid = lo + (hi - lo) / 2;
+    a0_transport_jump_seq(tlk, mid);
+    if (a0_reader_frame_before(tlk, time)) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  tlk.transport->_seq = prev_seq;
+  tlk.transport->_off = prev_off;
+  return lo;
+}
+
+// Resumes after the last packet committed to the cursor, if any.
+A0_STATIC_INLINE
+void a0_reader_resume(a0_reader_options_t* opts) {
+  uint64_t seq = 0;
+  if (opts->cursor._seq) {
+    a0_cursor_load(opts->cursor, &seq);
+  }
+  if (seq) {
+    opts->init = A0_INIT_AT_SEQ;
+    opts->seq = seq + 1;
+  }
+}
+
+// Notes that the packet with the given sequence number was processed.
+A0_STATIC_INLINE
+void a0_reader_commit(a0_cursor_t cursor, uint64_t seq) {
+  if (cursor._seq) {
+    a0_cursor_commit(cursor, seq);
+  }
+}
+
+A0_STATIC_INLINE
+bool a0_reader_filter_clause_match(a0_reader_filter_clause_t clause, a0_flat_packet_t fpkt) {
+  a0_flat_packet_header_iterator_t iter;
+  a0_flat_packet_header_iterator_init(&iter, &fpkt);
+
+  // Keys may repeat. Any header with the key can satisfy the clause.
+  a0_packet_header_t hdr;
+  while (!a0_flat_packet_header_iterator_next_match(&iter, clause.key, &hdr)) {
+    if (clause.op == A0_FILTER_KEY_EXISTS) {
+      return true;
+    }
+    if (clause.op == A0_FILTER_KEY_EQUALS && !strcmp(hdr.val, clause.val)) {
+      return true;
+    }
+    if (clause.op == A0_FILTER_VAL_PREFIX && !strncmp(hdr.val, clause.val, strlen(clause.val))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Checks the headers in place. Nothing is copied or allocated.
+A0_STATIC_INLINE
+bool a0_reader_filter_match(a0_reader_filter_t filter, a0_flat_packet_t fpkt) {
+  for (size_t i = 0; i < filter.num_clauses; i++) {
+    if (a0_reader_filter_clause_match(filter.clauses[i], fpkt) == filter.any) {
+      return filter.any;
+    }
+  }
+  return !filter.any || !filter.num_clauses;
+}
+
+// Whether the frame at the transport pointer passes the filter.
+A0_STATIC_INLINE
+bool a0_reader_frame_match(a0_transport_locked_t tlk, a0_reader_filter_t filter) {
+  if (!filter.num_clauses) {
+    return true;
+  }
+  a0_transport_frame_view_t frame;
+  a0_transport_frame_view(tlk, &frame);
+  return a0_reader_filter_match(filter, (a0_flat_packet_t){frame.data});
+}
+
+// Whether a frame after the transport pointer passes the filter.
+// The transport pointer is left in place.
+A0_STATIC_INLINE
+bool a0_reader_has_next_match(a0_transport_locked_t tlk, a0_reader_filter_t filter) {
+  bool has_next = false;
+  a0_transport_has_next(tlk, &has_next);
+  if (!filter.num_clauses) {
+    return has_next;
+  }
+
+  uint64_t prev_seq = tlk.transport->_seq;
+  size_t prev_off = tlk.transport->_off;
+
+  bool found = false;
+  while (!found && has_next) {
+    a0_transport_step_next(tlk);
+    found = a0_reader_frame_match(tlk, filter);
+    a0_transport_has_next(tlk, &has_next);
+  }
+
+  tlk.transport->_seq = prev_seq;
+  tlk.transport->_off = prev_off;
+  return found;
+}
+
+// Latest per key.
+//
+// A scan walks back from the newest frame to the transport pointer, and keeps
+// the first frame it finds of each key. The reader then visits those in order.
+
+// Copies the key. Scans take the lock, so the reader can't be optimistic.
+A0_STATIC_INLINE
+a0_err_t a0_reader_conflate_init(a0_reader_conflate_t* conflate, a0_reader_options_t* opts) {
+  *conflate = (a0_reader_conflate_t)A0_EMPTY;
+  if (opts->iter != A0_ITER_LATEST_PER_KEY) {
+    return A0_OK;
+  }
+  opts->optimistic = false;
+  if (opts->conflate_key) {
+    conflate->key = strdup(opts->conflate_key);
+    if (!conflate->key) {
+      return A0_MAKE_SYSERR(ENOMEM);
+    }
+  }
+  return A0_OK;
+}
+
+A0_STATIC_INLINE
+void a0_reader_conflate_close(a0_reader_conflate_t* conflate) {
+  free(conflate->key);
+  free(conflate->seqs);
+  *conflate = (a0_reader_conflate_t)A0_EMPTY;
+}
+
+// Keeps the frame at the transport pointer, unless a newer one has its key.
+A0_STATIC_INLINE
+a0_err_t a0_reader_conflate_visit(a0_reader_conflate_t* conflate, a0_map_t* seen, a0_transport_locked_t tlk) {
+  a0_transport_frame_view_t frame;
+  a0_transport_frame_view(tlk, &frame);
+  a0_flat_packet_t fpkt = {frame.data};
+
+  // Keys point into the frames, which stay put while the lock is held.
+  const char* key = "";
+  if (conflate->key) {
+    a0_flat_packet_header_iterator_t iter;
+    a0_packet_header_t hdr;
+    a0_flat_packet_header_iterator_init(&iter, &fpkt);
+    if (!a0_flat_packet_header_iterator_next_match(&iter, conflate->key, &hdr)) {
+      key = hdr.val;
+    }
+  }
+
+  bool known;
+  a0_map_has(seen, &key, &known);
+  if (known) {
+    return A0_OK;
+  }
+
+  uint64_t seq = tlk.transport->_seq;
+  A0_RETURN_ERR_ON_ERR(a0_map_put(seen, &key, &seq));
+  if (conflate->cnt == conflate->cap) {
+    size_t cap = conflate->cap ? 2 * conflate->cap : 16;
+    uint64_t* seqs = (uint64_t*)realloc(conflate->seqs, cap * sizeof(uint64_t));
+    if (!seqs) {
+      return A0_MAKE_SYSERR(ENOMEM);
+    }
+    conflate->seqs = seqs;
+    conflate->cap = cap;
+  }
+  conflate->seqs[conflate->cnt++] = seq;
+  return A0_OK;
+}
+
+// Picks the newest matching frame of each key, from the transport pointer on.
+A0_STATIC_INLINE
+a0_err_t a0_reader_conflate_scan(a0_reader_conflate_t* conflate, a0_transport_locked_t tlk, a0_reader_filter_t filter) {
+  conflate->cnt = 0;
+  conflate->idx = 0;
+
+  uint64_t first_seq = tlk.transport->_seq;
+  a0_transport_jump_tail(tlk);
+  conflate->end_seq = tlk.transport->_seq;
+
+  a0_map_t seen;
+  A0_RETURN_ERR_ON_ERR(a0_map_init(&seen, sizeof(const char*), sizeof(uint64_t), A0_HASH_STR, A0_CMP_STR));
+
+  a0_err_t err = A0_OK;
+  bool has_prev = true;
+  while (!err && has_prev && tlk.transport->_seq >= first_seq) {
+    if (a0_reader_frame_match(tlk, filter)) {
+      err = a0_reader_conflate_visit(conflate, &seen, tlk);
+    }
+    a0_transport_has_prev(tlk, &has_prev);
+    if (has_prev) {
+      a0_transport_step_prev(tlk);
+    }
+  }
+  a0_map_close(&seen);
+
+  // Oldest first.
+  for (size_t i = 0; i < conflate->cnt / 2; i++) {
+    uint64_t tmp = conflate->seqs[i];
+    conflate->seqs[i] = conflate->seqs[conflate->cnt - 1 - i];
+    conflate->seqs[conflate->cnt - 1 - i] = tmp;
+  }
+  return err;
+}
+
+// Moves to the next frame the last scan picked. Frames evicted since are skipped.
+//
+// Once none are left, moves to the end of the scan, so the reader continues
+// from there, and fails with A0_ERR_AGAIN.
+A0_STATIC_INLINE
+a0_err_t a0_reader_conflate_next(a0_reader_conflate_t* conflate, a0_transport_locked_t tlk) {
+  while (conflate->idx < conflate->cnt) {
+    if (!a0_transport_jump_seq(tlk, conflate->seqs[conflate->idx++])) {
+      return A0_OK;
+    }
+  }
+  if (conflate->end_seq) {
+    a0_transport_jump_seq(tlk, conflate->end_seq);
+    conflate->end_seq = 0;
+  }
+  return A0_ERR_AGAIN;
+}
+
+// Moves to the next frame to read: the sequentially next, or the newest.
+// A0_ITER_LATEST_PER_KEY scans from the sequentially next.
+A0_STATIC_INLINE
+void a0_reader_step(a0_transport_locked_t tlk, a0_reader_iter_t iter) {
+  if (iter == A0_ITER_NEWEST) {
+    a0_transport_jump_tail(tlk);
+  } else {
+    a0_transport_step_next(tlk);
+  }
+}
+
+// Lag and drop accounting.
+//
+// Counters are only written by the thread reading, but may be read by any.
+
+// Sequence number just before the first frame the reader will read, as of init.
+// Zero if unknown.
+A0_STATIC_INLINE
+uint64_t a0_reader_counters_baseline(a0_transport_locked_t tlk, a0_reader_options_t opts) {
+  if (a0_reader_starts_at_seq(opts)) {
+    return opts.seq ? opts.seq - 1 : 0;
+  }
+
+  bool empty;
+  a0_transport_empty(tlk, &empty);
+  if (empty) {
+    return 0;
+  }
+  uint64_t seq_low;
+  uint64_t seq_high;
+  a0_transport_seq_low(tlk, &seq_low);
+  a0_transport_seq_high(tlk, &seq_high);
+  if (opts.init == A0_INIT_OLDEST) {
+    return seq_low - 1;
+  } else if (opts.init == A0_INIT_MOST_RECENT) {
+    return seq_high - 1;
+  }
+  return seq_high;
+}
+
+// Notes that the reader moved onto the frame with the given sequence number.
+// Frames skipped over with A0_ITER_NEXT were evicted.
+A0_STATIC_INLINE
+void a0_reader_count_read(a0_reader_counters_t* counters, a0_reader_iter_t iter, uint64_t seq) {
+  uint64_t last_seq = counters->last_seq;
+  counters->last_seq = seq;
+  if (iter == A0_ITER_NEXT && last_seq && seq > last_seq + 1) {
+    a0_atomic_store(&counters->stats.dropped, counters->stats.dropped + (seq - last_seq - 1));
+  }
+}
+
+// A serialized a0_time_mono_t, in ns. Zero if it doesn't parse.
+A0_STATIC_INLINE
+uint64_t a0_reader_mono_str_ns(const char mono_str[20]) {
+  a0_time_mono_t written;
+  if (a0_time_mono_parse(mono_str, &written)) {
+    return 0;
+  }
+  return (uint64_t)written.ts.tv_sec * NS_PER_SEC + (uint64_t)written.ts.tv_nsec;
+}
+
+// When the packet was written, in ns, from its a0_time_mono header.
+// Zero if the header is missing.
+A0_STATIC_INLINE
+uint64_t a0_reader_packet_written_ns(a0_flat_packet_t fpkt) {
+  a0_flat_packet_header_iterator_t iter;
+  a0_packet_header_t hdr;
+  a0_flat_packet_header_iterator_init(&iter, &fpkt);
+  if (a0_flat_packet_header_iterator_next_match(&iter, A0_TIME_MONO, &hdr)) {
+    return 0;
+  }
+  return a0_reader_mono_str_ns(hdr.val);
+}
+
+// Copies the a0_time_mono header value out of the frame at the transport
+// pointer, which may be overwritten at any time. Only the header index and
+// the matching header are read, each bounded by the frame.
+A0_STATIC_INLINE
+a0_err_t a0_reader_optimistic_copy_written(a0_transport_locked_t tlk, char out[20]) {
+  a0_transport_frame_view_t frame;
+  A0_RETURN_ERR_ON_ERR(a0_transport_frame_view(tlk, &frame));
+  a0_buf_t data = frame.data;
+
+  // ID, then the header count, then a key and value offset per header.
+  size_t idx_off = sizeof(a0_uuid_t) + sizeof(size_t);
+  if (data.size < idx_off) {
+    return A0_ERR_NOT_FOUND;
+  }
+  size_t num_hdrs;
+  memcpy(&num_hdrs, data.data + sizeof(a0_uuid_t), sizeof(size_t));
+  if (num_hdrs > (data.size - idx_off) / (2 * sizeof(size_t))) {
+    return A0_ERR_NOT_FOUND;
+  }
+
+  size_t key_size = strlen(A0_TIME_MONO) + 1;
+  for (size_t i = 0; i < num_hdrs; i++) {
+    size_t key_off;
+    size_t val_off;
+    memcpy(&key_off, data.data + idx_off + (2 * i) * sizeof(size_t), sizeof(size_t));
+    memcpy(&val_off, data.data + idx_off + (2 * i + 1) * sizeof(size_t), sizeof(size_t));
+    if (key_off > data.size - key_size || memcmp(data.data + key_off, A0_TIME_MONO, key_size)) {
+      continue;
+    }
+    if (val_off > data.size - 20) {
+      return A0_ERR_NOT_FOUND;
+    }
+    memcpy(out, data.data + val_off, 20);
+    return A0_OK;
+  }
+  return A0_ERR_NOT_FOUND;
+}
+
+// Time since written_ns. Zero if it is unknown.
+A0_STATIC_INLINE
+uint64_t a0_reader_age_ns(uint64_t written_ns) {
+  if (!written_ns) {
+    return 0;
+  }
+  a0_time_mono_t now;
+  a0_time_mono_now(&now);
+  uint64_t now_ns = (uint64_t)now.ts.tv_sec * NS_PER_SEC + (uint64_t)now.ts.tv_nsec;
+  return now_ns > written_ns ? now_ns - written_ns : 0;
+}
+
+// Notes a delivery, and calls back if the lag just reached the threshold.
+//
+// lag_frames and lag_bytes come from a0_transport_lag, at the delivered frame.
+// The packet headers are only parsed if the threshold has a ns limit.
+A0_STATIC_INLINE
+void a0_reader_count_delivered(a0_reader_counters_t* counters,
+                               a0_reader_lag_threshold_t threshold,
+                               uint64_t lag_frames,
+                               size_t lag_bytes,
+                               a0_transport_t* transport,
+                               a0_flat_packet_t fpkt) {
+  a0_reader_stats_t* stats = &counters->stats;
+  a0_atomic_store(&stats->delivered, stats->delivered + 1);
+  a0_atomic_store(&stats->lag_frames, lag_frames);
+  a0_atomic_store(&stats->lag_bytes, (uint64_t)lag_bytes);
+  a0_atomic_store(&counters->delivered_seq, transport->_seq);
+  a0_atomic_store(&counters->delivered_off, transport->_off);
+  if (threshold.ns) {
+    uint64_t written_ns = a0_reader_packet_written_ns(fpkt);
+    a0_atomic_store(&counters->written_ns, written_ns);
+    a0_atomic_store(&stats->lag_ns, a0_reader_age_ns(written_ns));
+  }
+
+  if (!threshold.onlag.fn) {
+    return;
+  }
+  bool lagging = (threshold.frames && stats->lag_frames >= threshold.frames) ||
+                 (threshold.bytes && stats->lag_bytes >= threshold.bytes) ||
+                 (threshold.ns && stats->lag_ns >= threshold.ns);
+  if (lagging && !counters->lagging) {
+    threshold.onlag.fn(threshold.onlag.user_data, *stats);
+  }
+  counters->lagging = lagging;
+}
+
+// Lag at the transport pointer. Zero if it can't be measured.
+A0_STATIC_INLINE
+void a0_reader_lag(a0_transport_locked_t tlk, uint64_t* frames, size_t* bytes) {
+  if (a0_transport_lag(tlk, frames, bytes)) {
+    *frames = 0;
+    *bytes = 0;
+  }
+}
+
+// Write time of the last delivered packet, read back from the arena.
+// Zero if it has been evicted since.
+A0_STATIC_INLINE
+uint64_t a0_reader_counters_written_ns(a0_reader_counters_t* counters) {
+  uint64_t seq = a0_atomic_load(&counters->delivered_seq);
+  size_t off = a0_atomic_load(&counters->delivered_off);
+  if (!seq) {
+    return 0;
+  }
+
+  // The reader's own connection may be in use. Read optimistically, through
+  // a scratch connection to the same arena, so this never takes the lock.
+  a0_transport_t transport = A0_EMPTY;
+  transport._arena = counters->transport->_arena;
+  transport._map = transport._arena.buf;
+  transport._compact = counters->transport->_compact;
+  char written[20];
+  uint64_t written_ns = 0;
+  while (true) {
+    a0_transport_locked_t tlk;
+    if (a0_transport_optimistic_begin(&transport, &tlk)) {
+      break;
+    }
+    uint64_t seq_low;
+    a0_err_t err = a0_transport_seq_low(tlk, &seq_low);
+    if (!err && seq < seq_low) {
+      err = A0_ERR_RANGE;
+    }
+    if (!err) {
+      err = a0_transport_jump(tlk, off);
+    }
+    if (!err && transport._seq != seq) {
+      err = A0_ERR_RANGE;
+    }
+    if (!err) {
+      err = a0_reader_optimistic_copy_written(tlk, written);
+    }
+    if (a0_transport_optimistic_end(tlk)) {
+      // A writer committed mid-read.
+      continue;
+    }
+    if (!err) {
+      written_ns = a0_reader_mono_str_ns(written);
+    }
+    break;
+  }
+  return written_ns;
+}
+
+A0_STATIC_INLINE
+void a0_reader_counters_snapshot(a0_reader_counters_t* counters, a0_reader_stats_t* out) {
+  out->delivered = a0_atomic_load(&counters->stats.delivered);
+  out->dropped = a0_atomic_load(&counters->stats.dropped);
+  out->lag_frames = a0_atomic_load(&counters->stats.lag_frames);
+  out->lag_bytes = a0_atomic_load(&counters->stats.lag_bytes);
+  uint64_t written_ns = a0_atomic_load(&counters->written_ns);
+  if (!written_ns) {
+    written_ns = a0_reader_counters_written_ns(counters);
+  }
+  out->lag_ns = a0_reader_age_ns(written_ns);
+  out->evicted = a0_atomic_load(&counters->stats.evicted);
+  out->unleased = a0_atomic_load(&counters->stats.unleased);
+}
+
 // Synchronous zero-copy version.
 
 a0_err_t a0_reader_sync_zc_init(a0_reader_sync_zc_t* reader_sync_zc,
                                 a0_arena_t arena,
                                 a0_reader_options_t opts) {
-  reader_sync_zc->_opts = opts;
   reader_sync_zc->_first_read_done = false;
+  reader_sync_zc->_optimistic_buf = (a0_buf_t)A0_EMPTY;
+  reader_sync_zc->_counters = (a0_reader_counters_t)A0_EMPTY;
+  A0_RETURN_ERR_ON_ERR(a0_reader_conflate_init(&reader_sync_zc->_conflate, &opts));
+  a0_reader_resume(&opts);
+  reader_sync_zc->_opts = opts;
   A0_RETURN_ERR_ON_ERR(a0_transport_init(&reader_sync_zc->_transport, arena));
+  A0_RETURN_ERR_ON_ERR(a0_transport_set_spin(&reader_sync_zc->_transport, opts.spin_ns));
+  reader_sync_zc->_counters.transport = &reader_sync_zc->_transport;
 
   a0_transport_locked_t tlk;
   A0_RETURN_ERR_ON_ERR(a0_transport_lock(&reader_sync_zc->_transport, &tlk));
 
+  if (opts.init == A0_INIT_AT_TIME) {
+    reader_sync_zc->_opts.seq = a0_reader_time_seq(tlk, opts.time);
+  }
+  reader_sync_zc->_counters.last_seq = a0_reader_counters_baseline(tlk, reader_sync_zc->_opts);
   if (opts.init == A0_INIT_OLDEST) {
     a0_transport_jump_head(tlk);
   } else if (opts.init == A0_INIT_MOST_RECENT || opts.init == A0_INIT_AWAIT_NEW) {
@@ -64,63 +654,239 @@ a0_err_t a0_reader_sync_zc_close(a0_reader_sync_zc_t* reader_sync_zc) {
       "Reader (sync+zc) closing. Arena was previously closed.");
 #endif
 
+  free(reader_sync_zc->_optimistic_buf.data);
+  reader_sync_zc->_optimistic_buf = (a0_buf_t)A0_EMPTY;
+  a0_reader_conflate_close(&reader_sync_zc->_conflate);
+
   return A0_OK;
 }
 
+A0_STATIC_INLINE
+a0_err_t a0_reader_sync_zc_can_read_impl(a0_reader_sync_zc_t* reader_sync_zc, a0_transport_locked_t tlk, bool* can_read) {
+  if (reader_sync_zc->_conflate.idx < reader_sync_zc->_conflate.cnt) {
+    *can_read = true;
+    return A0_OK;
+  }
+  if (!reader_sync_zc->_first_read_done && a0_reader_starts_at_seq(reader_sync_zc->_opts)) {
+    return a0_reader_init_seq_ready(tlk, reader_sync_zc->_opts.seq, can_read);
+  }
+  if (reader_sync_zc->_first_read_done || reader_sync_zc->_opts.init == A0_INIT_AWAIT_NEW) {
+    return a0_transport_has_next(tlk, can_read);
+  }
+  return a0_transport_nonempty(tlk, can_read);
+}
+
+A0_STATIC_INLINE
+a0_err_t a0_reader_sync_zc_read_align(void* unused, a0_reader_sync_zc_t* reader_sync_zc, a0_transport_locked_t tlk);
+
+// Reads past frames the filter would skip, as a read would.
+// The transport pointer is left just before the first frame that matches.
+A0_STATIC_INLINE
+a0_err_t a0_reader_sync_zc_skip_filtered(a0_reader_sync_zc_t* reader_sync_zc, a0_transport_locked_t tlk, bool* can_read) {
+  *can_read = false;
+  while (true) {
+    uint64_t prev_seq = tlk.transport->_seq;
+    size_t prev_off = tlk.transport->_off;
+    bool prev_first_read_done = reader_sync_zc->_first_read_done;
+
+    a0_err_t err = a0_reader_sync_zc_read_align(NULL, reader_sync_zc, tlk);
+    if (err == A0_ERR_AGAIN) {
+      return A0_OK;
+    }
+    A0_RETURN_ERR_ON_ERR(err);
+
+    if (a0_reader_frame_match(tlk, reader_sync_zc->_opts.filter)) {
+      tlk.transport->_seq = prev_seq;
+      tlk.transport->_off = prev_off;
+      reader_sync_zc->_first_read_done = prev_first_read_done;
+      *can_read = true;
+      return A0_OK;
+    }
+    reader_sync_zc->_first_read_done = true;
+  }
+}
+
 a0_err_t a0_reader_sync_zc_can_read(a0_reader_sync_zc_t* reader_sync_zc, bool* can_read) {
   A0_ASSERT(reader_sync_zc, "Cannot read from null reader (sync+zc).");
 
   a0_err_t err;
   a0_transport_locked_t tlk;
+  bool filtered = reader_sync_zc->_opts.filter.num_clauses;
+
+  // With a filter, skipping frames takes the lock.
+  if (reader_sync_zc->_opts.optimistic && !filtered) {
+    // The snapshot alone is consistent. No need to validate.
+    A0_RETURN_ERR_ON_ERR(a0_transport_optimistic_begin(&reader_sync_zc->_transport, &tlk));
+    err = a0_reader_sync_zc_can_read_impl(reader_sync_zc, tlk, can_read);
+    a0_transport_optimistic_end(tlk);
+    return err;
+  }
+
   A0_RETURN_ERR_ON_ERR(a0_transport_lock(&reader_sync_zc->_transport, &tlk));
+  err = a0_reader_sync_zc_can_read_impl(reader_sync_zc, tlk, can_read);
+  if (!err && *can_read && filtered) {
+    err = a0_reader_sync_zc_skip_filtered(reader_sync_zc, tlk, can_read);
+  }
+  a0_transport_unlock(tlk);
+  return err;
+}
 
-  if (reader_sync_zc->_first_read_done || reader_sync_zc->_opts.init == A0_INIT_AWAIT_NEW) {
-    err = a0_transport_has_next(tlk, can_read);
-  } else {
-    err = a0_transport_nonempty(tlk, can_read);
+// Passes the frame at the transport pointer to the callback.
+//
+// With leases, the callback runs with the transport unlocked. The transport is
+// locked again on return. Frames evicted in the meantime are counted, and
+// reported with A0_ERR_EVICTED. Fallbacks to the locked path are counted too.
+//
+// If the lock can't be taken again, its error is returned with the transport
+// unlocked and the lease still held. See a0_reader_deliver_locked.
+A0_STATIC_INLINE
+a0_err_t a0_reader_deliver(a0_reader_counters_t* counters,
+                           a0_transport_locked_t tlk,
+                           bool lease,
+                           a0_zero_copy_callback_t cb) {
+  a0_transport_frame_view_t frame;
+  a0_transport_frame_view(tlk, &frame);
+
+  a0_flat_packet_t flat_packet = {
+      .buf = frame.data,
+  };
+
+  if (!lease) {
+    cb.fn(cb.user_data, tlk, flat_packet);
+    return A0_OK;
+  }
+
+  // If every lease is taken, fall back to holding the lock.
+  a0_transport_lease_t frame_lease;
+  if (a0_transport_lease(tlk, &frame_lease)) {
+    a0_atomic_store(&counters->stats.unleased, counters->stats.unleased + 1);
+    cb.fn(cb.user_data, tlk, flat_packet);
+    return A0_OK;
   }
 
   a0_transport_unlock(tlk);
+  cb.fn(cb.user_data, tlk, flat_packet);
+  A0_RETURN_ERR_ON_ERR(a0_transport_lock(tlk.transport, &tlk));
+  a0_err_t err = a0_transport_lease_release(tlk, frame_lease);
+  if (err == A0_ERR_EVICTED) {
+    a0_atomic_store(&counters->stats.evicted, counters->stats.evicted + 1);
+  }
   return err;
 }
 
+// Whether a0_reader_deliver returned with the transport locked.
+A0_STATIC_INLINE
+bool a0_reader_deliver_locked(a0_err_t err) {
+  return !err || err == A0_ERR_EVICTED;
+}
+
+A0_STATIC_INLINE
+void a0_reader_sync_zc_count_delivered(a0_reader_sync_zc_t* reader_sync_zc, a0_transport_locked_t tlk) {
+  uint64_t lag_frames;
+  size_t lag_bytes;
+  a0_reader_lag(tlk, &lag_frames, &lag_bytes);
+  a0_transport_frame_view_t frame;
+  a0_transport_frame_view(tlk, &frame);
+  a0_reader_count_delivered(&reader_sync_zc->_counters,
+                            reader_sync_zc->_opts.lag,
+                            lag_frames,
+                            lag_bytes,
+                            tlk.transport,
+                            (a0_flat_packet_t){frame.data});
+}
+
 typedef struct a0_reader_sync_zc_align_read_callback_s {
   void* user_data;
   a0_err_t (*fn)(void* user_data, a0_reader_sync_zc_t*, a0_transport_locked_t);
 } a0_reader_sync_zc_read_align_callback_t;
 
+// Aligns as asked. With A0_ITER_LATEST_PER_KEY, first visits what is left of
+// the last scan, and once that runs out, aligns and scans again.
+A0_STATIC_INLINE
+a0_err_t a0_reader_sync_zc_align(a0_reader_sync_zc_t* reader_sync_zc,
+                                 a0_transport_locked_t tlk,
+                                 a0_reader_sync_zc_read_align_callback_t align) {
+  if (reader_sync_zc->_opts.iter != A0_ITER_LATEST_PER_KEY) {
+    return align.fn(align.user_data, reader_sync_zc, tlk);
+  }
+  while (a0_reader_conflate_next(&reader_sync_zc->_conflate, tlk)) {
+    A0_RETURN_ERR_ON_ERR(align.fn(align.user_data, reader_sync_zc, tlk));
+    reader_sync_zc->_first_read_done = true;
+    A0_RETURN_ERR_ON_ERR(a0_reader_conflate_scan(&reader_sync_zc->_conflate, tlk, reader_sync_zc->_opts.filter));
+  }
+  return A0_OK;
+}
+
+// Reads up to max_cnt packets under a single lock hold.
+//
+// align_read positions the transport at the first packet. The rest are only
+// read if already available.
 A0_STATIC_INLINE
 a0_err_t a0_reader_sync_zc_read_helper(a0_reader_sync_zc_t* reader_sync_zc,
+                                       size_t max_cnt,
                                        a0_zero_copy_callback_t cb,
-                                       a0_reader_sync_zc_read_align_callback_t align_read) {
+                                       a0_reader_sync_zc_read_align_callback_t align_read,
+                                       size_t* out_cnt) {
   A0_ASSERT(reader_sync_zc, "Cannot read from null reader (sync+zc).");
 
-  a0_transport_locked_t tlk;
-  A0_RETURN_ERR_ON_ERR(a0_transport_lock(&reader_sync_zc->_transport, &tlk));
-
-  a0_err_t err = align_read.fn(align_read.user_data, reader_sync_zc, tlk);
-  if (err) {
-    a0_transport_unlock(tlk);
-    return err;
+  if (out_cnt) {
+    *out_cnt = 0;
+  }
+  if (!max_cnt) {
+    return A0_ERR_INVALID_ARG;
   }
 
-  reader_sync_zc->_first_read_done = true;
-
-  a0_transport_frame_t* frame;
-  a0_transport_frame(tlk, &frame);
+  a0_transport_locked_t tlk;
+  A0_RETURN_ERR_ON_ERR(a0_transport_lock(&reader_sync_zc->_transport, &tlk));
 
-  a0_flat_packet_t flat_packet = {
-      .buf = {frame->data, frame->hdr.data_size},
-  };
+  a0_reader_sync_zc_read_align_callback_t align_next = {NULL, a0_reader_sync_zc_read_align};
+  a0_err_t err = a0_reader_sync_zc_align(reader_sync_zc, tlk, align_read);
+  size_t cnt = 0;
+  while (!err) {
+    reader_sync_zc->_first_read_done = true;
+    a0_reader_count_read(&reader_sync_zc->_counters, reader_sync_zc->_opts.iter, tlk.transport->_seq);
+
+    // Skipped frames don't count. Until the first match, keep aligning as asked.
+    if (!a0_reader_frame_match(tlk, reader_sync_zc->_opts.filter)) {
+      err = a0_reader_sync_zc_align(reader_sync_zc, tlk, cnt ? align_next : align_read);
+      continue;
+    }
 
-  cb.fn(cb.user_data, tlk, flat_packet);
+    a0_reader_sync_zc_count_delivered(reader_sync_zc, tlk);
+    uint64_t seq = tlk.transport->_seq;
+    err = a0_reader_deliver(&reader_sync_zc->_counters, tlk, reader_sync_zc->_opts.lease, cb);
+    a0_reader_commit(reader_sync_zc->_opts.cursor, seq);
+    cnt++;
+    if (!a0_reader_deliver_locked(err)) {
+      if (out_cnt) {
+        *out_cnt = cnt;
+      }
+      return err;
+    }
+    if (err || cnt == max_cnt) {
+      break;
+    }
+    err = a0_reader_sync_zc_align(reader_sync_zc, tlk, align_next);
+  }
+  a0_transport_unlock(tlk);
 
-  return a0_transport_unlock(tlk);
+  if (out_cnt) {
+    *out_cnt = cnt;
+  }
+  // Running out of packets after the first is not an error.
+  if (cnt && err == A0_ERR_AGAIN) {
+    return A0_OK;
+  }
+  return err;
 }
 
 A0_STATIC_INLINE
 a0_err_t a0_reader_sync_zc_read_align(void* unused, a0_reader_sync_zc_t* reader_sync_zc, a0_transport_locked_t tlk) {
   A0_MAYBE_UNUSED(unused);
+  if (!reader_sync_zc->_first_read_done && a0_reader_starts_at_seq(reader_sync_zc->_opts)) {
+    return a0_reader_jump_init_seq(tlk, reader_sync_zc->_opts.seq);
+  }
+
   bool empty;
   a0_transport_empty(tlk, &empty);
   if (empty) {
@@ -143,27 +909,172 @@ a0_err_t a0_reader_sync_zc_read_align(void* unused, a0_reader_sync_zc_t* reader_
   }
 
   if (should_step) {
-    if (reader_sync_zc->_opts.iter == A0_ITER_NEXT) {
-      a0_transport_step_next(tlk);
-    } else if (reader_sync_zc->_opts.iter == A0_ITER_NEWEST) {
-      a0_transport_jump_tail(tlk);
+    a0_reader_step(tlk, reader_sync_zc->_opts.iter);
+  }
+
+  return A0_OK;
+}
+
+// Frame a0_reader_sync_zc_can_read_impl waits for. Zero if any frame will do.
+A0_STATIC_INLINE
+uint64_t a0_reader_sync_zc_wait_seq(a0_reader_sync_zc_t* reader_sync_zc, a0_transport_locked_t tlk) {
+  if (!reader_sync_zc->_first_read_done && a0_reader_starts_at_seq(reader_sync_zc->_opts)) {
+    return reader_sync_zc->_opts.seq;
+  }
+  if (reader_sync_zc->_first_read_done || reader_sync_zc->_opts.init == A0_INIT_AWAIT_NEW) {
+    return tlk.transport->_seq + 1;
+  }
+  return 0;
+}
+
+typedef struct a0_reader_sync_zc_can_read_pred_data_s {
+  a0_reader_sync_zc_t* reader_sync_zc;
+  a0_transport_locked_t* tlk;
+} a0_reader_sync_zc_can_read_pred_data_t;
+
+A0_STATIC_INLINE
+a0_err_t a0_reader_sync_zc_can_read_pred_fn(void* user_data, bool* out) {
+  a0_reader_sync_zc_can_read_pred_data_t* data = (a0_reader_sync_zc_can_read_pred_data_t*)user_data;
+  return a0_reader_sync_zc_can_read_impl(data->reader_sync_zc, *data->tlk, out);
+}
+
+// Lock-free version of a0_reader_sync_zc_read_helper.
+//
+// If nothing is available and blocking is requested, the lock is taken
+// only to wait for the next commit.
+A0_STATIC_INLINE
+a0_err_t a0_reader_sync_zc_read_optimistic_one(a0_reader_sync_zc_t* reader_sync_zc,
+                                               a0_zero_copy_callback_t cb,
+                                               bool blocking,
+                                               a0_time_mono_t* timeout) {
+  A0_ASSERT(reader_sync_zc, "Cannot read from null reader (sync+zc).");
+
+  a0_transport_t* transport = &reader_sync_zc->_transport;
+  a0_transport_locked_t tlk;
+  a0_flat_packet_t fpkt;
+  uint64_t lag_frames = 0;
+  size_t lag_bytes = 0;
+
+  while (true) {
+    uint64_t prev_seq = transport->_seq;
+    size_t prev_off = transport->_off;
+
+    A0_RETURN_ERR_ON_ERR(a0_transport_optimistic_begin(transport, &tlk));
+    a0_err_t err = a0_reader_sync_zc_read_align(NULL, reader_sync_zc, tlk);
+    if (!err) {
+      err = a0_reader_optimistic_copy(tlk, &reader_sync_zc->_optimistic_buf, &fpkt);
+      a0_reader_lag(tlk, &lag_frames, &lag_bytes);
+    }
+
+    if (a0_transport_optimistic_end(tlk)) {
+      // A writer committed mid-read. Nothing read can be trusted.
+      transport->_seq = prev_seq;
+      transport->_off = prev_off;
+      continue;
+    }
+
+    if (err != A0_ERR_AGAIN) {
+      if (err) {
+        // The copy failed. Leave the packet for the next read.
+        transport->_seq = prev_seq;
+        transport->_off = prev_off;
+        return err;
+      }
+      // The copy is validated, so its headers are safe to check.
+      reader_sync_zc->_first_read_done = true;
+      a0_reader_count_read(&reader_sync_zc->_counters, reader_sync_zc->_opts.iter, transport->_seq);
+      if (a0_reader_filter_match(reader_sync_zc->_opts.filter, fpkt)) {
+        a0_reader_count_delivered(&reader_sync_zc->_counters, reader_sync_zc->_opts.lag, lag_frames, lag_bytes, transport, fpkt);
+        break;
+      }
+      continue;
     }
+
+    // Nothing to read.
+    if (!blocking) {
+      return A0_ERR_AGAIN;
+    }
+
+    A0_RETURN_ERR_ON_ERR(a0_transport_lock(transport, &tlk));
+    a0_reader_sync_zc_can_read_pred_data_t pred_data = {reader_sync_zc, &tlk};
+    err = a0_transport_timedwait_seq(tlk,
+                                     a0_reader_sync_zc_wait_seq(reader_sync_zc, tlk),
+                                     (a0_predicate_t){&pred_data, a0_reader_sync_zc_can_read_pred_fn},
+                                     timeout);
+    a0_transport_unlock(tlk);
+    A0_RETURN_ERR_ON_ERR(err);
   }
 
+  cb.fn(cb.user_data, tlk, fpkt);
+  a0_reader_commit(reader_sync_zc->_opts.cursor, transport->_seq);
   return A0_OK;
 }
 
+// Optimistic version of a0_reader_sync_zc_read_helper.
+//
+// Only the first packet may block. Each packet is validated on its own.
+A0_STATIC_INLINE
+a0_err_t a0_reader_sync_zc_read_optimistic(a0_reader_sync_zc_t* reader_sync_zc,
+                                           size_t max_cnt,
+                                           a0_zero_copy_callback_t cb,
+                                           bool blocking,
+                                           a0_time_mono_t* timeout,
+                                           size_t* out_cnt) {
+  if (out_cnt) {
+    *out_cnt = 0;
+  }
+  if (!max_cnt) {
+    return A0_ERR_INVALID_ARG;
+  }
+
+  a0_err_t err = a0_reader_sync_zc_read_optimistic_one(reader_sync_zc, cb, blocking, timeout);
+  size_t cnt = 0;
+  while (!err) {
+    cnt++;
+    if (cnt == max_cnt) {
+      break;
+    }
+    err = a0_reader_sync_zc_read_optimistic_one(reader_sync_zc, cb, false, NULL);
+  }
+
+  if (out_cnt) {
+    *out_cnt = cnt;
+  }
+  if (cnt && err == A0_ERR_AGAIN) {
+    return A0_OK;
+  }
+  return err;
+}
+
 a0_err_t a0_reader_sync_zc_read(a0_reader_sync_zc_t* reader_sync_zc,
                                 a0_zero_copy_callback_t cb) {
+  return a0_reader_sync_zc_read_batch(reader_sync_zc, 1, cb, NULL);
+}
+
+a0_err_t a0_reader_sync_zc_read_batch(a0_reader_sync_zc_t* reader_sync_zc,
+                                      size_t max_cnt,
+                                      a0_zero_copy_callback_t cb,
+                                      size_t* out_cnt) {
+  if (reader_sync_zc->_opts.optimistic) {
+    return a0_reader_sync_zc_read_optimistic(reader_sync_zc, max_cnt, cb, false, NULL, out_cnt);
+  }
   return a0_reader_sync_zc_read_helper(
       reader_sync_zc,
+      max_cnt,
       cb,
-      (a0_reader_sync_zc_read_align_callback_t){NULL, a0_reader_sync_zc_read_align});
+      (a0_reader_sync_zc_read_align_callback_t){NULL, a0_reader_sync_zc_read_align},
+      out_cnt);
 }
 
 A0_STATIC_INLINE
 a0_err_t a0_reader_sync_zc_read_blocking_align(void* unused, a0_reader_sync_zc_t* reader_sync_zc, a0_transport_locked_t tlk) {
   A0_MAYBE_UNUSED(unused);
+  if (!reader_sync_zc->_first_read_done && a0_reader_starts_at_seq(reader_sync_zc->_opts)) {
+    a0_reader_sync_zc_can_read_pred_data_t pred_data = {reader_sync_zc, &tlk};
+    A0_RETURN_ERR_ON_ERR(a0_transport_wait_seq(tlk, reader_sync_zc->_opts.seq, (a0_predicate_t){&pred_data, a0_reader_sync_zc_can_read_pred_fn}));
+    return a0_reader_jump_init_seq(tlk, reader_sync_zc->_opts.seq);
+  }
+
   A0_RETURN_ERR_ON_ERR(a0_transport_wait(tlk, a0_transport_nonempty_pred(&tlk)));
 
   bool should_step = reader_sync_zc->_first_read_done || reader_sync_zc->_opts.init == A0_INIT_AWAIT_NEW;
@@ -174,12 +1085,8 @@ a0_err_t a0_reader_sync_zc_read_blocking_align(void* unused, a0_reader_sync_zc_t
   }
 
   if (should_step) {
-    A0_RETURN_ERR_ON_ERR(a0_transport_wait(tlk, a0_transport_has_next_pred(&tlk)));
-    if (reader_sync_zc->_opts.iter == A0_ITER_NEXT) {
-      a0_transport_step_next(tlk);
-    } else if (reader_sync_zc->_opts.iter == A0_ITER_NEWEST) {
-      a0_transport_jump_tail(tlk);
-    }
+    A0_RETURN_ERR_ON_ERR(a0_transport_wait_seq(tlk, tlk.transport->_seq + 1, a0_transport_has_next_pred(&tlk)));
+    a0_reader_step(tlk, reader_sync_zc->_opts.iter);
   }
 
   return A0_OK;
@@ -187,15 +1094,33 @@ a0_err_t a0_reader_sync_zc_read_blocking_align(void* unused, a0_reader_sync_zc_t
 
 a0_err_t a0_reader_sync_zc_read_blocking(a0_reader_sync_zc_t* reader_sync_zc,
                                          a0_zero_copy_callback_t cb) {
+  return a0_reader_sync_zc_read_batch_blocking(reader_sync_zc, 1, cb, NULL);
+}
+
+a0_err_t a0_reader_sync_zc_read_batch_blocking(a0_reader_sync_zc_t* reader_sync_zc,
+                                               size_t max_cnt,
+                                               a0_zero_copy_callback_t cb,
+                                               size_t* out_cnt) {
+  if (reader_sync_zc->_opts.optimistic) {
+    return a0_reader_sync_zc_read_optimistic(reader_sync_zc, max_cnt, cb, true, A0_TIMEOUT_NEVER, out_cnt);
+  }
   return a0_reader_sync_zc_read_helper(
       reader_sync_zc,
+      max_cnt,
       cb,
-      (a0_reader_sync_zc_read_align_callback_t){NULL, a0_reader_sync_zc_read_blocking_align});
+      (a0_reader_sync_zc_read_align_callback_t){NULL, a0_reader_sync_zc_read_blocking_align},
+      out_cnt);
 }
 
 A0_STATIC_INLINE
 a0_err_t a0_reader_sync_zc_read_blocking_timeout_align(void* user_data, a0_reader_sync_zc_t* reader_sync_zc, a0_transport_locked_t tlk) {
   a0_time_mono_t* timeout = (a0_time_mono_t*)user_data;
+  if (!reader_sync_zc->_first_read_done && a0_reader_starts_at_seq(reader_sync_zc->_opts)) {
+    a0_reader_sync_zc_can_read_pred_data_t pred_data = {reader_sync_zc, &tlk};
+    A0_RETURN_ERR_ON_ERR(a0_transport_timedwait_seq(tlk, reader_sync_zc->_opts.seq, (a0_predicate_t){&pred_data, a0_reader_sync_zc_can_read_pred_fn}, timeout));
+    return a0_reader_jump_init_seq(tlk, reader_sync_zc->_opts.seq);
+  }
+
   A0_RETURN_ERR_ON_ERR(a0_transport_timedwait(tlk, a0_transport_nonempty_pred(&tlk), timeout));
 
   bool should_step = reader_sync_zc->_first_read_done || reader_sync_zc->_opts.init == A0_INIT_AWAIT_NEW;
@@ -206,12 +1131,8 @@ a0_err_t a0_reader_sync_zc_read_blocking_timeout_align(void* user_data, a0_reade
   }
 
   if (should_step) {
-    A0_RETURN_ERR_ON_ERR(a0_transport_timedwait(tlk, a0_transport_has_next_pred(&tlk), timeout));
-    if (reader_sync_zc->_opts.iter == A0_ITER_NEXT) {
-      a0_transport_step_next(tlk);
-    } else if (reader_sync_zc->_opts.iter == A0_ITER_NEWEST) {
-      a0_transport_jump_tail(tlk);
-    }
+    A0_RETURN_ERR_ON_ERR(a0_transport_timedwait_seq(tlk, tlk.transport->_seq + 1, a0_transport_has_next_pred(&tlk), timeout));
+    a0_reader_step(tlk, reader_sync_zc->_opts.iter);
   }
 
   return A0_OK;
@@ -220,10 +1141,28 @@ a0_err_t a0_reader_sync_zc_read_blocking_timeout_align(void* user_data, a0_reade
 a0_err_t a0_reader_sync_zc_read_blocking_timeout(a0_reader_sync_zc_t* reader_sync_zc,
                                                  a0_time_mono_t* timeout,
                                                  a0_zero_copy_callback_t cb) {
+  return a0_reader_sync_zc_read_batch_blocking_timeout(reader_sync_zc, timeout, 1, cb, NULL);
+}
+
+a0_err_t a0_reader_sync_zc_read_batch_blocking_timeout(a0_reader_sync_zc_t* reader_sync_zc,
+                                                       a0_time_mono_t* timeout,
+                                                       size_t max_cnt,
+                                                       a0_zero_copy_callback_t cb,
+                                                       size_t* out_cnt) {
+  if (reader_sync_zc->_opts.optimistic) {
+    return a0_reader_sync_zc_read_optimistic(reader_sync_zc, max_cnt, cb, true, timeout, out_cnt);
+  }
   return a0_reader_sync_zc_read_helper(
       reader_sync_zc,
+      max_cnt,
       cb,
-      (a0_reader_sync_zc_read_align_callback_t){timeout, a0_reader_sync_zc_read_blocking_timeout_align});
+      (a0_reader_sync_zc_read_align_callback_t){timeout, a0_reader_sync_zc_read_blocking_timeout_align},
+      out_cnt);
+}
+
+a0_err_t a0_reader_sync_zc_stats(a0_reader_sync_zc_t* reader_sync_zc, a0_reader_stats_t* out) {
+  a0_reader_counters_snapshot(&reader_sync_zc->_counters, out);
+  return A0_OK;
 }
 
 // Synchronous version.
@@ -250,7 +1189,8 @@ a0_err_t a0_reader_sync_can_read(a0_reader_sync_t* reader_sync, bool* can_read)
 
 typedef struct a0_reader_sync_read_data_s {
   a0_alloc_t alloc;
-  a0_packet_t* out_pkt;
+  a0_packet_t* out_pkts;
+  size_t cnt;
 } a0_reader_sync_read_data_t;
 
 A0_STATIC_INLINE
@@ -258,96 +1198,277 @@ void a0_reader_sync_read_impl(void* user_data, a0_transport_locked_t tlk, a0_fla
   A0_MAYBE_UNUSED(tlk);
   a0_reader_sync_read_data_t* data = (a0_reader_sync_read_data_t*)user_data;
   a0_buf_t unused;
-  a0_packet_deserialize(fpkt, data->alloc, data->out_pkt, &unused);
+  a0_packet_deserialize(fpkt, data->alloc, &data->out_pkts[data->cnt++], &unused);
 }
 
 a0_err_t a0_reader_sync_read(a0_reader_sync_t* reader_sync, a0_packet_t* pkt) {
+  return a0_reader_sync_read_batch(reader_sync, pkt, 1, NULL);
+}
+
+a0_err_t a0_reader_sync_read_batch(a0_reader_sync_t* reader_sync, a0_packet_t* pkts, size_t max_cnt, size_t* out_cnt) {
   A0_ASSERT(reader_sync, "Cannot read from null reader (sync).");
 
   a0_reader_sync_read_data_t data = (a0_reader_sync_read_data_t){
       .alloc = reader_sync->_alloc,
-      .out_pkt = pkt,
+      .out_pkts = pkts,
+      .cnt = 0,
   };
   a0_zero_copy_callback_t zc_cb = (a0_zero_copy_callback_t){
       .user_data = &data,
       .fn = a0_reader_sync_read_impl,
   };
-  return a0_reader_sync_zc_read(&reader_sync->_reader_sync_zc, zc_cb);
+  return a0_reader_sync_zc_read_batch(&reader_sync->_reader_sync_zc, max_cnt, zc_cb, out_cnt);
 }
 
 a0_err_t a0_reader_sync_read_blocking(a0_reader_sync_t* reader_sync, a0_packet_t* pkt) {
   return a0_reader_sync_read_blocking_timeout(reader_sync, A0_TIMEOUT_NEVER, pkt);
 }
 
+a0_err_t a0_reader_sync_read_batch_blocking(a0_reader_sync_t* reader_sync, a0_packet_t* pkts, size_t max_cnt, size_t* out_cnt) {
+  return a0_reader_sync_read_batch_blocking_timeout(reader_sync, A0_TIMEOUT_NEVER, pkts, max_cnt, out_cnt);
+}
+
 a0_err_t a0_reader_sync_read_blocking_timeout(a0_reader_sync_t* reader_sync, a0_time_mono_t* timeout, a0_packet_t* pkt) {
+  return a0_reader_sync_read_batch_blocking_timeout(reader_sync, timeout, pkt, 1, NULL);
+}
+
+a0_err_t a0_reader_sync_read_batch_blocking_timeout(a0_reader_sync_t* reader_sync,
+                                                    a0_time_mono_t* timeout,
+                                                    a0_packet_t* pkts,
+                                                    size_t max_cnt,
+                                                    size_t* out_cnt) {
   A0_ASSERT(reader_sync, "Cannot read from null reader (sync).");
 
   a0_reader_sync_read_data_t data = (a0_reader_sync_read_data_t){
       .alloc = reader_sync->_alloc,
-      .out_pkt = pkt,
+      .out_pkts = pkts,
+      .cnt = 0,
   };
   a0_zero_copy_callback_t zc_cb = (a0_zero_copy_callback_t){
       .user_data = &data,
       .fn = a0_reader_sync_read_impl,
   };
-  return a0_reader_sync_zc_read_blocking_timeout(&reader_sync->_reader_sync_zc, timeout, zc_cb);
+  return a0_reader_sync_zc_read_batch_blocking_timeout(&reader_sync->_reader_sync_zc, timeout, max_cnt, zc_cb, out_cnt);
+}
+
+a0_err_t a0_reader_sync_stats(a0_reader_sync_t* reader_sync, a0_reader_stats_t* out) {
+  return a0_reader_sync_zc_stats(&reader_sync->_reader_sync_zc, out);
 }
 
 // Threaded zero-copy version.
 
+// Returns whether the transport is still locked.
 A0_STATIC_INLINE
-void a0_reader_zc_thread_handle_pkt(a0_reader_zc_t* reader_zc, a0_transport_locked_t tlk) {
-  a0_transport_frame_t* frame;
-  a0_transport_frame(tlk, &frame);
+bool a0_reader_zc_thread_handle_one(a0_reader_zc_t* reader_zc, a0_transport_locked_t tlk) {
+  a0_reader_count_read(&reader_zc->_counters, reader_zc->_opts.iter, tlk.transport->_seq);
+  if (a0_reader_frame_match(tlk, reader_zc->_opts.filter)) {
+    uint64_t lag_frames;
+    size_t lag_bytes;
+    a0_reader_lag(tlk, &lag_frames, &lag_bytes);
+    a0_transport_frame_view_t frame;
+    a0_transport_frame_view(tlk, &frame);
+    a0_reader_count_delivered(&reader_zc->_counters,
+                              reader_zc->_opts.lag,
+                              lag_frames,
+                              lag_bytes,
+                              tlk.transport,
+                              (a0_flat_packet_t){frame.data});
+    uint64_t seq = tlk.transport->_seq;
+    // Evictions under a lease are counted. The thread has nobody to report them to.
+    a0_err_t err = a0_reader_deliver(&reader_zc->_counters, tlk, reader_zc->_opts.lease, reader_zc->_onpacket);
+    a0_reader_commit(reader_zc->_opts.cursor, seq);
+    return a0_reader_deliver_locked(err);
+  }
+  return true;
+}
 
-  a0_flat_packet_t fpkt = {
-      .buf = {frame->data, frame->hdr.data_size},
-  };
+// Handles the frame at the transport pointer. With A0_ITER_LATEST_PER_KEY,
+// handles the newest frame of each key from there on instead.
+// Returns whether the transport is still locked.
+A0_STATIC_INLINE
+bool a0_reader_zc_thread_handle_pkt(a0_reader_zc_t* reader_zc, a0_transport_locked_t tlk) {
+  if (reader_zc->_opts.iter != A0_ITER_LATEST_PER_KEY) {
+    return a0_reader_zc_thread_handle_one(reader_zc, tlk);
+  }
+  a0_reader_conflate_scan(&reader_zc->_conflate, tlk, reader_zc->_opts.filter);
+  while (!a0_reader_conflate_next(&reader_zc->_conflate, tlk)) {
+    if (!a0_reader_zc_thread_handle_one(reader_zc, tlk)) {
+      return false;
+    }
+  }
+  return true;
+}
 
-  reader_zc->_onpacket.fn(reader_zc->_onpacket.user_data, tlk, fpkt);
+// Positions the transport at the first packet.
+// Returns whether that packet should be delivered.
+// Whether the first packet is available.
+A0_STATIC_INLINE
+a0_err_t a0_reader_zc_first_ready(a0_reader_zc_t* reader_zc, a0_transport_locked_t tlk, bool* out) {
+  if (a0_reader_starts_at_seq(reader_zc->_opts)) {
+    return a0_reader_init_seq_ready(tlk, reader_zc->_opts.seq, out);
+  }
+  return a0_transport_nonempty(tlk, out);
 }
 
+// Frame a0_reader_zc_first_ready waits for. Zero if any frame will do.
 A0_STATIC_INLINE
-bool a0_reader_zc_thread_handle_first_pkt(a0_reader_zc_t* reader_zc, a0_transport_locked_t tlk) {
-  if (a0_transport_wait(tlk, a0_transport_nonempty_pred(&tlk)) == A0_OK) {
-    bool reset = false;
-    if (reader_zc->_started_empty) {
-      reset = true;
-    } else {
-      bool ptr_valid;
-      a0_transport_iter_valid(tlk, &ptr_valid);
-      reset = !ptr_valid;
-    }
+uint64_t a0_reader_zc_first_seq(a0_reader_zc_t* reader_zc) {
+  return a0_reader_starts_at_seq(reader_zc->_opts) ? reader_zc->_opts.seq : 0;
+}
 
-    if (reset) {
-      a0_transport_jump_head(tlk);
-    }
+typedef struct a0_reader_zc_first_ready_pred_data_s {
+  a0_reader_zc_t* reader_zc;
+  a0_transport_locked_t* tlk;
+} a0_reader_zc_first_ready_pred_data_t;
+
+A0_STATIC_INLINE
+a0_err_t a0_reader_zc_first_ready_pred_fn(void* user_data, bool* out) {
+  a0_reader_zc_first_ready_pred_data_t* data = (a0_reader_zc_first_ready_pred_data_t*)user_data;
+  return a0_reader_zc_first_ready(data->reader_zc, *data->tlk, out);
+}
 
-    if (reset || reader_zc->_opts.init == A0_INIT_OLDEST || reader_zc->_opts.init == A0_INIT_MOST_RECENT) {
-      a0_reader_zc_thread_handle_pkt(reader_zc, tlk);
+A0_STATIC_INLINE
+bool a0_reader_zc_align_first(a0_reader_zc_t* reader_zc, a0_transport_locked_t tlk) {
+  if (a0_reader_starts_at_seq(reader_zc->_opts)) {
+    return a0_reader_jump_init_seq(tlk, reader_zc->_opts.seq) == A0_OK;
+  }
+
+  bool reset = false;
+  if (reader_zc->_started_empty) {
+    reset = true;
+  } else {
+    bool ptr_valid;
+    a0_transport_iter_valid(tlk, &ptr_valid);
+    reset = !ptr_valid;
+  }
+
+  if (reset) {
+    a0_transport_jump_head(tlk);
+  }
+
+  return reset || reader_zc->_opts.init == A0_INIT_OLDEST || reader_zc->_opts.init == A0_INIT_MOST_RECENT;
+}
+
+A0_STATIC_INLINE
+void a0_reader_zc_align_next(a0_reader_zc_t* reader_zc, a0_transport_locked_t tlk) {
+  a0_reader_step(tlk, reader_zc->_opts.iter);
+}
+
+// Returns whether to keep going. Clears *locked if the transport could not be
+// locked again after a leased callback.
+A0_STATIC_INLINE
+bool a0_reader_zc_thread_handle_first_pkt(a0_reader_zc_t* reader_zc, a0_transport_locked_t tlk, bool* locked) {
+  a0_reader_zc_first_ready_pred_data_t pred_data = {reader_zc, &tlk};
+  if (a0_transport_wait_seq(tlk, a0_reader_zc_first_seq(reader_zc), (a0_predicate_t){&pred_data, a0_reader_zc_first_ready_pred_fn}) == A0_OK) {
+    if (a0_reader_zc_align_first(reader_zc, tlk)) {
+      *locked = a0_reader_zc_thread_handle_pkt(reader_zc, tlk);
     }
 
-    return true;
+    return *locked;
+  }
+
+  return false;
+}
+
+A0_STATIC_INLINE
+bool a0_reader_zc_thread_handle_next_pkt(a0_reader_zc_t* reader_zc, a0_transport_locked_t tlk, bool* locked) {
+  if (a0_transport_wait_seq(tlk, tlk.transport->_seq + 1, a0_transport_has_next_pred(&tlk)) == A0_OK) {
+    a0_reader_zc_align_next(reader_zc, tlk);
+    *locked = a0_reader_zc_thread_handle_pkt(reader_zc, tlk);
+
+    return *locked;
   }
 
   return false;
 }
 
+// Lock-free version of the reader thread loop.
+//
+// The lock is only taken to wait when there is nothing left to read.
 A0_STATIC_INLINE
-bool a0_reader_zc_thread_handle_next_pkt(a0_reader_zc_t* reader_zc, a0_transport_locked_t tlk) {
-  if (a0_transport_wait(tlk, a0_transport_has_next_pred(&tlk)) == A0_OK) {
-    if (reader_zc->_opts.iter == A0_ITER_NEXT) {
-      a0_transport_step_next(tlk);
-    } else if (reader_zc->_opts.iter == A0_ITER_NEWEST) {
-      a0_transport_jump_tail(tlk);
+void a0_reader_zc_thread_main_optimistic(a0_reader_zc_t* reader_zc) {
+  a0_transport_t* transport = &reader_zc->_transport;
+  bool first = true;
+
+  while (true) {
+    uint64_t prev_seq = transport->_seq;
+    size_t prev_off = transport->_off;
+
+    a0_transport_locked_t tlk;
+    a0_transport_optimistic_begin(transport, &tlk);
+
+    bool shutdown;
+    a0_transport_shutdown_requested(tlk, &shutdown);
+    if (shutdown) {
+      a0_transport_optimistic_end(tlk);
+      break;
     }
 
-    a0_reader_zc_thread_handle_pkt(reader_zc, tlk);
+    bool ready;
+    if (first) {
+      a0_reader_zc_first_ready(reader_zc, tlk, &ready);
+    } else {
+      a0_transport_has_next(tlk, &ready);
+    }
 
-    return true;
-  }
+    bool deliver = false;
+    a0_flat_packet_t fpkt;
+    uint64_t lag_frames = 0;
+    size_t lag_bytes = 0;
+    a0_err_t err = A0_OK;
+    if (ready) {
+      if (first) {
+        deliver = a0_reader_zc_align_first(reader_zc, tlk);
+      } else {
+        a0_reader_zc_align_next(reader_zc, tlk);
+        deliver = true;
+      }
+      if (deliver) {
+        err = a0_reader_optimistic_copy(tlk, &reader_zc->_optimistic_buf, &fpkt);
+        a0_reader_lag(tlk, &lag_frames, &lag_bytes);
+      }
+    }
 
-  return false;
+    if (a0_transport_optimistic_end(tlk)) {
+      // A writer committed mid-read. Nothing read can be trusted.
+      transport->_seq = prev_seq;
+      transport->_off = prev_off;
+      continue;
+    }
+
+    if (!ready) {
+      a0_transport_lock(transport, &tlk);
+      a0_reader_zc_first_ready_pred_data_t pred_data = {reader_zc, &tlk};
+      if (first) {
+        err = a0_transport_wait_seq(tlk, a0_reader_zc_first_seq(reader_zc), (a0_predicate_t){&pred_data, a0_reader_zc_first_ready_pred_fn});
+      } else {
+        err = a0_transport_wait_seq(tlk, transport->_seq + 1, a0_transport_has_next_pred(&tlk));
+      }
+      a0_transport_unlock(tlk);
+      if (err) {
+        // Shutting down.
+        break;
+      }
+      continue;
+    }
+
+    first = false;
+    if (!deliver) {
+      continue;
+    }
+    a0_reader_count_read(&reader_zc->_counters, reader_zc->_opts.iter, transport->_seq);
+    if (err) {
+      // The copy failed. There is no caller to report to, and retrying
+      // would spin while memory is short. Count the packet as dropped.
+      a0_atomic_store(&reader_zc->_counters.stats.dropped, reader_zc->_counters.stats.dropped + 1);
+      continue;
+    }
+    if (a0_reader_filter_match(reader_zc->_opts.filter, fpkt)) {
+      a0_reader_count_delivered(&reader_zc->_counters, reader_zc->_opts.lag, lag_frames, lag_bytes, transport, fpkt);
+      reader_zc->_onpacket.fn(reader_zc->_onpacket.user_data, tlk, fpkt);
+      a0_reader_commit(reader_zc->_opts.cursor, transport->_seq);
+    }
+  }
 }
 
 A0_STATIC_INLINE
@@ -357,61 +1478,102 @@ void* a0_reader_zc_thread_main(void* data) {
   reader_zc->_thread_id = a0_tid();
   a0_event_set(&reader_zc->_thread_start_event);
 
+  if (reader_zc->_opts.optimistic) {
+    a0_reader_zc_thread_main_optimistic(reader_zc);
+    return NULL;
+  }
+
   // Lock until shutdown.
   // Lock will release lock while awaiting packets.
   a0_transport_locked_t tlk;
   a0_transport_lock(&reader_zc->_transport, &tlk);
 
-  // Loop until shutdown is triggered.
-  if (a0_reader_zc_thread_handle_first_pkt(reader_zc, tlk)) {
-    while (a0_reader_zc_thread_handle_next_pkt(reader_zc, tlk)) {
+  // Loop until shutdown is triggered, or the lock is lost.
+  bool locked = true;
+  if (a0_reader_zc_thread_handle_first_pkt(reader_zc, tlk, &locked)) {
+    while (a0_reader_zc_thread_handle_next_pkt(reader_zc, tlk, &locked)) {
     }
   }
 
   // Shutting down.
-  a0_transport_unlock(tlk);
+  if (locked) {
+    a0_transport_unlock(tlk);
+  }
 
   return NULL;
 }
 
+// Positions the transport as of reader creation.
+A0_STATIC_INLINE
+void a0_reader_zc_init_position(a0_reader_zc_t* reader_zc) {
+  a0_transport_locked_t tlk;
+  a0_transport_lock(&reader_zc->_transport, &tlk);
+
+  if (reader_zc->_opts.init == A0_INIT_AT_TIME) {
+    reader_zc->_opts.seq = a0_reader_time_seq(tlk, reader_zc->_opts.time);
+  }
+  reader_zc->_counters.last_seq = a0_reader_counters_baseline(tlk, reader_zc->_opts);
+  a0_transport_empty(tlk, &reader_zc->_started_empty);
+  if (!reader_zc->_started_empty) {
+    if (reader_zc->_opts.init == A0_INIT_OLDEST) {
+      a0_transport_jump_head(tlk);
+    } else if (reader_zc->_opts.init == A0_INIT_MOST_RECENT || reader_zc->_opts.init == A0_INIT_AWAIT_NEW) {
+      a0_transport_jump_tail(tlk);
+    }
+  }
+
+  a0_transport_unlock(tlk);
+}
+
 a0_err_t a0_reader_zc_init(a0_reader_zc_t* reader_zc,
                            a0_arena_t arena,
                            a0_reader_options_t opts,
                            a0_zero_copy_callback_t onpacket) {
   *reader_zc = (a0_reader_zc_t)A0_EMPTY;
+  A0_RETURN_ERR_ON_ERR(a0_reader_conflate_init(&reader_zc->_conflate, &opts));
+  a0_reader_resume(&opts);
   reader_zc->_opts = opts;
   reader_zc->_onpacket = onpacket;
 
   A0_RETURN_ERR_ON_ERR(a0_transport_init(&reader_zc->_transport, arena));
+  A0_RETURN_ERR_ON_ERR(a0_transport_set_spin(&reader_zc->_transport, opts.spin_ns));
+  reader_zc->_counters.transport = &reader_zc->_transport;
 
 #ifdef DEBUG
   a0_ref_cnt_inc(arena.buf.data, NULL);
 #endif
 
-  a0_transport_locked_t tlk;
-  a0_transport_lock(&reader_zc->_transport, &tlk);
-
-  a0_transport_empty(tlk, &reader_zc->_started_empty);
-  if (!reader_zc->_started_empty) {
-    if (opts.init == A0_INIT_OLDEST) {
-      a0_transport_jump_head(tlk);
-    } else if (opts.init == A0_INIT_MOST_RECENT || opts.init == A0_INIT_AWAIT_NEW) {
-      a0_transport_jump_tail(tlk);
-    }
-  }
-
-  a0_transport_unlock(tlk);
+  a0_reader_zc_init_position(reader_zc);
 
-  pthread_create(
+  a0_err_t err = a0_thread_create(
       &reader_zc->_thread,
-      NULL,
+      opts.thread_attr,
       a0_reader_zc_thread_main,
       reader_zc);
+  if (err) {
+#ifdef DEBUG
+    a0_ref_cnt_dec(arena.buf.data, NULL);
+#endif
+    a0_reader_conflate_close(&reader_zc->_conflate);
+    return err;
+  }
 
   return A0_OK;
 }
 
+A0_STATIC_INLINE
+a0_err_t a0_reader_mux_detach(a0_reader_mux_t*, a0_reader_zc_t*);
+
 a0_err_t a0_reader_zc_close(a0_reader_zc_t* reader_zc) {
+  if (reader_zc->_mux) {
+    A0_RETURN_ERR_ON_ERR(a0_reader_mux_detach(reader_zc->_mux, reader_zc));
+#ifdef DEBUG
+    a0_ref_cnt_dec(reader_zc->_transport._arena.buf.data, NULL);
+#endif
+    a0_reader_conflate_close(&reader_zc->_conflate);
+    return A0_OK;
+  }
+
   a0_event_wait(&reader_zc->_thread_start_event);
   if (pthread_equal(pthread_self(), reader_zc->_thread_id)) {
     return A0_MAKE_SYSERR(EDEADLK);
@@ -427,23 +1589,492 @@ a0_err_t a0_reader_zc_close(a0_reader_zc_t* reader_zc) {
 
   pthread_join(reader_zc->_thread, NULL);
 
+  free(reader_zc->_optimistic_buf.data);
+  reader_zc->_optimistic_buf = (a0_buf_t)A0_EMPTY;
+  a0_reader_conflate_close(&reader_zc->_conflate);
+
+  return A0_OK;
+}
+
+a0_err_t a0_reader_zc_stats(a0_reader_zc_t* reader_zc, a0_reader_stats_t* out) {
+  a0_reader_counters_snapshot(&reader_zc->_counters, out);
+  return A0_OK;
+}
+
+// Multiplexed zero-copy version.
+
+// Packets a reader may deliver before the multiplexer moves on to the next one.
+#define A0_READER_MUX_BURST 64
+
+// Longest sleep between looks at readers the multiplexer can't wait on.
+#define A0_READER_MUX_POLL_NS (1000 * 1000)
+
+A0_STATIC_INLINE
+bool a0_reader_mux_on_thread(a0_reader_mux_t* mux) {
+  a0_event_wait(&mux->_thread_start_event);
+  return a0_tid() == mux->_thread_id;
+}
+
+A0_STATIC_INLINE
+void a0_reader_mux_wake(a0_reader_mux_t* mux) {
+  a0_atomic_add_fetch(&mux->_wake, 1);
+  a0_ftx_broadcast(&mux->_wake);
+}
+
+// Callbacks run with the multiplexer lock held. From the multiplexer thread,
+// the lock is already ours.
+A0_STATIC_INLINE
+void a0_reader_mux_lock(a0_reader_mux_t* mux, bool on_thread) {
+  if (!on_thread) {
+    a0_atomic_add_fetch(&mux->_pending, 1);
+    pthread_mutex_lock(&mux->_mu);
+    a0_atomic_fetch_add(&mux->_pending, (uint32_t)-1);
+  }
+}
+
+A0_STATIC_INLINE
+void a0_reader_mux_unlock(a0_reader_mux_t* mux, bool on_thread) {
+  if (!on_thread) {
+    pthread_mutex_unlock(&mux->_mu);
+  }
+}
+
+// Delivers what is available, without waiting. Stops after a burst, leaving
+// the reader marked dirty.
+A0_STATIC_INLINE
+void a0_reader_zc_mux_dispatch(a0_reader_zc_t* reader_zc) {
+  a0_transport_locked_t tlk;
+  a0_transport_lock(&reader_zc->_transport, &tlk);
+
+  size_t cnt = 0;
+  reader_zc->_mux_dirty = false;
+  if (!reader_zc->_mux_first_done) {
+    bool ready;
+    a0_reader_zc_first_ready(reader_zc, tlk, &ready);
+    if (ready) {
+      reader_zc->_mux_first_done = true;
+      if (a0_reader_zc_align_first(reader_zc, tlk)) {
+        // The lock is lost. Leave the rest for the next dispatch.
+        if (!a0_reader_zc_thread_handle_pkt(reader_zc, tlk)) {
+          reader_zc->_mux_dirty = true;
+          return;
+        }
+        cnt++;
+      }
+    }
+  }
+
+  bool has_next = false;
+  if (reader_zc->_mux_first_done) {
+    a0_transport_has_next(tlk, &has_next);
+  }
+  while (has_next) {
+    if (cnt == A0_READER_MUX_BURST) {
+      reader_zc->_mux_dirty = true;
+      break;
+    }
+    a0_reader_zc_align_next(reader_zc, tlk);
+    if (!a0_reader_zc_thread_handle_pkt(reader_zc, tlk)) {
+      reader_zc->_mux_dirty = true;
+      return;
+    }
+    cnt++;
+    a0_transport_has_next(tlk, &has_next);
+  }
+
+  a0_transport_unlock(tlk);
+}
+
+// Sleeps until a watched word changes, the thread is woken, or the poll
+// interval passes if some readers aren't watched.
+A0_STATIC_INLINE
+void a0_reader_mux_sleep(a0_reader_mux_t* mux, a0_ftx_waitv_t* waiters, size_t waiter_cnt, bool watched_all) {
+  a0_time_mono_t now;
+  a0_time_mono_t poll_timeout;
+  a0_time_mono_now(&now);
+  a0_time_mono_add(now, A0_READER_MUX_POLL_NS, &poll_timeout);
+
+  if (mux->_waitv) {
+    a0_err_t err = a0_ftx_waitv(waiters, (uint32_t)waiter_cnt, watched_all ? A0_TIMEOUT_NEVER : &poll_timeout);
+    // Seccomp may refuse unknown syscalls with EPERM.
+    if (err != A0_ERR_SYS || (A0_SYSERR(err) != ENOSYS && A0_SYSERR(err) != EPERM)) {
+      return;
+    }
+    mux->_waitv = false;
+  }
+
+  // Only the wake word can be waited on. Readers are polled.
+  a0_ftx_wait(&mux->_wake, (int)waiters[0].val, &poll_timeout);
+}
+
+A0_STATIC_INLINE
+void* a0_reader_mux_thread_main(void* data) {
+  a0_reader_mux_t* mux = (a0_reader_mux_t*)data;
+  mux->_thread_id = a0_tid();
+  a0_event_set(&mux->_thread_start_event);
+
+  a0_ftx_waitv_t waiters[A0_FTX_WAITV_MAX];
+
+  pthread_mutex_lock(&mux->_mu);
+  while (!mux->_shutdown) {
+    // Callbacks may attach or detach other readers. Index afresh each time.
+    bool progress = false;
+    for (size_t i = 0; i < mux->_reader_cnt; i++) {
+      a0_reader_zc_t* reader_zc = mux->_readers[i];
+      uint32_t word = a0_atomic_load(reader_zc->_mux_word);
+      if (reader_zc->_mux_dirty || word != reader_zc->_mux_seen) {
+        reader_zc->_mux_seen = word;
+        mux->_dispatching = reader_zc;
+        a0_reader_zc_mux_dispatch(reader_zc);
+        mux->_dispatching = NULL;
+        progress = true;
+      }
+    }
+    if (progress) {
+      // Let attaching and detaching threads in between rounds.
+      if (a0_atomic_load(&mux->_pending)) {
+        pthread_mutex_unlock(&mux->_mu);
+        while (a0_atomic_load(&mux->_pending)) {
+          sched_yield();
+        }
+        pthread_mutex_lock(&mux->_mu);
+      }
+      continue;
+    }
+
+    // Register, then look once more. A commit after the look wakes the word.
+    a0_ftx_waitv_set(&waiters[0], &mux->_wake, a0_atomic_load(&mux->_wake));
+    size_t waiter_cnt = 1;
+    for (size_t i = 0; i < mux->_reader_cnt && waiter_cnt < A0_FTX_WAITV_MAX; i++) {
+      a0_reader_zc_t* reader_zc = mux->_readers[i];
+      a0_transport_wake_register(&reader_zc->_transport);
+      reader_zc->_mux_registered = true;
+      a0_ftx_waitv_set(&waiters[waiter_cnt++], reader_zc->_mux_word, reader_zc->_mux_seen);
+    }
+
+    bool changed = false;
+    for (size_t i = 0; i < mux->_reader_cnt && !changed; i++) {
+      changed = a0_atomic_load(mux->_readers[i]->_mux_word) != mux->_readers[i]->_mux_seen;
+    }
+
+    if (!changed) {
+      bool watched_all = waiter_cnt == mux->_reader_cnt + 1;
+      // Detached readers may be unmapped while asleep. The detach changes the
+      // wake word, so the wait returns rather than sleeping on stale words.
+      pthread_mutex_unlock(&mux->_mu);
+      a0_reader_mux_sleep(mux, waiters, waiter_cnt, watched_all);
+      pthread_mutex_lock(&mux->_mu);
+    }
+
+    for (size_t i = 0; i < mux->_reader_cnt; i++) {
+      a0_reader_zc_t* reader_zc = mux->_readers[i];
+      if (reader_zc->_mux_registered) {
+        a0_transport_wake_unregister(&reader_zc->_transport);
+        reader_zc->_mux_registered = false;
+      }
+    }
+  }
+  pthread_mutex_unlock(&mux->_mu);
+
+  return NULL;
+}
+
+a0_err_t a0_reader_mux_init(a0_reader_mux_t* mux) {
+  *mux = (a0_reader_mux_t)A0_EMPTY;
+  pthread_mutex_init(&mux->_mu, NULL);
+  mux->_waitv = true;
+
+  a0_err_t err = a0_thread_create(
+      &mux->_thread,
+      (a0_thread_attr_t)A0_EMPTY,
+      a0_reader_mux_thread_main,
+      mux);
+  if (err) {
+    pthread_mutex_destroy(&mux->_mu);
+    return err;
+  }
+
+  return A0_OK;
+}
+
+a0_err_t a0_reader_mux_close(a0_reader_mux_t* mux) {
+  if (a0_reader_mux_on_thread(mux)) {
+    return A0_MAKE_SYSERR(EDEADLK);
+  }
+
+  a0_reader_mux_lock(mux, false);
+  if (mux->_reader_cnt) {
+    pthread_mutex_unlock(&mux->_mu);
+    return A0_MAKE_SYSERR(EBUSY);
+  }
+  mux->_shutdown = true;
+  pthread_mutex_unlock(&mux->_mu);
+
+  a0_reader_mux_wake(mux);
+  pthread_join(mux->_thread, NULL);
+
+  free(mux->_readers);
+  mux->_readers = NULL;
+  mux->_reader_cap = 0;
+  pthread_mutex_destroy(&mux->_mu);
+
+  return A0_OK;
+}
+
+A0_STATIC_INLINE
+a0_err_t a0_reader_mux_attach(a0_reader_mux_t* mux, a0_reader_zc_t* reader_zc) {
+  bool on_thread = a0_reader_mux_on_thread(mux);
+  a0_reader_mux_lock(mux, on_thread);
+
+  a0_err_t err = A0_OK;
+  if (mux->_reader_cnt == mux->_reader_cap) {
+    size_t cap = mux->_reader_cap ? 2 * mux->_reader_cap : 16;
+    a0_reader_zc_t** readers = (a0_reader_zc_t**)realloc(mux->_readers, cap * sizeof(a0_reader_zc_t*));
+    if (readers) {
+      mux->_readers = readers;
+      mux->_reader_cap = cap;
+    } else {
+      err = A0_MAKE_SYSERR(ENOMEM);
+    }
+  }
+  if (!err) {
+    mux->_readers[mux->_reader_cnt++] = reader_zc;
+  }
+
+  a0_reader_mux_unlock(mux, on_thread);
+  a0_reader_mux_wake(mux);
+  return err;
+}
+
+A0_STATIC_INLINE
+a0_err_t a0_reader_mux_detach(a0_reader_mux_t* mux, a0_reader_zc_t* reader_zc) {
+  bool on_thread = a0_reader_mux_on_thread(mux);
+  if (on_thread && mux->_dispatching == reader_zc) {
+    return A0_MAKE_SYSERR(EDEADLK);
+  }
+  a0_reader_mux_lock(mux, on_thread);
+
+  // Keep the order, so readers are served round-robin.
+  for (size_t i = 0; i < mux->_reader_cnt; i++) {
+    if (mux->_readers[i] == reader_zc) {
+      memmove(&mux->_readers[i], &mux->_readers[i + 1], (mux->_reader_cnt - i - 1) * sizeof(a0_reader_zc_t*));
+      mux->_reader_cnt--;
+      break;
+    }
+  }
+  if (reader_zc->_mux_registered) {
+    a0_transport_wake_unregister(&reader_zc->_transport);
+    reader_zc->_mux_registered = false;
+  }
+
+  a0_reader_mux_unlock(mux, on_thread);
+  a0_reader_mux_wake(mux);
+  return A0_OK;
+}
+
+a0_err_t a0_reader_zc_init_mux(a0_reader_zc_t* reader_zc,
+                               a0_reader_mux_t* mux,
+                               a0_arena_t arena,
+                               a0_reader_options_t opts,
+                               a0_zero_copy_callback_t onpacket) {
+  *reader_zc = (a0_reader_zc_t)A0_EMPTY;
+  // The multiplexer always reads under the lock, and never spins.
+  opts.optimistic = false;
+  opts.spin_ns = 0;
+  A0_RETURN_ERR_ON_ERR(a0_reader_conflate_init(&reader_zc->_conflate, &opts));
+  a0_reader_resume(&opts);
+  reader_zc->_opts = opts;
+  reader_zc->_onpacket = onpacket;
+  reader_zc->_mux = mux;
+
+  a0_err_t err = a0_transport_init(&reader_zc->_transport, arena);
+  if (err) {
+    a0_reader_conflate_close(&reader_zc->_conflate);
+    return err;
+  }
+  reader_zc->_counters.transport = &reader_zc->_transport;
+
+  err = a0_transport_wake_word(&reader_zc->_transport, &reader_zc->_mux_word);
+  if (err) {
+    a0_reader_conflate_close(&reader_zc->_conflate);
+    return err;
+  }
+
+  a0_reader_zc_init_position(reader_zc);
+  reader_zc->_mux_dirty = true;
+
+  err = a0_reader_mux_attach(mux, reader_zc);
+  if (err) {
+    a0_reader_conflate_close(&reader_zc->_conflate);
+    return err;
+  }
+
+#ifdef DEBUG
+  a0_ref_cnt_inc(arena.buf.data, NULL);
+#endif
+
   return A0_OK;
 }
 
 // Threaded version.
 
+// The zero-copy reader would commit once the wrapper returns, which may be
+// before the packet reaches the callback. The reader commits by itself once
+// the callback returns.
+A0_STATIC_INLINE
+void a0_reader_take_cursor(a0_reader_t* reader, a0_reader_options_t* opts) {
+  a0_reader_resume(opts);
+  reader->_cursor = opts->cursor;
+  opts->cursor = (a0_cursor_t)A0_EMPTY;
+}
+
 A0_STATIC_INLINE
 void a0_reader_onpacket_wrapper(void* user_data, a0_transport_locked_t tlk, a0_flat_packet_t fpkt) {
   a0_reader_t* reader = (a0_reader_t*)user_data;
+  uint64_t seq = tlk.transport->_seq;
   a0_packet_t pkt;
   a0_buf_t buf;
   a0_packet_deserialize(fpkt, reader->_alloc, &pkt, &buf);
-  a0_transport_unlock(tlk);
+
+  // Optimistic readers are called without the lock held.
+  bool optimistic = reader->_reader_zc._opts.optimistic;
+  if (!optimistic) {
+    a0_transport_unlock(tlk);
+  }
 
   a0_packet_callback_call(reader->_onpacket, pkt);
   a0_dealloc(reader->_alloc, buf);
+  a0_reader_commit(reader->_cursor, seq);
+
+  if (!optimistic) {
+    a0_transport_lock(tlk.transport, &tlk);
+  }
+}
+
+// A packet copied out by the reader thread, waiting on the reader's strand.
+typedef struct a0_reader_task_s {
+  a0_executor_task_t task;
+  a0_reader_t* reader;
+  uint64_t seq;
+  a0_packet_t pkt;
+  a0_buf_t buf;
+} a0_reader_task_t;
 
-  a0_transport_lock(tlk.transport, &tlk);
+A0_STATIC_INLINE
+a0_err_t a0_reader_task_run(void* user_data) {
+  a0_reader_task_t* task = (a0_reader_task_t*)user_data;
+  a0_reader_t* reader = task->reader;
+  a0_packet_callback_call(reader->_onpacket, task->pkt);
+  a0_dealloc(reader->_alloc, task->buf);
+  a0_reader_commit(reader->_cursor, task->seq);
+  free(task);
+  return A0_OK;
+}
+
+// Copies the packet out and posts it to the executor.
+//
+// Posting is quick, so the transport stays locked. The reader thread moves on
+// to the next packet without waiting on the callback.
+A0_STATIC_INLINE
+void a0_reader_onpacket_post_wrapper(void* user_data, a0_transport_locked_t tlk, a0_flat_packet_t fpkt) {
+  a0_reader_t* reader = (a0_reader_t*)user_data;
+
+  a0_reader_task_t* task = (a0_reader_task_t*)malloc(sizeof(a0_reader_task_t));
+  task->reader = reader;
+  task->seq = tlk.transport->_seq;
+  a0_packet_deserialize(fpkt, reader->_alloc, &task->pkt, &task->buf);
+  task->task.callback = (a0_callback_t){
+      .user_data = task,
+      .fn = a0_reader_task_run,
+  };
+  a0_executor_post_task(&reader->_strand, &task->task);
+}
+
+// Collects packets while more are ready, then passes them on together.
+//
+// The transport stays locked between packets of a batch and is unlocked once
+// around the callback.
+A0_STATIC_INLINE
+void a0_reader_onbatch_wrapper(void* user_data, a0_transport_locked_t tlk, a0_flat_packet_t fpkt) {
+  a0_reader_t* reader = (a0_reader_t*)user_data;
+
+  if (reader->_batch_cnt == reader->_batch_cap) {
+    size_t cap = reader->_batch_cap ? 2 * reader->_batch_cap : 16;
+    if (cap > reader->_batch_max) {
+      cap = reader->_batch_max;
+    }
+    reader->_batch_pkts = (a0_packet_t*)realloc(reader->_batch_pkts, cap * sizeof(a0_packet_t));
+    reader->_batch_bufs = (a0_buf_t*)realloc(reader->_batch_bufs, cap * sizeof(a0_buf_t));
+    reader->_batch_cap = cap;
+  }
+
+  size_t idx = reader->_batch_cnt++;
+  a0_packet_deserialize(fpkt, reader->_alloc, &reader->_batch_pkts[idx], &reader->_batch_bufs[idx]);
+
+  // Optimistic readers are called without the lock held, and deliver as they go.
+  // ITER_NEWEST skips ahead, so only ITER_NEXT has anything to collect.
+  bool optimistic = reader->_reader_zc._opts.optimistic;
+  if (!optimistic &&
+      reader->_reader_zc._opts.iter == A0_ITER_NEXT &&
+      reader->_batch_cnt < reader->_batch_max) {
+    // Frames the filter skips won't add to the batch.
+    if (a0_reader_has_next_match(tlk, reader->_reader_zc._opts.filter)) {
+      return;
+    }
+  }
+
+  // The packet that ends the batch is the last one in it.
+  uint64_t seq = tlk.transport->_seq;
+  if (!optimistic) {
+    a0_transport_unlock(tlk);
+  }
+
+  reader->_onbatch.fn(reader->_onbatch.user_data, reader->_batch_pkts, reader->_batch_cnt);
+  for (size_t i = 0; i < reader->_batch_cnt; i++) {
+    a0_dealloc(reader->_alloc, reader->_batch_bufs[i]);
+  }
+  reader->_batch_cnt = 0;
+  a0_reader_commit(reader->_cursor, seq);
+
+  if (!optimistic) {
+    a0_transport_lock(tlk.transport, &tlk);
+  }
+}
+
+A0_STATIC_INLINE
+a0_err_t a0_reader_init_impl(a0_reader_t* reader,
+                             a0_reader_mux_t* mux,
+                             a0_arena_t arena,
+                             a0_alloc_t alloc,
+                             a0_reader_options_t opts,
+                             a0_packet_callback_t onpacket) {
+  *reader = (a0_reader_t)A0_EMPTY;
+  reader->_alloc = alloc;
+  reader->_onpacket = onpacket;
+
+  a0_zero_copy_callback_t onpacket_wrapper = (a0_zero_copy_callback_t){
+      .user_data = reader,
+      .fn = a0_reader_onpacket_wrapper,
+  };
+  if (opts.executor) {
+    onpacket_wrapper.fn = a0_reader_onpacket_post_wrapper;
+    A0_RETURN_ERR_ON_ERR(a0_executor_strand_init(&reader->_strand, opts.executor));
+  }
+
+  // The wrapper copies the packet out and unlocks by itself. A lease would
+  // unlock twice.
+  opts.lease = false;
+  a0_reader_take_cursor(reader, &opts);
+  a0_err_t err;
+  if (mux) {
+    err = a0_reader_zc_init_mux(&reader->_reader_zc, mux, arena, opts, onpacket_wrapper);
+  } else {
+    err = a0_reader_zc_init(&reader->_reader_zc, arena, opts, onpacket_wrapper);
+  }
+  if (err && opts.executor) {
+    a0_executor_strand_close(&reader->_strand);
+  }
+  return err;
 }
 
 a0_err_t a0_reader_init(a0_reader_t* reader,
@@ -451,19 +2082,74 @@ a0_err_t a0_reader_init(a0_reader_t* reader,
                         a0_alloc_t alloc,
                         a0_reader_options_t opts,
                         a0_packet_callback_t onpacket) {
+  return a0_reader_init_impl(reader, NULL, arena, alloc, opts, onpacket);
+}
+
+a0_err_t a0_reader_init_mux(a0_reader_t* reader,
+                            a0_reader_mux_t* mux,
+                            a0_arena_t arena,
+                            a0_alloc_t alloc,
+                            a0_reader_options_t opts,
+                            a0_packet_callback_t onpacket) {
+  return a0_reader_init_impl(reader, mux, arena, alloc, opts, onpacket);
+}
+
+a0_err_t a0_reader_init_batch(a0_reader_t* reader,
+                              a0_arena_t arena,
+                              a0_alloc_t alloc,
+                              a0_reader_options_t opts,
+                              size_t max_cnt,
+                              a0_packet_batch_callback_t onbatch) {
+  if (!max_cnt || opts.executor) {
+    return A0_ERR_INVALID_ARG;
+  }
+
+  *reader = (a0_reader_t)A0_EMPTY;
   reader->_alloc = alloc;
-  reader->_onpacket = onpacket;
+  reader->_onbatch = onbatch;
+  reader->_batch_max = max_cnt;
 
-  a0_zero_copy_callback_t onpacket_wrapper = (a0_zero_copy_callback_t){
+  a0_zero_copy_callback_t onbatch_wrapper = (a0_zero_copy_callback_t){
       .user_data = reader,
-      .fn = a0_reader_onpacket_wrapper,
+      .fn = a0_reader_onbatch_wrapper,
   };
 
-  return a0_reader_zc_init(&reader->_reader_zc, arena, opts, onpacket_wrapper);
+  opts.lease = false;
+  a0_reader_take_cursor(reader, &opts);
+  return a0_reader_zc_init(&reader->_reader_zc, arena, opts, onbatch_wrapper);
 }
 
 a0_err_t a0_reader_close(a0_reader_t* reader) {
-  return a0_reader_zc_close(&reader->_reader_zc);
+  // Closing from one of the reader's own callbacks would wait on itself.
+  // Check before the reader thread is stopped.
+  a0_executor_strand_t* strand = reader->_strand._executor ? &reader->_strand : NULL;
+  if (strand && a0_executor_strand_in_task(strand)) {
+    return A0_MAKE_SYSERR(EDEADLK);
+  }
+
+  A0_RETURN_ERR_ON_ERR(a0_reader_zc_close(&reader->_reader_zc));
+
+  // Deliver what the reader thread already posted.
+  if (strand) {
+    A0_RETURN_ERR_ON_ERR(a0_executor_strand_close(strand));
+  }
+
+  // Packets collected when shutdown came are dropped.
+  for (size_t i = 0; i < reader->_batch_cnt; i++) {
+    a0_dealloc(reader->_alloc, reader->_batch_bufs[i]);
+  }
+  free(reader->_batch_pkts);
+  free(reader->_batch_bufs);
+  reader->_batch_pkts = NULL;
+  reader->_batch_bufs = NULL;
+  reader->_batch_cnt = 0;
+  reader->_batch_cap = 0;
+
+  return A0_OK;
+}
+
+a0_err_t a0_reader_stats(a0_reader_t* reader, a0_reader_stats_t* out) {
+  return a0_reader_zc_stats(&reader->_reader_zc, out);
 }
 
 a0_err_t a0_read_random_access(a0_arena_t arena, size_t off, a0_zero_copy_callback_t cb) {
@@ -478,10 +2164,10 @@ a0_err_t a0_read_random_access(a0_arena_t arena, size_t off, a0_zero_copy_callba
     a0_transport_unlock(tlk);
     return err;
   }
-  a0_transport_frame_t* frame;
-  a0_transport_frame(tlk, &frame);
+  a0_transport_frame_view_t frame;
+  a0_transport_frame_view(tlk, &frame);
 
-  cb.fn(cb.user_data, tlk, (a0_flat_packet_t){{frame->data, frame->hdr.data_size}});
+  cb.fn(cb.user_data, tlk, (a0_flat_packet_t){frame.data});
 
   return a0_transport_unlock(tlk);
 }
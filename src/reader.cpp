@@ -14,28 +14,100 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <utility>
 #include <vector>
 
 #include "c_opts.hpp"
 #include "c_wrap.hpp"
+#include "err_macro.h"
+#include "packet_pool.hpp"
+#include "queued_alloc.hpp"
+#include "read_batch.hpp"
 
 namespace a0 {
 
-Reader::Options Reader::Options::DEFAULT = {
-    (Reader::Init)A0_READER_OPTIONS_DEFAULT.init,
-    (Reader::Iter)A0_READER_OPTIONS_DEFAULT.iter,
+Reader::Options Reader::Options::DEFAULT = cpp_readeropts(A0_READER_OPTIONS_DEFAULT);
+
+namespace {
+
+struct FilterImpl {
+  std::vector<Reader::Filter::Clause> clauses;
+  std::vector<a0_reader_filter_clause_t> c_clauses;
+  a0_reader_filter_t c;
 };
 
+}  // namespace
+
+Reader::Filter::Filter(std::vector<Clause> clauses, bool any) {
+  auto impl = std::make_shared<FilterImpl>();
+  impl->clauses = std::move(clauses);
+  for (auto&& clause : impl->clauses) {
+    impl->c_clauses.push_back(a0_reader_filter_clause_t{
+        .op = (a0_reader_filter_op_t)clause.op,
+        .key = clause.key.c_str(),
+        .val = clause.val.c_str(),
+    });
+  }
+  impl->c = a0_reader_filter_t{
+      .clauses = impl->c_clauses.data(),
+      .num_clauses = impl->c_clauses.size(),
+      .any = any,
+  };
+  c = std::shared_ptr<a0_reader_filter_t>(impl, &impl->c);
+}
+
+namespace {
+
+struct LagThresholdImpl {
+  std::function<void(Reader::Stats)> onlag;
+  a0_reader_lag_threshold_t c;
+};
+
+}  // namespace
+
+Reader::LagThreshold::LagThreshold(uint64_t frames, uint64_t bytes, uint64_t ns, std::function<void(Stats)> onlag) {
+  auto impl = std::make_shared<LagThresholdImpl>();
+  impl->onlag = std::move(onlag);
+  impl->c = a0_reader_lag_threshold_t{
+      .frames = frames,
+      .bytes = bytes,
+      .ns = ns,
+      .onlag = {
+          .user_data = impl.get(),
+          .fn = [](void* user_data, a0_reader_stats_t stats) {
+            auto* impl = (LagThresholdImpl*)user_data;
+            if (impl->onlag) {
+              impl->onlag(stats);
+            }
+          },
+      },
+  };
+  c = std::shared_ptr<a0_reader_lag_threshold_t>(impl, &impl->c);
+}
+
+Reader::Filter Reader::Filter::key_exists(std::string key) {
+  return Filter({{Op::KEY_EXISTS, std::move(key), ""}});
+}
+
+Reader::Filter Reader::Filter::key_equals(std::string key, std::string val) {
+  return Filter({{Op::KEY_EQUALS, std::move(key), std::move(val)}});
+}
+
+Reader::Filter Reader::Filter::val_prefix(std::string key, std::string prefix) {
+  return Filter({{Op::VAL_PREFIX, std::move(key), std::move(prefix)}});
+}
+
 ReaderSyncZeroCopy::ReaderSyncZeroCopy(Arena arena, Reader::Options opts) {
   set_c(
       &c,
       [&](a0_reader_sync_zc_t* c) {
         return a0_reader_sync_zc_init(c, *arena.c, c_readeropts(opts));
       },
-      [arena](a0_reader_sync_zc_t* c) {
+      [arena, opts](a0_reader_sync_zc_t* c) {
         a0_reader_sync_zc_close(c);
       });
 }
@@ -75,11 +147,46 @@ void ReaderSyncZeroCopy::read_blocking(TimeMono timeout, std::function<void(Tran
   check(a0_reader_sync_zc_read_blocking_timeout(&*c, &*timeout.c, ReadZeroCopy_CallbackWrapper(&fn)));
 }
 
+size_t ReaderSyncZeroCopy::read_batch(size_t max_cnt, std::function<void(TransportLocked, FlatPacket)> fn) {
+  CHECK_C;
+  size_t cnt;
+  a0_err_t err = a0_reader_sync_zc_read_batch(&*c, max_cnt, ReadZeroCopy_CallbackWrapper(&fn), &cnt);
+  if (err != A0_ERR_AGAIN) {
+    check(err);
+  }
+  return cnt;
+}
+
+size_t ReaderSyncZeroCopy::read_batch_blocking(size_t max_cnt, std::function<void(TransportLocked, FlatPacket)> fn) {
+  CHECK_C;
+  size_t cnt;
+  check(a0_reader_sync_zc_read_batch_blocking(&*c, max_cnt, ReadZeroCopy_CallbackWrapper(&fn), &cnt));
+  return cnt;
+}
+
+size_t ReaderSyncZeroCopy::read_batch_blocking(TimeMono timeout, size_t max_cnt, std::function<void(TransportLocked, FlatPacket)> fn) {
+  CHECK_C;
+  size_t cnt;
+  check(a0_reader_sync_zc_read_batch_blocking_timeout(&*c, &*timeout.c, max_cnt, ReadZeroCopy_CallbackWrapper(&fn), &cnt));
+  return cnt;
+}
+
+Reader::Stats ReaderSyncZeroCopy::stats() {
+  CHECK_C;
+  Reader::Stats out;
+  check(a0_reader_sync_zc_stats(&*c, &out));
+  return out;
+}
+
 namespace {
 
 struct ReaderSyncImpl {
   Arena arena;
-  std::vector<uint8_t> data;
+  // Buffer of the last read.
+  a0_buf_t buf;
+  // Batch reads allocate each packet separately.
+  bool batching{false};
+  std::vector<a0_buf_t> batch_bufs;
 };
 
 }  // namespace
@@ -89,20 +196,9 @@ ReaderSync::ReaderSync(Arena arena, Reader::Options opts) {
       &c,
       [&](a0_reader_sync_t* c, ReaderSyncImpl* impl) {
         impl->arena = arena;
-
-        a0_alloc_t alloc = {
-            .user_data = impl,
-            .alloc = [](void* user_data, size_t size, a0_buf_t* out) {
-              auto* impl = (ReaderSyncImpl*)user_data;
-              impl->data.resize(size);
-              *out = {impl->data.data(), size};
-              return A0_OK;
-            },
-            .dealloc = nullptr,
-        };
-        return a0_reader_sync_init(c, *arena.c, alloc, c_readeropts(opts));
+        return a0_reader_sync_init(c, *arena.c, read_batch_alloc(impl), c_readeropts(opts));
       },
-      [](a0_reader_sync_t* c, ReaderSyncImpl*) {
+      [opts](a0_reader_sync_t* c, ReaderSyncImpl*) {
         a0_reader_sync_close(c);
       });
 }
@@ -116,35 +212,51 @@ bool ReaderSync::can_read() {
 
 Packet ReaderSync::read() {
   CHECK_C;
-  auto* impl = c_impl<ReaderSyncImpl>(&c);
-
-  a0_packet_t pkt;
-  check(a0_reader_sync_read(&*c, &pkt));
-  auto data = std::make_shared<std::vector<uint8_t>>();
-  std::swap(*data, impl->data);
-  return Packet(pkt, [data](a0_packet_t*) {});
+  return read_one_impl(c_impl<ReaderSyncImpl>(&c), [&](a0_packet_t* pkt) {
+    return a0_reader_sync_read(&*c, pkt);
+  });
 }
 
 Packet ReaderSync::read_blocking() {
   CHECK_C;
-  auto* impl = c_impl<ReaderSyncImpl>(&c);
-
-  a0_packet_t pkt;
-  check(a0_reader_sync_read_blocking(&*c, &pkt));
-  auto data = std::make_shared<std::vector<uint8_t>>();
-  std::swap(*data, impl->data);
-  return Packet(pkt, [data](a0_packet_t*) {});
+  return read_one_impl(c_impl<ReaderSyncImpl>(&c), [&](a0_packet_t* pkt) {
+    return a0_reader_sync_read_blocking(&*c, pkt);
+  });
 }
 
 Packet ReaderSync::read_blocking(TimeMono timeout) {
   CHECK_C;
-  auto* impl = c_impl<ReaderSyncImpl>(&c);
+  return read_one_impl(c_impl<ReaderSyncImpl>(&c), [&](a0_packet_t* pkt) {
+    return a0_reader_sync_read_blocking_timeout(&*c, &*timeout.c, pkt);
+  });
+}
+
+std::vector<Packet> ReaderSync::read_batch(size_t max_cnt) {
+  CHECK_C;
+  return read_batch_impl(c_impl<ReaderSyncImpl>(&c), max_cnt, [&](a0_packet_t* pkts, size_t* cnt) {
+    return a0_reader_sync_read_batch(&*c, pkts, max_cnt, cnt);
+  });
+}
 
-  a0_packet_t pkt;
-  check(a0_reader_sync_read_blocking_timeout(&*c, &*timeout.c, &pkt));
-  auto data = std::make_shared<std::vector<uint8_t>>();
-  std::swap(*data, impl->data);
-  return Packet(pkt, [data](a0_packet_t*) {});
+std::vector<Packet> ReaderSync::read_batch_blocking(size_t max_cnt) {
+  CHECK_C;
+  return read_batch_impl(c_impl<ReaderSyncImpl>(&c), max_cnt, [&](a0_packet_t* pkts, size_t* cnt) {
+    return a0_reader_sync_read_batch_blocking(&*c, pkts, max_cnt, cnt);
+  });
+}
+
+std::vector<Packet> ReaderSync::read_batch_blocking(TimeMono timeout, size_t max_cnt) {
+  CHECK_C;
+  return read_batch_impl(c_impl<ReaderSyncImpl>(&c), max_cnt, [&](a0_packet_t* pkts, size_t* cnt) {
+    return a0_reader_sync_read_batch_blocking_timeout(&*c, &*timeout.c, pkts, max_cnt, cnt);
+  });
+}
+
+Reader::Stats ReaderSync::stats() {
+  CHECK_C;
+  Reader::Stats out;
+  check(a0_reader_sync_stats(&*c, &out));
+  return out;
 }
 
 namespace {
@@ -174,16 +286,25 @@ ReaderZeroCopy::ReaderZeroCopy(
 
         return a0_reader_zc_init(c, *arena.c, c_readeropts(opts), c_cb);
       },
-      [arena](a0_reader_zc_t* c, ReaderZeroCopyImpl*) {
+      [arena, opts](a0_reader_zc_t* c, ReaderZeroCopyImpl*) {
         a0_reader_zc_close(c);
       });
 }
 
+Reader::Stats ReaderZeroCopy::stats() {
+  CHECK_C;
+  Reader::Stats out;
+  check(a0_reader_zc_stats(&*c, &out));
+  return out;
+}
+
 namespace {
 
 struct ReaderImpl {
   Arena arena;
-  std::vector<uint8_t> data;
+  // Packet buffers, in read order. See queued_alloc.hpp.
+  std::mutex data_mu;
+  std::deque<a0_buf_t> data;
   std::function<void(Packet)> cb;
 };
 
@@ -199,33 +320,114 @@ Reader::Reader(
         impl->arena = arena;
         impl->cb = cb;
 
+        a0_alloc_t alloc = queued_alloc(impl);
+
+        a0_packet_callback_t c_cb = {
+            .user_data = impl,
+            .fn = [](void* user_data, a0_packet_t pkt) {
+              auto* impl = (ReaderImpl*)user_data;
+              impl->cb(queued_packet(impl, pkt));
+            }};
+
+        return a0_reader_init(c, *arena.c, alloc, c_readeropts(opts), c_cb);
+      },
+      [opts](a0_reader_t* c, ReaderImpl*) {
+        a0_reader_close(c);
+      });
+}
+
+ReaderMux::ReaderMux() {
+  set_c(&c, a0_reader_mux_init, a0_reader_mux_close);
+}
+
+Reader::Reader(
+    ReaderMux mux,
+    Arena arena,
+    Reader::Options opts,
+    std::function<void(Packet)> cb) {
+  check(__PRETTY_FUNCTION__, &mux);
+  set_c_impl<ReaderImpl>(
+      &c,
+      [&](a0_reader_t* c, ReaderImpl* impl) {
+        impl->arena = arena;
+        impl->cb = cb;
+
+        a0_alloc_t alloc = queued_alloc(impl);
+
+        a0_packet_callback_t c_cb = {
+            .user_data = impl,
+            .fn = [](void* user_data, a0_packet_t pkt) {
+              auto* impl = (ReaderImpl*)user_data;
+              impl->cb(queued_packet(impl, pkt));
+            }};
+
+        return a0_reader_init_mux(c, &*mux.c, *arena.c, alloc, c_readeropts(opts), c_cb);
+      },
+      [mux, opts](a0_reader_t* c, ReaderImpl*) {
+        a0_reader_close(c);
+      });
+}
+
+namespace {
+
+struct ReaderBatchImpl {
+  Arena arena;
+  // Packet buffers, in read order. Handed over to the Packets in each batch.
+  std::vector<a0_buf_t> data;
+  std::function<void(std::vector<Packet>)> cb;
+};
+
+}  // namespace
+
+Reader::Reader(
+    Arena arena,
+    Reader::Options opts,
+    size_t max_cnt,
+    std::function<void(std::vector<Packet>)> cb) {
+  set_c_impl<ReaderBatchImpl>(
+      &c,
+      [&](a0_reader_t* c, ReaderBatchImpl* impl) {
+        impl->arena = arena;
+        impl->cb = cb;
+
         a0_alloc_t alloc = {
             .user_data = impl,
             .alloc = [](void* user_data, size_t size, a0_buf_t* out) {
-              auto* impl = (ReaderImpl*)user_data;
-              impl->data.resize(size);
-              *out = {impl->data.data(), size};
+              auto* impl = (ReaderBatchImpl*)user_data;
+              A0_RETURN_ERR_ON_ERR(a0_alloc(packet_pool(), size, out));
+              impl->data.push_back(*out);
               return A0_OK;
             },
             .dealloc = nullptr,
         };
 
-        a0_packet_callback_t c_cb = {
+        a0_packet_batch_callback_t c_cb = {
             .user_data = impl,
-            .fn = [](void* user_data, a0_packet_t pkt) {
-              auto* impl = (ReaderImpl*)user_data;
-              auto data = std::make_shared<std::vector<uint8_t>>();
-              std::swap(*data, impl->data);
-              impl->cb(Packet(pkt, [data](a0_packet_t*) {}));
+            .fn = [](void* user_data, a0_packet_t* pkts, size_t cnt) {
+              auto* impl = (ReaderBatchImpl*)user_data;
+              std::vector<Packet> batch;
+              batch.reserve(cnt);
+              for (size_t i = 0; i < cnt; i++) {
+                batch.push_back(pooled_packet(pkts[i], impl->data[i]));
+              }
+              impl->data.erase(impl->data.begin(), impl->data.begin() + cnt);
+              impl->cb(std::move(batch));
             }};
 
-        return a0_reader_init(c, *arena.c, alloc, c_readeropts(opts), c_cb);
+        return a0_reader_init_batch(c, *arena.c, alloc, c_readeropts(opts), max_cnt, c_cb);
       },
-      [](a0_reader_t* c, ReaderImpl*) {
+      [opts](a0_reader_t* c, ReaderBatchImpl*) {
         a0_reader_close(c);
       });
 }
 
+Reader::Stats Reader::stats() {
+  CHECK_C;
+  Stats out;
+  check(a0_reader_stats(&*c, &out));
+  return out;
+}
+
 void read_random_access(Arena arena, size_t off, std::function<void(TransportLocked, FlatPacket)> fn) {
   check(a0_read_random_access(*arena.c, off, ReadZeroCopy_CallbackWrapper(&fn)));
 }
@@ -30,6 +30,20 @@ static const char RPC_TYPE_CANCEL[] = "cancel";
 
 static const char REQUEST_ID[] = "a0_req_id";
 
+// Servers only read requests and cancels. Clients only read responses.
+static const a0_reader_filter_clause_t RPC_SERVER_CLAUSES[] = {
+    {A0_FILTER_KEY_EQUALS, RPC_TYPE, RPC_TYPE_REQUEST},
+    {A0_FILTER_KEY_EQUALS, RPC_TYPE, RPC_TYPE_CANCEL},
+};
+static const a0_reader_filter_clause_t RPC_CLIENT_CLAUSES[] = {
+    {A0_FILTER_KEY_EQUALS, RPC_TYPE, RPC_TYPE_RESPONSE},
+    {A0_FILTER_KEY_EXISTS, REQUEST_ID, NULL},
+};
+
+const a0_rpc_options_t A0_RPC_OPTIONS_DEFAULT = {
+    .thread_attr = {NULL, 0, 0, 0, 0, NULL},
+};
+
 A0_STATIC_INLINE
 a0_err_t a0_rpc_topic_open(a0_rpc_topic_t topic, a0_file_t* file) {
   return a0_topic_open(a0_env_topic_tmpl_rpc(), topic.name, topic.file_opts, file);
@@ -66,6 +80,15 @@ a0_err_t a0_rpc_server_init(a0_rpc_server_t* server,
                             a0_alloc_t alloc,
                             a0_rpc_request_callback_t onrequest,
                             a0_packet_id_callback_t oncancel) {
+  return a0_rpc_server_init_options(server, topic, alloc, onrequest, oncancel, A0_RPC_OPTIONS_DEFAULT);
+}
+
+a0_err_t a0_rpc_server_init_options(a0_rpc_server_t* server,
+                                    a0_rpc_topic_t topic,
+                                    a0_alloc_t alloc,
+                                    a0_rpc_request_callback_t onrequest,
+                                    a0_packet_id_callback_t oncancel,
+                                    a0_rpc_options_t opts) {
   server->_onrequest = onrequest;
   server->_oncancel = oncancel;
 
@@ -90,7 +113,12 @@ a0_err_t a0_rpc_server_init(a0_rpc_server_t* server,
       &server->_request_reader,
       server->_file.arena,
       alloc,
-      (a0_reader_options_t){A0_INIT_AWAIT_NEW, A0_ITER_NEXT},
+      (a0_reader_options_t){
+          .init = A0_INIT_AWAIT_NEW,
+          .iter = A0_ITER_NEXT,
+          .filter = {RPC_SERVER_CLAUSES, 2, true},
+          .thread_attr = opts.thread_attr,
+      },
       (a0_packet_callback_t){
           .user_data = server,
           .fn = a0_rpc_server_onpacket,
@@ -182,6 +210,13 @@ void a0_rpc_client_onpacket(void* user_data, a0_packet_t pkt) {
 a0_err_t a0_rpc_client_init(a0_rpc_client_t* client,
                             a0_rpc_topic_t topic,
                             a0_alloc_t alloc) {
+  return a0_rpc_client_init_options(client, topic, alloc, A0_RPC_OPTIONS_DEFAULT);
+}
+
+a0_err_t a0_rpc_client_init_options(a0_rpc_client_t* client,
+                                    a0_rpc_topic_t topic,
+                                    a0_alloc_t alloc,
+                                    a0_rpc_options_t opts) {
   // Outstanding requests must be initialized before the response reader is opened to avoid a race condition.
 
   A0_RETURN_ERR_ON_ERR(a0_map_init(
@@ -220,7 +255,12 @@ a0_err_t a0_rpc_client_init(a0_rpc_client_t* client,
       &client->_response_reader,
       client->_file.arena,
       alloc,
-      (a0_reader_options_t){A0_INIT_AWAIT_NEW, A0_ITER_NEXT},
+      (a0_reader_options_t){
+          .init = A0_INIT_AWAIT_NEW,
+          .iter = A0_ITER_NEXT,
+          .filter = {RPC_CLIENT_CLAUSES, 2, false},
+          .thread_attr = opts.thread_attr,
+      },
       (a0_packet_callback_t){
           .user_data = client,
           .fn = a0_rpc_client_onpacket,
@@ -271,12 +311,16 @@ a0_err_t a0_rpc_client_send_blocking(a0_rpc_client_t* client, a0_packet_t pkt, a
 }
 
 a0_err_t a0_rpc_client_send_blocking_timeout(a0_rpc_client_t* client, a0_packet_t pkt, a0_time_mono_t* timeout, a0_alloc_t alloc, a0_packet_t* out) {
+  a0_reader_options_t opts = A0_READER_OPTIONS_DEFAULT;
+  opts.init = A0_INIT_AWAIT_NEW;
+  opts.iter = A0_ITER_NEXT;
+
   a0_reader_sync_t reader_sync;
   A0_RETURN_ERR_ON_ERR(a0_reader_sync_init(
       &reader_sync,
       client->_file.arena,
       alloc,
-      (a0_reader_options_t){A0_INIT_AWAIT_NEW, A0_ITER_NEXT}));
+      opts));
 
   a0_err_t err = a0_rpc_client_send(client, pkt, (a0_packet_callback_t)A0_EMPTY);
   while (!err) {
@@ -63,6 +63,7 @@ struct RpcServerImpl {
 
 RpcServer::RpcServer(
     RpcTopic topic,
+    RpcOptions opts,
     std::function<void(RpcRequest)> onrequest,
     std::function<void(string_view /* id */)> oncancel) {
   set_c_impl<RpcServerImpl>(
@@ -107,7 +108,8 @@ RpcServer::RpcServer(
               impl->oncancel(id);
             }};
 
-        return a0_rpc_server_init(c, c_topic, alloc, c_onrequest, c_oncancel);
+        a0_rpc_options_t c_opts{c_threadattr(opts.thread_attr)};
+        return a0_rpc_server_init_options(c, c_topic, alloc, c_onrequest, c_oncancel, c_opts);
       },
       [](a0_rpc_server_t* c, RpcServerImpl*) {
         a0_rpc_server_close(c);
@@ -125,7 +127,7 @@ struct RpcClientImpl {
 
 }  // namespace
 
-RpcClient::RpcClient(RpcTopic topic) {
+RpcClient::RpcClient(RpcTopic topic, RpcOptions opts) {
   set_c_impl<RpcClientImpl>(
       &c,
       [&](a0_rpc_client_t* c, RpcClientImpl* impl) {
@@ -143,7 +145,8 @@ RpcClient::RpcClient(RpcTopic topic) {
             .dealloc = nullptr,
         };
 
-        return a0_rpc_client_init(c, c_topic, alloc);
+        a0_rpc_options_t c_opts{c_threadattr(opts.thread_attr)};
+        return a0_rpc_client_init_options(c, c_topic, alloc, c_opts);
       },
       [](a0_rpc_client_t* c, RpcClientImpl*) {
         a0_rpc_client_close(c);
@@ -0,0 +1,220 @@
+#include <a0/alloc.h>
+#include <a0/buf.h>
+#include <a0/err.h>
+
+#include <doctest.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "src/err_macro.h"
+#include "src/test_util.hpp"
+
+static bool aligned(a0_buf_t buf) {
+  return (uintptr_t)buf.data % 16 == 0;
+}
+
+TEST_CASE("alloc] pool") {
+  a0_alloc_pool_t pool;
+  REQUIRE_OK(a0_alloc_pool_init(&pool, 100, 4));
+  a0_alloc_t alloc;
+  REQUIRE_OK(a0_alloc_pool_allocator(&pool, &alloc));
+
+  // Blocks are distinct and don't overlap.
+  std::vector<a0_buf_t> bufs(4);
+  std::set<uint8_t*> seen;
+  for (auto&& buf : bufs) {
+    REQUIRE_OK(a0_alloc(alloc, 100, &buf));
+    REQUIRE(buf.size == 100);
+    REQUIRE(aligned(buf));
+    memset(buf.data, 0xff, buf.size);
+    seen.insert(buf.data);
+  }
+  REQUIRE(seen.size() == 4);
+
+  // Exhausted, and oversized, requests fall back to malloc.
+  a0_buf_t extra;
+  REQUIRE_OK(a0_alloc(alloc, 100, &extra));
+  REQUIRE(!seen.count(extra.data));
+  a0_buf_t big;
+  REQUIRE_OK(a0_alloc(alloc, 1000, &big));
+  memset(big.data, 0xff, big.size);
+
+  REQUIRE(A0_SYSERR(a0_alloc_pool_close(&pool)) == EBUSY);
+
+  REQUIRE_OK(a0_dealloc(alloc, extra));
+  REQUIRE_OK(a0_dealloc(alloc, big));
+
+  // Released blocks are reused, in any order.
+  REQUIRE_OK(a0_dealloc(alloc, bufs[2]));
+  REQUIRE_OK(a0_dealloc(alloc, bufs[0]));
+  a0_buf_t reused;
+  REQUIRE_OK(a0_alloc(alloc, 1, &reused));
+  REQUIRE(reused.data == bufs[0].data);
+  bufs[0] = reused;
+
+  for (size_t i = 0; i < bufs.size(); i++) {
+    if (i != 2) {
+      REQUIRE_OK(a0_dealloc(alloc, bufs[i]));
+    }
+  }
+  REQUIRE_OK(a0_alloc_pool_close(&pool));
+}
+
+TEST_CASE("alloc] pool threads") {
+  a0_alloc_pool_t pool;
+  REQUIRE_OK(a0_alloc_pool_init(&pool, 64, 8));
+  a0_alloc_t alloc;
+  REQUIRE_OK(a0_alloc_pool_allocator(&pool, &alloc));
+
+  // Each thread checks nobody else wrote to its block while it held it.
+  std::vector<std::thread> threads;
+  std::vector<int> corrupted(4);
+  for (size_t t = 0; t < 4; t++) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < 10000; i++) {
+        a0_buf_t buf;
+        a0_alloc(alloc, 64, &buf);
+        memset(buf.data, (int)t, buf.size);
+        for (size_t j = 0; j < buf.size; j++) {
+          corrupted[t] |= buf.data[j] != t;
+        }
+        a0_dealloc(alloc, buf);
+      }
+    });
+  }
+  for (auto&& thread : threads) {
+    thread.join();
+  }
+  for (auto&& c : corrupted) {
+    REQUIRE(!c);
+  }
+
+  REQUIRE_OK(a0_alloc_pool_close(&pool));
+}
+
+TEST_CASE("alloc] ring") {
+  a0_alloc_ring_t ring;
+  REQUIRE_OK(a0_alloc_ring_init(&ring, 256));
+  a0_alloc_t alloc;
+  REQUIRE_OK(a0_alloc_ring_allocator(&ring, &alloc));
+
+  // Each buffer takes a 16 byte header, plus its size rounded up to 16.
+  a0_buf_t a, b, c;
+  REQUIRE_OK(a0_alloc(alloc, 100, &a));
+  REQUIRE_OK(a0_alloc(alloc, 100, &b));
+  REQUIRE(aligned(a));
+  REQUIRE(aligned(b));
+  REQUIRE(b.data == a.data + 128);
+
+  // Full. Falls back to malloc.
+  REQUIRE_OK(a0_alloc(alloc, 100, &c));
+  REQUIRE((c.data < a.data || c.data >= a.data + 256));
+  REQUIRE_OK(a0_dealloc(alloc, c));
+
+  REQUIRE(A0_SYSERR(a0_alloc_ring_close(&ring)) == EBUSY);
+
+  // Releasing the oldest makes room at the start.
+  REQUIRE_OK(a0_dealloc(alloc, a));
+  REQUIRE_OK(a0_alloc(alloc, 100, &c));
+  REQUIRE(c.data == a.data);
+
+  REQUIRE_OK(a0_dealloc(alloc, b));
+  REQUIRE_OK(a0_dealloc(alloc, c));
+
+  // Buffers that don't fit the end of the ring wrap to the start.
+  REQUIRE_OK(a0_alloc(alloc, 50, &a));
+  REQUIRE(a.data == c.data + 128);
+  REQUIRE_OK(a0_dealloc(alloc, a));
+  REQUIRE_OK(a0_alloc(alloc, 100, &b));
+  REQUIRE(b.data == c.data);
+  REQUIRE_OK(a0_dealloc(alloc, b));
+
+  REQUIRE_OK(a0_alloc_ring_close(&ring));
+}
+
+TEST_CASE("alloc] ring threads") {
+  a0_alloc_ring_t ring;
+  REQUIRE_OK(a0_alloc_ring_init(&ring, 4096));
+  a0_alloc_t alloc;
+  REQUIRE_OK(a0_alloc_ring_allocator(&ring, &alloc));
+
+  // One thread allocates, another releases in order.
+  std::mutex mu;
+  std::condition_variable cv;
+  std::deque<a0_buf_t> queue;
+  bool corrupted = false;
+  std::thread releaser([&]() {
+    for (size_t i = 0; i < 10000; i++) {
+      a0_buf_t buf;
+      {
+        std::unique_lock<std::mutex> lk{mu};
+        cv.wait(lk, [&]() { return !queue.empty(); });
+        buf = queue.front();
+        queue.pop_front();
+      }
+      for (size_t j = 0; j < buf.size; j++) {
+        corrupted |= buf.data[j] != (uint8_t)i;
+      }
+      a0_dealloc(alloc, buf);
+    }
+  });
+  for (size_t i = 0; i < 10000; i++) {
+    a0_buf_t buf;
+    a0_alloc(alloc, i % 300, &buf);
+    memset(buf.data, (uint8_t)i, buf.size);
+    std::unique_lock<std::mutex> lk{mu};
+    queue.push_back(buf);
+    cv.notify_one();
+  }
+  releaser.join();
+  REQUIRE(!corrupted);
+
+  REQUIRE_OK(a0_alloc_ring_close(&ring));
+}
+
+TEST_CASE("alloc] bump") {
+  a0_alloc_bump_t bump;
+  REQUIRE_OK(a0_alloc_bump_init(&bump, 256));
+  a0_alloc_t alloc;
+  REQUIRE_OK(a0_alloc_bump_allocator(&bump, &alloc));
+
+  a0_buf_t a, b, c;
+  REQUIRE_OK(a0_alloc(alloc, 100, &a));
+  REQUIRE_OK(a0_alloc(alloc, 100, &b));
+  REQUIRE(b.data == a.data + 112);
+  REQUIRE(aligned(b));
+
+  // Full. Falls back to malloc.
+  REQUIRE_OK(a0_alloc(alloc, 100, &c));
+  REQUIRE((c.data < a.data || c.data >= a.data + 256));
+  REQUIRE_OK(a0_dealloc(alloc, c));
+
+  // Rewinds once everything is released, in any order.
+  REQUIRE_OK(a0_dealloc(alloc, a));
+  REQUIRE(A0_SYSERR(a0_alloc_bump_close(&bump)) == EBUSY);
+  REQUIRE_OK(a0_dealloc(alloc, b));
+  REQUIRE_OK(a0_alloc(alloc, 200, &c));
+  REQUIRE(c.data == a.data);
+  REQUIRE_OK(a0_dealloc(alloc, c));
+
+  REQUIRE_OK(a0_alloc_bump_close(&bump));
+}
+
+TEST_CASE("alloc] invalid") {
+  a0_alloc_pool_t pool;
+  REQUIRE(a0_alloc_pool_init(&pool, 0, 4) == A0_ERR_INVALID_ARG);
+  REQUIRE(a0_alloc_pool_init(&pool, 64, 0) == A0_ERR_INVALID_ARG);
+  a0_alloc_ring_t ring;
+  REQUIRE(a0_alloc_ring_init(&ring, 16) == A0_ERR_INVALID_ARG);
+  a0_alloc_bump_t bump;
+  REQUIRE(a0_alloc_bump_init(&bump, 0) == A0_ERR_INVALID_ARG);
+}
@@ -0,0 +1,111 @@
+#include <a0/cursor.h>
+#include <a0/cursor.hpp>
+#include <a0/err.h>
+#include <a0/file.h>
+
+#include <doctest.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "src/err_macro.h"
+#include "src/test_util.hpp"
+
+struct CursorFixture {
+  a0_cursor_topic_t topic = {"test"};
+  const char* topic_path = "test.cursor";
+
+  CursorFixture() {
+    a0_file_remove(topic_path);
+  }
+
+  ~CursorFixture() {
+    a0_file_remove(topic_path);
+  }
+};
+
+TEST_CASE_FIXTURE(CursorFixture, "cursor] basic") {
+  a0_cursor_table_t table;
+  REQUIRE_OK(a0_cursor_table_init(&table, topic));
+
+  a0_cursor_t cursor;
+  REQUIRE_OK(a0_cursor_open(&table, "consumer", &cursor));
+  uint64_t seq;
+  REQUIRE_OK(a0_cursor_load(cursor, &seq));
+  REQUIRE(seq == 0);
+
+  REQUIRE_OK(a0_cursor_commit(cursor, 7));
+  REQUIRE_OK(a0_cursor_load(cursor, &seq));
+  REQUIRE(seq == 7);
+
+  // Positions survive the table being closed and opened again.
+  REQUIRE_OK(a0_cursor_table_close(&table));
+  REQUIRE_OK(a0_cursor_table_init(&table, topic));
+  REQUIRE_OK(a0_cursor_open(&table, "consumer", &cursor));
+  REQUIRE_OK(a0_cursor_load(cursor, &seq));
+  REQUIRE(seq == 7);
+
+  // Other names get their own slot.
+  a0_cursor_t other;
+  REQUIRE_OK(a0_cursor_open(&table, "other", &other));
+  REQUIRE_OK(a0_cursor_commit(other, 3));
+
+  a0_cursor_info_t infos[A0_CURSOR_MAX];
+  size_t cnt;
+  REQUIRE_OK(a0_cursor_table_list(&table, infos, &cnt));
+  REQUIRE(cnt == 2);
+  REQUIRE(std::string(infos[0].name) == "consumer");
+  REQUIRE(infos[0].seq == 7);
+  REQUIRE(std::string(infos[1].name) == "other");
+  REQUIRE(infos[1].seq == 3);
+
+  // Removed cursors start over.
+  REQUIRE_OK(a0_cursor_remove(&table, "consumer"));
+  REQUIRE(a0_cursor_remove(&table, "consumer") == A0_ERR_NOT_FOUND);
+  REQUIRE_OK(a0_cursor_open(&table, "consumer", &cursor));
+  REQUIRE_OK(a0_cursor_load(cursor, &seq));
+  REQUIRE(seq == 0);
+
+  REQUIRE_OK(a0_cursor_table_close(&table));
+}
+
+TEST_CASE_FIXTURE(CursorFixture, "cursor] limits") {
+  a0_cursor_table_t table;
+  REQUIRE_OK(a0_cursor_table_init(&table, topic));
+
+  a0_cursor_t cursor;
+  REQUIRE(a0_cursor_open(&table, "", &cursor) == A0_ERR_INVALID_ARG);
+  REQUIRE(a0_cursor_open(&table, std::string(A0_CURSOR_NAME_MAX, 'x').c_str(), &cursor) == A0_ERR_INVALID_ARG);
+  REQUIRE_OK(a0_cursor_open(&table, std::string(A0_CURSOR_NAME_MAX - 1, 'x').c_str(), &cursor));
+
+  for (size_t i = 1; i < A0_CURSOR_MAX; i++) {
+    REQUIRE_OK(a0_cursor_open(&table, std::to_string(i).c_str(), &cursor));
+  }
+  REQUIRE(A0_SYSERR(a0_cursor_open(&table, "full", &cursor)) == ENOSPC);
+  // Existing names still open.
+  REQUIRE_OK(a0_cursor_open(&table, "1", &cursor));
+
+  REQUIRE_OK(a0_cursor_table_close(&table));
+}
+
+TEST_CASE_FIXTURE(CursorFixture, "cursor] cpp") {
+  a0::Cursor cursor;
+  {
+    a0::CursorTable table("test");
+    cursor = table.open("consumer");
+    table.open("other").commit(3);
+  }
+
+  // The cursor keeps its table open.
+  REQUIRE(cursor.load() == 0);
+  cursor.commit(5);
+
+  a0::CursorTable table("test");
+  REQUIRE(table.list() == std::map<std::string, uint64_t>{{"consumer", 5}, {"other", 3}});
+  table.remove("other");
+  REQUIRE_THROWS_WITH(table.remove("other"), "Not found");
+  REQUIRE(table.list().size() == 1);
+}
@@ -0,0 +1,196 @@
+#include <a0/callback.h>
+#include <a0/empty.h>
+#include <a0/event.h>
+#include <a0/executor.h>
+#include <a0/executor.hpp>
+
+#include <doctest.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <vector>
+
+#include "src/err_macro.h"
+#include "src/test_util.hpp"
+
+struct StrandLog {
+  a0_executor_strand_t strand;
+  std::vector<size_t> seen;
+  std::atomic<int> running{0};
+  bool overlapped{false};
+};
+
+struct StrandTask {
+  StrandLog* log;
+  size_t idx;
+};
+
+static a0_err_t record_task(void* user_data) {
+  auto* task = (StrandTask*)user_data;
+  if (task->log->running.fetch_add(1)) {
+    task->log->overlapped = true;
+  }
+  task->log->seen.push_back(task->idx);
+  task->log->running.fetch_sub(1);
+  return A0_OK;
+}
+
+TEST_CASE("executor] strand order") {
+  a0_executor_t ex;
+  REQUIRE_OK(a0_executor_init(&ex, 4));
+
+  const size_t num_strands = 8;
+  const size_t num_tasks = 1000;
+  std::vector<StrandLog> logs(num_strands);
+  std::vector<StrandTask> tasks(num_strands * num_tasks);
+
+  for (auto&& log : logs) {
+    REQUIRE_OK(a0_executor_strand_init(&log.strand, &ex));
+  }
+
+  // Interleave posts across strands.
+  for (size_t i = 0; i < num_tasks; i++) {
+    for (size_t s = 0; s < num_strands; s++) {
+      auto* task = &tasks[s * num_tasks + i];
+      *task = {&logs[s], i};
+      REQUIRE_OK(a0_executor_post(&logs[s].strand, a0_callback_t{task, record_task}));
+    }
+  }
+
+  for (auto&& log : logs) {
+    REQUIRE_OK(a0_executor_strand_close(&log.strand));
+    REQUIRE(!log.overlapped);
+    REQUIRE(log.seen.size() == num_tasks);
+    bool in_order = true;
+    for (size_t i = 0; i < num_tasks; i++) {
+      in_order &= log.seen[i] == i;
+    }
+    REQUIRE(in_order);
+  }
+
+  REQUIRE_OK(a0_executor_close(&ex));
+}
+
+TEST_CASE("executor] strands run in parallel") {
+  a0_executor_t ex;
+  REQUIRE_OK(a0_executor_init(&ex, 2));
+
+  a0_executor_strand_t blocked;
+  a0_executor_strand_t unblocker;
+  REQUIRE_OK(a0_executor_strand_init(&blocked, &ex));
+  REQUIRE_OK(a0_executor_strand_init(&unblocker, &ex));
+
+  // The first task holds a worker until a task on another strand runs.
+  a0_event_t evt = A0_EMPTY;
+  REQUIRE_OK(a0_executor_post(&blocked, a0_callback_t{&evt, [](void* user_data) {
+                                                         return a0_event_wait((a0_event_t*)user_data);
+                                                       }}));
+  REQUIRE_OK(a0_executor_post(&unblocker, a0_callback_t{&evt, [](void* user_data) {
+                                                           return a0_event_set((a0_event_t*)user_data);
+                                                         }}));
+
+  REQUIRE_OK(a0_executor_strand_close(&blocked));
+  REQUIRE_OK(a0_executor_strand_close(&unblocker));
+  REQUIRE_OK(a0_executor_close(&ex));
+}
+
+TEST_CASE("executor] post task") {
+  a0_executor_t ex;
+  REQUIRE_OK(a0_executor_init(&ex, 1));
+
+  a0_executor_strand_t strand;
+  REQUIRE_OK(a0_executor_strand_init(&strand, &ex));
+
+  struct data_t {
+    a0_executor_task_t task;
+    int cnt;
+  } data = {};
+  data.task.callback = {&data, [](void* user_data) {
+                          ((data_t*)user_data)->cnt++;
+                          return A0_OK;
+                        }};
+
+  // Once run, the task may be posted again.
+  for (int i = 0; i < 3; i++) {
+    REQUIRE_OK(a0_executor_post_task(&strand, &data.task));
+    REQUIRE_OK(a0_executor_strand_close(&strand));
+    REQUIRE_OK(a0_executor_strand_init(&strand, &ex));
+  }
+  REQUIRE(data.cnt == 3);
+
+  REQUIRE_OK(a0_executor_strand_close(&strand));
+  REQUIRE_OK(a0_executor_close(&ex));
+}
+
+TEST_CASE("executor] close errors") {
+  a0_executor_t ex;
+  REQUIRE_OK(a0_executor_init(&ex, 1));
+
+  a0_executor_strand_t strand;
+  REQUIRE_OK(a0_executor_strand_init(&strand, &ex));
+  REQUIRE(A0_SYSERR(a0_executor_close(&ex)) == EBUSY);
+
+  struct data_t {
+    a0_executor_t* ex;
+    a0_executor_strand_t* strand;
+    // Syscodes are per-thread. Read them on the worker.
+    int strand_err;
+    int ex_err;
+  } data{&ex, &strand, 0, 0};
+
+  REQUIRE_OK(a0_executor_post(&strand, a0_callback_t{&data, [](void* user_data) {
+                                                        auto* data = (data_t*)user_data;
+                                                        data->strand_err = A0_SYSERR(a0_executor_strand_close(data->strand));
+                                                        data->ex_err = A0_SYSERR(a0_executor_close(data->ex));
+                                                        return A0_OK;
+                                                      }}));
+
+  REQUIRE_OK(a0_executor_strand_close(&strand));
+  REQUIRE(data.strand_err == EDEADLK);
+  REQUIRE(data.ex_err == EDEADLK);
+
+  REQUIRE_OK(a0_executor_close(&ex));
+}
+
+TEST_CASE("executor] close strand from another strand") {
+  // With one worker, the closed strand is queued behind the closing task.
+  a0_executor_t ex;
+  REQUIRE_OK(a0_executor_init(&ex, 1));
+
+  a0_executor_strand_t closer;
+  a0_executor_strand_t closed;
+  REQUIRE_OK(a0_executor_strand_init(&closer, &ex));
+  REQUIRE_OK(a0_executor_strand_init(&closed, &ex));
+
+  struct data_t {
+    a0_executor_strand_t* closed;
+    a0_event_t posted;
+    int ran;
+    a0_err_t err;
+  } data{&closed, A0_EMPTY, 0, A0_OK};
+
+  REQUIRE_OK(a0_executor_post(&closer, a0_callback_t{&data, [](void* user_data) {
+                                                       auto* data = (data_t*)user_data;
+                                                       a0_event_wait(&data->posted);
+                                                       data->err = a0_executor_strand_close(data->closed);
+                                                       return A0_OK;
+                                                     }}));
+  REQUIRE_OK(a0_executor_post(&closed, a0_callback_t{&data, [](void* user_data) {
+                                                       ((data_t*)user_data)->ran++;
+                                                       return A0_OK;
+                                                     }}));
+  REQUIRE_OK(a0_event_set(&data.posted));
+
+  REQUIRE_OK(a0_executor_strand_close(&closer));
+  REQUIRE_OK(data.err);
+  REQUIRE(data.ran == 1);
+
+  REQUIRE_OK(a0_executor_close(&ex));
+}
+
+TEST_CASE("executor] cpp") {
+  a0::Executor ex(2);
+  REQUIRE(ex.c);
+  REQUIRE(!a0::Executor().c);
+}
@@ -95,6 +95,111 @@ TEST_CASE("file] bad size") {
   REQUIRE_OK(a0_file_close(&file));
 }
 
+TEST_CASE("file] huge pages") {
+  static const char* TEST_FILE = "/dev/shm/test.file";
+  a0_file_remove(TEST_FILE);
+
+  REQUIRE(!A0_FILE_OPTIONS_DEFAULT.open_options.huge_pages);
+  REQUIRE(!a0::File::Options::DEFAULT.open_options.huge_pages);
+
+  // Falls back to normal pages if huge pages are unavailable.
+  a0_file_options_t opt = A0_FILE_OPTIONS_DEFAULT;
+  opt.create_options.size = 4 * 1024 * 1024;
+  opt.open_options.huge_pages = true;
+
+  a0_file_t file;
+  REQUIRE_OK(a0_file_open(TEST_FILE, &opt, &file));
+  REQUIRE(file.arena.buf.size == 4 * 1024 * 1024);
+  memset(file.arena.buf.data, 'a', file.arena.buf.size);
+  REQUIRE(file.arena.buf.data[file.arena.buf.size - 1] == 'a');
+  REQUIRE_OK(a0_file_close(&file));
+
+  REQUIRE_OK(a0_file_remove(TEST_FILE));
+}
+
+TEST_CASE("file] resident") {
+  static const char* TEST_FILE = "/dev/shm/test.file";
+  a0_file_remove(TEST_FILE);
+
+  a0_file_options_t opt = A0_FILE_OPTIONS_DEFAULT;
+  opt.create_options.size = 16 * 1024;
+  opt.open_options.populate = true;
+  opt.open_options.prefault = true;
+
+  a0_file_t file;
+  REQUIRE_OK(a0_file_open(TEST_FILE, &opt, &file));
+  memset(file.arena.buf.data, 'a', file.arena.buf.size);
+  REQUIRE_OK(a0_file_close(&file));
+
+  // Prefaulting leaves the contents unchanged.
+  opt.open_options.arena_mode = A0_ARENA_MODE_READONLY;
+  REQUIRE_OK(a0_file_open(TEST_FILE, &opt, &file));
+  REQUIRE(file.arena.buf.data[0] == 'a');
+  REQUIRE(file.arena.buf.data[file.arena.buf.size - 1] == 'a');
+  REQUIRE_OK(a0_file_close(&file));
+
+  // Locking may be disallowed by RLIMIT_MEMLOCK.
+  opt.open_options.arena_mode = A0_ARENA_MODE_SHARED;
+  for (auto mode : {A0_FILE_MLOCK_NOW, A0_FILE_MLOCK_ONFAULT}) {
+    opt.open_options.mlock = mode;
+    a0_err_t err = a0_file_open(TEST_FILE, &opt, &file);
+    if (err) {
+      int syserr = A0_SYSERR(err);
+      REQUIRE((syserr == ENOMEM || syserr == EPERM || syserr == ENOTSUP));
+    } else {
+      REQUIRE(file.arena.buf.data[0] == 'a');
+      REQUIRE_OK(a0_file_close(&file));
+    }
+  }
+
+  REQUIRE_OK(a0_file_remove(TEST_FILE));
+}
+
+TEST_CASE("file] grow") {
+  static const char* TEST_FILE = "/dev/shm/test.file";
+  a0_file_remove(TEST_FILE);
+
+  a0_file_options_t opt = A0_FILE_OPTIONS_DEFAULT;
+  opt.create_options.size = 16 * 1024;
+  opt.open_options.max_size = 64 * 1024;
+
+  a0_file_t file;
+  REQUIRE_OK(a0_file_open(TEST_FILE, &opt, &file));
+  REQUIRE(file.arena.buf.size == 16 * 1024);
+
+  a0_file_t other;
+  REQUIRE_OK(a0_file_open(TEST_FILE, &opt, &other));
+  uint8_t* other_data = other.arena.buf.data;
+
+  REQUIRE_OK(a0_file_grow(&file, 32 * 1024));
+  REQUIRE(file.arena.buf.size == 32 * 1024);
+  REQUIRE(file.stat.st_size == 32 * 1024);
+  file.arena.buf.data[32 * 1024 - 1] = 'a';
+
+  // Never shrinks.
+  REQUIRE_OK(a0_file_grow(&file, 1024));
+  REQUIRE(file.arena.buf.size == 32 * 1024);
+
+  // Picks up growth from elsewhere, in place.
+  REQUIRE_OK(a0_file_grow(&other, 0));
+  REQUIRE(other.arena.buf.size == 32 * 1024);
+  REQUIRE(other.arena.buf.data == other_data);
+  REQUIRE(other.arena.buf.data[32 * 1024 - 1] == 'a');
+
+  REQUIRE(A0_SYSERR(a0_file_grow(&file, 64 * 1024 + 1)) == ENOMEM);
+  REQUIRE_OK(a0_file_grow(&file, 64 * 1024));
+
+  REQUIRE_OK(a0_file_close(&other));
+  REQUIRE_OK(a0_file_close(&file));
+
+  // Without max_size, there is no room to grow.
+  REQUIRE_OK(a0_file_open(TEST_FILE, nullptr, &file));
+  REQUIRE(A0_SYSERR(a0_file_grow(&file, 128 * 1024)) == ENOMEM);
+  REQUIRE_OK(a0_file_close(&file));
+
+  REQUIRE_OK(a0_file_remove(TEST_FILE));
+}
+
 TEST_CASE("file] double close") {
   static const char* TEST_FILE = "/tmp/test.file";
   a0_file_remove(TEST_FILE);
@@ -114,6 +114,40 @@ TEST_CASE("packet] serialize deserialize") {
   });
 }
 
+TEST_CASE("packet] reserialize") {
+  with_standard_packet([](a0_packet_t prev_pkt) {
+    a0_flat_packet_t prev_fpkt;
+    REQUIRE_OK(a0_packet_serialize(prev_pkt, a0::test::alloc(), &prev_fpkt));
+
+    a0_packet_header_t extra_hdrs[] = {
+        {"extra_key_0", "extra_val_0"},
+        {"extra_key_1", "extra_val_1"},
+    };
+    a0_packet_t pkt = prev_pkt;
+    pkt.headers_block = {extra_hdrs, 2, &prev_pkt.headers_block};
+
+    a0_flat_packet_t want;
+    REQUIRE_OK(a0_packet_serialize(pkt, a0::test::alloc(), &want));
+
+    // No new headers is a plain copy.
+    a0_flat_packet_t got;
+    REQUIRE_OK(a0_packet_reserialize(prev_pkt, prev_pkt, prev_fpkt, a0::test::alloc(), &got));
+    REQUIRE(a0::test::str(got.buf) == a0::test::str(prev_fpkt.buf));
+
+    REQUIRE_OK(a0_packet_reserialize(pkt, prev_pkt, prev_fpkt, a0::test::alloc(), &got));
+    REQUIRE(a0::test::str(got.buf) == a0::test::str(want.buf));
+
+    // Replaced payload.
+    pkt.payload = a0::test::buf("other");
+    REQUIRE(a0_packet_reserialize(pkt, prev_pkt, prev_fpkt, a0::test::alloc(), &got) == A0_ERR_INVALID_ARG);
+
+    // Unrelated headers.
+    pkt.payload = prev_pkt.payload;
+    pkt.headers_block = {extra_hdrs, 2, nullptr};
+    REQUIRE(a0_packet_reserialize(pkt, prev_pkt, prev_fpkt, a0::test::alloc(), &got) == A0_ERR_INVALID_ARG);
+  });
+}
+
 TEST_CASE("packet] deep_copy") {
   with_standard_packet([](a0_packet_t pkt) {
     a0_packet_t pkt_after;
@@ -224,6 +258,25 @@ TEST_CASE("packet] cpp") {
   REQUIRE(pkt5.payload().data() == owner.data());
 }
 
+TEST_CASE("packet] cpp wrap") {
+  with_standard_packet([](a0_packet_t pkt) {
+    int deleted = 0;
+    {
+      a0::Packet cpp_pkt(pkt, [&](a0_packet_t*) { deleted++; });
+      a0::Packet cpp_pkt_copy = cpp_pkt;
+
+      REQUIRE(cpp_pkt.id() == pkt.id);
+      REQUIRE(cpp_pkt.payload() == "Hello, World!");
+      REQUIRE(cpp_pkt.payload().data() == (char*)pkt.payload.data);
+      REQUIRE(cpp_pkt.headers() == standard_packet_hdrs());
+      REQUIRE(&cpp_pkt_copy.headers() == &cpp_pkt.headers());
+      REQUIRE(cpp_pkt.c->headers_block.headers == pkt.headers_block.headers);
+      REQUIRE(deleted == 0);
+    }
+    REQUIRE(deleted == 1);
+  });
+}
+
 TEST_CASE("flat_packet] cpp") {
   with_standard_packet([](a0_packet_t pkt) {
     a0::FlatPacket fpkt;
@@ -27,6 +27,7 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <ostream>
 #include <set>
 #include <string>
@@ -38,7 +39,7 @@
 #include "src/test_util.hpp"
 
 struct PubsubFixture {
-  a0_pubsub_topic_t topic = {"test", nullptr};
+  a0_pubsub_topic_t topic = {"test", nullptr, nullptr};
   const char* topic_path = "test.pubsub.a0";
   std::vector<std::thread> threads;
 
@@ -89,7 +90,7 @@ TEST_CASE_FIXTURE(PubsubFixture, "pubsub] sync") {
     REQUIRE_OK(a0_subscriber_sync_init(&sub,
                                        topic,
                                        a0::test::alloc(),
-                                       (a0_reader_options_t){A0_INIT_OLDEST, A0_ITER_NEXT}));
+                                       a0::test::reader_opts(A0_INIT_OLDEST, A0_ITER_NEXT)));
 
     uint64_t pkt1_time_mono;
 
@@ -190,7 +191,7 @@ TEST_CASE_FIXTURE(PubsubFixture, "pubsub] sync") {
     REQUIRE_OK(a0_subscriber_sync_init(&sub,
                                        topic,
                                        a0::test::alloc(),
-                                       (a0_reader_options_t){A0_INIT_MOST_RECENT, A0_ITER_NEWEST}));
+                                       a0::test::reader_opts(A0_INIT_MOST_RECENT, A0_ITER_NEWEST)));
 
     {
       bool can_read;
@@ -442,6 +443,161 @@ TEST_CASE_FIXTURE(PubsubFixture, "pubsub] cpp zc") {
   }
 }
 
+TEST_CASE_FIXTURE(PubsubFixture, "pubsub] cpp batch") {
+  a0::Publisher p(topic.name);
+  for (int i = 0; i < 5; i++) {
+    p.pub("msg #" + std::to_string(i));
+  }
+
+  {
+    a0::SubscriberSync sub(topic.name, a0::INIT_OLDEST);
+    auto pkts = sub.read_batch(3);
+    REQUIRE(pkts.size() == 3);
+    REQUIRE(pkts[0].payload() == "msg #0");
+    REQUIRE(pkts[2].payload() == "msg #2");
+    REQUIRE(sub.read_batch(3).size() == 2);
+    REQUIRE(sub.read_batch(3).empty());
+  }
+
+  {
+    std::vector<std::string> payloads;
+    a0::SubscriberSyncZeroCopy sub_zc(topic.name, a0::INIT_OLDEST);
+    REQUIRE(sub_zc.read_batch(SIZE_MAX, [&](a0::TransportLocked, a0::FlatPacket fpkt) {
+      payloads.push_back(std::string(fpkt.payload()));
+    }) == 5);
+    REQUIRE(payloads.back() == "msg #4");
+  }
+
+  {
+    std::vector<std::string> payloads;
+    a0_event_t done = A0_EMPTY;
+    a0::Subscriber sub(
+        topic.name, a0::Reader::Options(a0::INIT_OLDEST), 4, [&](std::vector<a0::Packet> pkts) {
+          REQUIRE(!pkts.empty());
+          REQUIRE(pkts.size() <= 4);
+          for (auto&& pkt : pkts) {
+            payloads.push_back(std::string(pkt.payload()));
+          }
+          if (payloads.size() == 5) {
+            a0_event_set(&done);
+          }
+        });
+    a0_event_wait(&done);
+    REQUIRE(payloads.front() == "msg #0");
+    REQUIRE(payloads.back() == "msg #4");
+  }
+}
+
+TEST_CASE_FIXTURE(PubsubFixture, "pubsub] cpp packets outlive subscriber") {
+  // Small packets come from the subscriber's pool. Large ones don't fit.
+  std::string big(10000, 'x');
+  a0::Publisher p(topic.name);
+  for (int i = 0; i < 40; i++) {
+    p.pub(i % 10 ? "msg #" + std::to_string(i) : big);
+  }
+
+  std::vector<a0::Packet> pkts;
+  {
+    a0::SubscriberSync sub(topic.name, a0::INIT_OLDEST);
+    pkts.push_back(sub.read());
+    for (auto&& pkt : sub.read_batch(100)) {
+      pkts.push_back(pkt);
+    }
+  }
+  {
+    a0_event_t done = A0_EMPTY;
+    a0::Subscriber sub(topic.name, a0::INIT_OLDEST, [&](a0::Packet pkt) {
+      pkts.push_back(pkt);
+      if (pkts.size() == 80) {
+        a0_event_set(&done);
+      }
+    });
+    a0_event_wait(&done);
+  }
+
+  REQUIRE(pkts.size() == 80);
+  for (size_t i = 0; i < pkts.size(); i++) {
+    REQUIRE(pkts[i].payload() == (i % 10 ? "msg #" + std::to_string(i % 40) : big));
+  }
+}
+
+TEST_CASE_FIXTURE(PubsubFixture, "pubsub] cpp mux") {
+  a0_file_remove("other.pubsub.a0");
+
+  std::vector<std::string> payloads;
+  a0_latch_t latch;
+  a0_latch_init(&latch, 4);
+
+  a0::Publisher p(topic.name);
+  a0::Publisher other_p("other");
+  p.pub("msg #0");
+
+  {
+    a0::ReaderMux mux;
+    auto onpacket = [&](a0::Packet pkt) {
+      // Callbacks share the multiplexer thread, so they never overlap.
+      payloads.push_back(std::string(pkt.payload()));
+      a0_latch_count_down(&latch, 1);
+    };
+    a0::Subscriber sub(mux, topic.name, a0::Reader::Options(a0::INIT_OLDEST), onpacket);
+    a0::Subscriber other_sub(mux, "other", a0::Reader::Options(a0::INIT_OLDEST), onpacket);
+
+    other_p.pub("other #0");
+    p.pub("msg #1");
+    other_p.pub("other #1");
+
+    a0_latch_wait(&latch);
+  }
+
+  std::sort(payloads.begin(), payloads.end());
+  REQUIRE(payloads == std::vector<std::string>{"msg #0", "msg #1", "other #0", "other #1"});
+
+  a0_file_remove("other.pubsub.a0");
+}
+
+TEST_CASE_FIXTURE(PubsubFixture, "pubsub] cpp executor") {
+  a0_file_remove("other.pubsub.a0");
+
+  std::mutex mu;
+  std::vector<std::string> payloads;
+  std::vector<std::string> other_payloads;
+  a0_latch_t latch;
+  a0_latch_init(&latch, 20);
+
+  a0::Publisher p(topic.name);
+  a0::Publisher other_p("other");
+
+  {
+    a0::Reader::Options opts(a0::INIT_OLDEST);
+    opts.executor = a0::Executor(4);
+
+    a0::Subscriber sub(topic.name, opts, [&](a0::Packet pkt) {
+      std::unique_lock<std::mutex> lk{mu};
+      payloads.push_back(std::string(pkt.payload()));
+      a0_latch_count_down(&latch, 1);
+    });
+    a0::Subscriber other_sub("other", opts, [&](a0::Packet pkt) {
+      std::unique_lock<std::mutex> lk{mu};
+      other_payloads.push_back(std::string(pkt.payload()));
+      a0_latch_count_down(&latch, 1);
+    });
+
+    for (int i = 0; i < 10; i++) {
+      p.pub("msg #" + std::to_string(i));
+      other_p.pub("other #" + std::to_string(i));
+    }
+
+    a0_latch_wait(&latch);
+  }
+
+  for (int i = 0; i < 10; i++) {
+    REQUIRE(payloads[i] == "msg #" + std::to_string(i));
+    REQUIRE(other_payloads[i] == "other #" + std::to_string(i));
+  }
+
+  a0_file_remove("other.pubsub.a0");
+}
+
 TEST_CASE_FIXTURE(PubsubFixture, "pubsub] await_new") {
   struct data_t {
     std::vector<std::string> msgs;
@@ -467,7 +623,7 @@ TEST_CASE_FIXTURE(PubsubFixture, "pubsub] await_new") {
   REQUIRE_OK(a0_subscriber_init(&sub,
                                 topic,
                                 a0::test::alloc(),
-                                (a0_reader_options_t){A0_INIT_AWAIT_NEW, A0_ITER_NEXT},
+                                a0::test::reader_opts(A0_INIT_AWAIT_NEW, A0_ITER_NEXT),
                                 cb));
 
   REQUIRE_OK(a0_publisher_pub(&pub, a0::test::pkt("msg after")));
@@ -526,7 +682,7 @@ TEST_CASE_FIXTURE(PubsubFixture, "pubsub] most_recent") {
   REQUIRE_OK(a0_subscriber_init(&sub,
                                 topic,
                                 a0::test::alloc(),
-                                (a0_reader_options_t){A0_INIT_MOST_RECENT, A0_ITER_NEXT},
+                                a0::test::reader_opts(A0_INIT_MOST_RECENT, A0_ITER_NEXT),
                                 cb));
 
   REQUIRE_OK(a0_publisher_pub(&pub, a0::test::pkt("msg after")));
@@ -561,6 +717,217 @@ TEST_CASE_FIXTURE(PubsubFixture, "pubsub] cpp most_recent") {
   REQUIRE(msgs == std::vector<std::string>{"msg before", "msg after"});
 }
 
+TEST_CASE_FIXTURE(PubsubFixture, "pubsub] grow") {
+  a0_file_options_t file_opts = A0_FILE_OPTIONS_DEFAULT;
+  file_opts.create_options.size = 4096;
+  file_opts.open_options.max_size = 64 * 1024;
+  a0_pubsub_topic_t growable_topic = {topic.name, &file_opts, nullptr};
+
+  a0_publisher_t pub;
+  REQUIRE_OK(a0_publisher_init(&pub, growable_topic));
+
+  a0_subscriber_sync_t sub;
+  REQUIRE_OK(a0_subscriber_sync_init(&sub, growable_topic, a0::test::alloc(), a0::test::reader_opts(A0_INIT_OLDEST, A0_ITER_NEXT)));
+
+  std::string big(20 * 1024, 'x');
+  REQUIRE_OK(a0_publisher_pub(&pub, a0::test::pkt(big)));
+  REQUIRE(pub._file.arena.buf.size == 32 * 1024);
+
+  a0_packet_t pkt;
+  REQUIRE_OK(a0_subscriber_sync_read(&sub, &pkt));
+  REQUIRE(a0::test::str(pkt.payload) == big);
+
+  std::string too_big(64 * 1024, 'x');
+  REQUIRE(a0_publisher_pub(&pub, a0::test::pkt(too_big)) == A0_ERR_FRAME_LARGE);
+  REQUIRE(pub._file.arena.buf.size == 64 * 1024);
+
+  REQUIRE_OK(a0_subscriber_sync_close(&sub));
+  REQUIRE_OK(a0_publisher_close(&pub));
+}
+
+TEST_CASE_FIXTURE(PubsubFixture, "pubsub] grow past subscriber mapping") {
+  a0_file_options_t file_opts = A0_FILE_OPTIONS_DEFAULT;
+  file_opts.create_options.size = 4096;
+  file_opts.open_options.max_size = 1024 * 1024;
+  a0_pubsub_topic_t growable_topic = {topic.name, &file_opts, nullptr};
+
+  a0_publisher_t pub;
+  REQUIRE_OK(a0_publisher_init(&pub, growable_topic));
+
+  // Subscribers that only map the file as it is now.
+  a0_reader_options_t opts = A0_READER_OPTIONS_DEFAULT;
+  opts.init = A0_INIT_OLDEST;
+  opts.iter = A0_ITER_NEXT;
+  a0_subscriber_sync_t sub;
+  REQUIRE_OK(a0_subscriber_sync_init(&sub, topic, a0::test::alloc(), opts));
+  REQUIRE(sub._file._map_size == 4096);
+
+  opts.optimistic = true;
+  a0_subscriber_sync_t optimistic_sub;
+  REQUIRE_OK(a0_subscriber_sync_init(&optimistic_sub, topic, a0::test::alloc(), opts));
+
+  std::string big(256 * 1024, 'x');
+  REQUIRE_OK(a0_publisher_pub(&pub, a0::test::pkt(big)));
+  REQUIRE(pub._file.arena.buf.size == 512 * 1024);
+
+  a0_packet_t pkt;
+  REQUIRE_OK(a0_subscriber_sync_read(&sub, &pkt));
+  REQUIRE(a0::test::str(pkt.payload) == big);
+  REQUIRE_OK(a0_subscriber_sync_read(&optimistic_sub, &pkt));
+  REQUIRE(a0::test::str(pkt.payload) == big);
+
+  REQUIRE_OK(a0_subscriber_sync_close(&optimistic_sub));
+  REQUIRE_OK(a0_subscriber_sync_close(&sub));
+  REQUIRE_OK(a0_publisher_close(&pub));
+}
+
+TEST_CASE_FIXTURE(PubsubFixture, "pubsub] grow while subscriber waits") {
+  a0_file_options_t file_opts = A0_FILE_OPTIONS_DEFAULT;
+  file_opts.create_options.size = 4096;
+  file_opts.open_options.max_size = 1024 * 1024;
+  a0_pubsub_topic_t growable_topic = {topic.name, &file_opts, nullptr};
+
+  a0_publisher_t pub;
+  REQUIRE_OK(a0_publisher_init(&pub, growable_topic));
+
+  a0_reader_options_t opts = A0_READER_OPTIONS_DEFAULT;
+  opts.init = A0_INIT_OLDEST;
+  opts.iter = A0_ITER_NEXT;
+  a0_subscriber_sync_t sub;
+  REQUIRE_OK(a0_subscriber_sync_init(&sub, topic, a0::test::alloc(), opts));
+
+  // The subscriber blocks with the small mapping, and wakes after the growth.
+  std::string big(256 * 1024, 'x');
+  std::thread t([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    REQUIRE_OK(a0_publisher_pub(&pub, a0::test::pkt(big)));
+  });
+
+  a0_packet_t pkt;
+  REQUIRE_OK(a0_subscriber_sync_read_blocking(&sub, &pkt));
+  REQUIRE(a0::test::str(pkt.payload) == big);
+  t.join();
+
+  REQUIRE_OK(a0_subscriber_sync_close(&sub));
+  REQUIRE_OK(a0_publisher_close(&pub));
+}
+
+TEST_CASE_FIXTURE(PubsubFixture, "pubsub] no growth with fixed slots") {
+  a0_file_options_t file_opts = A0_FILE_OPTIONS_DEFAULT;
+  file_opts.create_options.size = 4096;
+  file_opts.open_options.max_size = 64 * 1024;
+  a0_transport_options_t slot_opts = A0_TRANSPORT_OPTIONS_DEFAULT;
+  slot_opts.slot_size = 1024;
+  a0_pubsub_topic_t slot_topic = {topic.name, &file_opts, &slot_opts};
+
+  a0_publisher_t pub;
+  REQUIRE_OK(a0_publisher_init(&pub, slot_topic));
+
+  // A larger arena has no larger slots.
+  REQUIRE(a0_publisher_pub(&pub, a0::test::pkt(std::string(2048, 'x'))) == A0_ERR_FRAME_LARGE);
+  REQUIRE(pub._file.arena.buf.size == 4096);
+
+  REQUIRE_OK(a0_publisher_pub(&pub, a0::test::pkt("small")));
+
+  REQUIRE_OK(a0_publisher_close(&pub));
+}
+
+TEST_CASE_FIXTURE(PubsubFixture, "pubsub] reserve") {
+  a0_file_options_t file_opts = A0_FILE_OPTIONS_DEFAULT;
+  file_opts.create_options.size = 4096;
+  file_opts.open_options.max_size = 64 * 1024;
+  a0_pubsub_topic_t growable_topic = {topic.name, &file_opts, nullptr};
+
+  a0_publisher_t pub;
+  REQUIRE_OK(a0_publisher_init(&pub, growable_topic));
+
+  a0_subscriber_sync_t sub;
+  REQUIRE_OK(a0_subscriber_sync_init(&sub, growable_topic, a0::test::alloc(), a0::test::reader_opts(A0_INIT_OLDEST, A0_ITER_NEXT)));
+
+  // Grows the topic to fit the reservation.
+  a0_writer_reservation_t res;
+  REQUIRE_OK(a0_publisher_reserve(&pub, a0::test::pkt({{"key", "val"}}, ""), 20 * 1024, &res));
+  REQUIRE(pub._file.arena.buf.size == 32 * 1024);
+  memset(res.payload.data, 'x', res.payload.size);
+  REQUIRE_OK(a0_writer_reservation_commit(&res));
+
+  a0_packet_t pkt;
+  REQUIRE_OK(a0_subscriber_sync_read(&sub, &pkt));
+  REQUIRE(a0::test::str(pkt.payload) == std::string(20 * 1024, 'x'));
+  REQUIRE(a0::test::hdr(pkt).count("a0_time_mono"));
+  REQUIRE(a0::test::hdr(pkt).find("key")->second == "val");
+
+  REQUIRE_OK(a0_subscriber_sync_close(&sub));
+  REQUIRE_OK(a0_publisher_close(&pub));
+}
+
+TEST_CASE_FIXTURE(PubsubFixture, "pubsub] cpp reserve") {
+  a0::Publisher p(topic.name);
+  auto res = p.reserve({{"key", "val"}}, 6);
+  memcpy(res.payload().data(), "msg #0", 6);
+  res.commit();
+
+  a0::SubscriberSync sub(topic.name, a0::INIT_OLDEST);
+  REQUIRE(sub.can_read());
+  auto pkt = sub.read();
+  REQUIRE(pkt.payload() == "msg #0");
+  REQUIRE(pkt.headers().find("key")->second == "val");
+  REQUIRE(pkt.headers().size() == 6);
+}
+
+TEST_CASE_FIXTURE(PubsubFixture, "pubsub] compact frames") {
+  a0_transport_options_t compact_opts = A0_TRANSPORT_OPTIONS_DEFAULT;
+  compact_opts.frame_format = A0_TRANSPORT_FRAME_FORMAT_COMPACT;
+  a0_pubsub_topic_t compact_topic = {topic.name, nullptr, &compact_opts};
+
+  a0_subscriber_sync_t sub;
+  REQUIRE_OK(a0_subscriber_sync_init(&sub, compact_topic, a0::test::alloc(), a0::test::reader_opts(A0_INIT_OLDEST, A0_ITER_NEXT)));
+
+  // The publisher does not ask for the compact format, but the topic has it.
+  a0_publisher_t pub;
+  REQUIRE_OK(a0_publisher_init(&pub, topic));
+
+  REQUIRE_OK(a0_publisher_pub(&pub, a0::test::pkt("msg #0")));
+  REQUIRE_OK(a0_publisher_pub(&pub, a0::test::pkt("msg #1")));
+
+  a0_packet_t pkt;
+  REQUIRE_OK(a0_subscriber_sync_read(&sub, &pkt));
+  REQUIRE(a0::test::str(pkt.payload) == "msg #0");
+  REQUIRE_OK(a0_subscriber_sync_read(&sub, &pkt));
+  REQUIRE(a0::test::str(pkt.payload) == "msg #1");
+
+  a0_transport_t transport;
+  REQUIRE_OK(a0_transport_init(&transport, pub._file.arena));
+  REQUIRE(transport._compact);
+
+  REQUIRE_OK(a0_publisher_close(&pub));
+  REQUIRE_OK(a0_subscriber_sync_close(&sub));
+}
+
+TEST_CASE_FIXTURE(PubsubFixture, "pubsub] fixed slots") {
+  a0_transport_options_t slot_opts = A0_TRANSPORT_OPTIONS_DEFAULT;
+  slot_opts.slot_size = 1024;
+  a0_pubsub_topic_t slot_topic = {topic.name, nullptr, &slot_opts};
+
+  a0_publisher_t pub;
+  REQUIRE_OK(a0_publisher_init(&pub, slot_topic));
+
+  for (int i = 0; i < 1000; i++) {
+    REQUIRE_OK(a0_publisher_pub(&pub, a0::test::pkt("msg #" + std::to_string(i))));
+  }
+  REQUIRE(a0_publisher_pub(&pub, a0::test::pkt(std::string(1024, 'x'))) == A0_ERR_FRAME_LARGE);
+
+  a0_subscriber_sync_t sub;
+  REQUIRE_OK(a0_subscriber_sync_init(&sub, topic, a0::test::alloc(), a0::test::reader_opts(A0_INIT_MOST_RECENT, A0_ITER_NEXT)));
+
+  a0_packet_t pkt;
+  REQUIRE_OK(a0_subscriber_sync_read(&sub, &pkt));
+  REQUIRE(a0::test::str(pkt.payload) == "msg #999");
+
+  REQUIRE_OK(a0_subscriber_sync_close(&sub));
+  REQUIRE_OK(a0_publisher_close(&pub));
+}
+
 TEST_CASE_FIXTURE(PubsubFixture, "pubsub] multithread") {
   {
     a0_publisher_t pub;
@@ -599,7 +966,7 @@ TEST_CASE_FIXTURE(PubsubFixture, "pubsub] multithread") {
   REQUIRE_OK(a0_subscriber_init(&sub,
                                 topic,
                                 a0::test::alloc(),
-                                (a0_reader_options_t){A0_INIT_OLDEST, A0_ITER_NEXT},
+                                a0::test::reader_opts(A0_INIT_OLDEST, A0_ITER_NEXT),
                                 cb));
 
   a0_latch_wait(&data.latch);
@@ -766,7 +1133,7 @@ TEST_CASE_FIXTURE(PubsubFixture, "pubsub] many publisher fuzz") {
   REQUIRE_OK(a0_subscriber_sync_init(&sub,
                                      topic,
                                      a0::test::alloc(),
-                                     (a0_reader_options_t){A0_INIT_OLDEST, A0_ITER_NEXT}));
+                                     a0::test::reader_opts(A0_INIT_OLDEST, A0_ITER_NEXT)));
 
   while (true) {
     a0_packet_t pkt;
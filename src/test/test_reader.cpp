@@ -2,18 +2,33 @@
 #include <a0/arena.h>
 #include <a0/arena.hpp>
 #include <a0/buf.h>
+#include <a0/cursor.h>
+#include <a0/cursor.hpp>
+#include <a0/empty.h>
 #include <a0/err.h>
+#include <a0/event.h>
+#include <a0/executor.h>
+#include <a0/executor.hpp>
+#include <a0/file.h>
 #include <a0/packet.h>
 #include <a0/packet.hpp>
 #include <a0/reader.h>
 #include <a0/reader.hpp>
 #include <a0/string_view.hpp>
+#include <a0/thread_attr.h>
+#include <a0/thread_attr.hpp>
+#include <a0/time.h>
+#include <a0/time.hpp>
 #include <a0/transport.h>
 #include <a0/transport.hpp>
 
 #include <doctest.h>
+#include <pthread.h>
+#include <sched.h>
 
 #include <algorithm>
+#include <atomic>
+#include <cerrno>
 #include <chrono>
 #include <condition_variable>
 #include <cstddef>
@@ -27,20 +42,44 @@
 #include <vector>
 
 #include "src/c_wrap.hpp"
+#include "src/err_macro.h"
 #include "src/test_util.hpp"
 
-static a0_reader_options_t C_OLDEST_NEXT{A0_INIT_OLDEST, A0_ITER_NEXT};
-static a0_reader_options_t C_MOST_RECENT_NEXT{A0_INIT_MOST_RECENT, A0_ITER_NEXT};
-static a0_reader_options_t C_AWAIT_NEW_NEXT{A0_INIT_AWAIT_NEW, A0_ITER_NEXT};
-static a0_reader_options_t C_MOST_RECENT_NEWEST{A0_INIT_MOST_RECENT, A0_ITER_NEWEST};
-static a0_reader_options_t C_AWAIT_NEW_NEWEST{A0_INIT_AWAIT_NEW, A0_ITER_NEWEST};
+static a0_reader_options_t C_OLDEST_NEXT = a0::test::reader_opts(A0_INIT_OLDEST, A0_ITER_NEXT);
+static a0_reader_options_t C_MOST_RECENT_NEXT = a0::test::reader_opts(A0_INIT_MOST_RECENT, A0_ITER_NEXT);
+static a0_reader_options_t C_AWAIT_NEW_NEXT = a0::test::reader_opts(A0_INIT_AWAIT_NEW, A0_ITER_NEXT);
+static a0_reader_options_t C_MOST_RECENT_NEWEST = a0::test::reader_opts(A0_INIT_MOST_RECENT, A0_ITER_NEWEST);
+static a0_reader_options_t C_AWAIT_NEW_NEWEST = a0::test::reader_opts(A0_INIT_AWAIT_NEW, A0_ITER_NEWEST);
+static a0_reader_options_t C_OLDEST_NEXT_OPTIMISTIC = [] {
+  a0_reader_options_t opts = C_OLDEST_NEXT;
+  opts.optimistic = true;
+  return opts;
+}();
 
 TEST_CASE("reader_options] construct") {
   REQUIRE(A0_READER_OPTIONS_DEFAULT.init == A0_INIT_AWAIT_NEW);
   REQUIRE(A0_READER_OPTIONS_DEFAULT.iter == A0_ITER_NEXT);
+  REQUIRE(!A0_READER_OPTIONS_DEFAULT.optimistic);
+  REQUIRE(A0_READER_OPTIONS_DEFAULT.seq == 0);
+  REQUIRE(A0_READER_OPTIONS_DEFAULT.spin_ns == 0);
+  REQUIRE(!A0_READER_OPTIONS_DEFAULT.lease);
+  REQUIRE(!A0_READER_OPTIONS_DEFAULT.executor);
+  REQUIRE(A0_READER_OPTIONS_DEFAULT.thread_attr.num_cpus == 0);
+  REQUIRE(A0_READER_OPTIONS_DEFAULT.thread_attr.sched_policy == SCHED_OTHER);
+  REQUIRE(!A0_READER_OPTIONS_DEFAULT.thread_attr.name);
+  REQUIRE(!A0_READER_OPTIONS_DEFAULT.conflate_key);
 
   REQUIRE(a0::Reader::Options::DEFAULT.init == a0::INIT_AWAIT_NEW);
   REQUIRE(a0::Reader::Options::DEFAULT.iter == a0::ITER_NEXT);
+  REQUIRE(!a0::Reader::Options::DEFAULT.optimistic);
+  REQUIRE(a0::Reader::Options::DEFAULT.seq == 0);
+  REQUIRE(a0::Reader::Options::DEFAULT.spin_ns == 0);
+  REQUIRE(!a0::Reader::Options::DEFAULT.lease);
+  REQUIRE(!a0::Reader::Options::DEFAULT.executor.c);
+  REQUIRE(a0::Reader::Options::DEFAULT.thread_attr.cpus.empty());
+  REQUIRE(a0::Reader::Options::DEFAULT.thread_attr.sched_policy == SCHED_OTHER);
+  REQUIRE(a0::Reader::Options::DEFAULT.thread_attr.name.empty());
+  REQUIRE(a0::Reader::Options::DEFAULT.conflate_key.empty());
 
   REQUIRE(a0::Reader::Options{}.init == a0::INIT_AWAIT_NEW);
   REQUIRE(a0::Reader::Options{}.iter == a0::ITER_NEXT);
@@ -67,15 +106,23 @@ struct ReaderBaseFixture {
   }
 
   void push_pkt(std::string payload) {
+    push_pkt(a0::test::pkt(std::move(payload)));
+  }
+
+  void push_pkt(a0_packet_t pkt) {
+    push_pkt(arena, pkt);
+  }
+
+  void push_pkt(a0_arena_t arena_, a0_packet_t pkt) {
     a0_transport_t transport;
-    REQUIRE_OK(a0_transport_init(&transport, arena));
+    REQUIRE_OK(a0_transport_init(&transport, arena_));
 
     a0_transport_locked_t lk;
     REQUIRE_OK(a0_transport_lock(&transport, &lk));
 
     a0_alloc_t alloc;
     a0_transport_allocator(&lk, &alloc);
-    a0_packet_serialize(a0::test::pkt(std::move(payload)), alloc, NULL);
+    a0_packet_serialize(pkt, alloc, NULL);
     a0_transport_commit(lk);
 
     REQUIRE_OK(a0_transport_unlock(lk));
@@ -435,6 +482,527 @@ TEST_CASE_FIXTURE(ReaderSyncZCFixture, "reader_sync_zc] cpp blocking oldest avai
   join_threads();
 }
 
+TEST_CASE_FIXTURE(ReaderSyncZCFixture, "reader_sync_zc] optimistic oldest-next") {
+  push_pkt("pkt_0");
+  push_pkt("pkt_1");
+
+  REQUIRE_OK(a0_reader_sync_zc_init(&rsz, arena, C_OLDEST_NEXT_OPTIMISTIC));
+  REQUIRE(can_read());
+  REQUIRE_READ("pkt_0");
+  REQUIRE(can_read());
+  REQUIRE_READ("pkt_1");
+  REQUIRE(!can_read());
+
+  push_pkt("pkt_2");
+
+  REQUIRE(can_read());
+  REQUIRE_READ("pkt_2");
+  REQUIRE(!can_read());
+
+  REQUIRE_OK(a0_reader_sync_zc_close(&rsz));
+}
+
+TEST_CASE_FIXTURE(ReaderSyncZCFixture, "reader_sync_zc] optimistic blocking") {
+  REQUIRE_OK(a0_reader_sync_zc_init(&rsz, arena, C_OLDEST_NEXT_OPTIMISTIC));
+
+  thread_sleep_push_pkt("pkt_0");
+  REQUIRE_READ_BLOCKING("pkt_0");
+
+  thread_sleep_push_pkt("pkt_1");
+  REQUIRE_READ_BLOCKING("pkt_1");
+
+  REQUIRE_OK(a0_reader_sync_zc_close(&rsz));
+  join_threads();
+}
+
+TEST_CASE_FIXTURE(ReaderSyncZCFixture, "reader_sync_zc] cpp optimistic") {
+  push_pkt("pkt_0");
+
+  a0::Reader::Options opts(a0::INIT_OLDEST);
+  opts.optimistic = true;
+  a0::ReaderSyncZeroCopy cpp_rsz(a0::cpp_wrap<a0::Arena>(arena), opts);
+
+  REQUIRE(cpp_rsz.can_read());
+  REQUIRE_READ_CPP(cpp_rsz, "pkt_0");
+  REQUIRE(!cpp_rsz.can_read());
+
+  thread_sleep_push_pkt("pkt_1");
+  REQUIRE_READ_BLOCKING_CPP(cpp_rsz, "pkt_1");
+
+  join_threads();
+}
+
+TEST_CASE_FIXTURE(ReaderSyncZCFixture, "reader_sync_zc] spin blocking") {
+  a0_reader_options_t opts = C_OLDEST_NEXT;
+  opts.spin_ns = A0_TRANSPORT_SPIN_FOREVER;
+  REQUIRE_OK(a0_reader_sync_zc_init(&rsz, arena, opts));
+
+  thread_sleep_push_pkt("pkt_0");
+  REQUIRE_READ_BLOCKING("pkt_0");
+
+  thread_sleep_push_pkt("pkt_1");
+  REQUIRE_READ_BLOCKING("pkt_1");
+
+  REQUIRE_OK(a0_reader_sync_zc_close(&rsz));
+  join_threads();
+}
+
+TEST_CASE_FIXTURE(ReaderSyncZCFixture, "reader_sync_zc] lease") {
+  push_pkt("pkt_0");
+  push_pkt("pkt_1");
+
+  a0_reader_options_t opts = C_OLDEST_NEXT;
+  opts.lease = true;
+  REQUIRE_OK(a0_reader_sync_zc_init(&rsz, arena, opts));
+
+  // The callback runs unlocked, so it may write to the same transport.
+  struct data_t {
+    ReaderSyncZCFixture* self;
+    std::string payload;
+  } data{this, ""};
+  a0_zero_copy_callback_t cb = {
+      .user_data = &data,
+      .fn = [](void* user_data, a0_transport_locked_t, a0_flat_packet_t fpkt) {
+        auto* data = (data_t*)user_data;
+        data->self->push_pkt("pkt_2");
+        a0_buf_t payload;
+        a0_flat_packet_payload(fpkt, &payload);
+        data->payload = a0::test::str(payload);
+      },
+  };
+  REQUIRE_OK(a0_reader_sync_zc_read(&rsz, cb));
+  REQUIRE(data.payload == "pkt_0");
+
+  REQUIRE_READ("pkt_1");
+  REQUIRE_READ("pkt_2");
+  REQUIRE(!can_read());
+
+  // A packet evicted under the lease is reported.
+  push_pkt("pkt_3");
+  cb.fn = [](void* user_data, a0_transport_locked_t, a0_flat_packet_t) {
+    auto* data = (data_t*)user_data;
+    for (int i = 0; i < 4; i++) {
+      data->self->push_pkt(std::string(1024, 'x'));
+    }
+  };
+  REQUIRE(a0_reader_sync_zc_read(&rsz, cb) == A0_ERR_EVICTED);
+
+  a0_reader_stats_t stats;
+  REQUIRE_OK(a0_reader_sync_zc_stats(&rsz, &stats));
+  REQUIRE(stats.evicted == 1);
+
+  REQUIRE_OK(a0_reader_sync_zc_close(&rsz));
+}
+
+TEST_CASE_FIXTURE(ReaderSyncZCFixture, "reader_sync_zc] lease fallback") {
+  push_pkt("pkt_0");
+
+  // Take every lease.
+  a0_transport_t transport;
+  REQUIRE_OK(a0_transport_init(&transport, arena));
+  a0_transport_locked_t lk;
+  REQUIRE_OK(a0_transport_lock(&transport, &lk));
+  REQUIRE_OK(a0_transport_jump_head(lk));
+  a0_transport_lease_t leases[A0_TRANSPORT_MAX_LEASES];
+  for (auto& l : leases) {
+    REQUIRE_OK(a0_transport_lease(lk, &l));
+  }
+  REQUIRE_OK(a0_transport_unlock(lk));
+
+  // The packet is still delivered, under the lock.
+  a0_reader_options_t opts = C_OLDEST_NEXT;
+  opts.lease = true;
+  REQUIRE_OK(a0_reader_sync_zc_init(&rsz, arena, opts));
+  REQUIRE_READ("pkt_0");
+
+  a0_reader_stats_t stats;
+  REQUIRE_OK(a0_reader_sync_zc_stats(&rsz, &stats));
+  REQUIRE(stats.delivered == 1);
+  REQUIRE(stats.unleased == 1);
+
+  REQUIRE_OK(a0_reader_sync_zc_close(&rsz));
+
+  REQUIRE_OK(a0_transport_lock(&transport, &lk));
+  for (auto& l : leases) {
+    REQUIRE_OK(a0_transport_lease_release(lk, l));
+  }
+  REQUIRE_OK(a0_transport_unlock(lk));
+}
+
+TEST_CASE_FIXTURE(ReaderSyncZCFixture, "reader_sync_zc] batch") {
+  for (int i = 0; i < 5; i++) {
+    push_pkt("pkt_" + std::to_string(i));
+  }
+
+  REQUIRE_OK(a0_reader_sync_zc_init(&rsz, arena, C_OLDEST_NEXT));
+
+  std::vector<std::string> payloads;
+  a0_zero_copy_callback_t cb = {
+      .user_data = &payloads,
+      .fn = [](void* user_data, a0_transport_locked_t, a0_flat_packet_t fpkt) {
+        a0_buf_t payload;
+        a0_flat_packet_payload(fpkt, &payload);
+        ((std::vector<std::string>*)user_data)->push_back(a0::test::str(payload));
+      },
+  };
+
+  size_t cnt;
+  REQUIRE(a0_reader_sync_zc_read_batch(&rsz, 0, cb, &cnt) == A0_ERR_INVALID_ARG);
+
+  REQUIRE_OK(a0_reader_sync_zc_read_batch(&rsz, 2, cb, &cnt));
+  REQUIRE(cnt == 2);
+  REQUIRE(payloads == std::vector<std::string>{"pkt_0", "pkt_1"});
+
+  REQUIRE_OK(a0_reader_sync_zc_read_batch(&rsz, SIZE_MAX, cb, &cnt));
+  REQUIRE(cnt == 3);
+  REQUIRE(payloads == std::vector<std::string>{"pkt_0", "pkt_1", "pkt_2", "pkt_3", "pkt_4"});
+
+  REQUIRE(a0_reader_sync_zc_read_batch(&rsz, SIZE_MAX, cb, &cnt) == A0_ERR_AGAIN);
+  REQUIRE(!can_read());
+
+  thread_sleep_push_pkt("pkt_5");
+  REQUIRE_OK(a0_reader_sync_zc_read_batch_blocking(&rsz, SIZE_MAX, cb, &cnt));
+  REQUIRE(cnt == 1);
+  REQUIRE(payloads.back() == "pkt_5");
+  join_threads();
+
+  REQUIRE_OK(a0_reader_sync_zc_close(&rsz));
+}
+
+TEST_CASE_FIXTURE(ReaderSyncZCFixture, "reader_sync_zc] cpp batch") {
+  for (int i = 0; i < 3; i++) {
+    push_pkt("pkt_" + std::to_string(i));
+  }
+
+  a0::ReaderSyncZeroCopy cpp_rsz(a0::cpp_wrap<a0::Arena>(arena), a0::INIT_OLDEST);
+
+  std::vector<std::string> payloads;
+  auto collect = [&](a0::TransportLocked, a0::FlatPacket fpkt) {
+    payloads.push_back(std::string(fpkt.payload()));
+  };
+
+  REQUIRE(cpp_rsz.read_batch(2, collect) == 2);
+  REQUIRE(cpp_rsz.read_batch(2, collect) == 1);
+  REQUIRE(cpp_rsz.read_batch(2, collect) == 0);
+  REQUIRE(payloads == std::vector<std::string>{"pkt_0", "pkt_1", "pkt_2"});
+
+  thread_sleep_push_pkt("pkt_3");
+  REQUIRE(cpp_rsz.read_batch_blocking(2, collect) == 1);
+  REQUIRE(payloads.back() == "pkt_3");
+  join_threads();
+}
+
+TEST_CASE_FIXTURE(ReaderSyncZCFixture, "reader_sync_zc] filter") {
+  push_pkt(a0::test::pkt({{"type", "a"}}, "pkt_0"));
+  push_pkt(a0::test::pkt({{"type", "b"}}, "pkt_1"));
+  push_pkt(a0::test::pkt({{"other", "a"}, {"type", "b"}, {"type", "a"}}, "pkt_2"));
+  push_pkt("pkt_3");
+
+  a0_reader_filter_clause_t clause = {A0_FILTER_KEY_EQUALS, "type", "a"};
+  a0_reader_options_t opts = C_OLDEST_NEXT;
+  opts.filter = {&clause, 1, false};
+  REQUIRE_OK(a0_reader_sync_zc_init(&rsz, arena, opts));
+
+  // Packets carry headers, so only payloads are compared.
+  std::string payload;
+  a0_zero_copy_callback_t payload_cb = {
+      .user_data = &payload,
+      .fn = [](void* user_data, a0_transport_locked_t, a0_flat_packet_t fpkt) {
+        a0_buf_t buf;
+        a0_flat_packet_payload(fpkt, &buf);
+        *(std::string*)user_data = a0::test::str(buf);
+      },
+  };
+  auto read_payload = [&]() {
+    REQUIRE_OK(a0_reader_sync_zc_read(&rsz, payload_cb));
+    return payload;
+  };
+
+  REQUIRE(can_read());
+  REQUIRE(read_payload() == "pkt_0");
+  REQUIRE(can_read());
+  REQUIRE(read_payload() == "pkt_2");
+  REQUIRE(!can_read());
+
+  bool executed = false;
+  a0_zero_copy_callback_t cb = {
+      .user_data = &executed,
+      .fn = [](void* user_data, a0_transport_locked_t, a0_flat_packet_t) {
+        *(bool*)user_data = true;
+      },
+  };
+  REQUIRE(a0_reader_sync_zc_read(&rsz, cb) == A0_ERR_AGAIN);
+  REQUIRE(!executed);
+
+  // Blocking reads wait past filtered packets.
+  threads.emplace_back([this]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    push_pkt("pkt_4");
+    push_pkt(a0::test::pkt({{"type", "a"}}, "pkt_5"));
+  });
+  REQUIRE_OK(a0_reader_sync_zc_read_blocking(&rsz, payload_cb));
+  REQUIRE(payload == "pkt_5");
+  join_threads();
+
+  REQUIRE_OK(a0_reader_sync_zc_close(&rsz));
+}
+
+TEST_CASE_FIXTURE(ReaderSyncZCFixture, "reader_sync_zc] optimistic filter") {
+  push_pkt(a0::test::pkt({{"type", "ab"}}, "pkt_0"));
+  push_pkt(a0::test::pkt({{"type", "b"}}, "pkt_1"));
+  push_pkt(a0::test::pkt({{"type", "abc"}}, "pkt_2"));
+  push_pkt(a0::test::pkt({{"type", "b"}}, "pkt_3"));
+
+  a0_reader_filter_clause_t clause = {A0_FILTER_VAL_PREFIX, "type", "ab"};
+  a0_reader_options_t opts = C_OLDEST_NEXT_OPTIMISTIC;
+  opts.filter = {&clause, 1, false};
+  REQUIRE_OK(a0_reader_sync_zc_init(&rsz, arena, opts));
+
+  a0::ReaderSyncZeroCopy cpp_rsz = a0::cpp_wrap<a0::ReaderSyncZeroCopy>(&rsz);
+  REQUIRE_READ_CPP(cpp_rsz, "pkt_0");
+  REQUIRE(can_read());
+  REQUIRE_READ_CPP(cpp_rsz, "pkt_2");
+  REQUIRE(!can_read());
+
+  REQUIRE_OK(a0_reader_sync_zc_close(&rsz));
+}
+
+TEST_CASE_FIXTURE(ReaderSyncZCFixture, "reader_sync_zc] latest per key") {
+  push_pkt(a0::test::pkt({{"id", "a"}}, "pkt_0"));
+  push_pkt(a0::test::pkt({{"id", "b"}}, "pkt_1"));
+  push_pkt(a0::test::pkt({{"id", "a"}}, "pkt_2"));
+  push_pkt("pkt_3");
+  push_pkt(a0::test::pkt({{"id", "c"}}, "pkt_4"));
+  push_pkt(a0::test::pkt({{"id", "b"}}, "pkt_5"));
+
+  // Scans take the lock. Optimistic is ignored.
+  a0_reader_options_t opts = C_OLDEST_NEXT_OPTIMISTIC;
+  opts.iter = A0_ITER_LATEST_PER_KEY;
+  opts.conflate_key = "id";
+  REQUIRE_OK(a0_reader_sync_zc_init(&rsz, arena, opts));
+
+  std::string payload;
+  a0_zero_copy_callback_t payload_cb = {
+      .user_data = &payload,
+      .fn = [](void* user_data, a0_transport_locked_t, a0_flat_packet_t fpkt) {
+        a0_buf_t buf;
+        a0_flat_packet_payload(fpkt, &buf);
+        *(std::string*)user_data = a0::test::str(buf);
+      },
+  };
+  auto read_payload = [&]() {
+    REQUIRE_OK(a0_reader_sync_zc_read(&rsz, payload_cb));
+    return payload;
+  };
+
+  // Packets without the key form their own group.
+  REQUIRE(read_payload() == "pkt_2");
+  REQUIRE(read_payload() == "pkt_3");
+  REQUIRE(read_payload() == "pkt_4");
+  REQUIRE(can_read());
+  REQUIRE(read_payload() == "pkt_5");
+  REQUIRE(!can_read());
+
+  push_pkt(a0::test::pkt({{"id", "a"}}, "pkt_6"));
+  push_pkt(a0::test::pkt({{"id", "b"}}, "pkt_7"));
+  push_pkt(a0::test::pkt({{"id", "a"}}, "pkt_8"));
+
+  std::vector<std::string> payloads;
+  a0_zero_copy_callback_t collect_cb = {
+      .user_data = &payloads,
+      .fn = [](void* user_data, a0_transport_locked_t, a0_flat_packet_t fpkt) {
+        a0_buf_t buf;
+        a0_flat_packet_payload(fpkt, &buf);
+        ((std::vector<std::string>*)user_data)->push_back(a0::test::str(buf));
+      },
+  };
+  size_t cnt;
+  REQUIRE_OK(a0_reader_sync_zc_read_batch(&rsz, 8, collect_cb, &cnt));
+  REQUIRE(cnt == 2);
+  REQUIRE(payloads == std::vector<std::string>{"pkt_7", "pkt_8"});
+  REQUIRE(!can_read());
+
+  // Blocking reads wait for the next scan.
+  threads.emplace_back([this]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    push_pkt(a0::test::pkt({{"id", "c"}}, "pkt_9"));
+  });
+  REQUIRE_OK(a0_reader_sync_zc_read_blocking(&rsz, payload_cb));
+  REQUIRE(payload == "pkt_9");
+  join_threads();
+
+  REQUIRE_OK(a0_reader_sync_zc_close(&rsz));
+}
+
+TEST_CASE_FIXTURE(ReaderSyncZCFixture, "reader_sync_zc] at seq") {
+  push_pkt("pkt_0");
+  push_pkt("pkt_1");
+  push_pkt("pkt_2");
+
+  a0_reader_options_t opts = C_OLDEST_NEXT;
+  opts.init = A0_INIT_AT_SEQ;
+  opts.seq = 2;
+
+  REQUIRE_OK(a0_reader_sync_zc_init(&rsz, arena, opts));
+  REQUIRE(can_read());
+  REQUIRE_READ("pkt_1");
+  REQUIRE_READ("pkt_2");
+  REQUIRE(!can_read());
+  REQUIRE_OK(a0_reader_sync_zc_close(&rsz));
+
+  // Evicted or never written sequence numbers start at the oldest.
+  opts.seq = 0;
+  REQUIRE_OK(a0_reader_sync_zc_init(&rsz, arena, opts));
+  REQUIRE_READ("pkt_0");
+  REQUIRE_OK(a0_reader_sync_zc_close(&rsz));
+
+  // Future sequence numbers wait.
+  opts.seq = 5;
+  REQUIRE_OK(a0_reader_sync_zc_init(&rsz, arena, opts));
+  REQUIRE(!can_read());
+  REQUIRE(a0_reader_sync_zc_read(&rsz, {}) == A0_ERR_AGAIN);
+
+  push_pkt("pkt_3");
+  REQUIRE(!can_read());
+
+  thread_sleep_push_pkt("pkt_4");
+  REQUIRE_READ_BLOCKING("pkt_4");
+  REQUIRE(!can_read());
+
+  REQUIRE_OK(a0_reader_sync_zc_close(&rsz));
+  join_threads();
+}
+
+TEST_CASE_FIXTURE(ReaderSyncZCFixture, "reader_sync_zc] cpp at seq") {
+  push_pkt("pkt_0");
+  push_pkt("pkt_1");
+
+  a0::Reader::Options opts(a0::INIT_AT_SEQ);
+  opts.seq = 2;
+  a0::ReaderSyncZeroCopy cpp_rsz(a0::cpp_wrap<a0::Arena>(arena), opts);
+
+  REQUIRE(cpp_rsz.can_read());
+  REQUIRE_READ_CPP(cpp_rsz, "pkt_1");
+  REQUIRE(!cpp_rsz.can_read());
+}
+
+TEST_CASE_FIXTURE(ReaderSyncZCFixture, "reader_sync_zc] at time") {
+  a0_time_mono_t t0;
+  REQUIRE_OK(a0_time_mono_now(&t0));
+  auto stamp = [&](int64_t ns) {
+    a0_time_mono_t t;
+    REQUIRE_OK(a0_time_mono_add(t0, ns, &t));
+    char str[20];
+    REQUIRE_OK(a0_time_mono_str(t, str));
+    return std::string(str);
+  };
+  for (int i = 0; i < 10; i++) {
+    push_pkt(a0::test::pkt({{A0_TIME_MONO, stamp(i * 1000)}}, "pkt_" + std::to_string(i)));
+  }
+
+  std::string payload;
+  a0_zero_copy_callback_t payload_cb = {
+      .user_data = &payload,
+      .fn = [](void* user_data, a0_transport_locked_t, a0_flat_packet_t fpkt) {
+        a0_buf_t buf;
+        a0_flat_packet_payload(fpkt, &buf);
+        *(std::string*)user_data = a0::test::str(buf);
+      },
+  };
+  auto read_payload = [&]() {
+    REQUIRE_OK(a0_reader_sync_zc_read(&rsz, payload_cb));
+    return payload;
+  };
+
+  a0_reader_options_t opts = C_OLDEST_NEXT;
+  opts.init = A0_INIT_AT_TIME;
+
+  // Starts at the first packet stamped at or after the time.
+  REQUIRE_OK(a0_time_mono_add(t0, 6500, &opts.time));
+  REQUIRE_OK(a0_reader_sync_zc_init(&rsz, arena, opts));
+  REQUIRE(read_payload() == "pkt_7");
+  REQUIRE(read_payload() == "pkt_8");
+  REQUIRE_OK(a0_reader_sync_zc_close(&rsz));
+
+  REQUIRE_OK(a0_time_mono_add(t0, 3000, &opts.time));
+  REQUIRE_OK(a0_reader_sync_zc_init(&rsz, arena, opts));
+  REQUIRE(read_payload() == "pkt_3");
+  REQUIRE_OK(a0_reader_sync_zc_close(&rsz));
+
+  // Earlier than everything starts at the oldest.
+  REQUIRE_OK(a0_time_mono_add(t0, -1000, &opts.time));
+  REQUIRE_OK(a0_reader_sync_zc_init(&rsz, arena, opts));
+  REQUIRE(read_payload() == "pkt_0");
+  REQUIRE_OK(a0_reader_sync_zc_close(&rsz));
+
+  // Later than everything waits for the next packet.
+  REQUIRE_OK(a0_time_mono_add(t0, 100000, &opts.time));
+  REQUIRE_OK(a0_reader_sync_zc_init(&rsz, arena, opts));
+  REQUIRE(!can_read());
+  push_pkt(a0::test::pkt({{A0_TIME_MONO, stamp(10000)}}, "pkt_10"));
+  REQUIRE(can_read());
+  REQUIRE(read_payload() == "pkt_10");
+  REQUIRE_OK(a0_reader_sync_zc_close(&rsz));
+}
+
+TEST_CASE_FIXTURE(ReaderSyncZCFixture, "reader_sync_zc] cpp at time") {
+  auto t0 = a0::TimeMono::now();
+  push_pkt(a0::test::pkt({{A0_TIME_MONO, t0.to_string()}}, "pkt_0"));
+  push_pkt(a0::test::pkt({{A0_TIME_MONO, (t0 + std::chrono::seconds(1)).to_string()}}, "pkt_1"));
+
+  a0::Reader::Options opts(a0::INIT_AT_TIME);
+  opts.time = t0 + std::chrono::milliseconds(1);
+  a0::ReaderSyncZeroCopy cpp_rsz(a0::cpp_wrap<a0::Arena>(arena), opts);
+
+  REQUIRE(cpp_rsz.can_read());
+  REQUIRE_READ_CPP(cpp_rsz, "pkt_1");
+  REQUIRE(!cpp_rsz.can_read());
+}
+
+TEST_CASE_FIXTURE(ReaderSyncZCFixture, "reader_sync_zc] cursor") {
+  a0_file_remove("test.cursor");
+  a0_cursor_table_t table;
+  REQUIRE_OK(a0_cursor_table_init(&table, {"test"}));
+  a0_cursor_t cursor;
+  REQUIRE_OK(a0_cursor_open(&table, "consumer", &cursor));
+
+  for (int i = 0; i < 5; i++) {
+    push_pkt("pkt_" + std::to_string(i));
+  }
+
+  // Without a committed position, init applies.
+  a0_reader_options_t opts = C_OLDEST_NEXT;
+  opts.cursor = cursor;
+  REQUIRE_OK(a0_reader_sync_zc_init(&rsz, arena, opts));
+  REQUIRE_READ("pkt_0");
+  REQUIRE_READ("pkt_1");
+  REQUIRE_OK(a0_reader_sync_zc_close(&rsz));
+
+  uint64_t seq;
+  REQUIRE_OK(a0_cursor_load(cursor, &seq));
+  REQUIRE(seq == 2);
+
+  // A restarted reader resumes after the last packet read, whatever its init.
+  opts.init = A0_INIT_AWAIT_NEW;
+  REQUIRE_OK(a0_reader_sync_zc_init(&rsz, arena, opts));
+  REQUIRE_READ("pkt_2");
+  REQUIRE_OK(a0_reader_sync_zc_close(&rsz));
+
+  opts.init = A0_INIT_MOST_RECENT;
+  opts.optimistic = true;
+  REQUIRE_OK(a0_reader_sync_zc_init(&rsz, arena, opts));
+  REQUIRE_READ("pkt_3");
+  REQUIRE_READ("pkt_4");
+  REQUIRE(!can_read());
+  REQUIRE_OK(a0_reader_sync_zc_close(&rsz));
+
+  REQUIRE_OK(a0_cursor_load(cursor, &seq));
+  REQUIRE(seq == 5);
+
+  REQUIRE_OK(a0_cursor_table_close(&table));
+  a0_file_remove("test.cursor");
+}
+
 TEST_CASE_FIXTURE(ReaderSyncZCFixture, "reader_sync_zc] blocking oldest not available") {
   REQUIRE_OK(a0_reader_sync_zc_init(&rsz, arena, C_OLDEST_NEXT));
 
@@ -535,7 +1103,7 @@ TEST_CASE_FIXTURE(ReaderSyncZCFixture, "read] random access") {
       },
   };
   REQUIRE_OK(a0_reader_sync_zc_read_blocking(&rsz, cb_0));
-  REQUIRE(off_0 == 144);
+  REQUIRE(off_0 == 832);
 
   size_t off_1 = 0;
   a0_zero_copy_callback_t cb_1 = {
@@ -547,7 +1115,7 @@ TEST_CASE_FIXTURE(ReaderSyncZCFixture, "read] random access") {
       },
   };
   REQUIRE_OK(a0_reader_sync_zc_read_blocking(&rsz, cb_1));
-  REQUIRE(off_1 == 256);
+  REQUIRE(off_1 == 944);
 
   REQUIRE_OK(a0_reader_sync_zc_close(&rsz));
 
@@ -578,13 +1146,13 @@ TEST_CASE_FIXTURE(ReaderSyncZCFixture, "read] cpp random access") {
   cpp_rsz.read([&](a0::TransportLocked tlk, a0::FlatPacket) {
     off_0 = tlk.frame()->hdr.off;
   });
-  REQUIRE(off_0 == 144);
+  REQUIRE(off_0 == 832);
 
   size_t off_1 = 0;
   cpp_rsz.read([&](a0::TransportLocked tlk, a0::FlatPacket) {
     off_1 = tlk.frame()->hdr.off;
   });
-  REQUIRE(off_1 == 256);
+  REQUIRE(off_1 == 944);
 
   a0::read_random_access(
       a0::cpp_wrap<a0::Arena>(arena),
@@ -654,15 +1222,264 @@ TEST_CASE_FIXTURE(ReaderSyncFixture, "reader_sync] cpp oldest-next") {
   REQUIRE(cpp_rs.read().payload() == "pkt_1");
   REQUIRE(!cpp_rs.can_read());
 
-  push_pkt("pkt_2");
+  push_pkt("pkt_2");
+
+  REQUIRE(cpp_rs.can_read());
+  REQUIRE(cpp_rs.read().payload() == "pkt_2");
+  REQUIRE(!cpp_rs.can_read());
+
+  REQUIRE_THROWS_WITH(
+      cpp_rs.read(),
+      "Not available yet");
+}
+
+TEST_CASE_FIXTURE(ReaderSyncFixture, "reader_sync] batch") {
+  for (int i = 0; i < 3; i++) {
+    push_pkt("pkt_" + std::to_string(i));
+  }
+
+  REQUIRE_OK(a0_reader_sync_init(&rs, arena, a0::test::alloc(), C_OLDEST_NEXT));
+
+  a0_packet_t pkts[2];
+  size_t cnt;
+  REQUIRE_OK(a0_reader_sync_read_batch(&rs, pkts, 2, &cnt));
+  REQUIRE(cnt == 2);
+  REQUIRE(a0::test::str(pkts[0].payload) == "pkt_0");
+  REQUIRE(a0::test::str(pkts[1].payload) == "pkt_1");
+
+  REQUIRE_OK(a0_reader_sync_read_batch(&rs, pkts, 2, &cnt));
+  REQUIRE(cnt == 1);
+  REQUIRE(a0::test::str(pkts[0].payload) == "pkt_2");
+
+  REQUIRE(a0_reader_sync_read_batch(&rs, pkts, 2, &cnt) == A0_ERR_AGAIN);
+
+  thread_sleep_push_pkt("pkt_3");
+  REQUIRE_OK(a0_reader_sync_read_batch_blocking(&rs, pkts, 2, &cnt));
+  REQUIRE(cnt == 1);
+  REQUIRE(a0::test::str(pkts[0].payload) == "pkt_3");
+  join_threads();
+
+  REQUIRE_OK(a0_reader_sync_close(&rs));
+}
+
+TEST_CASE_FIXTURE(ReaderSyncFixture, "reader_sync] cpp batch") {
+  for (int i = 0; i < 3; i++) {
+    push_pkt("pkt_" + std::to_string(i));
+  }
+
+  a0::ReaderSync cpp_rs(a0::cpp_wrap<a0::Arena>(arena), a0::INIT_OLDEST);
+
+  auto pkts = cpp_rs.read_batch(2);
+  REQUIRE(pkts.size() == 2);
+  REQUIRE(pkts[0].payload() == "pkt_0");
+  REQUIRE(pkts[1].payload() == "pkt_1");
+
+  // Packets from a batch outlive later reads.
+  auto more = cpp_rs.read_batch(2);
+  REQUIRE(more.size() == 1);
+  REQUIRE(more[0].payload() == "pkt_2");
+  REQUIRE(pkts[0].payload() == "pkt_0");
+
+  REQUIRE(cpp_rs.read_batch(2).empty());
+}
+
+TEST_CASE_FIXTURE(ReaderSyncFixture, "reader_sync] cpp filter") {
+  push_pkt(a0::test::pkt({{"type", "a"}}, "pkt_0"));
+  push_pkt(a0::test::pkt({{"type", "b"}}, "pkt_1"));
+  push_pkt(a0::test::pkt({{"key", "val"}}, "pkt_2"));
+  push_pkt(a0::test::pkt({{"type", "c"}}, "pkt_3"));
+
+  a0::Reader::Options opts(a0::INIT_OLDEST);
+  opts.filter = a0::Reader::Filter(
+      {
+          {a0::Reader::Filter::Op::KEY_EQUALS, "type", "a"},
+          {a0::Reader::Filter::Op::KEY_EXISTS, "key", ""},
+      },
+      true);
+  a0::ReaderSync cpp_rs(a0::cpp_wrap<a0::Arena>(arena), opts);
+
+  auto pkts = cpp_rs.read_batch(4);
+  REQUIRE(pkts.size() == 2);
+  REQUIRE(pkts[0].payload() == "pkt_0");
+  REQUIRE(pkts[1].payload() == "pkt_2");
+  REQUIRE(!cpp_rs.can_read());
+
+  a0::Reader::Options opts_b(a0::INIT_OLDEST);
+  opts_b.filter = a0::Reader::Filter::key_equals("type", "b");
+  a0::ReaderSync cpp_rs_b(a0::cpp_wrap<a0::Arena>(arena), opts_b);
+  REQUIRE(cpp_rs_b.read().payload() == "pkt_1");
+  REQUIRE(!cpp_rs_b.can_read());
+}
+
+TEST_CASE_FIXTURE(ReaderSyncFixture, "reader_sync] stats") {
+  for (bool optimistic : {false, true}) {
+    std::fill(arena_data.begin(), arena_data.end(), 0);
+    push_pkt("pkt_0");
+    push_pkt("pkt_1");
+    push_pkt("pkt_2");
+
+    a0_reader_options_t opts = C_OLDEST_NEXT;
+    opts.optimistic = optimistic;
+    REQUIRE_OK(a0_reader_sync_init(&rs, arena, a0::test::alloc(), opts));
+
+    a0_reader_stats_t stats;
+    REQUIRE_OK(a0_reader_sync_stats(&rs, &stats));
+    REQUIRE(stats.delivered == 0);
+
+    REQUIRE_READ("pkt_0");
+    REQUIRE_OK(a0_reader_sync_stats(&rs, &stats));
+    REQUIRE(stats.delivered == 1);
+    REQUIRE(stats.dropped == 0);
+    REQUIRE(stats.lag_frames == 2);
+    REQUIRE(stats.lag_bytes > 0);
+    // No a0_time_mono header.
+    REQUIRE(stats.lag_ns == 0);
+
+    // Overrun the reader. Sequence numbers are payload indices plus one.
+    for (int i = 3; i < 200; i++) {
+      push_pkt("pkt_" + std::to_string(i));
+    }
+    a0_packet_t pkt;
+    REQUIRE_OK(a0_reader_sync_read(&rs, &pkt));
+    int idx = std::stoi(a0::test::str(pkt.payload).substr(4));
+    REQUIRE(idx > 1);
+
+    REQUIRE_OK(a0_reader_sync_stats(&rs, &stats));
+    REQUIRE(stats.delivered == 2);
+    REQUIRE(stats.dropped == uint64_t(idx - 1));
+    REQUIRE(stats.lag_frames == uint64_t(199 - idx));
+
+    a0_time_mono_t written;
+    REQUIRE_OK(a0_time_mono_now(&written));
+    REQUIRE_OK(a0_time_mono_add(written, -5 * 1000 * 1000, &written));
+    char mono_str[20];
+    REQUIRE_OK(a0_time_mono_str(written, mono_str));
+    push_pkt(a0::test::pkt({{A0_TIME_MONO, mono_str}}, "late"));
+
+    size_t cnt;
+    std::vector<a0_packet_t> pkts(256);
+    REQUIRE_OK(a0_reader_sync_read_batch(&rs, pkts.data(), pkts.size(), &cnt));
+    REQUIRE(a0::test::str(pkts[cnt - 1].payload) == "late");
+    // The late packet may have evicted more.
+    int next_idx = std::stoi(a0::test::str(pkts[0].payload).substr(4));
+
+    REQUIRE_OK(a0_reader_sync_stats(&rs, &stats));
+    REQUIRE(stats.delivered == 2 + cnt);
+    REQUIRE(stats.dropped == uint64_t(next_idx - 2));
+    REQUIRE(stats.lag_frames == 0);
+    REQUIRE(stats.lag_bytes == 0);
+    REQUIRE(stats.lag_ns >= 5 * 1000 * 1000);
+
+    // Without a ns threshold, the write time is read back from the arena.
+    // Once the packet is evicted, the age is unknown.
+    for (int i = 0; i < 100; i++) {
+      push_pkt("pkt_" + std::to_string(i));
+    }
+    REQUIRE_OK(a0_reader_sync_stats(&rs, &stats));
+    REQUIRE(stats.lag_ns == 0);
+
+    REQUIRE_OK(a0_reader_sync_close(&rs));
+  }
+}
+
+TEST_CASE_FIXTURE(ReaderSyncFixture, "reader_sync] lag threshold") {
+  for (int i = 0; i < 5; i++) {
+    push_pkt("pkt_" + std::to_string(i));
+  }
+
+  struct data_t {
+    int calls;
+    a0_reader_stats_t stats;
+  } data{};
+  a0_reader_options_t opts = C_OLDEST_NEXT;
+  opts.lag.frames = 3;
+  opts.lag.onlag = {&data, [](void* user_data, a0_reader_stats_t stats) {
+                      auto* data = (data_t*)user_data;
+                      data->calls++;
+                      data->stats = stats;
+                    }};
+  REQUIRE_OK(a0_reader_sync_init(&rs, arena, a0::test::alloc(), opts));
+
+  REQUIRE_READ("pkt_0");
+  REQUIRE(data.calls == 1);
+  REQUIRE(data.stats.lag_frames == 4);
+  REQUIRE(data.stats.delivered == 1);
+
+  // Still behind.
+  REQUIRE_READ("pkt_1");
+  REQUIRE(data.calls == 1);
+
+  // Caught up enough to be called again.
+  REQUIRE_READ("pkt_2");
+  REQUIRE(data.calls == 1);
+
+  for (int i = 5; i < 10; i++) {
+    push_pkt("pkt_" + std::to_string(i));
+  }
+  REQUIRE_READ("pkt_3");
+  REQUIRE(data.calls == 2);
+  REQUIRE(data.stats.lag_frames == 6);
+
+  REQUIRE_OK(a0_reader_sync_close(&rs));
+}
+
+TEST_CASE_FIXTURE(ReaderSyncFixture, "reader_sync] lag threshold ns") {
+  a0_time_mono_t written;
+  REQUIRE_OK(a0_time_mono_now(&written));
+  REQUIRE_OK(a0_time_mono_add(written, -5 * 1000 * 1000, &written));
+  char mono_str[20];
+  REQUIRE_OK(a0_time_mono_str(written, mono_str));
+  push_pkt(a0::test::pkt({{A0_TIME_MONO, mono_str}}, "late"));
+
+  struct data_t {
+    int calls;
+    a0_reader_stats_t stats;
+  } data{};
+  a0_reader_options_t opts = C_OLDEST_NEXT;
+  opts.lag.ns = 1000 * 1000;
+  opts.lag.onlag = {&data, [](void* user_data, a0_reader_stats_t stats) {
+                      auto* data = (data_t*)user_data;
+                      data->calls++;
+                      data->stats = stats;
+                    }};
+  REQUIRE_OK(a0_reader_sync_init(&rs, arena, a0::test::alloc(), opts));
+
+  REQUIRE_READ("late");
+  REQUIRE(data.calls == 1);
+  REQUIRE(data.stats.lag_ns >= 5 * 1000 * 1000);
+
+  // The write time was kept on delivery, so it outlives the packet.
+  for (int i = 0; i < 100; i++) {
+    push_pkt("pkt_" + std::to_string(i));
+  }
+  a0_reader_stats_t stats;
+  REQUIRE_OK(a0_reader_sync_stats(&rs, &stats));
+  REQUIRE(stats.lag_ns >= data.stats.lag_ns);
+
+  REQUIRE_OK(a0_reader_sync_close(&rs));
+}
+
+TEST_CASE_FIXTURE(ReaderSyncFixture, "reader_sync] cpp stats") {
+  for (int i = 0; i < 3; i++) {
+    push_pkt("pkt_" + std::to_string(i));
+  }
 
-  REQUIRE(cpp_rs.can_read());
-  REQUIRE(cpp_rs.read().payload() == "pkt_2");
-  REQUIRE(!cpp_rs.can_read());
+  int calls = 0;
+  a0::Reader::Options opts(a0::INIT_OLDEST);
+  opts.lag = a0::Reader::LagThreshold(0, 1, 0, [&](a0::Reader::Stats stats) {
+    REQUIRE(stats.lag_frames == 2);
+    calls++;
+  });
+  a0::ReaderSync cpp_rs(a0::cpp_wrap<a0::Arena>(arena), opts);
 
-  REQUIRE_THROWS_WITH(
-      cpp_rs.read(),
-      "Not available yet");
+  REQUIRE(cpp_rs.read().payload() == "pkt_0");
+  REQUIRE(calls == 1);
+  REQUIRE(cpp_rs.stats().delivered == 1);
+  REQUIRE(cpp_rs.stats().lag_frames == 2);
+
+  cpp_rs.read_batch(2);
+  REQUIRE(cpp_rs.stats().delivered == 3);
+  REQUIRE(cpp_rs.stats().lag_bytes == 0);
 }
 
 TEST_CASE_FIXTURE(ReaderSyncFixture, "reader_sync] oldest-next, empty start") {
@@ -1096,6 +1913,112 @@ TEST_CASE_FIXTURE(ReaderZCFixture, "reader_zc] cpp oldest-next") {
   WAIT_AND_REQUIRE_PAYLOADS({"pkt_0", "pkt_1", "pkt_2"});
 }
 
+TEST_CASE_FIXTURE(ReaderZCFixture, "reader_zc] optimistic oldest-next") {
+  push_pkt("pkt_0");
+  push_pkt("pkt_1");
+
+  REQUIRE_OK(a0_reader_zc_init(&rz, arena, C_OLDEST_NEXT_OPTIMISTIC, make_callback()));
+
+  push_pkt("pkt_2");
+
+  WAIT_AND_REQUIRE_PAYLOADS({"pkt_0", "pkt_1", "pkt_2"});
+
+  REQUIRE_OK(a0_reader_zc_close(&rz));
+}
+
+TEST_CASE_FIXTURE(ReaderZCFixture, "reader_zc] lease") {
+  push_pkt("pkt_0");
+  push_pkt("pkt_1");
+
+  a0_reader_options_t opts = C_OLDEST_NEXT;
+  opts.lease = true;
+  REQUIRE_OK(a0_reader_zc_init(&rz, arena, opts, make_callback()));
+
+  push_pkt("pkt_2");
+
+  WAIT_AND_REQUIRE_PAYLOADS({"pkt_0", "pkt_1", "pkt_2"});
+
+  REQUIRE_OK(a0_reader_zc_close(&rz));
+}
+
+TEST_CASE_FIXTURE(ReaderZCFixture, "reader_zc] lease evicted") {
+  push_pkt("pkt_0");
+
+  // The first callback evicts its own packet.
+  struct evict_data_t {
+    ReaderZCFixture* self;
+    bool evicting;
+  } evict_data{this, true};
+
+  a0_reader_options_t opts = C_OLDEST_NEXT;
+  opts.lease = true;
+  REQUIRE_OK(a0_reader_zc_init(
+      &rz, arena, opts,
+      a0_zero_copy_callback_t{
+          .user_data = &evict_data,
+          .fn = [](void* user_data, a0_transport_locked_t, a0_flat_packet_t fpkt) {
+            auto* evict_data = (evict_data_t*)user_data;
+            if (evict_data->evicting) {
+              evict_data->evicting = false;
+              for (int i = 0; i < 4; i++) {
+                evict_data->self->push_pkt(std::string(1024, 'x'));
+              }
+              evict_data->self->push_pkt("pkt_1");
+              // The packet is gone. Nothing in it can be trusted.
+              return;
+            }
+            a0_buf_t payload;
+            a0_flat_packet_payload(fpkt, &payload);
+            if (a0::test::str(payload) == "pkt_1") {
+              auto* data = &evict_data->self->data;
+              std::unique_lock<std::mutex> lk{data->mu};
+              data->collected_payloads.push_back("pkt_1");
+              data->cv.notify_all();
+            }
+          },
+      }));
+
+  WAIT_AND_REQUIRE_PAYLOADS({"pkt_1"});
+
+  a0_reader_stats_t stats;
+  REQUIRE_OK(a0_reader_zc_stats(&rz, &stats));
+  REQUIRE(stats.evicted == 1);
+
+  REQUIRE_OK(a0_reader_zc_close(&rz));
+}
+
+TEST_CASE_FIXTURE(ReaderZCFixture, "reader_zc] spin") {
+  a0_reader_options_t opts = C_OLDEST_NEXT;
+  opts.spin_ns = A0_TRANSPORT_SPIN_FOREVER;
+  REQUIRE_OK(a0_reader_zc_init(&rz, arena, opts, make_callback()));
+
+  push_pkt("pkt_0");
+  push_pkt("pkt_1");
+
+  WAIT_AND_REQUIRE_PAYLOADS({"pkt_0", "pkt_1"});
+
+  // Closing interrupts the spin.
+  REQUIRE_OK(a0_reader_zc_close(&rz));
+}
+
+TEST_CASE_FIXTURE(ReaderZCFixture, "reader_zc] at seq") {
+  push_pkt("pkt_0");
+
+  a0_reader_options_t opts = C_OLDEST_NEXT;
+  opts.init = A0_INIT_AT_SEQ;
+  opts.seq = 3;
+
+  REQUIRE_OK(a0_reader_zc_init(&rz, arena, opts, make_callback()));
+
+  push_pkt("pkt_1");
+  push_pkt("pkt_2");
+  push_pkt("pkt_3");
+
+  WAIT_AND_REQUIRE_PAYLOADS({"pkt_2", "pkt_3"});
+
+  REQUIRE_OK(a0_reader_zc_close(&rz));
+}
+
 TEST_CASE_FIXTURE(ReaderZCFixture, "reader_zc] oldest-next, empty start") {
   REQUIRE_OK(a0_reader_zc_init(&rz, arena, C_OLDEST_NEXT, make_callback()));
 
@@ -1276,6 +2199,540 @@ TEST_CASE_FIXTURE(ReaderFixture, "reader] cpp oldest-next") {
   WAIT_AND_REQUIRE_PAYLOADS({"pkt_0", "pkt_1", "pkt_2"});
 }
 
+TEST_CASE_FIXTURE(ReaderFixture, "reader] batch") {
+  for (int i = 0; i < 10; i++) {
+    push_pkt("pkt_" + std::to_string(i));
+  }
+
+  struct batch_data_t {
+    std::vector<size_t> sizes;
+    data_t* data;
+  } batch_data{{}, &data};
+
+  a0_packet_batch_callback_t cb = {
+      .user_data = &batch_data,
+      .fn = [](void* user_data, a0_packet_t* pkts, size_t cnt) {
+        auto* batch_data = (batch_data_t*)user_data;
+
+        std::unique_lock<std::mutex> lk{batch_data->data->mu};
+        batch_data->sizes.push_back(cnt);
+        for (size_t i = 0; i < cnt; i++) {
+          batch_data->data->collected_payloads.push_back(a0::test::str(pkts[i].payload));
+        }
+        batch_data->data->cv.notify_all();
+      },
+  };
+
+  REQUIRE(a0_reader_init_batch(&r, arena, a0::test::alloc(), C_OLDEST_NEXT, 0, cb) == A0_ERR_INVALID_ARG);
+  REQUIRE_OK(a0_reader_init_batch(&r, arena, a0::test::alloc(), C_OLDEST_NEXT, 4, cb));
+
+  WAIT_AND_REQUIRE_PAYLOADS({"pkt_0", "pkt_1", "pkt_2", "pkt_3", "pkt_4",
+                             "pkt_5", "pkt_6", "pkt_7", "pkt_8", "pkt_9"});
+  {
+    std::unique_lock<std::mutex> lk{data.mu};
+    REQUIRE(batch_data.sizes == std::vector<size_t>{4, 4, 2});
+  }
+
+  push_pkt("pkt_10");
+  WAIT_AND_REQUIRE_PAYLOADS({"pkt_0", "pkt_1", "pkt_2", "pkt_3", "pkt_4",
+                             "pkt_5", "pkt_6", "pkt_7", "pkt_8", "pkt_9", "pkt_10"});
+
+  REQUIRE_OK(a0_reader_close(&r));
+}
+
+TEST_CASE_FIXTURE(ReaderFixture, "reader] cpp batch") {
+  push_pkt("pkt_0");
+  push_pkt("pkt_1");
+  push_pkt("pkt_2");
+
+  std::vector<size_t> sizes;
+  a0::Reader cpp_r(
+      a0::cpp_wrap<a0::Arena>(arena),
+      a0::Reader::Options(a0::INIT_OLDEST),
+      2,
+      [&](std::vector<a0::Packet> pkts) {
+        std::unique_lock<std::mutex> lk{data.mu};
+        sizes.push_back(pkts.size());
+        for (auto&& pkt : pkts) {
+          data.collected_payloads.push_back(std::string(pkt.payload()));
+        }
+        data.cv.notify_all();
+      });
+
+  WAIT_AND_REQUIRE_PAYLOADS({"pkt_0", "pkt_1", "pkt_2"});
+  std::unique_lock<std::mutex> lk{data.mu};
+  REQUIRE(sizes == std::vector<size_t>{2, 1});
+}
+
+TEST_CASE_FIXTURE(ReaderFixture, "reader] filter") {
+  push_pkt(a0::test::pkt({{"type", "a"}}, "pkt_0"));
+  push_pkt(a0::test::pkt({{"type", "b"}}, "pkt_1"));
+  push_pkt(a0::test::pkt({{"type", "a"}}, "pkt_2"));
+  push_pkt(a0::test::pkt({{"type", "b"}}, "pkt_3"));
+
+  a0::Reader::Options opts(a0::INIT_OLDEST);
+  opts.filter = a0::Reader::Filter::key_equals("type", "a");
+  a0::Reader cpp_r(a0::cpp_wrap<a0::Arena>(arena), opts, make_cpp_callback());
+
+  WAIT_AND_REQUIRE_PAYLOADS({"pkt_0", "pkt_2"});
+
+  push_pkt(a0::test::pkt({{"type", "b"}}, "pkt_4"));
+  push_pkt(a0::test::pkt({{"type", "a"}}, "pkt_5"));
+  WAIT_AND_REQUIRE_PAYLOADS({"pkt_0", "pkt_2", "pkt_5"});
+}
+
+TEST_CASE_FIXTURE(ReaderFixture, "reader] latest per key") {
+  push_pkt(a0::test::pkt({{"id", "a"}, {"type", "x"}}, "pkt_0"));
+  push_pkt(a0::test::pkt({{"id", "b"}, {"type", "x"}}, "pkt_1"));
+  push_pkt(a0::test::pkt({{"id", "a"}, {"type", "x"}}, "pkt_2"));
+  push_pkt(a0::test::pkt({{"id", "b"}, {"type", "y"}}, "pkt_3"));
+
+  // The filter applies first.
+  a0::Reader::Options opts(a0::INIT_OLDEST, a0::ITER_LATEST_PER_KEY);
+  opts.conflate_key = "id";
+  opts.filter = a0::Reader::Filter::key_equals("type", "x");
+  a0::Reader cpp_r(a0::cpp_wrap<a0::Arena>(arena), opts, make_cpp_callback());
+
+  WAIT_AND_REQUIRE_PAYLOADS({"pkt_1", "pkt_2"});
+
+  push_pkt(a0::test::pkt({{"id", "b"}, {"type", "x"}}, "pkt_4"));
+  WAIT_AND_REQUIRE_PAYLOADS({"pkt_1", "pkt_2", "pkt_4"});
+}
+
+TEST_CASE_FIXTURE(ReaderFixture, "reader] cpp cursor") {
+  a0_file_remove("test.cursor");
+  a0::CursorTable table("test");
+
+  push_pkt("pkt_0");
+  push_pkt("pkt_1");
+
+  a0::Reader::Options opts(a0::INIT_OLDEST);
+  opts.cursor = table.open("consumer");
+  {
+    a0::Reader cpp_r(a0::cpp_wrap<a0::Arena>(arena), opts, make_cpp_callback());
+    WAIT_AND_REQUIRE_PAYLOADS({"pkt_0", "pkt_1"});
+  }
+  REQUIRE(table.list()["consumer"] == 2);
+
+  push_pkt("pkt_2");
+  push_pkt("pkt_3");
+
+  // Resumes where the last reader left off.
+  data.collected_payloads.clear();
+  a0::Reader cpp_r(a0::cpp_wrap<a0::Arena>(arena), opts, make_cpp_callback());
+  WAIT_AND_REQUIRE_PAYLOADS({"pkt_2", "pkt_3"});
+
+  a0_file_remove("test.cursor");
+}
+
+struct cursor_data_t {
+  a0_cursor_t cursor;
+  // Cursor position when each callback started.
+  std::vector<uint64_t> seen;
+  std::mutex mu;
+  std::condition_variable cv;
+};
+
+TEST_CASE_FIXTURE(ReaderFixture, "reader] executor cursor") {
+  a0_file_remove("test.cursor");
+  a0_cursor_table_t table;
+  REQUIRE_OK(a0_cursor_table_init(&table, {"test"}));
+  cursor_data_t cursor_data;
+  REQUIRE_OK(a0_cursor_open(&table, "consumer", &cursor_data.cursor));
+
+  for (int i = 0; i < 5; i++) {
+    push_pkt("pkt_" + std::to_string(i));
+  }
+
+  a0_executor_t ex;
+  REQUIRE_OK(a0_executor_init(&ex, 2));
+
+  a0_reader_options_t opts = C_OLDEST_NEXT;
+  opts.executor = &ex;
+  opts.cursor = cursor_data.cursor;
+
+  a0_packet_callback_t cb = {
+      .user_data = &cursor_data,
+      .fn = [](void* user_data, a0_packet_t) {
+        auto* cursor_data = (cursor_data_t*)user_data;
+        uint64_t seq;
+        REQUIRE_OK(a0_cursor_load(cursor_data->cursor, &seq));
+        std::unique_lock<std::mutex> lk{cursor_data->mu};
+        cursor_data->seen.push_back(seq);
+        cursor_data->cv.notify_all();
+      },
+  };
+  REQUIRE_OK(a0_reader_init(&r, arena, a0::test::alloc(), opts, cb));
+
+  {
+    std::unique_lock<std::mutex> lk{cursor_data.mu};
+    cursor_data.cv.wait(lk, [&]() { return cursor_data.seen.size() == 5; });
+  }
+  REQUIRE_OK(a0_reader_close(&r));
+  REQUIRE_OK(a0_executor_close(&ex));
+
+  // Each packet is committed once its callback has run, not when it is posted.
+  REQUIRE(cursor_data.seen == std::vector<uint64_t>{0, 1, 2, 3, 4});
+  uint64_t seq;
+  REQUIRE_OK(a0_cursor_load(cursor_data.cursor, &seq));
+  REQUIRE(seq == 5);
+
+  REQUIRE_OK(a0_cursor_table_close(&table));
+  a0_file_remove("test.cursor");
+}
+
+TEST_CASE_FIXTURE(ReaderFixture, "reader] batch cursor") {
+  a0_file_remove("test.cursor");
+  a0_cursor_table_t table;
+  REQUIRE_OK(a0_cursor_table_init(&table, {"test"}));
+  cursor_data_t cursor_data;
+  REQUIRE_OK(a0_cursor_open(&table, "consumer", &cursor_data.cursor));
+
+  for (int i = 0; i < 10; i++) {
+    push_pkt("pkt_" + std::to_string(i));
+  }
+
+  a0_reader_options_t opts = C_OLDEST_NEXT;
+  opts.cursor = cursor_data.cursor;
+
+  a0_packet_batch_callback_t cb = {
+      .user_data = &cursor_data,
+      .fn = [](void* user_data, a0_packet_t*, size_t) {
+        auto* cursor_data = (cursor_data_t*)user_data;
+        uint64_t seq;
+        REQUIRE_OK(a0_cursor_load(cursor_data->cursor, &seq));
+        std::unique_lock<std::mutex> lk{cursor_data->mu};
+        cursor_data->seen.push_back(seq);
+        cursor_data->cv.notify_all();
+      },
+  };
+  REQUIRE_OK(a0_reader_init_batch(&r, arena, a0::test::alloc(), opts, 4, cb));
+
+  {
+    std::unique_lock<std::mutex> lk{cursor_data.mu};
+    cursor_data.cv.wait(lk, [&]() { return cursor_data.seen.size() == 3; });
+  }
+  REQUIRE_OK(a0_reader_close(&r));
+
+  // Each batch commits its last packet once the callback has run.
+  REQUIRE(cursor_data.seen == std::vector<uint64_t>{0, 4, 8});
+  uint64_t seq;
+  REQUIRE_OK(a0_cursor_load(cursor_data.cursor, &seq));
+  REQUIRE(seq == 10);
+
+  // A restarted reader resumes after the last batch.
+  push_pkt("pkt_10");
+  cursor_data.seen.clear();
+  REQUIRE_OK(a0_reader_init_batch(&r, arena, a0::test::alloc(), opts, 4, cb));
+  {
+    std::unique_lock<std::mutex> lk{cursor_data.mu};
+    cursor_data.cv.wait(lk, [&]() { return cursor_data.seen.size() == 1; });
+  }
+  REQUIRE_OK(a0_reader_close(&r));
+  REQUIRE(cursor_data.seen == std::vector<uint64_t>{10});
+  REQUIRE_OK(a0_cursor_load(cursor_data.cursor, &seq));
+  REQUIRE(seq == 11);
+
+  REQUIRE_OK(a0_cursor_table_close(&table));
+  a0_file_remove("test.cursor");
+}
+
+TEST_CASE_FIXTURE(ReaderFixture, "reader] batch filter") {
+  push_pkt(a0::test::pkt({{"type", "a"}}, "pkt_0"));
+  push_pkt(a0::test::pkt({{"type", "a"}}, "pkt_1"));
+  push_pkt(a0::test::pkt({{"type", "b"}}, "pkt_2"));
+  push_pkt(a0::test::pkt({{"type", "b"}}, "pkt_3"));
+
+  // Trailing filtered packets must not hold the batch back.
+  a0::Reader::Options opts(a0::INIT_OLDEST);
+  opts.filter = a0::Reader::Filter::key_equals("type", "a");
+  a0::Reader cpp_r(
+      a0::cpp_wrap<a0::Arena>(arena),
+      opts,
+      8,
+      [&](std::vector<a0::Packet> pkts) {
+        std::unique_lock<std::mutex> lk{data.mu};
+        for (auto&& pkt : pkts) {
+          data.collected_payloads.push_back(std::string(pkt.payload()));
+        }
+        data.cv.notify_all();
+      });
+
+  WAIT_AND_REQUIRE_PAYLOADS({"pkt_0", "pkt_1"});
+}
+
+TEST_CASE_FIXTURE(ReaderFixture, "reader] mux") {
+  std::vector<uint8_t> other_data(4096);
+  a0_arena_t other = {{other_data.data(), other_data.size()}, A0_ARENA_MODE_SHARED};
+
+  push_pkt("a_0");
+  push_pkt(other, a0::test::pkt("b_0"));
+
+  a0_reader_mux_t mux;
+  REQUIRE_OK(a0_reader_mux_init(&mux));
+
+  a0_reader_t other_r;
+  REQUIRE_OK(a0_reader_init_mux(&r, &mux, arena, a0::test::alloc(), C_OLDEST_NEXT, make_callback()));
+  REQUIRE_OK(a0_reader_init_mux(&other_r, &mux, other, a0::test::alloc(), C_OLDEST_NEXT, make_callback()));
+
+  REQUIRE(A0_SYSERR(a0_reader_mux_close(&mux)) == EBUSY);
+
+  {
+    std::unique_lock<std::mutex> lk{data.mu};
+    data.cv.wait(lk, [&]() { return data.collected_payloads.size() >= 2; });
+  }
+
+  push_pkt("a_1");
+  push_pkt(other, a0::test::pkt("b_1"));
+  push_pkt(other, a0::test::pkt("b_2"));
+
+  {
+    std::unique_lock<std::mutex> lk{data.mu};
+    data.cv.wait(lk, [&]() { return data.collected_payloads.size() >= 5; });
+    std::sort(data.collected_payloads.begin(), data.collected_payloads.end());
+  }
+  WAIT_AND_REQUIRE_PAYLOADS({"a_0", "a_1", "b_0", "b_1", "b_2"});
+
+  // Detached readers get no more packets.
+  REQUIRE_OK(a0_reader_close(&other_r));
+  push_pkt(other, a0::test::pkt("b_3"));
+  push_pkt("a_2");
+
+  {
+    std::unique_lock<std::mutex> lk{data.mu};
+    data.cv.wait(lk, [&]() { return data.collected_payloads.size() >= 6; });
+  }
+  WAIT_AND_REQUIRE_PAYLOADS({"a_0", "a_1", "b_0", "b_1", "b_2", "a_2"});
+
+  REQUIRE_OK(a0_reader_close(&r));
+  REQUIRE_OK(a0_reader_mux_close(&mux));
+}
+
+TEST_CASE_FIXTURE(ReaderFixture, "reader] mux many") {
+  // More readers than a single futex_waitv call can watch.
+  const size_t cnt = 150;
+  std::vector<std::vector<uint8_t>> arena_datas(cnt, std::vector<uint8_t>(1024));
+  std::vector<a0_arena_t> arenas(cnt);
+  std::vector<a0_reader_t> readers(cnt);
+
+  a0_reader_mux_t mux;
+  REQUIRE_OK(a0_reader_mux_init(&mux));
+
+  for (size_t i = 0; i < cnt; i++) {
+    arenas[i] = {{arena_datas[i].data(), arena_datas[i].size()}, A0_ARENA_MODE_SHARED};
+    REQUIRE_OK(a0_reader_init_mux(&readers[i], &mux, arenas[i], a0::test::alloc(), C_AWAIT_NEW_NEXT, make_callback()));
+  }
+
+  std::vector<std::string> want;
+  for (size_t i = 0; i < cnt; i++) {
+    push_pkt(arenas[i], a0::test::pkt("pkt_" + std::to_string(i)));
+    want.push_back("pkt_" + std::to_string(i));
+  }
+  std::sort(want.begin(), want.end());
+
+  {
+    std::unique_lock<std::mutex> lk{data.mu};
+    data.cv.wait(lk, [&]() { return data.collected_payloads.size() >= cnt; });
+    std::sort(data.collected_payloads.begin(), data.collected_payloads.end());
+  }
+  WAIT_AND_REQUIRE_PAYLOADS(want);
+
+  for (auto&& reader : readers) {
+    REQUIRE_OK(a0_reader_close(&reader));
+  }
+  REQUIRE_OK(a0_reader_mux_close(&mux));
+}
+
+TEST_CASE_FIXTURE(ReaderFixture, "reader] cpp mux") {
+  std::vector<uint8_t> other_data(4096);
+  a0_arena_t other = {{other_data.data(), other_data.size()}, A0_ARENA_MODE_SHARED};
+
+  push_pkt("a_0");
+  push_pkt(other, a0::test::pkt("b_0"));
+
+  a0::ReaderMux mux;
+  a0::Reader cpp_r(mux, a0::cpp_wrap<a0::Arena>(arena), a0::Reader::Options(a0::INIT_OLDEST), make_cpp_callback());
+  a0::Reader cpp_other_r(mux, a0::cpp_wrap<a0::Arena>(other), a0::Reader::Options(a0::INIT_OLDEST), make_cpp_callback());
+
+  // The readers keep the multiplexer alive.
+  mux.c.reset();
+
+  push_pkt("a_1");
+
+  {
+    std::unique_lock<std::mutex> lk{data.mu};
+    data.cv.wait(lk, [&]() { return data.collected_payloads.size() >= 3; });
+    std::sort(data.collected_payloads.begin(), data.collected_payloads.end());
+  }
+  WAIT_AND_REQUIRE_PAYLOADS({"a_0", "a_1", "b_0"});
+}
+
+TEST_CASE_FIXTURE(ReaderFixture, "reader] executor") {
+  std::vector<uint8_t> other_data(4096);
+  a0_arena_t other = {{other_data.data(), other_data.size()}, A0_ARENA_MODE_SHARED};
+
+  for (int i = 0; i < 10; i++) {
+    push_pkt("a_" + std::to_string(i));
+    push_pkt(other, a0::test::pkt("b_" + std::to_string(i)));
+  }
+
+  a0_executor_t ex;
+  REQUIRE_OK(a0_executor_init(&ex, 2));
+
+  a0_reader_options_t opts = C_OLDEST_NEXT;
+  opts.executor = &ex;
+
+  a0_reader_t other_r;
+  REQUIRE_OK(a0_reader_init(&r, arena, a0::test::alloc(), opts, make_callback()));
+  REQUIRE_OK(a0_reader_init(&other_r, other, a0::test::alloc(), opts, make_callback()));
+  REQUIRE(a0_reader_init_batch(&other_r, other, a0::test::alloc(), opts, 4, a0_packet_batch_callback_t{}) == A0_ERR_INVALID_ARG);
+
+  REQUIRE(A0_SYSERR(a0_executor_close(&ex)) == EBUSY);
+
+  {
+    std::unique_lock<std::mutex> lk{data.mu};
+    data.cv.wait(lk, [&]() { return data.collected_payloads.size() >= 20; });
+  }
+
+  // Each reader's packets arrive in order.
+  std::vector<std::string> a_payloads;
+  std::vector<std::string> b_payloads;
+  for (auto&& payload : data.collected_payloads) {
+    (payload[0] == 'a' ? a_payloads : b_payloads).push_back(payload);
+  }
+  for (int i = 0; i < 10; i++) {
+    REQUIRE(a_payloads[i] == "a_" + std::to_string(i));
+    REQUIRE(b_payloads[i] == "b_" + std::to_string(i));
+  }
+
+  REQUIRE_OK(a0_reader_close(&r));
+  REQUIRE_OK(a0_reader_close(&other_r));
+  REQUIRE_OK(a0_executor_close(&ex));
+}
+
+TEST_CASE_FIXTURE(ReaderFixture, "reader] cpp executor") {
+  for (int i = 0; i < 5; i++) {
+    push_pkt("pkt_" + std::to_string(i));
+  }
+
+  a0::Reader::Options opts(a0::INIT_OLDEST);
+  opts.executor = a0::Executor(2);
+  a0::Reader cpp_r(a0::cpp_wrap<a0::Arena>(arena), opts, make_cpp_callback());
+
+  // The reader keeps the executor alive.
+  opts.executor = {};
+
+  WAIT_AND_REQUIRE_PAYLOADS({"pkt_0", "pkt_1", "pkt_2", "pkt_3", "pkt_4"});
+}
+
+struct ThreadAttrSeen {
+  a0_event_t evt;
+  char name[16];
+  cpu_set_t cpus;
+};
+
+TEST_CASE_FIXTURE(ReaderFixture, "reader] thread attr") {
+  push_pkt("pkt_0");
+
+  int cpu = 0;
+  a0_reader_options_t opts = C_OLDEST_NEXT;
+  opts.thread_attr.cpus = &cpu;
+  opts.thread_attr.num_cpus = 1;
+  opts.thread_attr.stack_size = 1 << 20;
+  opts.thread_attr.name = "a0_test_reader";
+
+  ThreadAttrSeen seen{};
+  a0_packet_callback_t cb = {
+      .user_data = &seen,
+      .fn = [](void* user_data, a0_packet_t) {
+        auto* seen = (ThreadAttrSeen*)user_data;
+        pthread_getname_np(pthread_self(), seen->name, sizeof(seen->name));
+        pthread_getaffinity_np(pthread_self(), sizeof(seen->cpus), &seen->cpus);
+        a0_event_set(&seen->evt);
+      },
+  };
+  REQUIRE_OK(a0_reader_init(&r, arena, a0::test::alloc(), opts, cb));
+  REQUIRE_OK(a0_event_wait(&seen.evt));
+  REQUIRE_OK(a0_reader_close(&r));
+
+  REQUIRE(std::string(seen.name) == "a0_test_reader");
+  REQUIRE(CPU_COUNT(&seen.cpus) == 1);
+  REQUIRE(CPU_ISSET(0, &seen.cpus));
+
+  cpu = CPU_SETSIZE;
+  REQUIRE(A0_SYSERR(a0_reader_init(&r, arena, a0::test::alloc(), opts, cb)) == EINVAL);
+}
+
+TEST_CASE_FIXTURE(ReaderFixture, "reader] cpp thread attr") {
+  push_pkt("pkt_0");
+
+  a0::Reader::Options opts(a0::INIT_OLDEST);
+  opts.thread_attr.name = "a0_cpp_reader";
+
+  std::string name;
+  a0_event_t evt = A0_EMPTY;
+  a0::Reader cpp_r(a0::cpp_wrap<a0::Arena>(arena), opts, [&](a0::Packet) {
+    char buf[16];
+    pthread_getname_np(pthread_self(), buf, sizeof(buf));
+    name = buf;
+    a0_event_set(&evt);
+  });
+  REQUIRE_OK(a0_event_wait(&evt));
+
+  REQUIRE(name == "a0_cpp_reader");
+}
+
+TEST_CASE_FIXTURE(ReaderFixture, "reader] stats") {
+  for (bool optimistic : {false, true}) {
+    std::fill(arena_data.begin(), arena_data.end(), 0);
+    data.collected_payloads.clear();
+    for (int i = 0; i < 5; i++) {
+      push_pkt("pkt_" + std::to_string(i));
+    }
+
+    struct lag_data_t {
+      std::atomic<int> calls;
+      uint64_t lag_frames;
+    } lag_data{{0}, 0};
+    a0_reader_options_t opts = C_OLDEST_NEXT;
+    opts.optimistic = optimistic;
+    opts.lag.frames = 1;
+    opts.lag.onlag = {&lag_data, [](void* user_data, a0_reader_stats_t stats) {
+                        auto* lag_data = (lag_data_t*)user_data;
+                        lag_data->lag_frames = stats.lag_frames;
+                        lag_data->calls++;
+                      }};
+
+    REQUIRE_OK(a0_reader_init(&r, arena, a0::test::alloc(), opts, make_callback()));
+    WAIT_AND_REQUIRE_PAYLOADS({"pkt_0", "pkt_1", "pkt_2", "pkt_3", "pkt_4"});
+
+    a0_reader_stats_t stats;
+    REQUIRE_OK(a0_reader_stats(&r, &stats));
+    REQUIRE(stats.delivered == 5);
+    REQUIRE(stats.dropped == 0);
+    REQUIRE(stats.lag_frames == 0);
+
+    REQUIRE_OK(a0_reader_close(&r));
+    REQUIRE(lag_data.calls == 1);
+    REQUIRE(lag_data.lag_frames == 4);
+  }
+}
+
+TEST_CASE_FIXTURE(ReaderFixture, "reader] optimistic oldest-next, empty start") {
+  REQUIRE_OK(a0_reader_init(&r, arena, a0::test::alloc(), C_OLDEST_NEXT_OPTIMISTIC, make_callback()));
+
+  push_pkt("pkt_0");
+  push_pkt("pkt_1");
+
+  WAIT_AND_REQUIRE_PAYLOADS({"pkt_0", "pkt_1"});
+
+  push_pkt("pkt_2");
+
+  WAIT_AND_REQUIRE_PAYLOADS({"pkt_0", "pkt_1", "pkt_2"});
+
+  REQUIRE_OK(a0_reader_close(&r));
+}
+
 TEST_CASE_FIXTURE(ReaderFixture, "reader] oldest-next, empty start") {
   REQUIRE_OK(a0_reader_init(&r, arena, a0::test::alloc(), C_OLDEST_NEXT, make_callback()));
 
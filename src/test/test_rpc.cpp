@@ -9,6 +9,7 @@
 #include <a0/uuid.h>
 
 #include <doctest.h>
+#include <pthread.h>
 
 #include <cerrno>
 #include <chrono>
@@ -179,6 +180,41 @@ TEST_CASE_FIXTURE(RpcFixture, "rpc] cpp blocking") {
   t_1.join();
 }
 
+TEST_CASE_FIXTURE(RpcFixture, "rpc] cpp reply headers") {
+  a0::RpcServer server(
+      "test", [](a0::RpcRequest req) {
+        req.reply({{"reply-to", std::string(req.pkt().payload())}}, "reply");
+      },
+      nullptr);
+
+  a0::RpcClient client("test");
+
+  // Both replies are read into the same client buffer.
+  auto reply_0 = client.send("req_0");
+  auto reply_0_pkt = reply_0.get();
+  auto reply_1_pkt = client.send("req_1").get();
+
+  REQUIRE(reply_0_pkt.headers().find("reply-to")->second == "req_0");
+  REQUIRE(reply_1_pkt.headers().find("reply-to")->second == "req_1");
+}
+
+TEST_CASE_FIXTURE(RpcFixture, "rpc] cpp options") {
+  a0::RpcOptions server_opts;
+  server_opts.thread_attr.name = "a0_rpc_server";
+  a0::RpcServer server(
+      "test", server_opts, [](a0::RpcRequest req) {
+        char name[16];
+        pthread_getname_np(pthread_self(), name, sizeof(name));
+        req.reply(name);
+      },
+      nullptr);
+
+  a0::RpcOptions client_opts;
+  client_opts.thread_attr.name = "a0_rpc_client";
+  a0::RpcClient client("test", client_opts);
+  REQUIRE(client.send_blocking("send").payload() == "a0_rpc_server");
+}
+
 TEST_CASE_FIXTURE(RpcFixture, "rpc] empty oncancel onreply") {
   a0_rpc_request_callback_t onrequest = {
       .user_data = nullptr,
@@ -1,3 +1,4 @@
+#include <a0/alloc.h>
 #include <a0/arena.h>
 #include <a0/arena.hpp>
 #include <a0/buf.h>
@@ -10,6 +11,7 @@
 #include <doctest.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cerrno>
 #include <chrono>
 #include <csignal>
@@ -17,12 +19,18 @@
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
+#include <functional>
 #include <memory>
 #include <stdexcept>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
 #include "src/c_wrap.hpp"
 #include "src/err_macro.h"
 #include "src/test_util.hpp"
@@ -36,6 +44,20 @@ static const char COPY_DISK[] = "/tmp/copy.a0";
 static const char COPY_SHM[] = "copy.a0";
 static const char COPY_SHM_ABS[] = "/dev/shm/alephzero/copy.a0";
 
+// Interposed clock. Lets a test act at a particular clock read, and move time forward.
+// Only the thread that installs a hook sees it.
+static thread_local std::function<void(timespec*)> clock_hook;
+
+extern "C" int clock_gettime(clockid_t clk, timespec* ts) {
+  int ret = syscall(SYS_clock_gettime, clk, ts);
+  if (!ret && clock_hook) {
+    auto hook = std::move(clock_hook);
+    clock_hook = nullptr;
+    hook(ts);
+  }
+  return ret;
+}
+
 struct TransportFixture {
   std::vector<uint8_t> stack_arena_data;
   a0_arena_t arena;
@@ -97,14 +119,14 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] construct") {
       "seq_high": 0,
       "off_head": 0,
       "off_tail": 0,
-      "high_water_mark": 144
+      "high_water_mark": 832
     },
     "working_state": {
       "seq_low": 0,
       "seq_high": 0,
       "off_head": 0,
       "off_tail": 0,
-      "high_water_mark": 144
+      "high_water_mark": 832
     }
   },
   "data": [
@@ -128,14 +150,14 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] cpp construct") {
       "seq_high": 0,
       "off_head": 0,
       "off_tail": 0,
-      "high_water_mark": 144
+      "high_water_mark": 832
     },
     "working_state": {
       "seq_low": 0,
       "seq_high": 0,
       "off_head": 0,
       "off_tail": 0,
-      "high_water_mark": 144
+      "high_water_mark": 832
     }
   },
   "data": [
@@ -144,6 +166,563 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] cpp construct") {
 )");
 }
 
+// Writes a 0.3 header, as laid out before the cache line split, holding two
+// frames at the given offsets.
+static void write_v0_3(std::vector<uint8_t>* data, size_t off_0, size_t off_1) {
+  std::fill(data->begin(), data->end(), 0);
+  memcpy(data->data(), "ALEPHZERO", 9);
+  (*data)[10] = 3;  // minor version.
+  (*data)[12] = 1;  // initialized.
+
+  a0_transport_state_t state;
+  state.seq_low = 1;
+  state.seq_high = 2;
+  state.off_head = off_0;
+  state.off_tail = off_1;
+  state.high_water_mark = off_1 + sizeof(a0_transport_frame_hdr_t) + 1;
+  memcpy(&(*data)[48], &state, sizeof(state));  // state_pages[0].
+  (*data)[128] = 0;                                // committed_page_idx.
+  size_t arena_size = data->size();
+  memcpy(&(*data)[136], &arena_size, sizeof(arena_size));
+
+  a0_transport_frame_hdr_t frame_0 = {1, off_0, off_1, 0, 1};
+  a0_transport_frame_hdr_t frame_1 = {2, off_1, 0, off_0, 1};
+  memcpy(&(*data)[off_0], &frame_0, sizeof(frame_0));
+  (*data)[off_0 + sizeof(frame_0)] = 'a';
+  memcpy(&(*data)[off_1], &frame_1, sizeof(frame_1));
+  (*data)[off_1 + sizeof(frame_1)] = 'b';
+}
+
+TEST_CASE_FIXTURE(TransportFixture, "transport] upgrade from 0.3") {
+  // Frames clear of the new header are kept.
+  write_v0_3(&stack_arena_data, 1024, 2048);
+
+  a0_transport_t transport;
+  REQUIRE_OK(a0_transport_init(&transport, arena));
+  REQUIRE(stack_arena_data[10] == 4);
+
+  a0_transport_locked_t lk;
+  REQUIRE_OK(a0_transport_lock(&transport, &lk));
+
+  uint64_t seq;
+  REQUIRE_OK(a0_transport_seq_low(lk, &seq));
+  REQUIRE(seq == 1);
+  REQUIRE_OK(a0_transport_seq_high(lk, &seq));
+  REQUIRE(seq == 2);
+
+  a0_transport_frame_t* frame;
+  REQUIRE_OK(a0_transport_jump_head(lk));
+  REQUIRE_OK(a0_transport_frame(lk, &frame));
+  REQUIRE(a0::test::str(frame) == "a");
+  REQUIRE_OK(a0_transport_step_next(lk));
+  REQUIRE_OK(a0_transport_frame(lk, &frame));
+  REQUIRE(a0::test::str(frame) == "b");
+
+  REQUIRE_OK(a0_transport_unlock(lk));
+
+  // Frames overlapping the new header are dropped.
+  write_v0_3(&stack_arena_data, 144, 1024);
+
+  REQUIRE_OK(a0_transport_init(&transport, arena));
+  REQUIRE_OK(a0_transport_lock(&transport, &lk));
+
+  bool empty;
+  REQUIRE_OK(a0_transport_empty(lk, &empty));
+  REQUIRE(empty);
+  REQUIRE_OK(a0_transport_seq_low(lk, &seq));
+  REQUIRE(seq == 3);
+  REQUIRE_OK(a0_transport_seq_high(lk, &seq));
+  REQUIRE(seq == 2);
+
+  size_t used_space;
+  REQUIRE_OK(a0_transport_used_space(lk, &used_space));
+  REQUIRE(used_space == 832);
+
+  REQUIRE_OK(a0_transport_unlock(lk));
+}
+
+TEST_CASE_FIXTURE(TransportFixture, "transport] compact") {
+  a0_transport_t transport;
+  a0_transport_options_t opts = A0_TRANSPORT_OPTIONS_DEFAULT;
+  opts.frame_format = A0_TRANSPORT_FRAME_FORMAT_COMPACT;
+  REQUIRE_OK(a0_transport_init_options(&transport, arena, &opts));
+
+  // Connecting with another format keeps the original.
+  a0_transport_t other;
+  REQUIRE_OK(a0_transport_init(&other, arena));
+  REQUIRE(other._compact);
+
+  a0_transport_locked_t lk;
+  REQUIRE_OK(a0_transport_lock(&transport, &lk));
+
+  a0_transport_frame_t* frame;
+  REQUIRE(a0_transport_alloc(lk, 10, &frame) == A0_ERR_INVALID_ARG);
+
+  a0_alloc_t alloc;
+  REQUIRE_OK(a0_transport_allocator(&lk, &alloc));
+
+  // Fill the arena with 64 byte frames until the first eviction.
+  a0_buf_t buf;
+  int num_frames = 0;
+  bool evicts = false;
+  while (!evicts) {
+    REQUIRE_OK(a0_alloc(alloc, 64, &buf));
+    memset(buf.data, 'a' + num_frames % 26, 64);
+    REQUIRE_OK(a0_transport_commit(lk));
+    num_frames++;
+    REQUIRE_OK(a0_transport_alloc_evicts(lk, 64, &evicts));
+  }
+
+  // 24 byte headers, 8 byte aligned. The default format fits 29.
+  REQUIRE(num_frames == 37);
+  size_t used_space;
+  REQUIRE_OK(a0_transport_used_space(lk, &used_space));
+  REQUIRE(used_space == 832 + 37 * (24 + 64));
+
+  REQUIRE(a0_transport_frame(lk, &frame) == A0_ERR_INVALID_ARG);
+
+  a0_transport_frame_view_t view;
+  REQUIRE_OK(a0_transport_jump_head(lk));
+  REQUIRE_OK(a0_transport_frame_view(lk, &view));
+  REQUIRE(view.hdr.seq == 1);
+  REQUIRE(view.hdr.off == 832);
+  REQUIRE(view.hdr.next_off == 832 + 88);
+  REQUIRE(view.data.size == 64);
+  REQUIRE(view.data.data[0] == 'a');
+
+  REQUIRE_OK(a0_transport_step_next(lk));
+  REQUIRE_OK(a0_transport_frame_view(lk, &view));
+  REQUIRE(view.hdr.seq == 2);
+  REQUIRE(view.hdr.prev_off == 832);
+  REQUIRE(view.data.data[0] == 'b');
+
+  // Wrap around, evicting the oldest frames.
+  REQUIRE_OK(a0_alloc(alloc, 100, &buf));
+  memset(buf.data, 'z', 100);
+  REQUIRE_OK(a0_transport_commit(lk));
+
+  uint64_t seq;
+  REQUIRE_OK(a0_transport_seq_low(lk, &seq));
+  REQUIRE(seq == 3);
+
+  REQUIRE_OK(a0_transport_jump_tail(lk));
+  REQUIRE_OK(a0_transport_frame_view(lk, &view));
+  REQUIRE(view.hdr.seq == 38);
+  REQUIRE(view.hdr.off == 832);
+  REQUIRE(view.hdr.prev_off == 832 + 36 * 88);
+  REQUIRE(a0::test::str(view.data) == std::string(100, 'z'));
+
+  REQUIRE_OK(a0_transport_step_prev(lk));
+  REQUIRE_OK(a0_transport_frame_view(lk, &view));
+  REQUIRE(view.hdr.seq == 37);
+  REQUIRE(view.hdr.next_off == 832);
+
+  REQUIRE_OK(a0_transport_jump(lk, 832 + 2 * 88));
+  REQUIRE_OK(a0_transport_frame_view(lk, &view));
+  REQUIRE(view.hdr.seq == 3);
+
+  REQUIRE_OK(a0_transport_unlock(lk));
+}
+
+TEST_CASE_FIXTURE(TransportFixture, "transport] cpp compact") {
+  a0::Transport::Options opts = a0::Transport::Options::DEFAULT;
+  opts.frame_format = a0::Transport::FrameFormat::COMPACT;
+  a0::Transport transport(a0::cpp_wrap<a0::Arena>(arena), opts);
+  a0::TransportLocked tlk = transport.lock();
+
+  REQUIRE_THROWS_WITH(tlk.alloc(10), "Invalid argument");
+
+  a0_alloc_t alloc;
+  REQUIRE_OK(a0_transport_allocator(&*tlk.c, &alloc));
+  a0_buf_t buf;
+  REQUIRE_OK(a0_alloc(alloc, 5, &buf));
+  memcpy(buf.data, "hello", 5);
+  tlk.commit();
+
+  tlk.jump_head();
+  a0::FrameView view = tlk.frame_view();
+  REQUIRE(view.hdr.seq == 1);
+  REQUIRE(a0::test::str(view.data) == "hello");
+}
+
+TEST_CASE_FIXTURE(TransportFixture, "transport] fixed slots") {
+  a0_transport_t transport;
+  a0_transport_options_t opts = A0_TRANSPORT_OPTIONS_DEFAULT;
+  opts.slot_size = 100;
+  REQUIRE_OK(a0_transport_init_options(&transport, arena, &opts));
+
+  a0_transport_locked_t lk;
+  REQUIRE_OK(a0_transport_lock(&transport, &lk));
+
+  size_t slot_size;
+  REQUIRE_OK(a0_transport_slot_size(lk, &slot_size));
+  REQUIRE(slot_size == 100);
+
+  // 40 byte header + 100 byte slot, aligned to 144 bytes.
+  // (4096 - 832) / 144 = 22 slots.
+  a0_transport_frame_t* frame;
+  REQUIRE(a0_transport_alloc(lk, 101, &frame) == A0_ERR_FRAME_LARGE);
+
+  bool evicts;
+  for (size_t i = 0; i < 22; i++) {
+    REQUIRE_OK(a0_transport_alloc_evicts(lk, 10, &evicts));
+    REQUIRE(!evicts);
+    // Frames smaller than a slot still take the whole slot.
+    REQUIRE_OK(a0_transport_alloc(lk, i % 2 ? 100 : 10, &frame));
+    REQUIRE(frame->hdr.off == 832u + i * 144u);
+    memset(frame->data, 'a' + i, frame->hdr.data_size);
+    REQUIRE_OK(a0_transport_commit(lk));
+  }
+
+  size_t used_space;
+  REQUIRE_OK(a0_transport_used_space(lk, &used_space));
+  REQUIRE(used_space == 832 + 22 * 144);
+
+  // The next frame takes the oldest slot.
+  REQUIRE_OK(a0_transport_alloc_evicts(lk, 10, &evicts));
+  REQUIRE(evicts);
+  for (size_t i = 22; i < 26; i++) {
+    REQUIRE_OK(a0_transport_alloc(lk, 10, &frame));
+    REQUIRE(frame->hdr.off == 832u + (i % 22u) * 144u);
+    memset(frame->data, 'a' + i, 10);
+    REQUIRE_OK(a0_transport_commit(lk));
+  }
+
+  uint64_t seq;
+  REQUIRE_OK(a0_transport_seq_low(lk, &seq));
+  REQUIRE(seq == 5);
+  REQUIRE_OK(a0_transport_seq_high(lk, &seq));
+  REQUIRE(seq == 26);
+  REQUIRE_OK(a0_transport_used_space(lk, &used_space));
+  REQUIRE(used_space == 832 + 22 * 144);
+
+  // Seqs map directly onto slots.
+  REQUIRE(a0_transport_jump_seq(lk, 4) == A0_ERR_RANGE);
+  for (uint64_t s : {5, 26, 22, 23, 12}) {
+    REQUIRE_OK(a0_transport_jump_seq(lk, s));
+    REQUIRE_OK(a0_transport_frame(lk, &frame));
+    REQUIRE(frame->hdr.seq == s);
+    REQUIRE(frame->hdr.off == 832 + ((s - 1) % 22) * 144);
+    REQUIRE(frame->data[0] == 'a' + (s - 1));
+  }
+
+  // Links follow seq order across the wrap.
+  REQUIRE_OK(a0_transport_jump_seq(lk, 22));
+  REQUIRE_OK(a0_transport_step_next(lk));
+  REQUIRE_OK(a0_transport_frame(lk, &frame));
+  REQUIRE(frame->hdr.seq == 23);
+  REQUIRE(frame->hdr.off == 832);
+
+  REQUIRE_OK(a0_transport_jump_tail(lk));
+  REQUIRE_OK(a0_transport_step_prev(lk));
+  REQUIRE_OK(a0_transport_frame(lk, &frame));
+  REQUIRE(frame->hdr.seq == 25);
+
+  // After a clear, slots continue from the next seq.
+  REQUIRE_OK(a0_transport_clear(lk));
+  REQUIRE_OK(a0_transport_alloc(lk, 10, &frame));
+  REQUIRE(frame->hdr.seq == 27);
+  REQUIRE(frame->hdr.off == 832 + 4 * 144);
+  REQUIRE_OK(a0_transport_commit(lk));
+  REQUIRE_OK(a0_transport_jump_seq(lk, 27));
+
+  // The arena cannot shrink below the last slot, even if it is unused.
+  REQUIRE(a0_transport_resize(lk, 3990) == A0_ERR_INVALID_ARG);
+  REQUIRE_OK(a0_transport_resize(lk, 832 + 22 * 144));
+
+  REQUIRE_OK(a0_transport_unlock(lk));
+
+  // Slots larger than the arena are rejected.
+  std::vector<uint8_t> small_data(1024);
+  a0_arena_t small_arena = {
+      .buf = {small_data.data(), small_data.size()},
+      .mode = A0_ARENA_MODE_SHARED,
+  };
+  a0_transport_t small;
+  opts.slot_size = 1024;
+  REQUIRE(a0_transport_init_options(&small, small_arena, &opts) == A0_ERR_INVALID_ARG);
+}
+
+TEST_CASE_FIXTURE(TransportFixture, "transport] cpp fixed slots") {
+  a0::Transport::Options opts = a0::Transport::Options::DEFAULT;
+  opts.frame_format = a0::Transport::FrameFormat::COMPACT;
+  opts.slot_size = 64;
+  a0::Transport transport(a0::cpp_wrap<a0::Arena>(arena), opts);
+  a0::TransportLocked tlk = transport.lock();
+  REQUIRE(tlk.slot_size() == 64);
+
+  a0_alloc_t alloc;
+  REQUIRE_OK(a0_transport_allocator(&*tlk.c, &alloc));
+  a0_buf_t buf;
+  REQUIRE(a0_alloc(alloc, 65, &buf) == A0_ERR_FRAME_LARGE);
+
+  // 24 byte compact header + 64 byte slot = 88 bytes.
+  // (4096 - 832) / 88 = 37 slots.
+  for (int i = 0; i < 50; i++) {
+    REQUIRE_OK(a0_alloc(alloc, 64, &buf));
+    memset(buf.data, 'a' + i, 64);
+    tlk.commit();
+  }
+  REQUIRE(tlk.seq_low() == 14);
+  REQUIRE(tlk.seq_high() == 50);
+
+  tlk.jump_seq(38);
+  a0::FrameView view = tlk.frame_view();
+  REQUIRE(view.hdr.seq == 38);
+  REQUIRE(view.hdr.off == 832);
+  REQUIRE(view.data.data[0] == 'a' + 37);
+}
+
+// Commits 240 byte frames until the next one would evict the oldest.
+static void fill_until_evicts(a0_transport_locked_t lk) {
+  bool evicts = false;
+  while (!evicts) {
+    a0_transport_frame_t* frame;
+    REQUIRE_OK(a0_transport_alloc(lk, 240, &frame));
+    memset(frame->data, 'a' + (frame->hdr.seq - 1) % 26, 240);
+    REQUIRE_OK(a0_transport_commit(lk));
+    REQUIRE_OK(a0_transport_alloc_evicts(lk, 240, &evicts));
+  }
+}
+
+TEST_CASE_FIXTURE(TransportFixture, "transport] lease fail") {
+  a0_transport_t transport;
+  a0_transport_options_t opts = A0_TRANSPORT_OPTIONS_DEFAULT;
+  opts.lease_policy = A0_TRANSPORT_LEASE_FAIL;
+  REQUIRE_OK(a0_transport_init_options(&transport, arena, &opts));
+
+  a0_transport_locked_t lk;
+  REQUIRE_OK(a0_transport_lock(&transport, &lk));
+
+  a0_transport_lease_t lease;
+  REQUIRE(a0_transport_lease(lk, &lease) == A0_ERR_RANGE);
+
+  fill_until_evicts(lk);
+
+  REQUIRE_OK(a0_transport_jump_head(lk));
+  REQUIRE_OK(a0_transport_lease(lk, &lease));
+
+  // The lease survives unlocking.
+  REQUIRE_OK(a0_transport_unlock(lk));
+  REQUIRE_OK(a0_transport_lock(&transport, &lk));
+
+  a0_transport_frame_t* frame;
+  REQUIRE(a0_transport_alloc(lk, 240, &frame) == A0_ERR_AGAIN);
+  uint64_t seq;
+  REQUIRE_OK(a0_transport_seq_low(lk, &seq));
+  REQUIRE(seq == 1);
+
+  // Leasing a newer frame does not block evicting older ones.
+  REQUIRE_OK(a0_transport_lease_release(lk, lease));
+  REQUIRE_OK(a0_transport_step_next(lk));
+  REQUIRE_OK(a0_transport_step_next(lk));
+  REQUIRE_OK(a0_transport_lease(lk, &lease));
+  for (int i = 0; i < 2; i++) {
+    REQUIRE_OK(a0_transport_alloc(lk, 240, &frame));
+    REQUIRE_OK(a0_transport_commit(lk));
+  }
+  REQUIRE(a0_transport_alloc(lk, 240, &frame) == A0_ERR_AGAIN);
+  REQUIRE_OK(a0_transport_seq_low(lk, &seq));
+  REQUIRE(seq == 3);
+  REQUIRE_OK(a0_transport_lease_release(lk, lease));
+  REQUIRE_OK(a0_transport_alloc(lk, 240, &frame));
+  REQUIRE_OK(a0_transport_commit(lk));
+
+  // Leases are limited.
+  REQUIRE_OK(a0_transport_jump_tail(lk));
+  a0_transport_lease_t leases[A0_TRANSPORT_MAX_LEASES];
+  for (auto& l : leases) {
+    REQUIRE_OK(a0_transport_lease(lk, &l));
+  }
+  REQUIRE(a0_transport_lease(lk, &lease) == A0_ERR_AGAIN);
+  REQUIRE_OK(a0_transport_lease_release(lk, leases[0]));
+  REQUIRE_OK(a0_transport_lease(lk, &lease));
+  REQUIRE(lease._idx == 0);
+
+  // Clearing drops leased frames.
+  REQUIRE_OK(a0_transport_clear(lk));
+  REQUIRE(a0_transport_lease_release(lk, lease) == A0_ERR_EVICTED);
+  for (size_t i = 1; i < A0_TRANSPORT_MAX_LEASES; i++) {
+    REQUIRE(a0_transport_lease_release(lk, leases[i]) == A0_ERR_EVICTED);
+  }
+
+  REQUIRE_OK(a0_transport_unlock(lk));
+}
+
+TEST_CASE_FIXTURE(TransportFixture, "transport] lease overwrite") {
+  a0_transport_t transport;
+  a0_transport_options_t opts = A0_TRANSPORT_OPTIONS_DEFAULT;
+  opts.lease_policy = A0_TRANSPORT_LEASE_OVERWRITE;
+  REQUIRE_OK(a0_transport_init_options(&transport, arena, &opts));
+
+  a0_transport_locked_t lk;
+  REQUIRE_OK(a0_transport_lock(&transport, &lk));
+
+  fill_until_evicts(lk);
+
+  a0_transport_lease_t head_lease;
+  REQUIRE_OK(a0_transport_jump_head(lk));
+  REQUIRE_OK(a0_transport_lease(lk, &head_lease));
+  a0_transport_lease_t tail_lease;
+  REQUIRE_OK(a0_transport_jump_tail(lk));
+  REQUIRE_OK(a0_transport_lease(lk, &tail_lease));
+
+  a0_transport_frame_t* frame;
+  REQUIRE_OK(a0_transport_alloc(lk, 240, &frame));
+  REQUIRE_OK(a0_transport_commit(lk));
+
+  REQUIRE(a0_transport_lease_release(lk, head_lease) == A0_ERR_EVICTED);
+  REQUIRE_OK(a0_transport_lease_release(lk, tail_lease));
+
+  // Releasing twice is an error.
+  REQUIRE(a0_transport_lease_release(lk, tail_lease) == A0_ERR_EVICTED);
+
+  REQUIRE_OK(a0_transport_unlock(lk));
+}
+
+TEST_CASE_FIXTURE(TransportFixture, "transport] lease block") {
+  a0_transport_t transport;
+  REQUIRE_OK(a0_transport_init(&transport, arena));
+
+  a0_transport_locked_t lk;
+  REQUIRE_OK(a0_transport_lock(&transport, &lk));
+  fill_until_evicts(lk);
+
+  // Our own leases never block.
+  a0_transport_lease_t lease;
+  REQUIRE_OK(a0_transport_jump_head(lk));
+  REQUIRE_OK(a0_transport_lease(lk, &lease));
+  a0_transport_frame_t* frame;
+  REQUIRE_OK(a0_transport_alloc(lk, 240, &frame));
+  REQUIRE_OK(a0_transport_commit(lk));
+  REQUIRE(a0_transport_lease_release(lk, lease) == A0_ERR_EVICTED);
+  REQUIRE_OK(a0_transport_unlock(lk));
+
+  std::atomic<bool> leased{false};
+  std::atomic<bool> released{false};
+  std::thread t([&]() {
+    a0_transport_t reader;
+    REQUIRE_OK(a0_transport_init(&reader, arena));
+    a0_transport_locked_t rlk;
+    REQUIRE_OK(a0_transport_lock(&reader, &rlk));
+    REQUIRE_OK(a0_transport_jump_head(rlk));
+    a0_transport_lease_t rlease;
+    REQUIRE_OK(a0_transport_lease(rlk, &rlease));
+    REQUIRE_OK(a0_transport_unlock(rlk));
+    leased = true;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    REQUIRE_OK(a0_transport_lock(&reader, &rlk));
+    released = true;
+    REQUIRE_OK(a0_transport_lease_release(rlk, rlease));
+    REQUIRE_OK(a0_transport_unlock(rlk));
+  });
+
+  while (!leased) {
+    std::this_thread::yield();
+  }
+
+  REQUIRE_OK(a0_transport_lock(&transport, &lk));
+
+  // Frames pending a commit cannot be held across the wait.
+  REQUIRE_OK(a0_transport_batch_begin(lk));
+  REQUIRE(a0_transport_alloc(lk, 240, &frame) == A0_ERR_AGAIN);
+  REQUIRE_OK(a0_transport_batch_end(lk));
+
+  REQUIRE_OK(a0_transport_alloc(lk, 240, &frame));
+  REQUIRE(released);
+  REQUIRE_OK(a0_transport_commit(lk));
+  REQUIRE_OK(a0_transport_unlock(lk));
+
+  t.join();
+}
+
+TEST_CASE_FIXTURE(TransportFixture, "transport] lease dead holder") {
+  a0_transport_t transport;
+  REQUIRE_OK(a0_transport_init(&transport, shm.arena));
+
+  a0_transport_locked_t lk;
+  REQUIRE_OK(a0_transport_lock(&transport, &lk));
+  fill_until_evicts(lk);
+  REQUIRE_OK(a0_transport_unlock(lk));
+
+  REQUIRE_EXIT({
+    a0_transport_t child;
+    a0_transport_init(&child, shm.arena);
+    a0_transport_locked_t clk;
+    a0_transport_lock(&child, &clk);
+    a0_transport_jump_head(clk);
+    a0_transport_lease_t lease;
+    a0_transport_lease(clk, &lease);
+    a0_transport_unlock(clk);
+  });
+
+  // The lease is reclaimed rather than waited on.
+  REQUIRE_OK(a0_transport_lock(&transport, &lk));
+  a0_transport_frame_t* frame;
+  REQUIRE_OK(a0_transport_alloc(lk, 240, &frame));
+  REQUIRE_OK(a0_transport_commit(lk));
+
+  // Its slot is taken over, along with every other.
+  REQUIRE_OK(a0_transport_jump_head(lk));
+  a0_transport_lease_t leases[A0_TRANSPORT_MAX_LEASES];
+  for (auto& l : leases) {
+    REQUIRE_OK(a0_transport_lease(lk, &l));
+  }
+  for (auto& l : leases) {
+    REQUIRE_OK(a0_transport_lease_release(lk, l));
+  }
+  REQUIRE_OK(a0_transport_unlock(lk));
+}
+
+TEST_CASE_FIXTURE(TransportFixture, "transport] lease dead thread") {
+  a0_transport_t transport;
+  REQUIRE_OK(a0_transport_init(&transport, arena));
+
+  a0_transport_locked_t lk;
+  REQUIRE_OK(a0_transport_lock(&transport, &lk));
+  fill_until_evicts(lk);
+  REQUIRE_OK(a0_transport_unlock(lk));
+
+  std::thread t([&]() {
+    a0_transport_locked_t tlk;
+    REQUIRE_OK(a0_transport_lock(&transport, &tlk));
+    REQUIRE_OK(a0_transport_jump_head(tlk));
+    a0_transport_lease_t lease;
+    REQUIRE_OK(a0_transport_lease(tlk, &lease));
+    REQUIRE_OK(a0_transport_unlock(tlk));
+  });
+  t.join();
+
+  // The lease died with its thread.
+  REQUIRE_OK(a0_transport_lock(&transport, &lk));
+  a0_transport_frame_t* frame;
+  REQUIRE_OK(a0_transport_alloc(lk, 240, &frame));
+  REQUIRE_OK(a0_transport_commit(lk));
+  REQUIRE_OK(a0_transport_unlock(lk));
+}
+
+TEST_CASE_FIXTURE(TransportFixture, "transport] cpp lease") {
+  a0::Transport::Options opts = a0::Transport::Options::DEFAULT;
+  REQUIRE(opts.lease_policy == a0::Transport::LeasePolicy::BLOCK);
+  opts.lease_policy = a0::Transport::LeasePolicy::FAIL;
+  a0::Transport transport(a0::cpp_wrap<a0::Arena>(arena), opts);
+  a0::TransportLocked tlk = transport.lock();
+
+  REQUIRE_THROWS_WITH(tlk.lease(), "Index out of bounds");
+
+  fill_until_evicts(*tlk.c);
+  tlk.jump_head();
+  a0::Lease lease = tlk.lease();
+  REQUIRE_THROWS_WITH(tlk.alloc(240), "Not available yet");
+  tlk.lease_release(lease);
+  tlk.alloc(240);
+  tlk.commit();
+
+  REQUIRE_THROWS_WITH(tlk.lease_release(lease), "Frame evicted while in use");
+}
+
 TEST_CASE_FIXTURE(TransportFixture, "transport] alloc/commit") {
   a0_transport_t transport;
   REQUIRE_OK(a0_transport_init(&transport, arena));
@@ -164,14 +743,14 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] alloc/commit") {
       "seq_high": 0,
       "off_head": 0,
       "off_tail": 0,
-      "high_water_mark": 144
+      "high_water_mark": 832
     },
     "working_state": {
       "seq_low": 0,
       "seq_high": 0,
       "off_head": 0,
       "off_tail": 0,
-      "high_water_mark": 144
+      "high_water_mark": 832
     }
   },
   "data": [
@@ -195,32 +774,32 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] alloc/commit") {
     "committed_state": {
       "seq_low": 1,
       "seq_high": 1,
-      "off_head": 144,
-      "off_tail": 144,
-      "high_water_mark": 194
+      "off_head": 832,
+      "off_tail": 832,
+      "high_water_mark": 882
     },
     "working_state": {
       "seq_low": 1,
       "seq_high": 2,
-      "off_head": 144,
-      "off_tail": 208,
-      "high_water_mark": 288
+      "off_head": 832,
+      "off_tail": 896,
+      "high_water_mark": 976
     }
   },
   "data": [
     {
-      "off": 144,
+      "off": 832,
       "seq": 1,
       "prev_off": 0,
-      "next_off": 208,
+      "next_off": 896,
       "data_size": 10,
       "data": "0123456789"
     },
     {
       "committed": false,
-      "off": 208,
+      "off": 896,
       "seq": 2,
-      "prev_off": 144,
+      "prev_off": 832,
       "next_off": 0,
       "data_size": 40,
       "data": "01234567890123456789012345678..."
@@ -238,31 +817,31 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] alloc/commit") {
     "committed_state": {
       "seq_low": 1,
       "seq_high": 2,
-      "off_head": 144,
-      "off_tail": 208,
-      "high_water_mark": 288
+      "off_head": 832,
+      "off_tail": 896,
+      "high_water_mark": 976
     },
     "working_state": {
       "seq_low": 1,
       "seq_high": 2,
-      "off_head": 144,
-      "off_tail": 208,
-      "high_water_mark": 288
+      "off_head": 832,
+      "off_tail": 896,
+      "high_water_mark": 976
     }
   },
   "data": [
     {
-      "off": 144,
+      "off": 832,
       "seq": 1,
       "prev_off": 0,
-      "next_off": 208,
+      "next_off": 896,
       "data_size": 10,
       "data": "0123456789"
     },
     {
-      "off": 208,
+      "off": 896,
       "seq": 2,
-      "prev_off": 144,
+      "prev_off": 832,
       "next_off": 0,
       "data_size": 40,
       "data": "01234567890123456789012345678..."
@@ -289,14 +868,14 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] cpp alloc/commit") {
       "seq_high": 0,
       "off_head": 0,
       "off_tail": 0,
-      "high_water_mark": 144
+      "high_water_mark": 832
     },
     "working_state": {
       "seq_low": 0,
       "seq_high": 0,
       "off_head": 0,
       "off_tail": 0,
-      "high_water_mark": 144
+      "high_water_mark": 832
     }
   },
   "data": [
@@ -318,32 +897,32 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] cpp alloc/commit") {
     "committed_state": {
       "seq_low": 1,
       "seq_high": 1,
-      "off_head": 144,
-      "off_tail": 144,
-      "high_water_mark": 194
+      "off_head": 832,
+      "off_tail": 832,
+      "high_water_mark": 882
     },
     "working_state": {
       "seq_low": 1,
       "seq_high": 2,
-      "off_head": 144,
-      "off_tail": 208,
-      "high_water_mark": 288
+      "off_head": 832,
+      "off_tail": 896,
+      "high_water_mark": 976
     }
   },
   "data": [
     {
-      "off": 144,
+      "off": 832,
       "seq": 1,
       "prev_off": 0,
-      "next_off": 208,
+      "next_off": 896,
       "data_size": 10,
       "data": "0123456789"
     },
     {
       "committed": false,
-      "off": 208,
+      "off": 896,
       "seq": 2,
-      "prev_off": 144,
+      "prev_off": 832,
       "next_off": 0,
       "data_size": 40,
       "data": "01234567890123456789012345678..."
@@ -361,31 +940,31 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] cpp alloc/commit") {
     "committed_state": {
       "seq_low": 1,
       "seq_high": 2,
-      "off_head": 144,
-      "off_tail": 208,
-      "high_water_mark": 288
+      "off_head": 832,
+      "off_tail": 896,
+      "high_water_mark": 976
     },
     "working_state": {
       "seq_low": 1,
       "seq_high": 2,
-      "off_head": 144,
-      "off_tail": 208,
-      "high_water_mark": 288
+      "off_head": 832,
+      "off_tail": 896,
+      "high_water_mark": 976
     }
   },
   "data": [
     {
-      "off": 144,
+      "off": 832,
       "seq": 1,
       "prev_off": 0,
-      "next_off": 208,
+      "next_off": 896,
       "data_size": 10,
       "data": "0123456789"
     },
     {
-      "off": 208,
+      "off": 896,
       "seq": 2,
-      "prev_off": 144,
+      "prev_off": 832,
       "next_off": 0,
       "data_size": 40,
       "data": "01234567890123456789012345678..."
@@ -416,14 +995,14 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] cpp evict no-head intersect") {
       "seq_high": 0,
       "off_head": 0,
       "off_tail": 0,
-      "high_water_mark": 144
+      "high_water_mark": 832
     },
     "working_state": {
       "seq_low": 0,
       "seq_high": 0,
       "off_head": 0,
       "off_tail": 0,
-      "high_water_mark": 144
+      "high_water_mark": 832
     }
   },
   "data": [
@@ -444,24 +1023,24 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] cpp evict no-head intersect") {
   "header": {
     "arena_size": 4096,
     "committed_state": {
-      "seq_low": 6,
-      "seq_high": 5,
+      "seq_low": 1,
+      "seq_high": 0,
       "off_head": 0,
       "off_tail": 0,
-      "high_water_mark": 144
+      "high_water_mark": 832
     },
     "working_state": {
       "seq_low": 6,
       "seq_high": 6,
-      "off_head": 144,
-      "off_tail": 144,
-      "high_water_mark": 2232
+      "off_head": 832,
+      "off_tail": 832,
+      "high_water_mark": 2920
     }
   },
   "data": [
     {
       "committed": false,
-      "off": 144,
+      "off": 832,
       "seq": 6,
       "prev_off": 0,
       "next_off": 0,
@@ -802,6 +1381,131 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] cpp empty jumps") {
   REQUIRE(!tlk.has_prev());
 }
 
+TEST_CASE_FIXTURE(TransportFixture, "transport] jump seq") {
+  a0_transport_t transport;
+  REQUIRE_OK(a0_transport_init(&transport, arena));
+
+  a0_transport_locked_t lk;
+  REQUIRE_OK(a0_transport_lock(&transport, &lk));
+
+  REQUIRE(a0_transport_jump_seq(lk, 0) == A0_ERR_RANGE);
+
+  for (int i = 0; i < 20; i++) {
+    a0_transport_frame_t* frame;
+    REQUIRE_OK(a0_transport_alloc(lk, 240, &frame));
+    memset(frame->data, 'a' + i, 240);
+    REQUIRE_OK(a0_transport_commit(lk));
+  }
+
+  uint64_t seq_low;
+  REQUIRE_OK(a0_transport_seq_low(lk, &seq_low));
+  uint64_t seq_high;
+  REQUIRE_OK(a0_transport_seq_high(lk, &seq_high));
+  REQUIRE(seq_low > 1);
+  REQUIRE(seq_high == 20);
+
+  REQUIRE(a0_transport_jump_seq(lk, seq_low - 1) == A0_ERR_RANGE);
+  REQUIRE(a0_transport_jump_seq(lk, seq_high + 1) == A0_ERR_RANGE);
+
+  a0_transport_frame_t* frame;
+  for (uint64_t seq : {seq_low, seq_high, seq_low + 3, seq_high - 1, seq_low + 1, seq_low + 2}) {
+    REQUIRE_OK(a0_transport_jump_seq(lk, seq));
+    REQUIRE_OK(a0_transport_frame(lk, &frame));
+    REQUIRE(frame->hdr.seq == seq);
+    REQUIRE(frame->data[0] == 'a' + (seq - 1));
+  }
+
+  REQUIRE_OK(a0_transport_unlock(lk));
+}
+
+TEST_CASE_FIXTURE(TransportFixture, "transport] cpp jump seq") {
+  a0::Transport transport(a0::cpp_wrap<a0::Arena>(arena));
+  a0::TransportLocked tlk = transport.lock();
+
+  REQUIRE_THROWS_WITH(
+      tlk.jump_seq(1),
+      "Index out of bounds");
+
+  for (int i = 0; i < 3; i++) {
+    tlk.alloc(10);
+    tlk.commit();
+  }
+
+  tlk.jump_seq(2);
+  REQUIRE(tlk.frame()->hdr.seq == 2);
+  tlk.jump_seq(1);
+  REQUIRE(tlk.frame()->hdr.seq == 1);
+
+  REQUIRE_THROWS_WITH(
+      tlk.jump_seq(4),
+      "Index out of bounds");
+}
+
+TEST_CASE_FIXTURE(TransportFixture, "transport] jump seq index") {
+  // Large enough to be indexed.
+  stack_arena_data.resize(64 * 1024);
+  arena.buf = {stack_arena_data.data(), stack_arena_data.size()};
+
+  for (auto format : {A0_TRANSPORT_FRAME_FORMAT_DEFAULT, A0_TRANSPORT_FRAME_FORMAT_COMPACT}) {
+    std::fill(stack_arena_data.begin(), stack_arena_data.end(), 0);
+    a0_transport_options_t opts = A0_TRANSPORT_OPTIONS_DEFAULT;
+    opts.frame_format = format;
+
+    a0_transport_t transport;
+    REQUIRE_OK(a0_transport_init_options(&transport, arena, &opts));
+
+    a0_transport_locked_t lk;
+    REQUIRE_OK(a0_transport_lock(&transport, &lk));
+
+    // Start small, so the index is rebuilt when the arena grows.
+    REQUIRE_OK(a0_transport_resize(lk, 16 * 1024));
+
+    a0_alloc_t alloc;
+    REQUIRE_OK(a0_transport_allocator(&lk, &alloc));
+    auto write = [&](uint64_t seq) {
+      a0_buf_t buf;
+      REQUIRE_OK(a0_alloc(alloc, sizeof(seq) + seq % 100, &buf));
+      memcpy(buf.data, &seq, sizeof(seq));
+      REQUIRE_OK(a0_transport_commit(lk));
+    };
+    auto check = [&]() {
+      uint64_t seq_low;
+      REQUIRE_OK(a0_transport_seq_low(lk, &seq_low));
+      uint64_t seq_high;
+      REQUIRE_OK(a0_transport_seq_high(lk, &seq_high));
+      for (uint64_t seq = seq_low; seq <= seq_high; seq += 7) {
+        REQUIRE_OK(a0_transport_jump_seq(lk, seq));
+        a0_transport_frame_view_t view;
+        REQUIRE_OK(a0_transport_frame_view(lk, &view));
+        REQUIRE(view.hdr.seq == seq);
+        REQUIRE(memcmp(view.data.data, &seq, sizeof(seq)) == 0);
+      }
+    };
+
+    uint64_t seq = 0;
+    while (seq < 2000) {
+      write(++seq);
+    }
+    check();
+
+    REQUIRE_OK(a0_transport_resize(lk, stack_arena_data.size()));
+    check();
+
+    // Wrap around the grown arena a few times.
+    while (seq < 10000) {
+      write(++seq);
+    }
+    check();
+
+    // Frames stay clear of the index at the end of the arena.
+    size_t used_space;
+    REQUIRE_OK(a0_transport_used_space(lk, &used_space));
+    REQUIRE(used_space < stack_arena_data.size() - 64);
+
+    REQUIRE_OK(a0_transport_unlock(lk));
+  }
+}
+
 TEST_CASE_FIXTURE(TransportFixture, "transport] wrap around") {
   a0_transport_t transport;
   REQUIRE_OK(a0_transport_init(&transport, arena));
@@ -825,39 +1529,39 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] wrap around") {
     "committed_state": {
       "seq_low": 18,
       "seq_high": 20,
-      "off_head": 2288,
-      "off_tail": 1216,
-      "high_water_mark": 3352
+      "off_head": 2976,
+      "off_tail": 1904,
+      "high_water_mark": 4040
     },
     "working_state": {
       "seq_low": 18,
       "seq_high": 20,
-      "off_head": 2288,
-      "off_tail": 1216,
-      "high_water_mark": 3352
+      "off_head": 2976,
+      "off_tail": 1904,
+      "high_water_mark": 4040
     }
   },
   "data": [
     {
-      "off": 2288,
+      "off": 2976,
       "seq": 18,
-      "prev_off": 1216,
-      "next_off": 144,
+      "prev_off": 1904,
+      "next_off": 832,
       "data_size": 1024,
       "data": "aaaaaaaaaaaaaaaaaaaaaaaaaaaaa..."
     },
     {
-      "off": 144,
+      "off": 832,
       "seq": 19,
-      "prev_off": 2288,
-      "next_off": 1216,
+      "prev_off": 2976,
+      "next_off": 1904,
       "data_size": 1024,
       "data": "aaaaaaaaaaaaaaaaaaaaaaaaaaaaa..."
     },
     {
-      "off": 1216,
+      "off": 1904,
       "seq": 20,
-      "prev_off": 144,
+      "prev_off": 832,
       "next_off": 0,
       "data_size": 1024,
       "data": "aaaaaaaaaaaaaaaaaaaaaaaaaaaaa..."
@@ -888,39 +1592,39 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] cpp wrap around") {
     "committed_state": {
       "seq_low": 18,
       "seq_high": 20,
-      "off_head": 2288,
-      "off_tail": 1216,
-      "high_water_mark": 3352
+      "off_head": 2976,
+      "off_tail": 1904,
+      "high_water_mark": 4040
     },
     "working_state": {
       "seq_low": 18,
       "seq_high": 20,
-      "off_head": 2288,
-      "off_tail": 1216,
-      "high_water_mark": 3352
+      "off_head": 2976,
+      "off_tail": 1904,
+      "high_water_mark": 4040
     }
   },
   "data": [
     {
-      "off": 2288,
+      "off": 2976,
       "seq": 18,
-      "prev_off": 1216,
-      "next_off": 144,
+      "prev_off": 1904,
+      "next_off": 832,
       "data_size": 1024,
       "data": "aaaaaaaaaaaaaaaaaaaaaaaaaaaaa..."
     },
     {
-      "off": 144,
+      "off": 832,
       "seq": 19,
-      "prev_off": 2288,
-      "next_off": 1216,
+      "prev_off": 2976,
+      "next_off": 1904,
       "data_size": 1024,
       "data": "aaaaaaaaaaaaaaaaaaaaaaaaaaaaa..."
     },
     {
-      "off": 1216,
+      "off": 1904,
       "seq": 20,
-      "prev_off": 144,
+      "prev_off": 832,
       "next_off": 0,
       "data_size": 1024,
       "data": "aaaaaaaaaaaaaaaaaaaaaaaaaaaaa..."
@@ -941,6 +1645,7 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] expired next") {
 
   REQUIRE_OK(a0_transport_alloc(lk, data.size(), &frame));
   memcpy(frame->data, data.c_str(), data.size());
+  REQUIRE_OK(a0_transport_commit(lk));
 
   REQUIRE_OK(a0_transport_jump_head(lk));
   REQUIRE_OK(a0_transport_frame(lk, &frame));
@@ -956,6 +1661,7 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] expired next") {
     for (int i = 0; i < 20; i++) {
       REQUIRE_OK(a0_transport_alloc(lk, data.size(), &frame));
       memcpy(frame->data, data.c_str(), data.size());
+      REQUIRE_OK(a0_transport_commit(lk));
     }
 
     REQUIRE_OK(a0_transport_unlock(lk));
@@ -973,7 +1679,7 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] expired next") {
 
   REQUIRE_OK(a0_transport_step_next(lk));
   REQUIRE_OK(a0_transport_frame(lk, &frame));
-  REQUIRE(frame->hdr.seq == 18);
+  REQUIRE(frame->hdr.seq == 19);
 
   REQUIRE_OK(a0_transport_iter_valid(lk, &valid));
   REQUIRE(valid);
@@ -995,6 +1701,7 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] cpp expired next") {
   std::string data(1 * 1024, 'a');  // 1kB string
   auto* frame = tlk.alloc(data.size());
   memcpy(frame->data, data.c_str(), data.size());
+  tlk.commit();
 
   tlk.jump_head();
   frame = tlk.frame();
@@ -1009,6 +1716,7 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] cpp expired next") {
     for (int i = 0; i < 20; i++) {
       auto frame = other_tlk.alloc(data.size());
       memcpy(frame->data, data.c_str(), data.size());
+      other_tlk.commit();
     }
   }
 
@@ -1020,7 +1728,7 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] cpp expired next") {
   tlk.step_next();
   REQUIRE(tlk.iter_valid());
   frame = tlk.frame();
-  REQUIRE(frame->hdr.seq == 18);
+  REQUIRE(frame->hdr.seq == 19);
 
   REQUIRE(!tlk.has_prev());
   REQUIRE(tlk.has_next());
@@ -1048,21 +1756,21 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] large alloc") {
     "committed_state": {
       "seq_low": 5,
       "seq_high": 5,
-      "off_head": 144,
-      "off_tail": 144,
-      "high_water_mark": 3256
+      "off_head": 832,
+      "off_tail": 832,
+      "high_water_mark": 3944
     },
     "working_state": {
       "seq_low": 5,
       "seq_high": 5,
-      "off_head": 144,
-      "off_tail": 144,
-      "high_water_mark": 3256
+      "off_head": 832,
+      "off_tail": 832,
+      "high_water_mark": 3944
     }
   },
   "data": [
     {
-      "off": 144,
+      "off": 832,
       "seq": 5,
       "prev_off": 0,
       "next_off": 0,
@@ -1094,21 +1802,21 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] cpp large alloc") {
     "committed_state": {
       "seq_low": 5,
       "seq_high": 5,
-      "off_head": 144,
-      "off_tail": 144,
-      "high_water_mark": 3256
+      "off_head": 832,
+      "off_tail": 832,
+      "high_water_mark": 3944
     },
     "working_state": {
       "seq_low": 5,
       "seq_high": 5,
-      "off_head": 144,
-      "off_tail": 144,
-      "high_water_mark": 3256
+      "off_head": 832,
+      "off_tail": 832,
+      "high_water_mark": 3944
     }
   },
   "data": [
     {
-      "off": 144,
+      "off": 832,
       "seq": 5,
       "prev_off": 0,
       "next_off": 0,
@@ -1129,7 +1837,7 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] resize") {
 
   size_t used_space;
   REQUIRE_OK(a0_transport_used_space(lk, &used_space));
-  REQUIRE(used_space == 144);
+  REQUIRE(used_space == 832);
 
   std::string data(1024, 'a');
   a0_transport_frame_t* frame;
@@ -1139,11 +1847,11 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] resize") {
   REQUIRE_OK(a0_transport_commit(lk));
 
   REQUIRE_OK(a0_transport_used_space(lk, &used_space));
-  REQUIRE(used_space == 1208);
+  REQUIRE(used_space == 1896);
 
   REQUIRE(a0_transport_resize(lk, 0) == A0_ERR_INVALID_ARG);
-  REQUIRE(a0_transport_resize(lk, 1207) == A0_ERR_INVALID_ARG);
-  REQUIRE_OK(a0_transport_resize(lk, 1208));
+  REQUIRE(a0_transport_resize(lk, 1895) == A0_ERR_INVALID_ARG);
+  REQUIRE_OK(a0_transport_resize(lk, 1896));
 
   data = std::string(1024 + 1, 'a');  // 1 byte larger than previous.
   REQUIRE(a0_transport_alloc(lk, data.size(), &frame) == A0_ERR_FRAME_LARGE);
@@ -1157,31 +1865,31 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] resize") {
   REQUIRE_OK(a0_transport_frame(lk, &frame));
   REQUIRE(frame->hdr.data_size == 1024);
   REQUIRE(a0::test::str(frame) == data);
-  REQUIRE(arena.buf.data[1207] == 'b');
-  REQUIRE(arena.buf.data[1208] != 'b');
+  REQUIRE(arena.buf.data[1895] == 'b');
+  REQUIRE(arena.buf.data[1896] != 'b');
 
   require_debugstr(lk, R"(
 {
   "header": {
-    "arena_size": 1208,
+    "arena_size": 1896,
     "committed_state": {
       "seq_low": 2,
       "seq_high": 2,
-      "off_head": 144,
-      "off_tail": 144,
-      "high_water_mark": 1208
+      "off_head": 832,
+      "off_tail": 832,
+      "high_water_mark": 1896
     },
     "working_state": {
       "seq_low": 2,
       "seq_high": 2,
-      "off_head": 144,
-      "off_tail": 144,
-      "high_water_mark": 1208
+      "off_head": 832,
+      "off_tail": 832,
+      "high_water_mark": 1896
     }
   },
   "data": [
     {
-      "off": 144,
+      "off": 832,
       "seq": 2,
       "prev_off": 0,
       "next_off": 0,
@@ -1193,17 +1901,17 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] resize") {
 )");
 
   REQUIRE_OK(a0_transport_used_space(lk, &used_space));
-  REQUIRE(used_space == 1208);
+  REQUIRE(used_space == 1896);
 
   REQUIRE_OK(a0_transport_resize(lk, 4096));
 
-  data = std::string(2 * 1024, 'c');
+  data = std::string(1536, 'c');
   REQUIRE_OK(a0_transport_alloc(lk, data.size(), &frame));
   memcpy(frame->data, data.c_str(), data.size());
   REQUIRE_OK(a0_transport_commit(lk));
 
   REQUIRE_OK(a0_transport_used_space(lk, &used_space));
-  REQUIRE(used_space == 3304);
+  REQUIRE(used_space == 3480);
 
   require_debugstr(lk, R"(
 {
@@ -1212,33 +1920,33 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] resize") {
     "committed_state": {
       "seq_low": 2,
       "seq_high": 3,
-      "off_head": 144,
-      "off_tail": 1216,
-      "high_water_mark": 3304
+      "off_head": 832,
+      "off_tail": 1904,
+      "high_water_mark": 3480
     },
     "working_state": {
       "seq_low": 2,
       "seq_high": 3,
-      "off_head": 144,
-      "off_tail": 1216,
-      "high_water_mark": 3304
+      "off_head": 832,
+      "off_tail": 1904,
+      "high_water_mark": 3480
     }
   },
   "data": [
     {
-      "off": 144,
+      "off": 832,
       "seq": 2,
       "prev_off": 0,
-      "next_off": 1216,
+      "next_off": 1904,
       "data_size": 1024,
       "data": "bbbbbbbbbbbbbbbbbbbbbbbbbbbbb..."
     },
     {
-      "off": 1216,
+      "off": 1904,
       "seq": 3,
-      "prev_off": 144,
+      "prev_off": 832,
       "next_off": 0,
-      "data_size": 2048,
+      "data_size": 1536,
       "data": "ccccccccccccccccccccccccccccc..."
     }
   ]
@@ -1253,15 +1961,15 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] resize") {
   REQUIRE_OK(a0_transport_commit(lk));
 
   REQUIRE_OK(a0_transport_used_space(lk, &used_space));
-  REQUIRE(used_space == 3368);
+  REQUIRE(used_space == 3544);
 
-  data = std::string(3 * 1024, 'e');
+  data = std::string(2560, 'e');
   REQUIRE_OK(a0_transport_alloc(lk, data.size(), &frame));
   memcpy(frame->data, data.c_str(), data.size());
   REQUIRE_OK(a0_transport_commit(lk));
 
   REQUIRE_OK(a0_transport_used_space(lk, &used_space));
-  REQUIRE(used_space == 3368);
+  REQUIRE(used_space == 3544);
 
   data = std::string(16, 'f');
   REQUIRE_OK(a0_transport_alloc(lk, data.size(), &frame));
@@ -1269,7 +1977,7 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] resize") {
   REQUIRE_OK(a0_transport_commit(lk));
 
   REQUIRE_OK(a0_transport_used_space(lk, &used_space));
-  REQUIRE(used_space == 3320);
+  REQUIRE(used_space == 3496);
 
   require_debugstr(lk, R"(
 {
@@ -1278,31 +1986,31 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] resize") {
     "committed_state": {
       "seq_low": 5,
       "seq_high": 6,
-      "off_head": 144,
-      "off_tail": 3264,
-      "high_water_mark": 3320
+      "off_head": 832,
+      "off_tail": 3440,
+      "high_water_mark": 3496
     },
     "working_state": {
       "seq_low": 5,
       "seq_high": 6,
-      "off_head": 144,
-      "off_tail": 3264,
-      "high_water_mark": 3320
+      "off_head": 832,
+      "off_tail": 3440,
+      "high_water_mark": 3496
     }
   },
   "data": [
     {
-      "off": 144,
+      "off": 832,
       "seq": 5,
-      "prev_off": 3312,
-      "next_off": 3264,
-      "data_size": 3072,
+      "prev_off": 3488,
+      "next_off": 3440,
+      "data_size": 2560,
       "data": "eeeeeeeeeeeeeeeeeeeeeeeeeeeee..."
     },
     {
-      "off": 3264,
+      "off": 3440,
       "seq": 6,
-      "prev_off": 144,
+      "prev_off": 832,
       "next_off": 0,
       "data_size": 16,
       "data": "ffffffffffffffff"
@@ -1313,13 +2021,13 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] resize") {
 
   // This forces an eviction of all existing data, reducing the high water mark.
   // We replace it with less data.
-  data = std::string(3264, 'e');
+  data = std::string(2752, 'e');
   REQUIRE_OK(a0_transport_alloc(lk, data.size(), &frame));
   memcpy(frame->data, data.c_str(), data.size());
   REQUIRE_OK(a0_transport_commit(lk));
 
   REQUIRE_OK(a0_transport_used_space(lk, &used_space));
-  REQUIRE(used_space == (144 + 40 + 3264));
+  REQUIRE(used_space == (832 + 40 + 2752));
 
   uint64_t seq_low;
   REQUIRE_OK(a0_transport_seq_low(lk, &seq_low));
@@ -1336,7 +2044,7 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] resize") {
   REQUIRE_OK(a0_transport_lock(&transport, &lk));
 
   REQUIRE_OK(a0_transport_used_space(lk, &used_space));
-  REQUIRE(used_space == 144);
+  REQUIRE(used_space == 832);
 
   REQUIRE_OK(a0_transport_seq_low(lk, &seq_low));
   REQUIRE(seq_low == 8);
@@ -1351,24 +2059,24 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] cpp resize") {
   a0::Transport transport(a0::cpp_wrap<a0::Arena>(arena));
   a0::TransportLocked tlk = transport.lock();
 
-  REQUIRE(tlk.used_space() == 144);
+  REQUIRE(tlk.used_space() == 832);
 
   std::string data(1024, 'a');
   auto* frame = tlk.alloc(data.size());
   memcpy(frame->data, data.c_str(), data.size());
   tlk.commit();
 
-  REQUIRE(tlk.used_space() == 1208);
+  REQUIRE(tlk.used_space() == 1896);
 
   REQUIRE_THROWS_WITH(
       tlk.resize(0),
       "Invalid argument");
 
   REQUIRE_THROWS_WITH(
-      tlk.resize(1207),
+      tlk.resize(1895),
       "Invalid argument");
 
-  tlk.resize(1208);
+  tlk.resize(1896);
 
   data = std::string(1024 + 1, 'a');  // 1 byte larger than previous.
 
@@ -1389,31 +2097,31 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] cpp resize") {
   frame = tlk.frame();
   REQUIRE(frame->hdr.data_size == 1024);
   REQUIRE(a0::test::str(frame) == data);
-  REQUIRE(arena.buf.data[1207] == 'b');
-  REQUIRE(arena.buf.data[1208] != 'b');
+  REQUIRE(arena.buf.data[1895] == 'b');
+  REQUIRE(arena.buf.data[1896] != 'b');
 
   require_debugstr(*tlk.c, R"(
 {
   "header": {
-    "arena_size": 1208,
+    "arena_size": 1896,
     "committed_state": {
       "seq_low": 2,
       "seq_high": 2,
-      "off_head": 144,
-      "off_tail": 144,
-      "high_water_mark": 1208
+      "off_head": 832,
+      "off_tail": 832,
+      "high_water_mark": 1896
     },
     "working_state": {
       "seq_low": 2,
       "seq_high": 2,
-      "off_head": 144,
-      "off_tail": 144,
-      "high_water_mark": 1208
+      "off_head": 832,
+      "off_tail": 832,
+      "high_water_mark": 1896
     }
   },
   "data": [
     {
-      "off": 144,
+      "off": 832,
       "seq": 2,
       "prev_off": 0,
       "next_off": 0,
@@ -1424,16 +2132,16 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] cpp resize") {
 }
 )");
 
-  REQUIRE(tlk.used_space() == 1208);
+  REQUIRE(tlk.used_space() == 1896);
 
   tlk.resize(4096);
 
-  data = std::string(2 * 1024, 'c');
+  data = std::string(1536, 'c');
   frame = tlk.alloc(data.size());
   memcpy(frame->data, data.c_str(), data.size());
   tlk.commit();
 
-  REQUIRE(tlk.used_space() == 3304);
+  REQUIRE(tlk.used_space() == 3480);
 
   require_debugstr(*tlk.c, R"(
 {
@@ -1442,33 +2150,33 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] cpp resize") {
     "committed_state": {
       "seq_low": 2,
       "seq_high": 3,
-      "off_head": 144,
-      "off_tail": 1216,
-      "high_water_mark": 3304
+      "off_head": 832,
+      "off_tail": 1904,
+      "high_water_mark": 3480
     },
     "working_state": {
       "seq_low": 2,
       "seq_high": 3,
-      "off_head": 144,
-      "off_tail": 1216,
-      "high_water_mark": 3304
+      "off_head": 832,
+      "off_tail": 1904,
+      "high_water_mark": 3480
     }
   },
   "data": [
     {
-      "off": 144,
+      "off": 832,
       "seq": 2,
       "prev_off": 0,
-      "next_off": 1216,
+      "next_off": 1904,
       "data_size": 1024,
       "data": "bbbbbbbbbbbbbbbbbbbbbbbbbbbbb..."
     },
     {
-      "off": 1216,
+      "off": 1904,
       "seq": 3,
-      "prev_off": 144,
+      "prev_off": 832,
       "next_off": 0,
-      "data_size": 2048,
+      "data_size": 1536,
       "data": "ccccccccccccccccccccccccccccc..."
     }
   ]
@@ -1482,21 +2190,21 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] cpp resize") {
   memcpy(frame->data, data.c_str(), data.size());
   tlk.commit();
 
-  REQUIRE(tlk.used_space() == 3368);
+  REQUIRE(tlk.used_space() == 3544);
 
-  data = std::string(3 * 1024, 'e');
+  data = std::string(2560, 'e');
   frame = tlk.alloc(data.size());
   memcpy(frame->data, data.c_str(), data.size());
   tlk.commit();
 
-  REQUIRE(tlk.used_space() == 3368);
+  REQUIRE(tlk.used_space() == 3544);
 
   data = std::string(16, 'f');
   frame = tlk.alloc(data.size());
   memcpy(frame->data, data.c_str(), data.size());
   tlk.commit();
 
-  REQUIRE(tlk.used_space() == 3320);
+  REQUIRE(tlk.used_space() == 3496);
 
   require_debugstr(*tlk.c, R"(
 {
@@ -1505,31 +2213,31 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] cpp resize") {
     "committed_state": {
       "seq_low": 5,
       "seq_high": 6,
-      "off_head": 144,
-      "off_tail": 3264,
-      "high_water_mark": 3320
+      "off_head": 832,
+      "off_tail": 3440,
+      "high_water_mark": 3496
     },
     "working_state": {
       "seq_low": 5,
       "seq_high": 6,
-      "off_head": 144,
-      "off_tail": 3264,
-      "high_water_mark": 3320
+      "off_head": 832,
+      "off_tail": 3440,
+      "high_water_mark": 3496
     }
   },
   "data": [
     {
-      "off": 144,
+      "off": 832,
       "seq": 5,
-      "prev_off": 3312,
-      "next_off": 3264,
-      "data_size": 3072,
+      "prev_off": 3488,
+      "next_off": 3440,
+      "data_size": 2560,
       "data": "eeeeeeeeeeeeeeeeeeeeeeeeeeeee..."
     },
     {
-      "off": 3264,
+      "off": 3440,
       "seq": 6,
-      "prev_off": 144,
+      "prev_off": 832,
       "next_off": 0,
       "data_size": 16,
       "data": "ffffffffffffffff"
@@ -1540,12 +2248,12 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] cpp resize") {
 
   // This forces an eviction of all existing data, reducing the high water mark.
   // We replace it with less data.
-  data = std::string(3264, 'e');
+  data = std::string(2752, 'e');
   frame = tlk.alloc(data.size());
   memcpy(frame->data, data.c_str(), data.size());
   tlk.commit();
 
-  REQUIRE(tlk.used_space() == (144 + 40 + 3264));
+  REQUIRE(tlk.used_space() == (832 + 40 + 2752));
 
   REQUIRE(tlk.seq_low() == 7);
   REQUIRE(tlk.seq_high() == 7);
@@ -1557,7 +2265,7 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] cpp resize") {
   tlk = {};
   tlk = transport.lock();
 
-  REQUIRE(tlk.used_space() == 144);
+  REQUIRE(tlk.used_space() == 832);
 
   REQUIRE(tlk.seq_low() == 8);
   REQUIRE(tlk.seq_high() == 7);
@@ -1568,14 +2276,14 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] cpp clear") {
   a0::TransportLocked tlk = transport.lock();
 
   REQUIRE(tlk.empty());
-  REQUIRE(tlk.used_space() == 144);
+  REQUIRE(tlk.used_space() == 832);
   REQUIRE(tlk.seq_low() == 0);
   REQUIRE(tlk.seq_high() == 0);
 
   tlk.clear();
 
   REQUIRE(tlk.empty());
-  REQUIRE(tlk.used_space() == 144);
+  REQUIRE(tlk.used_space() == 832);
   REQUIRE(tlk.seq_low() == 1);
   REQUIRE(tlk.seq_high() == 0);
 
@@ -1584,7 +2292,7 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] cpp clear") {
 
   REQUIRE(frame->hdr.seq == 1);
   REQUIRE(!tlk.empty());
-  REQUIRE(tlk.used_space() == 696);
+  REQUIRE(tlk.used_space() == 1384);
   REQUIRE(tlk.seq_low() == 1);
   REQUIRE(tlk.seq_high() == 1);
 
@@ -1593,14 +2301,14 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] cpp clear") {
 
   REQUIRE(frame->hdr.seq == 2);
   REQUIRE(!tlk.empty());
-  REQUIRE(tlk.used_space() == 1768);
+  REQUIRE(tlk.used_space() == 2456);
   REQUIRE(tlk.seq_low() == 1);
   REQUIRE(tlk.seq_high() == 2);
 
   tlk.clear();
 
   REQUIRE(tlk.empty());
-  REQUIRE(tlk.used_space() == 144);
+  REQUIRE(tlk.used_space() == 832);
   REQUIRE(tlk.seq_low() == 3);
   REQUIRE(tlk.seq_high() == 2);
 
@@ -1609,7 +2317,7 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] cpp clear") {
 
   REQUIRE(frame->hdr.seq == 3);
   REQUIRE(!tlk.empty());
-  REQUIRE(tlk.used_space() == 696);
+  REQUIRE(tlk.used_space() == 1384);
   REQUIRE(tlk.seq_low() == 3);
   REQUIRE(tlk.seq_high() == 3);
 
@@ -1618,25 +2326,201 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] cpp clear") {
 
   REQUIRE(frame->hdr.seq == 4);
   REQUIRE(!tlk.empty());
-  REQUIRE(tlk.used_space() == 1768);
+  REQUIRE(tlk.used_space() == 2456);
   REQUIRE(tlk.seq_low() == 3);
   REQUIRE(tlk.seq_high() == 4);
 
   tlk.clear();
 
   REQUIRE(tlk.empty());
-  REQUIRE(tlk.used_space() == 144);
+  REQUIRE(tlk.used_space() == 832);
   REQUIRE(tlk.seq_low() == 5);
   REQUIRE(tlk.seq_high() == 4);
 
   tlk.clear();
 
   REQUIRE(tlk.empty());
-  REQUIRE(tlk.used_space() == 144);
+  REQUIRE(tlk.used_space() == 832);
   REQUIRE(tlk.seq_low() == 5);
   REQUIRE(tlk.seq_high() == 4);
 }
 
+TEST_CASE_FIXTURE(TransportFixture, "transport] optimistic") {
+  a0_transport_t transport;
+  REQUIRE_OK(a0_transport_init(&transport, arena));
+
+  a0_transport_locked_t lk;
+  REQUIRE_OK(a0_transport_lock(&transport, &lk));
+  for (int i = 0; i < 3; i++) {
+    a0_transport_frame_t* frame;
+    REQUIRE_OK(a0_transport_alloc(lk, 10, &frame));
+    memcpy(frame->data, "0123456789", 10);
+  }
+  REQUIRE_OK(a0_transport_commit(lk));
+  REQUIRE_OK(a0_transport_unlock(lk));
+
+  // Consistent read.
+  REQUIRE_OK(a0_transport_optimistic_begin(&transport, &lk));
+
+  bool empty;
+  REQUIRE_OK(a0_transport_empty(lk, &empty));
+  REQUIRE(!empty);
+
+  uint64_t seq_low, seq_high;
+  REQUIRE_OK(a0_transport_seq_low(lk, &seq_low));
+  REQUIRE_OK(a0_transport_seq_high(lk, &seq_high));
+  REQUIRE(seq_low == 1);
+  REQUIRE(seq_high == 3);
+
+  REQUIRE_OK(a0_transport_jump_head(lk));
+  a0_transport_frame_t* frame;
+  REQUIRE_OK(a0_transport_frame(lk, &frame));
+  REQUIRE(frame->hdr.seq == 1);
+
+  bool has_next;
+  REQUIRE_OK(a0_transport_has_next(lk, &has_next));
+  REQUIRE(has_next);
+  REQUIRE_OK(a0_transport_step_next(lk));
+  REQUIRE_OK(a0_transport_frame(lk, &frame));
+  REQUIRE(frame->hdr.seq == 2);
+
+  // Mutations are rejected.
+  REQUIRE(A0_SYSERR(a0_transport_alloc(lk, 10, &frame)) == EPERM);
+  REQUIRE(A0_SYSERR(a0_transport_commit(lk)) == EPERM);
+  REQUIRE(A0_SYSERR(a0_transport_unlock(lk)) == EPERM);
+
+  REQUIRE_OK(a0_transport_optimistic_validate(lk));
+  REQUIRE_OK(a0_transport_optimistic_end(lk));
+
+  // Interleaved commit.
+  REQUIRE_OK(a0_transport_optimistic_begin(&transport, &lk));
+  REQUIRE_OK(a0_transport_jump_tail(lk));
+
+  {
+    a0_transport_t writer;
+    REQUIRE_OK(a0_transport_init(&writer, arena));
+    a0_transport_locked_t wlk;
+    REQUIRE_OK(a0_transport_lock(&writer, &wlk));
+    a0_transport_frame_t* wframe;
+    REQUIRE_OK(a0_transport_alloc(wlk, 10, &wframe));
+    REQUIRE_OK(a0_transport_commit(wlk));
+    REQUIRE_OK(a0_transport_unlock(wlk));
+  }
+
+  REQUIRE(a0_transport_optimistic_validate(lk) == A0_ERR_AGAIN);
+  REQUIRE(a0_transport_optimistic_end(lk) == A0_ERR_AGAIN);
+
+  // Retry sees the new frame.
+  REQUIRE_OK(a0_transport_optimistic_begin(&transport, &lk));
+  REQUIRE_OK(a0_transport_seq_high(lk, &seq_high));
+  REQUIRE(seq_high == 4);
+  REQUIRE_OK(a0_transport_optimistic_end(lk));
+}
+
+TEST_CASE_FIXTURE(TransportFixture, "transport] alloc batch") {
+  a0_transport_t transport;
+  REQUIRE_OK(a0_transport_init(&transport, arena));
+
+  a0_transport_t observer;
+  REQUIRE_OK(a0_transport_init(&observer, arena));
+
+  auto committed_seq = [&]() {
+    a0_transport_locked_t olk;
+    REQUIRE_OK(a0_transport_optimistic_begin(&observer, &olk));
+    uint64_t seq_low, seq_high;
+    REQUIRE_OK(a0_transport_seq_low(olk, &seq_low));
+    REQUIRE_OK(a0_transport_seq_high(olk, &seq_high));
+    REQUIRE_OK(a0_transport_optimistic_end(olk));
+    return std::make_pair(seq_low, seq_high);
+  };
+
+  a0_transport_locked_t lk;
+  REQUIRE_OK(a0_transport_lock(&transport, &lk));
+
+  size_t sizes[] = {1000, 1000, 1000};
+  a0_transport_frame_t* frames[3];
+  REQUIRE_OK(a0_transport_alloc_batch(lk, sizes, 3, frames));
+  REQUIRE(frames[0]->hdr.seq == 1);
+  REQUIRE(frames[2]->hdr.seq == 3);
+  REQUIRE(committed_seq() == std::make_pair<uint64_t, uint64_t>(0, 0));
+
+  REQUIRE_OK(a0_transport_commit(lk));
+  REQUIRE(committed_seq() == std::make_pair<uint64_t, uint64_t>(1, 3));
+
+  // The next batch evicts the first. Only the eviction is published early.
+  REQUIRE_OK(a0_transport_alloc_batch(lk, sizes, 2, frames));
+  REQUIRE(frames[0]->hdr.seq == 4);
+  REQUIRE(committed_seq() == std::make_pair<uint64_t, uint64_t>(3, 3));
+
+  REQUIRE_OK(a0_transport_commit(lk));
+  REQUIRE(committed_seq() == std::make_pair<uint64_t, uint64_t>(3, 5));
+
+  // A batch that evicts itself is rejected.
+  size_t big_sizes[] = {2000, 2000};
+  REQUIRE(a0_transport_alloc_batch(lk, big_sizes, 2, frames) == A0_ERR_FRAME_LARGE);
+
+  REQUIRE_OK(a0_transport_commit(lk));
+  uint64_t seq_high;
+  REQUIRE_OK(a0_transport_seq_high(lk, &seq_high));
+  REQUIRE(seq_high == 5);
+
+  REQUIRE_OK(a0_transport_unlock(lk));
+}
+
+TEST_CASE_FIXTURE(TransportFixture, "transport] cpp alloc batch") {
+  a0::Transport transport(a0::cpp_wrap<a0::Arena>(arena));
+  a0::TransportLocked tlk = transport.lock();
+
+  auto frames = tlk.alloc_batch({10, 20, 30});
+  REQUIRE(frames.size() == 3);
+  REQUIRE(frames[0]->hdr.data_size == 10);
+  REQUIRE(frames[2]->hdr.data_size == 30);
+  REQUIRE(frames[2]->hdr.seq == 3);
+  tlk.commit();
+  REQUIRE(tlk.seq_high() == 3);
+
+  REQUIRE_THROWS_WITH(
+      tlk.alloc_batch({2000, 2000}),
+      "Frame size too large");
+  REQUIRE(tlk.seq_high() == 3);
+}
+
+TEST_CASE_FIXTURE(TransportFixture, "transport] batch") {
+  a0_transport_t transport;
+  REQUIRE_OK(a0_transport_init(&transport, arena));
+
+  a0_transport_locked_t lk;
+  REQUIRE_OK(a0_transport_lock(&transport, &lk));
+  REQUIRE_OK(a0_transport_batch_begin(lk));
+  REQUIRE(A0_SYSERR(a0_transport_batch_begin(lk)) == EPERM);
+
+  a0_transport_frame_t* frame;
+  REQUIRE_OK(a0_transport_alloc(lk, 10, &frame));
+  REQUIRE_OK(a0_transport_commit(lk));
+  REQUIRE_OK(a0_transport_alloc(lk, 10, &frame));
+  REQUIRE_OK(a0_transport_commit(lk));
+
+  // Discards only the frame allocated after the last commit.
+  REQUIRE_OK(a0_transport_alloc(lk, 10, &frame));
+  REQUIRE_OK(a0_transport_unlock(lk));
+
+  uint64_t seq_high;
+  REQUIRE_OK(a0_transport_seq_high(lk, &seq_high));
+  REQUIRE(seq_high == 2);
+
+  REQUIRE_OK(a0_transport_batch_end(lk));
+  REQUIRE(A0_SYSERR(a0_transport_batch_end(lk)) == EPERM);
+  REQUIRE_OK(a0_transport_unlock(lk));
+
+  REQUIRE_OK(a0_transport_lock(&transport, &lk));
+  uint64_t seq_low;
+  REQUIRE_OK(a0_transport_seq_low(lk, &seq_low));
+  REQUIRE_OK(a0_transport_seq_high(lk, &seq_high));
+  REQUIRE(seq_low == 1);
+  REQUIRE(seq_high == 2);
+  REQUIRE_OK(a0_transport_unlock(lk));
+}
+
 void fork_sleep_push(a0_transport_t* transport, const std::string& str) {
   a0::test::subproc([&]() {
     std::this_thread::sleep_for(std::chrono::milliseconds(1));
@@ -1686,6 +2570,147 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] cpp timedwait") {
       strerror(ETIMEDOUT));
 }
 
+TEST_CASE_FIXTURE(TransportFixture, "transport] spin wait") {
+  a0_transport_t transport;
+  REQUIRE_OK(a0_transport_init(&transport, arena));
+  REQUIRE(a0_transport_set_spin(&transport, -1) == A0_ERR_INVALID_ARG);
+
+  a0_transport_locked_t lk;
+
+  // Spin, then block until the timeout.
+  REQUIRE_OK(a0_transport_set_spin(&transport, 1e5));
+  REQUIRE_OK(a0_transport_lock(&transport, &lk));
+  a0_time_mono_t timeout;
+  a0_time_mono_now(&timeout);
+  a0_time_mono_add(timeout, 1e6, &timeout);
+  REQUIRE(A0_SYSERR(a0_transport_timedwait(lk, a0_transport_nonempty_pred(&lk), &timeout)) == ETIMEDOUT);
+  REQUIRE_OK(a0_transport_unlock(lk));
+
+  // Spin without ever blocking.
+  REQUIRE_OK(a0_transport_set_spin(&transport, A0_TRANSPORT_SPIN_FOREVER));
+  REQUIRE_OK(a0_transport_lock(&transport, &lk));
+  a0_time_mono_now(&timeout);
+  a0_time_mono_add(timeout, 1e6, &timeout);
+  REQUIRE(A0_SYSERR(a0_transport_timedwait(lk, a0_transport_nonempty_pred(&lk), &timeout)) == ETIMEDOUT);
+
+  std::thread t([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    a0_transport_t writer;
+    REQUIRE_OK(a0_transport_init(&writer, arena));
+    a0_transport_locked_t writer_lk;
+    REQUIRE_OK(a0_transport_lock(&writer, &writer_lk));
+    a0_transport_frame_t* frame;
+    REQUIRE_OK(a0_transport_alloc(writer_lk, 3, &frame));
+    memcpy(frame->data, "ABC", 3);
+    REQUIRE_OK(a0_transport_commit(writer_lk));
+    REQUIRE_OK(a0_transport_unlock(writer_lk));
+  });
+
+  REQUIRE_OK(a0_transport_wait(lk, a0_transport_nonempty_pred(&lk)));
+  REQUIRE_OK(a0_transport_jump_head(lk));
+  a0_transport_frame_t* frame;
+  REQUIRE_OK(a0_transport_frame(lk, &frame));
+  REQUIRE(a0::test::str(frame) == "ABC");
+  REQUIRE_OK(a0_transport_unlock(lk));
+
+  t.join();
+}
+
+TEST_CASE_FIXTURE(TransportFixture, "transport] spin deadline") {
+  a0_transport_t transport;
+  REQUIRE_OK(a0_transport_init(&transport, arena));
+  REQUIRE_OK(a0_transport_set_spin(&transport, 1e5));
+
+  a0_transport_locked_t lk;
+  REQUIRE_OK(a0_transport_lock(&transport, &lk));
+  a0_time_mono_t timeout;
+  a0_time_mono_now(&timeout);
+  a0_time_mono_add(timeout, 1e9, &timeout);
+
+  // Clock reads within the wait: the timeout check and the spin deadline,
+  // both locked, then the first deadline check, unlocked. Commit just before
+  // that check, and report the spin budget as spent.
+  int reads = 0;
+  std::function<void(timespec*)> hook = [&](timespec* ts) {
+    if (++reads < 3) {
+      clock_hook = hook;
+      return;
+    }
+    a0_transport_t writer;
+    REQUIRE_OK(a0_transport_init(&writer, arena));
+    a0_transport_locked_t writer_lk;
+    REQUIRE_OK(a0_transport_lock(&writer, &writer_lk));
+    a0_transport_frame_t* frame;
+    REQUIRE_OK(a0_transport_alloc(writer_lk, 3, &frame));
+    memcpy(frame->data, "ABC", 3);
+    REQUIRE_OK(a0_transport_commit(writer_lk));
+    REQUIRE_OK(a0_transport_unlock(writer_lk));
+    ts->tv_sec += (ts->tv_nsec + 1000000) / 1000000000;
+    ts->tv_nsec = (ts->tv_nsec + 1000000) % 1000000000;
+  };
+  clock_hook = hook;
+
+  REQUIRE_OK(a0_transport_timedwait(lk, a0_transport_nonempty_pred(&lk), &timeout));
+  REQUIRE(reads == 3);
+  REQUIRE_OK(a0_transport_unlock(lk));
+}
+
+TEST_CASE_FIXTURE(TransportFixture, "transport] spin remap failure") {
+  a0_transport_t transport;
+  REQUIRE_OK(a0_transport_init(&transport, arena));
+  REQUIRE_OK(a0_transport_set_spin(&transport, A0_TRANSPORT_SPIN_FOREVER));
+
+  a0_transport_locked_t lk;
+  REQUIRE_OK(a0_transport_lock(&transport, &lk));
+
+  // The header's arena size.
+  size_t* arena_size = (size_t*)(arena.buf.data + 16);
+  REQUIRE(*arena_size == arena.buf.size);
+
+  // Claim the arena grew. This arena isn't a file mapping, so the waiter
+  // can't map the rest.
+  std::thread t([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    a0_transport_t writer;
+    REQUIRE_OK(a0_transport_init(&writer, arena));
+    a0_transport_locked_t writer_lk;
+    REQUIRE_OK(a0_transport_lock(&writer, &writer_lk));
+    a0_transport_frame_t* frame;
+    REQUIRE_OK(a0_transport_alloc(writer_lk, 3, &frame));
+    memcpy(frame->data, "ABC", 3);
+    REQUIRE_OK(a0_transport_commit(writer_lk));
+    *arena_size = 2 * arena.buf.size;
+    REQUIRE_OK(a0_transport_unlock(writer_lk));
+  });
+
+  // The wait fails, but still returns with the lock held.
+  REQUIRE(A0_SYSERR(a0_transport_wait(lk, a0_transport_nonempty_pred(&lk))) == ENOMEM);
+  t.join();
+  *arena_size = arena.buf.size;
+  REQUIRE_OK(a0_transport_unlock(lk));
+
+  REQUIRE_OK(a0_transport_lock(&transport, &lk));
+  bool empty;
+  REQUIRE_OK(a0_transport_empty(lk, &empty));
+  REQUIRE(!empty);
+  REQUIRE_OK(a0_transport_unlock(lk));
+}
+
+TEST_CASE_FIXTURE(TransportFixture, "transport] cpp spin wait") {
+  a0::Transport transport(a0::cpp_wrap<a0::Arena>(arena));
+  REQUIRE_THROWS_WITH(
+      transport.set_spin(std::chrono::nanoseconds(-1)),
+      "Invalid argument");
+  transport.set_spin(std::chrono::microseconds(100));
+
+  a0::TransportLocked tlk = transport.lock();
+  REQUIRE_THROWS_WITH(
+      tlk.wait_for([]() { return false; }, std::chrono::nanoseconds((uint64_t)1e6)),
+      strerror(ETIMEDOUT));
+}
+
 TEST_CASE_FIXTURE(TransportFixture, "transport] cpp pred throws") {
   a0::Transport transport(a0::cpp_wrap<a0::Arena>(arena));
   a0::TransportLocked tlk = transport.lock();
@@ -1787,6 +2812,100 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] shm await") {
   REQUIRE_OK(a0_transport_unlock(lk));
 }
 
+TEST_CASE_FIXTURE(TransportFixture, "transport] many waiters") {
+  a0_transport_t transport;
+  REQUIRE_OK(a0_transport_init(&transport, shm.arena));
+
+  a0_transport_locked_t lk;
+  REQUIRE_OK(a0_transport_lock(&transport, &lk));
+
+  // Time out, with nothing to wake us.
+  a0_time_mono_t timeout;
+  REQUIRE_OK(a0_time_mono_now(&timeout));
+  REQUIRE_OK(a0_time_mono_add(timeout, 1e6, &timeout));
+  REQUIRE(A0_SYSERR(a0_transport_timedwait(lk, a0_transport_nonempty_pred(&lk), &timeout)) == ETIMEDOUT);
+  REQUIRE_OK(a0_transport_unlock(lk));
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; i++) {
+    threads.emplace_back([&]() {
+      a0_transport_t waiter;
+      REQUIRE_OK(a0_transport_init(&waiter, shm.arena));
+
+      a0_transport_locked_t waiter_lk;
+      REQUIRE_OK(a0_transport_lock(&waiter, &waiter_lk));
+      REQUIRE_OK(a0_transport_wait(waiter_lk, a0_transport_nonempty_pred(&waiter_lk)));
+      REQUIRE_OK(a0_transport_unlock(waiter_lk));
+    });
+  }
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  REQUIRE_OK(a0_transport_lock(&transport, &lk));
+  a0_transport_frame_t* frame;
+  REQUIRE_OK(a0_transport_alloc(lk, 3, &frame));
+  memcpy(frame->data, "ABC", 3);
+  REQUIRE_OK(a0_transport_commit(lk));
+  REQUIRE_OK(a0_transport_unlock(lk));
+
+  for (auto&& t : threads) {
+    t.join();
+  }
+}
+
+TEST_CASE_FIXTURE(TransportFixture, "transport] seq waiters") {
+  std::atomic<bool> registered{false};
+  std::atomic<int> evals{0};
+  std::thread t([&]() {
+    a0_transport_t waiter;
+    REQUIRE_OK(a0_transport_init(&waiter, shm.arena));
+
+    a0_transport_locked_t waiter_lk;
+    REQUIRE_OK(a0_transport_lock(&waiter, &waiter_lk));
+    struct pred_data_t {
+      a0_transport_locked_t* lk;
+      std::atomic<int>* evals;
+      std::atomic<bool>* registered;
+    } pred_data{&waiter_lk, &evals, &registered};
+    a0_predicate_t pred = {
+        &pred_data,
+        [](void* user_data, bool* out) {
+          auto* data = (pred_data_t*)user_data;
+          (*data->evals)++;
+          *data->registered = true;
+          uint64_t seq_high;
+          a0_transport_seq_high(*data->lk, &seq_high);
+          *out = seq_high >= 10;
+          return A0_OK;
+        },
+    };
+    REQUIRE_OK(a0_transport_wait_seq(waiter_lk, 10, pred));
+    REQUIRE_OK(a0_transport_unlock(waiter_lk));
+  });
+
+  // The waiter holds the lock until it sleeps.
+  while (!registered) {
+    std::this_thread::yield();
+  }
+
+  a0_transport_t transport;
+  REQUIRE_OK(a0_transport_init(&transport, shm.arena));
+  for (int i = 0; i < 10; i++) {
+    a0_transport_locked_t lk;
+    REQUIRE_OK(a0_transport_lock(&transport, &lk));
+    a0_transport_frame_t* frame;
+    REQUIRE_OK(a0_transport_alloc(lk, 3, &frame));
+    memcpy(frame->data, "ABC", 3);
+    REQUIRE_OK(a0_transport_commit(lk));
+    REQUIRE_OK(a0_transport_unlock(lk));
+  }
+
+  t.join();
+
+  // Only seqs 2, 6 and 10 share the waiter's queue.
+  REQUIRE(evals <= 4);
+}
+
 TEST_CASE_FIXTURE(TransportFixture, "transport] cpp shm await") {
   a0::Transport transport(a0::cpp_wrap<a0::Arena>(shm.arena));
 
@@ -1848,32 +2967,32 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] robust") {
     "committed_state": {
       "seq_low": 1,
       "seq_high": 1,
-      "off_head": 144,
-      "off_tail": 144,
-      "high_water_mark": 187
+      "off_head": 832,
+      "off_tail": 832,
+      "high_water_mark": 875
     },
     "working_state": {
       "seq_low": 1,
       "seq_high": 2,
-      "off_head": 144,
-      "off_tail": 192,
-      "high_water_mark": 234
+      "off_head": 832,
+      "off_tail": 880,
+      "high_water_mark": 922
     }
   },
   "data": [
     {
-      "off": 144,
+      "off": 832,
       "seq": 1,
       "prev_off": 0,
-      "next_off": 192,
+      "next_off": 880,
       "data_size": 3,
       "data": "YES"
     },
     {
       "committed": false,
-      "off": 192,
+      "off": 880,
       "seq": 2,
-      "prev_off": 144,
+      "prev_off": 832,
       "next_off": 0,
       "data_size": 2,
       "data": "NO"
@@ -1900,24 +3019,24 @@ TEST_CASE_FIXTURE(TransportFixture, "transport] robust") {
     "committed_state": {
       "seq_low": 1,
       "seq_high": 1,
-      "off_head": 144,
-      "off_tail": 144,
-      "high_water_mark": 187
+      "off_head": 832,
+      "off_tail": 832,
+      "high_water_mark": 875
     },
     "working_state": {
       "seq_low": 1,
       "seq_high": 1,
-      "off_head": 144,
-      "off_tail": 144,
-      "high_water_mark": 187
+      "off_head": 832,
+      "off_tail": 832,
+      "high_water_mark": 875
     }
   },
   "data": [
     {
-      "off": 144,
+      "off": 832,
       "seq": 1,
       "prev_off": 0,
-      "next_off": 192,
+      "next_off": 880,
       "data_size": 3,
       "data": "YES"
     }
@@ -117,6 +117,69 @@ TEST_CASE_FIXTURE(WriterFixture, "writer] cpp basic") {
        }});
 }
 
+TEST_CASE_FIXTURE(WriterFixture, "writer] batch") {
+  a0_writer_t w;
+  REQUIRE_OK(a0_writer_init(&w, arena));
+  REQUIRE_OK(a0_writer_push(&w, a0_add_transport_seq_header()));
+
+  a0_packet_t pkts[] = {
+      a0::test::pkt({{"key", "val"}}, "msg #0"),
+      a0::test::pkt({{"key", "val"}}, "msg #1"),
+      a0::test::pkt({{"key", "val"}}, "msg #2"),
+  };
+  REQUIRE_OK(a0_writer_write_batch(&w, pkts, 3));
+  REQUIRE_OK(a0_writer_write_batch(&w, pkts, 0));
+
+  // The caller's packets are left untouched.
+  REQUIRE(pkts[0].headers_block.next_block == nullptr);
+
+  REQUIRE_OK(a0_writer_close(&w));
+
+  require_transport_state(
+      {{
+           {{"a0_transport_seq", "0"}, {"key", "val"}},
+           "msg #0",
+       },
+       {
+           {{"a0_transport_seq", "1"}, {"key", "val"}},
+           "msg #1",
+       },
+       {
+           {{"a0_transport_seq", "2"}, {"key", "val"}},
+           "msg #2",
+       }});
+}
+
+TEST_CASE_FIXTURE(WriterFixture, "writer] cpp batch") {
+  a0::Writer w(a0::cpp_wrap<a0::Arena>(arena));
+  w.push(a0::write_if_empty());
+
+  w.write_batch({a0::Packet("msg #0"), a0::Packet("msg #1")});
+  w.write_batch({a0::Packet("msg #2")});
+
+  require_transport_state(
+      {{
+          {},
+          "msg #0",
+      }});
+}
+
+TEST_CASE_FIXTURE(WriterFixture, "writer] frame large") {
+  a0_writer_t w;
+  REQUIRE_OK(a0_writer_init(&w, arena));
+
+  REQUIRE_OK(a0_writer_write(&w, a0::test::pkt({{"key", "val"}}, "msg #0")));
+  REQUIRE(a0_writer_write(&w, a0::test::pkt(std::string(8192, 'x'))) == A0_ERR_FRAME_LARGE);
+
+  REQUIRE_OK(a0_writer_close(&w));
+
+  require_transport_state(
+      {{
+          {{"key", "val"}},
+          "msg #0",
+      }});
+}
+
 TEST_CASE_FIXTURE(WriterFixture, "writer] wrap middleware") {
   a0_writer_t w_0;
   REQUIRE_OK(a0_writer_init(&w_0, arena));
@@ -359,6 +422,170 @@ TEST_CASE_FIXTURE(WriterFixture, "writer] cpp standard headers") {
        }});
 }
 
+TEST_CASE_FIXTURE(WriterFixture, "writer] staged") {
+  a0_writer_options_t opts = A0_WRITER_OPTIONS_DEFAULT;
+  REQUIRE(!opts.staged);
+  opts.staged = true;
+
+  a0_writer_t w_0;
+  REQUIRE_OK(a0_writer_init_options(&w_0, arena, opts));
+
+  a0_writer_t w_1;
+  REQUIRE_OK(a0_writer_wrap(&w_0, a0_add_standard_headers(), &w_1));
+
+  // Replacing the payload under the lock falls back to a full serialize.
+  a0_middleware_t replace_payload = {
+      .user_data = nullptr,
+      .close = nullptr,
+      .process = nullptr,
+      .process_locked = [](void*, a0_transport_locked_t, a0_packet_t* pkt, a0_middleware_chain_t chain) {
+        pkt->payload = a0::test::buf("replaced");
+        return a0_middleware_chain(chain, pkt);
+      },
+  };
+  a0_writer_t w_2;
+  REQUIRE_OK(a0_writer_wrap(&w_1, replace_payload, &w_2));
+
+  REQUIRE_OK(a0_writer_write(&w_0, a0::test::pkt({{"key", "val"}}, "msg #0")));
+  REQUIRE_OK(a0_writer_write(&w_1, a0::test::pkt({{"key", "val"}}, "msg #1")));
+  REQUIRE_OK(a0_writer_write(&w_2, a0::test::pkt({{"key", "val"}}, "msg #2")));
+
+  a0_packet_t pkts[] = {
+      a0::test::pkt({{"key", "val"}}, "msg #3"),
+      a0::test::pkt({{"key", "val"}}, "msg #4"),
+  };
+  REQUIRE_OK(a0_writer_write_batch(&w_1, pkts, 2));
+
+  REQUIRE_OK(a0_writer_close(&w_2));
+  REQUIRE_OK(a0_writer_close(&w_1));
+  REQUIRE_OK(a0_writer_close(&w_0));
+
+  auto std_hdrs = [](std::string transport_seq, std::string writer_seq) {
+    return std::vector<std::pair<std::string, std::string>>{
+        {"a0_transport_seq", transport_seq},
+        {"a0_time_mono", "???"},
+        {"a0_writer_seq", writer_seq},
+        {"a0_writer_id", "???"},
+        {"a0_time_wall", "???"},
+        {"key", "val"},
+    };
+  };
+
+  require_transport_state(
+      {{
+           {{"key", "val"}},
+           "msg #0",
+       },
+       {
+           std_hdrs("1", "0"),
+           "msg #1",
+       },
+       {
+           std_hdrs("2", "1"),
+           "replaced",
+       },
+       {
+           std_hdrs("3", "2"),
+           "msg #3",
+       },
+       {
+           std_hdrs("4", "3"),
+           "msg #4",
+       }});
+}
+
+TEST_CASE_FIXTURE(WriterFixture, "writer] cpp staged") {
+  a0::Writer::Options opts;
+  opts.staged = true;
+  a0::Writer w(a0::cpp_wrap<a0::Arena>(arena), opts);
+  w.push(a0::add_transport_seq_header());
+
+  w.write(a0::Packet({{"key", "val"}}, "msg #0"));
+  w.write_batch({a0::Packet({{"key", "val"}}, "msg #1")});
+
+  require_transport_state(
+      {{
+           {{"a0_transport_seq", "0"}, {"key", "val"}},
+           "msg #0",
+       },
+       {
+           {{"a0_transport_seq", "1"}, {"key", "val"}},
+           "msg #1",
+       }});
+}
+
+TEST_CASE_FIXTURE(WriterFixture, "writer] reserve") {
+  a0_writer_t w;
+  REQUIRE_OK(a0_writer_init(&w, arena));
+  REQUIRE_OK(a0_writer_push(&w, a0_add_transport_seq_header()));
+
+  a0_writer_reservation_t res;
+  REQUIRE_OK(a0_writer_reserve(&w, a0::test::pkt({{"key", "val"}}, ""), 6, &res));
+  REQUIRE(res.payload.size == 6);
+  memcpy(res.payload.data, "msg #0", 6);
+  REQUIRE_OK(a0_writer_reservation_commit(&res));
+  REQUIRE(a0_writer_reservation_commit(&res) == A0_ERR_INVALID_ARG);
+
+  // Aborted reservations leave nothing behind.
+  REQUIRE_OK(a0_writer_reserve(&w, a0::test::pkt({{"key", "val"}}, ""), 6, &res));
+  memcpy(res.payload.data, "msg #1", 6);
+  REQUIRE_OK(a0_writer_reservation_abort(&res));
+  REQUIRE(a0_writer_reservation_abort(&res) == A0_ERR_INVALID_ARG);
+
+  REQUIRE_OK(a0_writer_write(&w, a0::test::pkt({{"key", "val"}}, "msg #2")));
+
+  REQUIRE(a0_writer_reserve(&w, a0::test::pkt(""), 4096, &res) == A0_ERR_FRAME_LARGE);
+
+  // Dropped by middleware.
+  a0_writer_t w_if_empty;
+  REQUIRE_OK(a0_writer_wrap(&w, a0_write_if_empty(nullptr), &w_if_empty));
+  REQUIRE(a0_writer_reserve(&w_if_empty, a0::test::pkt(""), 6, &res) == A0_ERR_CANCELLED);
+  REQUIRE_OK(a0_writer_close(&w_if_empty));
+
+  REQUIRE_OK(a0_writer_close(&w));
+
+  require_transport_state(
+      {{
+           {{"a0_transport_seq", "0"}, {"key", "val"}},
+           "msg #0",
+       },
+       {
+           {{"a0_transport_seq", "1"}, {"key", "val"}},
+           "msg #2",
+       }});
+}
+
+TEST_CASE_FIXTURE(WriterFixture, "writer] cpp reserve") {
+  a0::Writer w(a0::cpp_wrap<a0::Arena>(arena));
+
+  {
+    auto res = w.reserve({{"key", "val"}}, 6);
+    memcpy(res.payload().data(), "msg #0", 6);
+    res.commit();
+    REQUIRE_THROWS_WITH(res.commit(), "Invalid argument");
+  }
+
+  {
+    // Aborted when dropped.
+    auto res = w.reserve(6);
+    memcpy(res.payload().data(), "msg #1", 6);
+  }
+
+  auto res = w.reserve(6);
+  memcpy(res.payload().data(), "msg #2", 6);
+  res.commit();
+
+  require_transport_state(
+      {{
+           {{"key", "val"}},
+           "msg #0",
+       },
+       {
+           {},
+           "msg #2",
+       }});
+}
+
 TEST_CASE_FIXTURE(WriterFixture, "writer] push middleware") {
   a0_writer_t w;
   REQUIRE_OK(a0_writer_init(&w, arena));
@@ -7,6 +7,7 @@
 #include <a0/err.h>
 #include <a0/file.h>
 #include <a0/packet.h>
+#include <a0/reader.h>
 #include <a0/time.h>
 #include <a0/transport.h>
 
@@ -264,6 +265,13 @@ inline a0_time_mono_t timeout_now() {
   return timeout_in(std::chrono::nanoseconds(0));
 }
 
+inline a0_reader_options_t reader_opts(a0_reader_init_t init, a0_reader_iter_t iter) {
+  a0_reader_options_t opts = A0_READER_OPTIONS_DEFAULT;
+  opts.init = init;
+  opts.iter = iter;
+  return opts;
+}
+
 inline bool is_valgrind() {
 #ifdef RUNNING_ON_VALGRIND
   return RUNNING_ON_VALGRIND;
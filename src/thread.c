@@ -0,0 +1,100 @@
+// Needed for pthread_attr_setaffinity_np and pthread_setname_np.
+#define _GNU_SOURCE
+
+#include "thread.h"
+
+#include <a0/err.h>
+#include <a0/inline.h>
+#include <a0/thread_attr.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "err_macro.h"
+
+// Linux limits names to 16 bytes, including the terminator.
+#define A0_THREAD_NAME_MAX 16
+
+A0_STATIC_INLINE
+int a0_thread_attr_apply(a0_thread_attr_t attr, pthread_attr_t* pattr) {
+  int err = 0;
+  if (attr.stack_size) {
+    err = pthread_attr_setstacksize(pattr, attr.stack_size);
+    if (err) {
+      return err;
+    }
+  }
+
+  if (attr.sched_policy != SCHED_OTHER) {
+    struct sched_param param = {.sched_priority = attr.sched_priority};
+    if ((err = pthread_attr_setinheritsched(pattr, PTHREAD_EXPLICIT_SCHED)) ||
+        (err = pthread_attr_setschedpolicy(pattr, attr.sched_policy)) ||
+        (err = pthread_attr_setschedparam(pattr, &param))) {
+      return err;
+    }
+  }
+
+  if (attr.num_cpus) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (size_t i = 0; i < attr.num_cpus; i++) {
+      if (attr.cpus[i] < 0 || attr.cpus[i] >= CPU_SETSIZE) {
+        return EINVAL;
+      }
+      CPU_SET(attr.cpus[i], &cpus);
+    }
+    err = pthread_attr_setaffinity_np(pattr, sizeof(cpus), &cpus);
+  }
+
+  return err;
+}
+
+// Names the thread before handing it to fn, so fn never runs unnamed.
+typedef struct a0_thread_start_s {
+  void* (*fn)(void*);
+  void* arg;
+  char name[A0_THREAD_NAME_MAX];
+} a0_thread_start_t;
+
+A0_STATIC_INLINE
+void* a0_thread_start(void* user_data) {
+  a0_thread_start_t start = *(a0_thread_start_t*)user_data;
+  free(user_data);
+  // Best effort.
+  pthread_setname_np(pthread_self(), start.name);
+  return start.fn(start.arg);
+}
+
+a0_err_t a0_thread_create(pthread_t* thread, a0_thread_attr_t attr, void* (*fn)(void*), void* arg) {
+  a0_thread_start_t* start = NULL;
+  if (attr.name) {
+    start = (a0_thread_start_t*)malloc(sizeof(a0_thread_start_t));
+    if (!start) {
+      return A0_MAKE_SYSERR(ENOMEM);
+    }
+    start->fn = fn;
+    start->arg = arg;
+    strncpy(start->name, attr.name, A0_THREAD_NAME_MAX - 1);
+    start->name[A0_THREAD_NAME_MAX - 1] = '\0';
+    fn = a0_thread_start;
+    arg = start;
+  }
+
+  pthread_attr_t pattr;
+  int err = pthread_attr_init(&pattr);
+  if (!err) {
+    err = a0_thread_attr_apply(attr, &pattr);
+    if (!err) {
+      err = pthread_create(thread, &pattr, fn, arg);
+    }
+    pthread_attr_destroy(&pattr);
+  }
+  if (err) {
+    free(start);
+    return A0_MAKE_SYSERR(err);
+  }
+  return A0_OK;
+}
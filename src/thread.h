@@ -0,0 +1,20 @@
+#ifndef A0_SRC_THREAD_H
+#define A0_SRC_THREAD_H
+
+#include <a0/err.h>
+#include <a0/thread_attr.h>
+
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// pthread_create, with the given attributes.
+a0_err_t a0_thread_create(pthread_t*, a0_thread_attr_t, void* (*fn)(void*), void* arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // A0_SRC_THREAD_H
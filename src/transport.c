@@ -5,6 +5,7 @@
 #include <a0/err.h>
 #include <a0/inline.h>
 #include <a0/mtx.h>
+#include <a0/tid.h>
 #include <a0/time.h>
 #include <a0/transport.h>
 #include <a0/unused.h>
@@ -18,44 +19,105 @@
 #include <string.h>
 #include <time.h>
 
+#include "atomic.h"
 #include "clock.h"
 #include "err_macro.h"
+#include "file_map.h"
+#include "ftx.h"
 #include "tsan.h"
 
-typedef struct a0_transport_state_s {
-  uint64_t seq_low;
-  uint64_t seq_high;
-  size_t off_head;
-  size_t off_tail;
-  size_t high_water_mark;
-} a0_transport_state_t;
-
 typedef struct a0_transport_version_s {
   uint8_t major;
   uint8_t minor;
   uint8_t patch;
 } a0_transport_version_t;
 
+// Cache line size assumed by the header layout.
+#define A0_TRANSPORT_CACHE_LINE 64
+
+// Number of wait queues for waiters that need a given seq.
+#define A0_TRANSPORT_SEQ_WAIT_BUCKETS 4
+
+// A reader's hold on a frame.
+//
+// The owner mutex is held by the leasing thread. It is robust, so the kernel
+// marks it free if that thread dies, in any process or PID namespace.
+typedef struct a0_transport_lease_slot_s {
+  a0_mtx_t owner;
+  uint64_t seq;
+} a0_transport_lease_slot_t;
+
+_Static_assert(A0_TRANSPORT_MAX_LEASES <= 32, "Lease evictions are tracked in a 32-bit mask.");
+
+// The header is split into cache lines by who touches them:
+// * Metadata, written once at init.
+// * The mutex, contended by every locker.
+// * The condition, polled and waited on by blocked readers.
+// * The committed state, rewritten by every commit.
+// * The leases, taken and released by leasing readers.
+// This keeps futex traffic on cnd from false-sharing with the lock and with
+// the state the lock holder is updating.
 typedef struct a0_transport_hdr_s {
   char magic[9]; /* ALEPHZERO */
   a0_transport_version_t version;
   bool initialized;
+  size_t arena_size;
+  // Data capacity and number of fixed slots. Zero for variable-size frames.
+  size_t slot_size;
+  size_t slot_cnt;
+  uint32_t lease_policy;
+  // Number of entries in the seq index, and where it starts. Zero if none.
+  uint32_t index_cap;
+  size_t index_off;
+  uint8_t _pad_meta[8];
 
   a0_mtx_t mtx;
-  a0_cnd_t cnd;
+  // Bit i is set if the frame under lease i was evicted. Only touched under mtx.
+  uint32_t lease_evicted;
+  uint8_t _pad_mtx[36];
 
-  a0_transport_state_t state_pages[2];
+  a0_cnd_t cnd;
+  // Number of threads, across all processes, blocked on cnd.
+  uint32_t waiter_cnt;
+  // Number of waiters, across all processes, sleeping on seqlock directly.
+  // Updated atomically, without the lock.
+  uint32_t word_waiter_cnt;
+  // Waiters that need a given seq, bucketed by seq. A commit only wakes the
+  // buckets of the seqs it added.
+  struct {
+    a0_cnd_t cnd;
+    uint32_t waiter_cnt;
+  } seq_waiters[A0_TRANSPORT_SEQ_WAIT_BUCKETS];
+  uint32_t _pad_seq_waiters;
+  // Highest seq the seq waiters have been notified of.
+  uint64_t notified_seq;
+  uint8_t _pad_cnd[8];
+
+  // Odd while a commit is in progress. Used to validate optimistic reads.
+  uint32_t seqlock;
   uint8_t committed_page_idx;
+  a0_transport_state_t state_pages[2];
+  // Keeps the leases off the last state line.
+  uint8_t _pad_state[40];
 
-  size_t arena_size;
+  // Taken and released under mtx.
+  a0_transport_lease_slot_t leases[A0_TRANSPORT_MAX_LEASES];
 } a0_transport_hdr_t;
 
-// TODO(lshamis): Consider packing or reordering fields to reduce this.
-_Static_assert(sizeof(a0_transport_hdr_t) == 144, "Unexpected transport binary representation.");
+_Static_assert(offsetof(a0_transport_hdr_t, mtx) == 1 * A0_TRANSPORT_CACHE_LINE,
+               "Unexpected transport binary representation.");
+_Static_assert(offsetof(a0_transport_hdr_t, cnd) == 2 * A0_TRANSPORT_CACHE_LINE,
+               "Unexpected transport binary representation.");
+_Static_assert(offsetof(a0_transport_hdr_t, seqlock) == 3 * A0_TRANSPORT_CACHE_LINE,
+               "Unexpected transport binary representation.");
+_Static_assert(offsetof(a0_transport_hdr_t, leases) == 5 * A0_TRANSPORT_CACHE_LINE,
+               "Unexpected transport binary representation.");
+_Static_assert(sizeof(a0_transport_hdr_t) == 13 * A0_TRANSPORT_CACHE_LINE,
+               "Unexpected transport binary representation.");
 
 A0_STATIC_INLINE
 a0_transport_hdr_t* a0_transport_header(a0_transport_locked_t lk) {
-  return (a0_transport_hdr_t*)lk.transport->_arena.buf.data;
+  return (a0_transport_hdr_t*)lk.transport->_map.data;
 }
 
 A0_STATIC_INLINE
@@ -64,6 +126,109 @@ a0_transport_frame_hdr_t* a0_transport_frame_header(a0_transport_locked_t lk, si
   return (a0_transport_frame_hdr_t*)((uint8_t*)hdr + off);
 }
 
+// Frame header of the compact format. The frame offset is implicit.
+typedef struct a0_transport_compact_frame_hdr_s {
+  uint64_t seq;
+  // Offsets of the neighboring frames, relative to this frame. Zero if none.
+  int32_t next_rel;
+  int32_t prev_rel;
+  uint32_t data_size;
+  uint32_t _reserved;
+} a0_transport_compact_frame_hdr_t;
+
+_Static_assert(sizeof(a0_transport_compact_frame_hdr_t) == 24, "Unexpected transport binary representation.");
+
+A0_STATIC_INLINE
+a0_transport_compact_frame_hdr_t* a0_transport_compact_frame_header(a0_transport_locked_t lk, size_t off) {
+  a0_transport_hdr_t* hdr = a0_transport_header(lk);
+  return (a0_transport_compact_frame_hdr_t*)((uint8_t*)hdr + off);
+}
+
+A0_STATIC_INLINE
+size_t a0_transport_compact_abs(size_t off, int32_t rel) {
+  return rel ? (size_t)((int64_t)off + rel) : 0;
+}
+
+A0_STATIC_INLINE
+int32_t a0_transport_compact_rel(size_t off, size_t abs) {
+  return abs ? (int32_t)((int64_t)abs - (int64_t)off) : 0;
+}
+
+// Accessors for the frame header at the given offset, in either format.
+
+A0_STATIC_INLINE
+size_t a0_transport_frame_hdr_size(a0_transport_locked_t lk) {
+  if (lk.transport->_compact) {
+    return sizeof(a0_transport_compact_frame_hdr_t);
+  }
+  return sizeof(a0_transport_frame_hdr_t);
+}
+
+A0_STATIC_INLINE
+uint64_t a0_transport_frame_seq(a0_transport_locked_t lk, size_t off) {
+  if (lk.transport->_compact) {
+    return a0_transport_compact_frame_header(lk, off)->seq;
+  }
+  return a0_transport_frame_header(lk, off)->seq;
+}
+
+A0_STATIC_INLINE
+size_t a0_transport_frame_next(a0_transport_locked_t lk, size_t off) {
+  if (lk.transport->_compact) {
+    return a0_transport_compact_abs(off, a0_transport_compact_frame_header(lk, off)->next_rel);
+  }
+  return a0_transport_frame_header(lk, off)->next_off;
+}
+
+A0_STATIC_INLINE
+size_t a0_transport_frame_prev(a0_transport_locked_t lk, size_t off) {
+  if (lk.transport->_compact) {
+    return a0_transport_compact_abs(off, a0_transport_compact_frame_header(lk, off)->prev_rel);
+  }
+  return a0_transport_frame_header(lk, off)->prev_off;
+}
+
+A0_STATIC_INLINE
+size_t a0_transport_frame_data_size(a0_transport_locked_t lk, size_t off) {
+  if (lk.transport->_compact) {
+    return a0_transport_compact_frame_header(lk, off)->data_size;
+  }
+  return a0_transport_frame_header(lk, off)->data_size;
+}
+
+A0_STATIC_INLINE
+void a0_transport_frame_set_next(a0_transport_locked_t lk, size_t off, size_t next_off) {
+  if (lk.transport->_compact) {
+    a0_transport_compact_frame_header(lk, off)->next_rel = a0_transport_compact_rel(off, next_off);
+  } else {
+    a0_transport_frame_header(lk, off)->next_off = next_off;
+  }
+}
+
+A0_STATIC_INLINE
+void a0_transport_frame_set_prev(a0_transport_locked_t lk, size_t off, size_t prev_off) {
+  if (lk.transport->_compact) {
+    a0_transport_compact_frame_header(lk, off)->prev_rel = a0_transport_compact_rel(off, prev_off);
+  } else {
+    a0_transport_frame_header(lk, off)->prev_off = prev_off;
+  }
+}
+
+A0_STATIC_INLINE
+uint8_t* a0_transport_frame_data(a0_transport_locked_t lk, size_t off) {
+  return (uint8_t*)a0_transport_header(lk) + off + a0_transport_frame_hdr_size(lk);
+}
+
+A0_STATIC_INLINE
+void a0_transport_frame_decode(a0_transport_locked_t lk, size_t off, a0_transport_frame_view_t* out) {
+  out->hdr.seq = a0_transport_frame_seq(lk, off);
+  out->hdr.off = off;
+  out->hdr.next_off = a0_transport_frame_next(lk, off);
+  out->hdr.prev_off = a0_transport_frame_prev(lk, off);
+  out->hdr.data_size = a0_transport_frame_data_size(lk, off);
+  out->data = (a0_buf_t){a0_transport_frame_data(lk, off), out->hdr.data_size};
+}
+
 A0_STATIC_INLINE
 a0_transport_state_t* a0_transport_committed_page(a0_transport_locked_t lk) {
   a0_transport_hdr_t* hdr = a0_transport_header(lk);
@@ -72,6 +237,9 @@ a0_transport_state_t* a0_transport_committed_page(a0_transport_locked_t lk) {
 
 A0_STATIC_INLINE
 a0_transport_state_t* a0_transport_working_page(a0_transport_locked_t lk) {
+  if (lk.transport->_optimistic) {
+    return &lk.transport->_optimistic_state;
+  }
   a0_transport_hdr_t* hdr = a0_transport_header(lk);
   return &hdr->state_pages[!hdr->committed_page_idx];
 }
@@ -86,8 +254,214 @@ size_t a0_transport_workspace_off() {
   return a0_max_align(sizeof(a0_transport_hdr_t));
 }
 
-// Converts a 0.2 transport into a 0.3 transport.
-// Note: This does not allow 0.2 and 0.3 to run simultaniously.
+// Aligns a frame offset. Compact frames are only aligned for their header.
+A0_STATIC_INLINE
+size_t a0_transport_frame_align(a0_transport_locked_t lk, size_t off) {
+  if (lk.transport->_compact) {
+    const size_t align = alignof(a0_transport_compact_frame_hdr_t);
+    return (off + align - 1) & ~(align - 1);
+  }
+  return a0_max_align(off);
+}
+
+A0_STATIC_INLINE
+bool a0_transport_state_empty(const a0_transport_state_t* state) {
+  return !state->seq_high | (state->seq_low > state->seq_high);
+}
+
+// Distance between fixed slots.
+A0_STATIC_INLINE
+size_t a0_transport_slot_stride(a0_transport_locked_t lk) {
+  a0_transport_hdr_t* hdr = a0_transport_header(lk);
+  return a0_transport_frame_align(lk, a0_transport_frame_hdr_size(lk) + hdr->slot_size);
+}
+
+// Offset of the fixed slot holding the given seq.
+A0_STATIC_INLINE
+size_t a0_transport_slot_off(a0_transport_locked_t lk, uint64_t seq) {
+  a0_transport_hdr_t* hdr = a0_transport_header(lk);
+  return a0_transport_workspace_off() + ((seq - 1) % hdr->slot_cnt) * a0_transport_slot_stride(lk);
+}
+
+// Frames are indexed every A0_TRANSPORT_INDEX_STRIDE sequence numbers.
+#define A0_TRANSPORT_INDEX_STRIDE 64
+// Arenas that fit fewer frames than this have no index. Walks are short there.
+#define A0_TRANSPORT_INDEX_MIN_FRAMES (4 * A0_TRANSPORT_INDEX_STRIDE)
+
+// End of the space frames may occupy. The seq index, if any, follows it.
+// Optimistic readers may see the arena grow past the local mapping. Never
+// report space beyond it.
+A0_STATIC_INLINE
+size_t a0_transport_frames_end(a0_transport_locked_t lk) {
+  a0_transport_hdr_t* hdr = a0_transport_header(lk);
+  size_t end = hdr->index_cap ? hdr->index_off : hdr->arena_size;
+  return end < lk.transport->_map.size ? end : lk.transport->_map.size;
+}
+
+// Number of index entries for an arena of the given size.
+// There are enough that no two live frames share an entry.
+A0_STATIC_INLINE
+uint32_t a0_transport_index_cap(a0_transport_locked_t lk, size_t arena_size) {
+  if (a0_transport_header(lk)->slot_cnt || arena_size <= a0_transport_workspace_off()) {
+    return 0;
+  }
+  size_t min_frame = a0_transport_frame_align(lk, a0_transport_frame_hdr_size(lk));
+  size_t max_frames = (arena_size - a0_transport_workspace_off()) / min_frame;
+  if (max_frames < A0_TRANSPORT_INDEX_MIN_FRAMES || max_frames / A0_TRANSPORT_INDEX_STRIDE >= UINT32_MAX) {
+    return 0;
+  }
+  return (uint32_t)(max_frames / A0_TRANSPORT_INDEX_STRIDE + 1);
+}
+
+A0_STATIC_INLINE
+size_t* a0_transport_index(a0_transport_hdr_t* hdr) {
+  return (size_t*)((uint8_t*)hdr + hdr->index_off);
+}
+
+// Records the offset of a newly allocated frame, if it falls on the stride.
+A0_STATIC_INLINE
+void a0_transport_index_add(a0_transport_locked_t lk, uint64_t seq, size_t off) {
+  a0_transport_hdr_t* hdr = a0_transport_header(lk);
+  if (hdr->index_cap && !(seq % A0_TRANSPORT_INDEX_STRIDE)) {
+    a0_transport_index(hdr)[(seq / A0_TRANSPORT_INDEX_STRIDE) % hdr->index_cap] = off;
+  }
+}
+
+// Looks up the offset of the frame with the given seq, which must fall on the stride.
+// Entries may be stale, so the frame is checked before it is trusted.
+A0_NO_TSAN
+static bool a0_transport_index_find(a0_transport_locked_t lk, uint64_t seq, size_t* off) {
+  a0_transport_hdr_t* hdr = a0_transport_header(lk);
+  uint32_t cap = hdr->index_cap;
+  size_t index_off = hdr->index_off;
+  size_t hdr_size = a0_transport_frame_hdr_size(lk);
+  // Optimistic readers may race a resize. Stay within the mapping.
+  if (!cap || index_off > lk.transport->_map.size ||
+      cap > (lk.transport->_map.size - index_off) / sizeof(size_t)) {
+    return false;
+  }
+
+  *off = ((size_t*)((uint8_t*)hdr + index_off))[(seq / A0_TRANSPORT_INDEX_STRIDE) % cap];
+  return a0_transport_frame_align(lk, *off) == *off && *off >= a0_transport_workspace_off() &&
+         *off + hdr_size <= index_off && a0_transport_frame_seq(lk, *off) == seq;
+}
+
+// Sizes the index for the given arena size, and refills it from the live frames.
+A0_STATIC_INLINE
+void a0_transport_index_build(a0_transport_locked_t lk, size_t arena_size, size_t used_space) {
+  a0_transport_hdr_t* hdr = a0_transport_header(lk);
+  hdr->index_cap = a0_transport_index_cap(lk, arena_size);
+  hdr->index_off = (arena_size - hdr->index_cap * sizeof(size_t)) & ~(sizeof(size_t) - 1);
+  // Frames come first. Go without an index if they leave no room for it.
+  if (!hdr->index_cap || hdr->index_off < used_space) {
+    hdr->index_cap = 0;
+    hdr->index_off = 0;
+    return;
+  }
+
+  memset(a0_transport_index(hdr), 0, hdr->index_cap * sizeof(size_t));
+  a0_transport_state_t* state = a0_transport_working_page(lk);
+  if (a0_transport_state_empty(state)) {
+    return;
+  }
+  size_t off = state->off_head;
+  for (uint64_t seq = state->seq_low; seq <= state->seq_high; seq++) {
+    a0_transport_index_add(lk, seq, off);
+    off = a0_transport_frame_next(lk, off);
+  }
+}
+
+// Thread holding lease i, or zero if it is free.
+// The kernel clears the owner of a thread that died.
+A0_STATIC_INLINE
+uint32_t a0_transport_lease_owner(a0_transport_hdr_t* hdr, uint32_t i) {
+  return a0_ftx_tid(a0_atomic_load(&hdr->leases[i].owner.ftx));
+}
+
+// Whether any lease is held.
+A0_STATIC_INLINE
+bool a0_transport_leased(a0_transport_hdr_t* hdr) {
+  for (uint32_t i = 0; i < A0_TRANSPORT_MAX_LEASES; i++) {
+    if (a0_transport_lease_owner(hdr, i)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+A0_STATIC_INLINE
+void a0_transport_lease_mark_evicted(a0_transport_hdr_t* hdr, uint64_t seq) {
+  for (uint32_t i = 0; i < A0_TRANSPORT_MAX_LEASES; i++) {
+    if (a0_transport_lease_owner(hdr, i) && hdr->leases[i].seq == seq) {
+      hdr->lease_evicted |= 1u << i;
+    }
+  }
+}
+
+// Drops the frames newer than those in base, keeping any evictions.
+A0_STATIC_INLINE
+void a0_transport_state_truncate(a0_transport_state_t* state, const a0_transport_state_t* base) {
+  if (state->seq_low > base->seq_high) {
+    // Every frame in base was evicted.
+    state->seq_low = base->seq_high + 1;
+    state->seq_high = base->seq_high;
+    state->off_head = 0;
+    state->off_tail = 0;
+    state->high_water_mark = a0_transport_workspace_off();
+  } else {
+    state->seq_high = base->seq_high;
+    state->off_tail = base->off_tail;
+    state->high_water_mark = base->high_water_mark;
+  }
+}
+
+// Replaces an older header with a 0.4 header holding the given state.
+// The 0.4 header is larger than older ones. If any frame overlaps it, every
+// frame is dropped, since the ring cannot lose frames from its middle.
+A0_NO_TSAN
+static void a0_backward_compatiblility_rewrite_header(a0_arena_t arena,
+                                                      a0_transport_state_t state) {
+  if (state.off_head) {
+    bool overlaps = false;
+    size_t off = state.off_head;
+    while (true) {
+      if (off < a0_transport_workspace_off() ||
+          off + sizeof(a0_transport_frame_hdr_t) > arena.buf.size) {
+        overlaps = true;
+        break;
+      }
+      if (off == state.off_tail) {
+        break;
+      }
+      off = ((a0_transport_frame_hdr_t*)(arena.buf.data + off))->next_off;
+    }
+
+    if (overlaps) {
+      state.seq_low = state.seq_high + 1;
+      state.off_head = 0;
+      state.off_tail = 0;
+      state.high_water_mark = a0_transport_workspace_off();
+    }
+  } else {
+    state.high_water_mark = a0_transport_workspace_off();
+  }
+
+  a0_transport_hdr_t* hdr = (a0_transport_hdr_t*)arena.buf.data;
+  memset(hdr, 0, sizeof(a0_transport_hdr_t));
+
+  memcpy(hdr->magic, "ALEPHZERO", 9);
+  hdr->version.major = 0;
+  hdr->version.minor = 4;
+  hdr->version.patch = 0;
+
+  hdr->arena_size = arena.buf.size;
+  hdr->state_pages[0] = state;
+  hdr->state_pages[1] = state;
+  hdr->initialized = true;
+}
+
+// Converts a 0.2 transport into a 0.4 transport.
+// Note: This does not allow 0.2 and 0.4 to run simultaniously.
 //       0.2 transport will no longer work after this.
 A0_NO_TSAN
 static void a0_backward_compatiblility_update_from_0_2(a0_arena_t arena) {
@@ -101,39 +475,101 @@ static void a0_backward_compatiblility_update_from_0_2(a0_arena_t arena) {
   uint32_t page_offset = committed_page_idx ? 88 : 56;
   uint8_t* ptr = &arena.buf.data[page_offset];
 
-  uint64_t seq_low = *(uint64_t*)ptr;
+  a0_transport_state_t state;
+  state.seq_low = *(uint64_t*)ptr;
   ptr += sizeof(uint64_t);
 
-  uint64_t seq_high = *(uint64_t*)ptr;
+  state.seq_high = *(uint64_t*)ptr;
   ptr += sizeof(uint64_t);
 
-  uintptr_t off_head = *(uintptr_t*)ptr;
+  state.off_head = *(uintptr_t*)ptr;
   ptr += sizeof(uintptr_t);
 
-  uintptr_t off_tail = *(uintptr_t*)ptr;
+  state.off_tail = *(uintptr_t*)ptr;
   // ptr += sizeof(uintptr_t);
 
-  a0_transport_hdr_t* hdr = (a0_transport_hdr_t*)arena.buf.data;
-  memset(hdr, 0, sizeof(a0_transport_hdr_t));
+  state.high_water_mark = arena.buf.size;
 
-  memcpy(hdr->magic, "ALEPHZERO", 9);
-  hdr->version.major = 0;
-  hdr->version.minor = 3;
-  hdr->version.patch = 0;
+  a0_backward_compatiblility_rewrite_header(arena, state);
+}
 
-  hdr->arena_size = arena.buf.size;
-  hdr->state_pages[0].seq_low = seq_low;
-  hdr->state_pages[0].seq_high = seq_high;
-  hdr->state_pages[0].off_head = off_head;
-  hdr->state_pages[0].off_tail = off_tail;
-  hdr->state_pages[0].high_water_mark = hdr->arena_size;
+// Converts a 0.3 transport into a 0.4 transport.
+// The 0.3 header packed the mutex, condition, and state into 144 bytes.
+// Note: This does not allow 0.3 and 0.4 to run simultaniously.
+//       0.3 transport will no longer work after this.
+A0_NO_TSAN
+static void a0_backward_compatiblility_update_from_0_3(a0_arena_t arena) {
+  const uint8_t* data = arena.buf.data;
+  if (memcmp(data, "ALEPHZERO", 9) || data[9] != 0 || data[10] != 3 || !data[12]) {
+    // Not 0.3 format.
+    return;
+  }
 
-  hdr->state_pages[1] = hdr->state_pages[0];
-  hdr->initialized = true;
+  uint8_t committed_page_idx = data[128];
+
+  a0_transport_state_t state;
+  memcpy(&state, &data[48 + committed_page_idx * sizeof(a0_transport_state_t)], sizeof(state));
+
+  a0_backward_compatiblility_rewrite_header(arena, state);
 }
 
+const a0_transport_options_t A0_TRANSPORT_OPTIONS_DEFAULT = {
+    .frame_format = A0_TRANSPORT_FRAME_FORMAT_DEFAULT,
+    .slot_size = 0,
+    .lease_policy = A0_TRANSPORT_LEASE_BLOCK,
+};
+
 a0_err_t a0_transport_init(a0_transport_t* transport, a0_arena_t arena) {
+  return a0_transport_init_options(transport, arena, NULL);
+}
+
+// Formats a new transport header. Called with the lock held.
+A0_STATIC_INLINE
+a0_err_t a0_transport_create(a0_transport_locked_t lk, const a0_transport_options_t* opts) {
+  a0_transport_hdr_t* hdr = a0_transport_header(lk);
+  size_t arena_size = lk.transport->_map.size;
+
+  lk.transport->_compact = opts->frame_format == A0_TRANSPORT_FRAME_FORMAT_COMPACT;
+  if (lk.transport->_compact && arena_size > INT32_MAX) {
+    return A0_ERR_INVALID_ARG;
+  }
+
+  size_t slot_cnt = 0;
+  if (opts->slot_size) {
+    size_t stride = a0_transport_frame_align(lk, a0_transport_frame_hdr_size(lk) + opts->slot_size);
+    if (arena_size > a0_transport_workspace_off()) {
+      slot_cnt = (arena_size - a0_transport_workspace_off()) / stride;
+    }
+    if (!slot_cnt) {
+      return A0_ERR_INVALID_ARG;
+    }
+  }
+
+  memcpy(hdr->magic, "ALEPHZERO", 9);
+  hdr->version.major = 0;
+  hdr->version.minor = 4;
+  // The patch number records the frame format.
+  hdr->version.patch = (uint8_t)opts->frame_format;
+  hdr->arena_size = arena_size;
+  hdr->slot_size = opts->slot_size;
+  hdr->slot_cnt = slot_cnt;
+  hdr->lease_policy = opts->lease_policy;
+  hdr->state_pages[0].high_water_mark = a0_transport_workspace_off();
+  hdr->state_pages[1].high_water_mark = a0_transport_workspace_off();
+  a0_transport_index_build(lk, arena_size, a0_transport_workspace_off());
+  hdr->initialized = true;
+  return A0_OK;
+}
+
+a0_err_t a0_transport_init_options(a0_transport_t* transport,
+                                   a0_arena_t arena,
+                                   const a0_transport_options_t* opts) {
+  if (!opts) {
+    opts = &A0_TRANSPORT_OPTIONS_DEFAULT;
+  }
+
   a0_backward_compatiblility_update_from_0_2(arena);
+  a0_backward_compatiblility_update_from_0_3(arena);
   // The arena is expected to be either:
   // 1) all null bytes.
   //    this is guaranteed by ftruncate, as is used in a0/file.h
@@ -142,6 +578,7 @@ a0_err_t a0_transport_init(a0_transport_t* transport, a0_arena_t arena) {
 
   memset(transport, 0, sizeof(a0_transport_t));
   transport->_arena = arena;
+  transport->_map = arena.buf;
 
   if (transport->_arena.mode == A0_ARENA_MODE_EXCLUSIVE) {
     memset(&hdr->mtx, 0, sizeof(hdr->mtx));
@@ -150,20 +587,16 @@ a0_err_t a0_transport_init(a0_transport_t* transport, a0_arena_t arena) {
   a0_transport_locked_t lk;
   A0_RETURN_ERR_ON_ERR(a0_transport_lock(transport, &lk));
 
+  a0_err_t err = A0_OK;
   if (!hdr->initialized) {
-    memcpy(hdr->magic, "ALEPHZERO", 9);
-    hdr->version.major = 0;
-    hdr->version.minor = 3;
-    hdr->version.patch = 0;
-    hdr->arena_size = transport->_arena.buf.size;
-    hdr->state_pages[0].high_water_mark = a0_transport_workspace_off();
-    hdr->state_pages[1].high_water_mark = a0_transport_workspace_off();
-    hdr->initialized = true;
+    err = a0_transport_create(lk, opts);
   } else {
     // TODO(lshamis): Verify magic + version.
   }
+  transport->_compact = hdr->version.patch == A0_TRANSPORT_FRAME_FORMAT_COMPACT;
 
   a0_transport_unlock(lk);
+  A0_RETURN_ERR_ON_ERR(err);
 
   return A0_OK;
 }
@@ -171,8 +604,11 @@ a0_err_t a0_transport_init(a0_transport_t* transport, a0_arena_t arena) {
 a0_err_t a0_transport_shutdown(a0_transport_locked_t lk) {
   a0_transport_hdr_t* hdr = a0_transport_header(lk);
 
-  lk.transport->_shutdown = true;
+  a0_atomic_store(&lk.transport->_shutdown, true);
   a0_cnd_broadcast(&hdr->cnd, &hdr->mtx);
+  for (size_t i = 0; i < A0_TRANSPORT_SEQ_WAIT_BUCKETS; i++) {
+    a0_cnd_broadcast(&hdr->seq_waiters[i].cnd, &hdr->mtx);
+  }
 
   while (lk.transport->_wait_cnt) {
     a0_cnd_wait(&hdr->cnd, &hdr->mtx);
@@ -185,17 +621,100 @@ a0_err_t a0_transport_shutdown_requested(a0_transport_locked_t lk, bool* out) {
   return A0_OK;
 }
 
+// Publishes the working page without notifying waiters.
+A0_STATIC_INLINE
+void a0_transport_commit_state(a0_transport_locked_t lk) {
+  a0_transport_hdr_t* hdr = a0_transport_header(lk);
+  // Optimistic readers may be looking at either page. Mark the seqlock odd
+  // until both pages settle.
+  a0_atomic_add_fetch(&hdr->seqlock, 1);
+  a0_barrier();
+  // Assume page A was the previously committed page and page B is the working
+  // page that is ready to be committed. Both represent a valid state for the
+  // transport. It's possible that the copying of B into A will fail (prog crash),
+  // leaving A in an inconsistent state. We set B as the committed page, before
+  // copying the page info.
+  hdr->committed_page_idx = !hdr->committed_page_idx;
+  *a0_transport_working_page(lk) = *a0_transport_committed_page(lk);
+  a0_barrier();
+  a0_atomic_add_fetch(&hdr->seqlock, 1);
+}
+
+A0_STATIC_INLINE
+void a0_transport_notify(a0_transport_locked_t lk) {
+  a0_transport_hdr_t* hdr = a0_transport_header(lk);
+  lk.transport->_notify_pending = false;
+  // Waiters register under the lock, so nobody can be missed.
+  // Skip the syscall if nobody is listening.
+  if (hdr->waiter_cnt) {
+    a0_cnd_broadcast(&hdr->cnd, &hdr->mtx);
+  }
+  // Seq waiters are only woken once a seq in their bucket is committed.
+  uint64_t seq_high = a0_transport_committed_page(lk)->seq_high;
+  if (seq_high > hdr->notified_seq) {
+    uint64_t seq = hdr->notified_seq + 1;
+    if (seq_high - hdr->notified_seq > A0_TRANSPORT_SEQ_WAIT_BUCKETS) {
+      seq = seq_high - A0_TRANSPORT_SEQ_WAIT_BUCKETS + 1;
+    }
+    for (; seq <= seq_high; seq++) {
+      size_t bucket = seq % A0_TRANSPORT_SEQ_WAIT_BUCKETS;
+      if (hdr->seq_waiters[bucket].waiter_cnt) {
+        a0_cnd_broadcast(&hdr->seq_waiters[bucket].cnd, &hdr->mtx);
+      }
+    }
+    hdr->notified_seq = seq_high;
+  }
+  // Word waiters register without the lock. The barrier orders the commit
+  // before the check, pairing with the one in a0_transport_wake_register.
+  a0_barrier();
+  if (a0_atomic_load(&hdr->word_waiter_cnt)) {
+    a0_ftx_broadcast(&hdr->seqlock);
+  }
+}
+
+A0_STATIC_INLINE
+void a0_transport_commit_evictions(a0_transport_locked_t lk) {
+  // Frames allocated since the last commit may not be written yet.
+  // Publish the evictions without them.
+  a0_transport_state_t* state = a0_transport_working_page(lk);
+  a0_transport_state_t pending = *state;
+  a0_transport_state_truncate(state, a0_transport_committed_page(lk));
+
+  a0_transport_commit_state(lk);
+  *a0_transport_working_page(lk) = pending;
+  lk.transport->_notify_pending = true;
+}
+
 a0_err_t a0_transport_lock(a0_transport_t* transport, a0_transport_locked_t* lk_out) {
   lk_out->transport = transport;
+  transport->_notify_pending = false;
 
   if (transport->_arena.mode != A0_ARENA_MODE_SHARED) {
     return A0_OK;
   }
 
-  a0_transport_hdr_t* hdr = a0_transport_header(*lk_out);
+  a0_transport_hdr_t* hdr;
+  while (true) {
+    hdr = a0_transport_header(*lk_out);
+    a0_err_t prior_owner_died = a0_mtx_lock(&hdr->mtx);
+    A0_MAYBE_UNUSED(prior_owner_died);
+
+    size_t arena_size = hdr->arena_size;
+    if (arena_size <= transport->_map.size) {
+      break;
+    }
+    // Another connection grew the arena past this one's mapping. Map the rest
+    // before touching it. The mutex must be unlocked through the address it
+    // was locked through, so lock again through the new mapping.
+    a0_mtx_unlock(&hdr->mtx);
+    A0_RETURN_ERR_ON_ERR(a0_file_map_fit(&transport->_map, arena_size));
+  }
 
-  a0_err_t prior_owner_died = a0_mtx_lock(&hdr->mtx);
-  A0_MAYBE_UNUSED(prior_owner_died);
+  // The previous owner died mid-commit. The committed page is still
+  // consistent, so simply close out the seqlock.
+  if (a0_atomic_load(&hdr->seqlock) & 1) {
+    a0_atomic_add_fetch(&hdr->seqlock, 1);
+  }
 
   // Clear any incomplete changes.
   *a0_transport_working_page(*lk_out) = *a0_transport_committed_page(*lk_out);
@@ -204,6 +723,17 @@ a0_err_t a0_transport_lock(a0_transport_t* transport, a0_transport_locked_t* lk_
 }
 
 a0_err_t a0_transport_unlock(a0_transport_locked_t lk) {
+  if (lk.transport->_optimistic) {
+    return A0_MAKE_SYSERR(EPERM);
+  }
+  if (lk.transport->_batch) {
+    // Only discard the frames allocated since the last deferred commit.
+    a0_transport_state_truncate(a0_transport_working_page(lk), &lk.transport->_batch_state);
+    return A0_OK;
+  }
+  if (lk.transport->_notify_pending) {
+    a0_transport_notify(lk);
+  }
   if (lk.transport->_arena.mode != A0_ARENA_MODE_SHARED) {
     return A0_OK;
   }
@@ -214,9 +744,85 @@ a0_err_t a0_transport_unlock(a0_transport_locked_t lk) {
   return A0_OK;
 }
 
+// Number of times an optimistic reader will spin on an in-progress commit
+// before suspecting the committer died mid-commit.
+static const uint32_t A0_TRANSPORT_OPTIMISTIC_SPIN_LIMIT = 1 << 16;
+
+A0_NO_TSAN
+a0_err_t a0_transport_optimistic_begin(a0_transport_t* transport, a0_transport_locked_t* lk_out) {
+  lk_out->transport = transport;
+  a0_transport_hdr_t* hdr = a0_transport_header(*lk_out);
+
+  // Another connection may have grown the arena past this one's mapping.
+  // Growth can also race the read. Bounds checks use the mapped size.
+  size_t arena_size = a0_atomic_load(&hdr->arena_size);
+  if (arena_size > transport->_map.size) {
+    A0_RETURN_ERR_ON_ERR(a0_file_map_fit(&transport->_map, arena_size));
+    hdr = a0_transport_header(*lk_out);
+  }
+
+  uint32_t spins = 0;
+  while (true) {
+    uint32_t seqlock = a0_atomic_load(&hdr->seqlock);
+    if (seqlock & 1) {
+      // A commit is in progress. Commits only copy a single page, so this
+      // resolves quickly, unless the committer died. Cycling the lock
+      // repairs the seqlock in that case.
+      if (++spins == A0_TRANSPORT_OPTIMISTIC_SPIN_LIMIT) {
+        a0_transport_locked_t repair_lk;
+        A0_RETURN_ERR_ON_ERR(a0_transport_lock(transport, &repair_lk));
+        a0_transport_unlock(repair_lk);
+        spins = 0;
+      }
+      continue;
+    }
+    a0_barrier();
+    transport->_optimistic_state = *a0_transport_committed_page(*lk_out);
+    a0_barrier();
+    if (a0_atomic_load(&hdr->seqlock) == seqlock) {
+      transport->_optimistic_seqlock = seqlock;
+      break;
+    }
+  }
+
+  transport->_optimistic = true;
+  return A0_OK;
+}
+
+a0_err_t a0_transport_optimistic_validate(a0_transport_locked_t lk) {
+  if (!lk.transport->_optimistic) {
+    return A0_ERR_INVALID_ARG;
+  }
+  a0_transport_hdr_t* hdr = a0_transport_header(lk);
+  a0_barrier();
+  if (a0_atomic_load(&hdr->seqlock) != lk.transport->_optimistic_seqlock) {
+    return A0_ERR_AGAIN;
+  }
+  return A0_OK;
+}
+
+a0_err_t a0_transport_optimistic_end(a0_transport_locked_t lk) {
+  a0_err_t err = a0_transport_optimistic_validate(lk);
+  lk.transport->_optimistic = false;
+  return err;
+}
+
+// Checks that an optimistic reader can safely dereference the frame at the given offset.
+// A frame that fails this check was overwritten mid-read.
+A0_STATIC_INLINE
+bool a0_transport_optimistic_frame_ok(a0_transport_locked_t lk, size_t off, uint64_t seq) {
+  size_t hdr_size = a0_transport_frame_hdr_size(lk);
+  size_t end = a0_transport_frames_end(lk);
+  if (a0_transport_frame_align(lk, off) != off || off < a0_transport_workspace_off() ||
+      off + hdr_size > end) {
+    return false;
+  }
+  return a0_transport_frame_seq(lk, off) == seq &&
+         a0_transport_frame_data_size(lk, off) <= end - off - hdr_size;
+}
+
 a0_err_t a0_transport_empty(a0_transport_locked_t lk, bool* out) {
-  a0_transport_state_t* working_page = a0_transport_working_page(lk);
-  *out = !working_page->seq_high | (working_page->seq_low > working_page->seq_high);
+  *out = a0_transport_state_empty(a0_transport_working_page(lk));
   return A0_OK;
 }
 
@@ -234,22 +840,21 @@ a0_err_t a0_transport_iter_valid(a0_transport_locked_t lk, bool* out) {
 }
 
 a0_err_t a0_transport_jump(a0_transport_locked_t lk, size_t off) {
-  if (a0_max_align(off) != off) {
+  if (a0_transport_frame_align(lk, off) != off) {
     return A0_ERR_RANGE;
   }
 
-  a0_transport_hdr_t* hdr = a0_transport_header(lk);
-  if (off + sizeof(a0_transport_frame_hdr_t) >= hdr->arena_size) {
+  size_t hdr_size = a0_transport_frame_hdr_size(lk);
+  if (off + hdr_size >= a0_transport_frames_end(lk)) {
     return A0_ERR_RANGE;
   }
 
-  a0_transport_frame_hdr_t* frame_hdr = a0_transport_frame_header(lk, off);
-  if (off + sizeof(a0_transport_frame_hdr_t) + frame_hdr->data_size >= hdr->arena_size) {
+  if (off + hdr_size + a0_transport_frame_data_size(lk, off) >= a0_transport_frames_end(lk)) {
     return A0_ERR_RANGE;
   }
 
   lk.transport->_off = off;
-  lk.transport->_seq = frame_hdr->seq;
+  lk.transport->_seq = a0_transport_frame_seq(lk, off);
   return A0_OK;
 }
 
@@ -281,6 +886,62 @@ a0_err_t a0_transport_jump_tail(a0_transport_locked_t lk) {
   return A0_OK;
 }
 
+a0_err_t a0_transport_jump_seq(a0_transport_locked_t lk, uint64_t seq) {
+  a0_transport_state_t* state = a0_transport_working_page(lk);
+
+  bool empty;
+  A0_RETURN_ERR_ON_ERR(a0_transport_empty(lk, &empty));
+  if (empty || seq < state->seq_low || seq > state->seq_high) {
+    return A0_ERR_RANGE;
+  }
+
+  // Fixed slots are addressed directly.
+  if (a0_transport_header(lk)->slot_cnt) {
+    lk.transport->_seq = seq;
+    lk.transport->_off = a0_transport_slot_off(lk, seq);
+    return A0_OK;
+  }
+
+  // Start from the closest indexed frame, if it is still live.
+  uint64_t indexed_seq = seq - seq % A0_TRANSPORT_INDEX_STRIDE;
+  size_t indexed_off;
+  if (indexed_seq >= state->seq_low && a0_transport_index_find(lk, indexed_seq, &indexed_off)) {
+    lk.transport->_seq = indexed_seq;
+    lk.transport->_off = indexed_off;
+    while (lk.transport->_seq < seq) {
+      A0_RETURN_ERR_ON_ERR(a0_transport_step_next(lk));
+    }
+    return A0_OK;
+  }
+
+  // Frames are only linked to their neighbors. Start the walk from the
+  // closest known frame.
+  uint64_t dist = seq - state->seq_low;
+  bool from_head = true;
+  if (state->seq_high - seq < dist) {
+    dist = state->seq_high - seq;
+    from_head = false;
+  }
+
+  bool valid;
+  A0_RETURN_ERR_ON_ERR(a0_transport_iter_valid(lk, &valid));
+  uint64_t curr_seq = lk.transport->_seq;
+  bool from_curr = valid && (curr_seq > seq ? curr_seq - seq : seq - curr_seq) < dist;
+
+  if (!from_curr) {
+    A0_RETURN_ERR_ON_ERR(from_head ? a0_transport_jump_head(lk) : a0_transport_jump_tail(lk));
+  }
+
+  while (lk.transport->_seq < seq) {
+    A0_RETURN_ERR_ON_ERR(a0_transport_step_next(lk));
+  }
+  while (lk.transport->_seq > seq) {
+    A0_RETURN_ERR_ON_ERR(a0_transport_step_prev(lk));
+  }
+
+  return A0_OK;
+}
+
 a0_err_t a0_transport_has_next(a0_transport_locked_t lk, bool* out) {
   bool empty;
   A0_RETURN_ERR_ON_ERR(a0_transport_empty(lk, &empty));
@@ -290,6 +951,22 @@ a0_err_t a0_transport_has_next(a0_transport_locked_t lk, bool* out) {
   return A0_OK;
 }
 
+A0_NO_TSAN
+static a0_err_t a0_transport_optimistic_step(a0_transport_locked_t lk, bool forward) {
+  if (!a0_transport_optimistic_frame_ok(lk, lk.transport->_off, lk.transport->_seq)) {
+    return A0_ERR_AGAIN;
+  }
+  size_t off = forward ? a0_transport_frame_next(lk, lk.transport->_off)
+                       : a0_transport_frame_prev(lk, lk.transport->_off);
+  uint64_t seq = forward ? lk.transport->_seq + 1 : lk.transport->_seq - 1;
+  if (!a0_transport_optimistic_frame_ok(lk, off, seq)) {
+    return A0_ERR_AGAIN;
+  }
+  lk.transport->_off = off;
+  lk.transport->_seq = seq;
+  return A0_OK;
+}
+
 a0_err_t a0_transport_step_next(a0_transport_locked_t lk) {
   a0_transport_state_t* state = a0_transport_working_page(lk);
 
@@ -305,8 +982,12 @@ a0_err_t a0_transport_step_next(a0_transport_locked_t lk) {
     return A0_OK;
   }
 
-  lk.transport->_off = a0_transport_frame_header(lk, lk.transport->_off)->next_off;
-  lk.transport->_seq = a0_transport_frame_header(lk, lk.transport->_off)->seq;
+  if (lk.transport->_optimistic) {
+    return a0_transport_optimistic_step(lk, true);
+  }
+
+  lk.transport->_off = a0_transport_frame_next(lk, lk.transport->_off);
+  lk.transport->_seq = a0_transport_frame_seq(lk, lk.transport->_off);
 
   return A0_OK;
 }
@@ -327,35 +1008,127 @@ a0_err_t a0_transport_step_prev(a0_transport_locked_t lk) {
     return A0_ERR_RANGE;
   }
 
-  lk.transport->_off = a0_transport_frame_header(lk, lk.transport->_off)->prev_off;
-  lk.transport->_seq = a0_transport_frame_header(lk, lk.transport->_off)->seq;
+  if (lk.transport->_optimistic) {
+    return a0_transport_optimistic_step(lk, false);
+  }
+
+  lk.transport->_off = a0_transport_frame_prev(lk, lk.transport->_off);
+  lk.transport->_seq = a0_transport_frame_seq(lk, lk.transport->_off);
+
+  return A0_OK;
+}
+
+A0_STATIC_INLINE
+bool a0_transport_timedwait_istimeout(a0_time_mono_t* timeout) {
+  if (!timeout) {
+    return false;
+  }
+
+  a0_time_mono_t now;
+  a0_time_mono_now(&now);
+
+  uint64_t now_ns = now.ts.tv_sec * NS_PER_SEC + now.ts.tv_nsec;
+  uint64_t timeout_ns = timeout->ts.tv_sec * NS_PER_SEC + timeout->ts.tv_nsec;
+
+  return now_ns >= timeout_ns;
+}
 
+a0_err_t a0_transport_set_spin(a0_transport_t* transport, int64_t spin_ns) {
+  if (spin_ns < 0) {
+    return A0_ERR_INVALID_ARG;
+  }
+  transport->_spin_ns = spin_ns;
   return A0_OK;
 }
 
+// Relocks a transport the caller had unlocked.
+//
+// Waits must return with the lock held, whatever happens. If the arena grew
+// and the rest can't be mapped, the lock is taken through the current mapping
+// and the error returned. The caller must not read past the mapping.
 A0_STATIC_INLINE
-bool a0_transport_timedwait_istimeout(a0_time_mono_t* timeout) {
-  if (!timeout) {
-    return false;
+a0_err_t a0_transport_relock(a0_transport_locked_t* lk) {
+  a0_err_t err = a0_transport_lock(lk->transport, lk);
+  if (err) {
+    a0_err_t prior_owner_died = a0_mtx_lock(&a0_transport_header(*lk)->mtx);
+    A0_MAYBE_UNUSED(prior_owner_died);
   }
+  return err;
+}
+
+// Busy-polls the commit counter, with the lock released, until the predicate
+// is satisfied or the spin budget runs out.
+A0_STATIC_INLINE
+a0_err_t a0_transport_spin(a0_transport_locked_t lk, a0_predicate_t pred, a0_time_mono_t* timeout, bool* sat) {
+  a0_transport_hdr_t* hdr = a0_transport_header(lk);
 
   a0_time_mono_t now;
   a0_time_mono_now(&now);
-
   uint64_t now_ns = now.ts.tv_sec * NS_PER_SEC + now.ts.tv_nsec;
-  uint64_t timeout_ns = timeout->ts.tv_sec * NS_PER_SEC + timeout->ts.tv_nsec;
+  uint64_t spin_ns = (uint64_t)lk.transport->_spin_ns;
+  uint64_t deadline_ns = spin_ns > UINT64_MAX - now_ns ? UINT64_MAX : now_ns + spin_ns;
 
-  return now_ns >= timeout_ns;
+  uint32_t seqlock = a0_atomic_load(&hdr->seqlock);
+  a0_transport_unlock(lk);
+
+  a0_err_t err = A0_OK;
+  while (true) {
+    a0_cpu_relax();
+
+    if (a0_atomic_load(&lk.transport->_shutdown)) {
+      A0_RETURN_ERR_ON_ERR(a0_transport_relock(&lk));
+      err = a0_predicate_eval(pred, sat);
+      break;
+    }
+
+    if (a0_atomic_load(&hdr->seqlock) != seqlock) {
+      A0_RETURN_ERR_ON_ERR(a0_transport_relock(&lk));
+      err = a0_predicate_eval(pred, sat);
+      if (err | *sat) {
+        break;
+      }
+      seqlock = a0_atomic_load(&hdr->seqlock);
+      a0_transport_unlock(lk);
+    }
+
+    a0_time_mono_now(&now);
+    now_ns = now.ts.tv_sec * NS_PER_SEC + now.ts.tv_nsec;
+    if (now_ns >= deadline_ns || a0_transport_timedwait_istimeout(timeout)) {
+      // A commit may have landed since the last look at the counter. Its
+      // notify found no registered waiter, so check before blocking.
+      A0_RETURN_ERR_ON_ERR(a0_transport_relock(&lk));
+      err = a0_predicate_eval(pred, sat);
+      break;
+    }
+  }
+  return err;
 }
 
-a0_err_t a0_transport_timedwait(a0_transport_locked_t lk, a0_predicate_t pred, a0_time_mono_t* timeout) {
+// Condition to block on until a commit may satisfy the waiter.
+// Waiters whose seq is already committed wait on every commit.
+A0_STATIC_INLINE
+void a0_transport_wait_queue(a0_transport_locked_t lk, uint64_t seq, a0_cnd_t** cnd, uint32_t** waiter_cnt) {
+  a0_transport_hdr_t* hdr = a0_transport_header(lk);
+  if (seq > a0_transport_committed_page(lk)->seq_high) {
+    size_t bucket = seq % A0_TRANSPORT_SEQ_WAIT_BUCKETS;
+    *cnd = &hdr->seq_waiters[bucket].cnd;
+    *waiter_cnt = &hdr->seq_waiters[bucket].waiter_cnt;
+  } else {
+    *cnd = &hdr->cnd;
+    *waiter_cnt = &hdr->waiter_cnt;
+  }
+}
+
+a0_err_t a0_transport_timedwait_seq(a0_transport_locked_t lk,
+                                    uint64_t seq,
+                                    a0_predicate_t pred,
+                                    a0_time_mono_t* timeout) {
   if (lk.transport->_shutdown) {
     return A0_MAKE_SYSERR(ESHUTDOWN);
   }
-  if (lk.transport->_arena.mode != A0_ARENA_MODE_SHARED) {
+  if (lk.transport->_arena.mode != A0_ARENA_MODE_SHARED || lk.transport->_optimistic) {
     return A0_MAKE_SYSERR(EPERM);
   }
-  a0_transport_hdr_t* hdr = a0_transport_header(lk);
 
   bool sat = false;
   a0_err_t err = a0_transport_timedwait_istimeout(timeout) ? A0_MAKE_SYSERR(ETIMEDOUT) : a0_predicate_eval(pred, &sat);
@@ -363,33 +1136,101 @@ a0_err_t a0_transport_timedwait(a0_transport_locked_t lk, a0_predicate_t pred, a
     return err;
   }
 
+  if (lk.transport->_notify_pending) {
+    a0_transport_notify(lk);
+  }
+
   lk.transport->_wait_cnt++;
 
-  while (!lk.transport->_shutdown) {
-    err = a0_cnd_timedwait(&hdr->cnd, &hdr->mtx, timeout);
+  if (lk.transport->_spin_ns) {
+    err = a0_transport_spin(lk, pred, timeout, &sat);
+  }
+
+  while (!(err | sat) && !lk.transport->_shutdown) {
+    // Registration is redone on every wakeup, since the queue depends on
+    // what has been committed.
+    // The spin, or a previous wakeup, may have moved the mapping.
+    a0_transport_hdr_t* hdr = a0_transport_header(lk);
+    a0_cnd_t* cnd;
+    uint32_t* waiter_cnt;
+    a0_transport_wait_queue(lk, seq, &cnd, &waiter_cnt);
+    (*waiter_cnt)++;
+    err = a0_cnd_timedwait(cnd, &hdr->mtx, timeout);
+    (*waiter_cnt)--;
+
+    // The wakeup relocked through hdr. If the arena grew, or another thread
+    // on this connection remapped it meanwhile, relock through a mapping
+    // that fits.
+    if (hdr != a0_transport_header(lk) || hdr->arena_size > lk.transport->_map.size) {
+      a0_mtx_unlock(&hdr->mtx);
+      a0_err_t lock_err = a0_transport_relock(&lk);
+      if (lock_err) {
+        err = lock_err;
+        break;
+      }
+    }
     if (A0_SYSERR(err) == ETIMEDOUT) {
       break;
     }
 
     err = a0_transport_timedwait_istimeout(timeout) ? A0_MAKE_SYSERR(ETIMEDOUT) : a0_predicate_eval(pred, &sat);
-    if (err | sat) {
-      break;
-    }
   }
   if (!err && lk.transport->_shutdown) {
     err = A0_MAKE_SYSERR(ESHUTDOWN);
   }
 
   lk.transport->_wait_cnt--;
-  a0_cnd_broadcast(&hdr->cnd, &hdr->mtx);
+  // Only a shutdown waits for waiters to leave.
+  if (lk.transport->_shutdown) {
+    a0_transport_hdr_t* hdr = a0_transport_header(lk);
+    a0_cnd_broadcast(&hdr->cnd, &hdr->mtx);
+  }
 
   return err;
 }
 
+a0_err_t a0_transport_wake_word(a0_transport_t* transport, uint32_t** out) {
+  if (transport->_arena.mode != A0_ARENA_MODE_SHARED) {
+    return A0_MAKE_SYSERR(EPERM);
+  }
+  a0_transport_hdr_t* hdr = (a0_transport_hdr_t*)transport->_map.data;
+  *out = &hdr->seqlock;
+  return A0_OK;
+}
+
+a0_err_t a0_transport_wake_register(a0_transport_t* transport) {
+  if (transport->_arena.mode != A0_ARENA_MODE_SHARED) {
+    return A0_MAKE_SYSERR(EPERM);
+  }
+  a0_transport_hdr_t* hdr = (a0_transport_hdr_t*)transport->_map.data;
+  a0_atomic_add_fetch(&hdr->word_waiter_cnt, 1);
+  // Pairs with the barrier in a0_transport_notify. Either the committer sees
+  // the registration, or the caller's next look at the word sees the commit.
+  a0_barrier();
+  return A0_OK;
+}
+
+a0_err_t a0_transport_wake_unregister(a0_transport_t* transport) {
+  if (transport->_arena.mode != A0_ARENA_MODE_SHARED) {
+    return A0_MAKE_SYSERR(EPERM);
+  }
+  a0_transport_hdr_t* hdr = (a0_transport_hdr_t*)transport->_map.data;
+  a0_atomic_fetch_add(&hdr->word_waiter_cnt, (uint32_t)-1);
+  return A0_OK;
+}
+
+a0_err_t a0_transport_timedwait(a0_transport_locked_t lk, a0_predicate_t pred, a0_time_mono_t* timeout) {
+  return a0_transport_timedwait_seq(lk, 0, pred, timeout);
+}
+
 a0_err_t a0_transport_wait(a0_transport_locked_t lk, a0_predicate_t pred) {
   return a0_transport_timedwait(lk, pred, A0_TIMEOUT_NEVER);
 }
 
+a0_err_t a0_transport_wait_seq(a0_transport_locked_t lk, uint64_t seq, a0_predicate_t pred) {
+  return a0_transport_timedwait_seq(lk, seq, pred, A0_TIMEOUT_NEVER);
+}
+
 A0_STATIC_INLINE
 a0_err_t a0_transport_empty_pred_fn(void* user_data, bool* out) {
   return a0_transport_empty(*(a0_transport_locked_t*)user_data, out);
@@ -426,6 +1267,57 @@ a0_predicate_t a0_transport_has_next_pred(a0_transport_locked_t* lk) {
   };
 }
 
+a0_err_t a0_transport_lease(a0_transport_locked_t lk, a0_transport_lease_t* lease_out) {
+  if (lk.transport->_optimistic) {
+    return A0_MAKE_SYSERR(EPERM);
+  }
+  bool valid;
+  A0_RETURN_ERR_ON_ERR(a0_transport_iter_valid(lk, &valid));
+  if (!valid || a0_transport_state_empty(a0_transport_working_page(lk))) {
+    return A0_ERR_RANGE;
+  }
+
+  a0_transport_hdr_t* hdr = a0_transport_header(lk);
+  for (uint32_t i = 0; i < A0_TRANSPORT_MAX_LEASES; i++) {
+    // Leases of dead threads are taken over.
+    if (a0_mtx_lock_successful(a0_mtx_trylock(&hdr->leases[i].owner))) {
+      hdr->leases[i].seq = lk.transport->_seq;
+      hdr->lease_evicted &= ~(1u << i);
+      *lease_out = (a0_transport_lease_t){
+          ._seq = lk.transport->_seq,
+          ._idx = i,
+      };
+      return A0_OK;
+    }
+  }
+  return A0_ERR_AGAIN;
+}
+
+a0_err_t a0_transport_lease_release(a0_transport_locked_t lk, a0_transport_lease_t lease) {
+  if (lk.transport->_optimistic) {
+    return A0_MAKE_SYSERR(EPERM);
+  }
+  if (lease._idx >= A0_TRANSPORT_MAX_LEASES) {
+    return A0_ERR_INVALID_ARG;
+  }
+
+  a0_transport_hdr_t* hdr = a0_transport_header(lk);
+  uint32_t bit = 1u << lease._idx;
+  a0_transport_lease_slot_t* slot = &hdr->leases[lease._idx];
+  // Only the leasing thread can release the lease.
+  bool held = slot->seq == lease._seq && !a0_mtx_unlock(&slot->owner);
+  bool evicted = !held || (hdr->lease_evicted & bit);
+  if (held) {
+    hdr->lease_evicted &= ~bit;
+  }
+
+  // Wake any writer blocked on this lease.
+  if (hdr->lease_policy == A0_TRANSPORT_LEASE_BLOCK) {
+    lk.transport->_notify_pending = true;
+  }
+  return evicted ? A0_ERR_EVICTED : A0_OK;
+}
+
 a0_err_t a0_transport_seq_low(a0_transport_locked_t lk, uint64_t* out) {
   a0_transport_state_t* state = a0_transport_working_page(lk);
   *out = state->seq_low;
@@ -438,23 +1330,60 @@ a0_err_t a0_transport_seq_high(a0_transport_locked_t lk, uint64_t* out) {
   return A0_OK;
 }
 
+a0_err_t a0_transport_slot_size(a0_transport_locked_t lk, size_t* out) {
+  *out = a0_transport_header(lk)->slot_size;
+  return A0_OK;
+}
+
 a0_err_t a0_transport_frame(a0_transport_locked_t lk, a0_transport_frame_t** frame_out) {
+  if (lk.transport->_compact) {
+    return A0_ERR_INVALID_ARG;
+  }
+
   a0_transport_state_t* state = a0_transport_working_page(lk);
 
   if (lk.transport->_seq < state->seq_low) {
     return A0_MAKE_SYSERR(ESPIPE);
   }
 
+  if (lk.transport->_optimistic &&
+      !a0_transport_optimistic_frame_ok(lk, lk.transport->_off, lk.transport->_seq)) {
+    return A0_ERR_AGAIN;
+  }
+
   a0_transport_frame_hdr_t* frame_hdr = a0_transport_frame_header(lk, lk.transport->_off);
 
   *frame_out = (a0_transport_frame_t*)frame_hdr;
   return A0_OK;
 }
 
+A0_NO_TSAN
+a0_err_t a0_transport_frame_view(a0_transport_locked_t lk, a0_transport_frame_view_t* view_out) {
+  a0_transport_state_t* state = a0_transport_working_page(lk);
+
+  if (lk.transport->_seq < state->seq_low) {
+    return A0_MAKE_SYSERR(ESPIPE);
+  }
+
+  size_t off = lk.transport->_off;
+  if (lk.transport->_optimistic &&
+      !a0_transport_optimistic_frame_ok(lk, off, lk.transport->_seq)) {
+    return A0_ERR_AGAIN;
+  }
+
+  size_t hdr_size = a0_transport_frame_hdr_size(lk);
+
+  a0_transport_frame_decode(lk, off, view_out);
+  // An optimistic reader may see the size change after the check above.
+  if (view_out->hdr.data_size > a0_transport_frames_end(lk) - off - hdr_size) {
+    return A0_ERR_AGAIN;
+  }
+  return A0_OK;
+}
+
 A0_STATIC_INLINE
 size_t a0_transport_frame_end(a0_transport_locked_t lk, size_t frame_off) {
-  a0_transport_frame_hdr_t* frame_hdr = a0_transport_frame_header(lk, frame_off);
-  return frame_off + sizeof(a0_transport_frame_hdr_t) + frame_hdr->data_size;
+  return frame_off + a0_transport_frame_hdr_size(lk) + a0_transport_frame_data_size(lk, frame_off);
 }
 
 A0_STATIC_INLINE
@@ -472,15 +1401,12 @@ bool a0_transport_head_interval(a0_transport_locked_t lk,
                                 a0_transport_state_t* state,
                                 size_t* head_off,
                                 size_t* head_size) {
-  bool empty;
-  a0_transport_empty(lk, &empty);
-  if (empty) {
+  if (a0_transport_state_empty(state)) {
     return false;
   }
 
   *head_off = state->off_head;
-  a0_transport_frame_hdr_t* head_hdr = a0_transport_frame_header(lk, *head_off);
-  *head_size = sizeof(a0_transport_frame_hdr_t) + head_hdr->data_size;
+  *head_size = a0_transport_frame_end(lk, *head_off) - *head_off;
   return true;
 }
 
@@ -491,19 +1417,18 @@ void a0_transport_remove_head(a0_transport_locked_t lk, a0_transport_state_t* st
     state->off_tail = 0;
     state->high_water_mark = a0_transport_workspace_off();
   } else {
-    a0_transport_frame_hdr_t* head_hdr = a0_transport_frame_header(lk, state->off_head);
-    state->off_head = head_hdr->next_off;
+    size_t head_off = state->off_head;
+    state->off_head = a0_transport_frame_next(lk, head_off);
 
     // Check whether the old head frame was responsible for the high water mark.
-    size_t head_end = a0_transport_frame_end(lk, head_hdr->off);
-    if (state->high_water_mark == head_end) {
+    // Fixed slots keep the mark at the end of the highest slot in use.
+    size_t head_end = a0_transport_frame_end(lk, head_off);
+    if (!a0_transport_header(lk)->slot_cnt && state->high_water_mark == head_end) {
       // The high water mark is always set by a tail element.
       state->high_water_mark = a0_transport_frame_end(lk, state->off_tail);
     }
   }
   state->seq_low++;
-
-  a0_transport_commit(lk);
 }
 
 A0_STATIC_INLINE
@@ -511,19 +1436,27 @@ a0_err_t a0_transport_find_slot(a0_transport_locked_t lk, size_t frame_size, siz
   a0_transport_hdr_t* hdr = a0_transport_header(lk);
   a0_transport_state_t* state = a0_transport_working_page(lk);
 
+  if (hdr->slot_cnt) {
+    if (frame_size > a0_transport_frame_hdr_size(lk) + hdr->slot_size) {
+      return A0_ERR_FRAME_LARGE;
+    }
+    *off = a0_transport_slot_off(lk, state->seq_high + 1);
+    return A0_OK;
+  }
+
   bool empty;
   A0_RETURN_ERR_ON_ERR(a0_transport_empty(lk, &empty));
 
   if (empty) {
     *off = a0_transport_workspace_off();
   } else {
-    *off = a0_max_align(a0_transport_frame_end(lk, state->off_tail));
-    if (*off + frame_size >= hdr->arena_size) {
+    *off = a0_transport_frame_align(lk, a0_transport_frame_end(lk, state->off_tail));
+    if (*off + frame_size >= a0_transport_frames_end(lk)) {
       *off = a0_transport_workspace_off();
     }
   }
 
-  if (*off + frame_size > hdr->arena_size) {
+  if (*off + frame_size > a0_transport_frames_end(lk)) {
     return A0_ERR_FRAME_LARGE;
   }
 
@@ -531,8 +1464,16 @@ a0_err_t a0_transport_find_slot(a0_transport_locked_t lk, size_t frame_size, siz
 }
 
 A0_STATIC_INLINE
-bool a0_transport_slot_evicts(a0_transport_locked_t lk, size_t off, size_t frame_size) {
-  a0_transport_state_t* state = a0_transport_working_page(lk);
+bool a0_transport_slot_evicts(a0_transport_locked_t lk,
+                              a0_transport_state_t* state,
+                              size_t off,
+                              size_t frame_size) {
+  a0_transport_hdr_t* hdr = a0_transport_header(lk);
+
+  // Fixed slots only evict when every slot is full.
+  if (hdr->slot_cnt) {
+    return !a0_transport_state_empty(state) && state->seq_high - state->seq_low + 1 >= hdr->slot_cnt;
+  }
 
   size_t head_off;
   size_t head_size;
@@ -558,80 +1499,179 @@ bool a0_transport_slot_evicts(a0_transport_locked_t lk, size_t off, size_t frame
   return false;
 }
 
+// Whether an allocation at off would evict a leased frame.
+// Leases held by skip_tid, and by dead threads, are ignored.
+A0_STATIC_INLINE
+bool a0_transport_lease_blocks(a0_transport_locked_t lk, size_t off, size_t frame_size, a0_tid_t skip_tid) {
+  a0_transport_hdr_t* hdr = a0_transport_header(lk);
+  a0_transport_state_t state = *a0_transport_working_page(lk);
+
+  uint64_t min_seq = UINT64_MAX;
+  for (uint32_t i = 0; i < A0_TRANSPORT_MAX_LEASES; i++) {
+    uint32_t owner = a0_transport_lease_owner(hdr, i);
+    uint64_t seq = hdr->leases[i].seq;
+    if (owner && owner != skip_tid && seq >= state.seq_low && seq < min_seq) {
+      min_seq = seq;
+    }
+  }
+  if (min_seq == UINT64_MAX) {
+    return false;
+  }
+
+  // Replay the evictions on a copy of the state. Frames are evicted in order.
+  while (a0_transport_slot_evicts(lk, &state, off, frame_size)) {
+    if (state.seq_low == min_seq) {
+      return true;
+    }
+    a0_transport_remove_head(lk, &state);
+  }
+  return false;
+}
+
+typedef struct a0_transport_lease_pred_data_s {
+  a0_transport_locked_t* lk;
+  size_t frame_size;
+} a0_transport_lease_pred_data_t;
+
+A0_STATIC_INLINE
+a0_err_t a0_transport_lease_pred_fn(void* user_data, bool* out) {
+  a0_transport_lease_pred_data_t* data = (a0_transport_lease_pred_data_t*)user_data;
+  size_t off;
+  // Slot errors are left for the allocation to report.
+  *out = a0_transport_find_slot(*data->lk, data->frame_size, &off) ||
+         !a0_transport_lease_blocks(*data->lk, off, data->frame_size, a0_tid());
+  return A0_OK;
+}
+
+// Applies the lease policy to an allocation at off.
+// The offset is recomputed if the allocation had to wait.
+A0_STATIC_INLINE
+a0_err_t a0_transport_lease_await(a0_transport_locked_t lk, size_t frame_size, size_t* off) {
+  a0_transport_hdr_t* hdr = a0_transport_header(lk);
+  if (hdr->lease_policy == A0_TRANSPORT_LEASE_OVERWRITE || !a0_transport_leased(hdr)) {
+    return A0_OK;
+  }
+
+  if (hdr->lease_policy == A0_TRANSPORT_LEASE_FAIL) {
+    return a0_transport_lease_blocks(lk, *off, frame_size, 0) ? A0_ERR_AGAIN : A0_OK;
+  }
+
+  // Never wait on ourselves.
+  if (!a0_transport_lease_blocks(lk, *off, frame_size, a0_tid())) {
+    return A0_OK;
+  }
+
+  // Waiting unlocks the transport, which would discard uncommitted frames.
+  if (lk.transport->_batch ||
+      memcmp(a0_transport_working_page(lk), a0_transport_committed_page(lk), sizeof(a0_transport_state_t))) {
+    return A0_ERR_AGAIN;
+  }
+
+  a0_transport_lease_pred_data_t pred_data = {&lk, frame_size};
+  A0_RETURN_ERR_ON_ERR(a0_transport_wait(lk, (a0_predicate_t){&pred_data, a0_transport_lease_pred_fn}));
+  return a0_transport_find_slot(lk, frame_size, off);
+}
+
 A0_STATIC_INLINE
 void a0_transport_evict(a0_transport_locked_t lk, size_t off, size_t frame_size) {
+  // The evicted frames are only removed from the working page. Their memory is
+  // untouched until the single commit below publishes the whole run, so the
+  // committed page stays valid if we crash part way through.
+  // Waiters are notified by the next commit or unlock.
+  a0_transport_hdr_t* hdr = a0_transport_header(lk);
   a0_transport_state_t* state = a0_transport_working_page(lk);
-  while (a0_transport_slot_evicts(lk, off, frame_size)) {
+  bool leased = a0_transport_leased(hdr);
+  bool evicted = false;
+  while (a0_transport_slot_evicts(lk, state, off, frame_size)) {
+    if (leased) {
+      a0_transport_lease_mark_evicted(hdr, state->seq_low);
+    }
     a0_transport_remove_head(lk, state);
-    state = a0_transport_working_page(lk);
+    evicted = true;
+  }
+
+  if (evicted) {
+    a0_transport_commit_evictions(lk);
   }
 }
 
 A0_STATIC_INLINE
-void a0_transport_slot_init(a0_transport_state_t* state,
-                            a0_transport_frame_hdr_t* frame_hdr,
+void a0_transport_slot_init(a0_transport_locked_t lk,
+                            a0_transport_state_t* state,
                             size_t off,
                             size_t size) {
-  memset(frame_hdr, 0, sizeof(a0_transport_frame_hdr_t));
-
-  frame_hdr->seq = ++state->seq_high;
+  uint64_t seq = ++state->seq_high;
   if (!state->seq_low) {
-    state->seq_low = frame_hdr->seq;
+    state->seq_low = seq;
   }
 
-  frame_hdr->off = off;
-  frame_hdr->next_off = 0;
-
-  frame_hdr->data_size = size;
+  if (lk.transport->_compact) {
+    a0_transport_compact_frame_hdr_t* frame_hdr = a0_transport_compact_frame_header(lk, off);
+    memset(frame_hdr, 0, sizeof(a0_transport_compact_frame_hdr_t));
+    frame_hdr->seq = seq;
+    frame_hdr->data_size = (uint32_t)size;
+  } else {
+    a0_transport_frame_hdr_t* frame_hdr = a0_transport_frame_header(lk, off);
+    memset(frame_hdr, 0, sizeof(a0_transport_frame_hdr_t));
+    frame_hdr->seq = seq;
+    frame_hdr->off = off;
+    frame_hdr->next_off = 0;
+    frame_hdr->data_size = size;
+  }
 }
 
 A0_STATIC_INLINE
-void a0_transport_maybe_set_head(a0_transport_state_t* state, a0_transport_frame_hdr_t* frame_hdr) {
+void a0_transport_maybe_set_head(a0_transport_state_t* state, size_t off) {
   if (!state->off_head) {
-    state->off_head = frame_hdr->off;
+    state->off_head = off;
   }
 }
 
 A0_STATIC_INLINE
 void a0_transport_update_tail(a0_transport_locked_t lk,
                               a0_transport_state_t* state,
-                              a0_transport_frame_hdr_t* frame_hdr) {
+                              size_t off) {
   if (state->off_tail) {
-    a0_transport_frame_hdr_t* tail_frame_hdr = a0_transport_frame_header(lk, state->off_tail);
-    tail_frame_hdr->next_off = frame_hdr->off;
-    frame_hdr->prev_off = state->off_tail;
+    a0_transport_frame_set_next(lk, state->off_tail, off);
+    a0_transport_frame_set_prev(lk, off, state->off_tail);
   }
-  state->off_tail = frame_hdr->off;
+  state->off_tail = off;
 }
 
 A0_STATIC_INLINE
 void a0_transport_update_high_water_mark(a0_transport_locked_t lk,
                                          a0_transport_state_t* state,
-                                         a0_transport_frame_hdr_t* frame_hdr) {
-  size_t high_water_mark = a0_transport_frame_end(lk, frame_hdr->off);
+                                         size_t off) {
+  size_t high_water_mark = a0_transport_frame_end(lk, off);
+  if (a0_transport_header(lk)->slot_cnt) {
+    high_water_mark = off + a0_transport_slot_stride(lk);
+  }
   if (state->high_water_mark < high_water_mark) {
     state->high_water_mark = high_water_mark;
   }
 }
 
 a0_err_t a0_transport_alloc_evicts(a0_transport_locked_t lk, size_t size, bool* out) {
-  size_t frame_size = sizeof(a0_transport_frame_hdr_t) + size;
+  size_t frame_size = a0_transport_frame_hdr_size(lk) + size;
 
   size_t off;
   A0_RETURN_ERR_ON_ERR(a0_transport_find_slot(lk, frame_size, &off));
 
-  *out = a0_transport_slot_evicts(lk, off, frame_size);
+  *out = a0_transport_slot_evicts(lk, a0_transport_working_page(lk), off, frame_size);
   return A0_OK;
 }
 
-a0_err_t a0_transport_alloc(a0_transport_locked_t lk, size_t size, a0_transport_frame_t** frame_out) {
-  if (lk.transport->_arena.mode == A0_ARENA_MODE_READONLY) {
+// Allocates a frame in either format, returning its offset.
+A0_STATIC_INLINE
+a0_err_t a0_transport_alloc_off(a0_transport_locked_t lk, size_t size, size_t* off_out) {
+  if (lk.transport->_arena.mode == A0_ARENA_MODE_READONLY || lk.transport->_optimistic) {
     return A0_MAKE_SYSERR(EPERM);
   }
-  size_t frame_size = sizeof(a0_transport_frame_hdr_t) + size;
+  size_t frame_size = a0_transport_frame_hdr_size(lk) + size;
 
   size_t off;
   A0_RETURN_ERR_ON_ERR(a0_transport_find_slot(lk, frame_size, &off));
+  A0_RETURN_ERR_ON_ERR(a0_transport_lease_await(lk, frame_size, &off));
 
   a0_transport_evict(lk, off, frame_size);
 
@@ -639,23 +1679,62 @@ a0_err_t a0_transport_alloc(a0_transport_locked_t lk, size_t size, a0_transport_
   //       Must grab state afterwards.
   a0_transport_state_t* state = a0_transport_working_page(lk);
 
-  a0_transport_frame_hdr_t* frame_hdr = a0_transport_frame_header(lk, off);
-  a0_transport_slot_init(state, frame_hdr, off, size);
+  a0_transport_slot_init(lk, state, off, size);
+  a0_transport_index_add(lk, state->seq_high, off);
 
-  a0_transport_maybe_set_head(state, frame_hdr);
-  a0_transport_update_tail(lk, state, frame_hdr);
-  a0_transport_update_high_water_mark(lk, state, frame_hdr);
+  a0_transport_maybe_set_head(state, off);
+  a0_transport_update_tail(lk, state, off);
+  a0_transport_update_high_water_mark(lk, state, off);
 
-  *frame_out = (a0_transport_frame_t*)frame_hdr;
+  *off_out = off;
+  return A0_OK;
+}
+
+a0_err_t a0_transport_alloc(a0_transport_locked_t lk, size_t size, a0_transport_frame_t** frame_out) {
+  if (lk.transport->_compact) {
+    return A0_ERR_INVALID_ARG;
+  }
+
+  size_t off;
+  A0_RETURN_ERR_ON_ERR(a0_transport_alloc_off(lk, size, &off));
 
+  *frame_out = (a0_transport_frame_t*)a0_transport_frame_header(lk, off);
   return A0_OK;
 }
 
+a0_err_t a0_transport_alloc_batch(a0_transport_locked_t lk,
+                                  const size_t* sizes,
+                                  size_t cnt,
+                                  a0_transport_frame_t** frames_out) {
+  if (lk.transport->_compact) {
+    return A0_ERR_INVALID_ARG;
+  }
+
+  a0_transport_state_t base = *a0_transport_working_page(lk);
+
+  a0_err_t err = A0_OK;
+  for (size_t i = 0; !err && i < cnt; i++) {
+    err = a0_transport_alloc(lk, sizes[i], &frames_out[i]);
+  }
+
+  // Later frames must not evict earlier ones.
+  a0_transport_state_t* state = a0_transport_working_page(lk);
+  if (!err && state->seq_low > base.seq_high + 1) {
+    err = A0_ERR_FRAME_LARGE;
+  }
+
+  if (err) {
+    a0_transport_state_truncate(state, &base);
+  }
+  return err;
+}
+
 A0_STATIC_INLINE
 a0_err_t a0_transport_allocator_impl(void* user_data, size_t size, a0_buf_t* buf_out) {
-  a0_transport_frame_t* frame;
-  A0_RETURN_ERR_ON_ERR(a0_transport_alloc(*(a0_transport_locked_t*)user_data, size, &frame));
-  *buf_out = (a0_buf_t){frame->data, frame->hdr.data_size};
+  a0_transport_locked_t lk = *(a0_transport_locked_t*)user_data;
+  size_t off;
+  A0_RETURN_ERR_ON_ERR(a0_transport_alloc_off(lk, size, &off));
+  *buf_out = (a0_buf_t){a0_transport_frame_data(lk, off), size};
   return A0_OK;
 }
 
@@ -667,17 +1746,42 @@ a0_err_t a0_transport_allocator(a0_transport_locked_t* lk, a0_alloc_t* alloc_out
 }
 
 a0_err_t a0_transport_commit(a0_transport_locked_t lk) {
-  a0_transport_hdr_t* hdr = a0_transport_header(lk);
-  // Assume page A was the previously committed page and page B is the working
-  // page that is ready to be committed. Both represent a valid state for the
-  // transport. It's possible that the copying of B into A will fail (prog crash),
-  // leaving A in an inconsistent state. We set B as the committed page, before
-  // copying the page info.
-  hdr->committed_page_idx = !hdr->committed_page_idx;
-  *a0_transport_working_page(lk) = *a0_transport_committed_page(lk);
+  if (lk.transport->_optimistic) {
+    return A0_MAKE_SYSERR(EPERM);
+  }
+  if (lk.transport->_batch) {
+    lk.transport->_batch_state = *a0_transport_working_page(lk);
+    return A0_OK;
+  }
+  a0_transport_commit_state(lk);
+  a0_transport_notify(lk);
+  return A0_OK;
+}
 
-  a0_cnd_broadcast(&hdr->cnd, &hdr->mtx);
+a0_err_t a0_transport_batch_begin(a0_transport_locked_t lk) {
+  if (lk.transport->_optimistic || lk.transport->_batch) {
+    return A0_MAKE_SYSERR(EPERM);
+  }
+  lk.transport->_batch = true;
+  lk.transport->_batch_state = *a0_transport_committed_page(lk);
+  return A0_OK;
+}
+
+a0_err_t a0_transport_batch_end(a0_transport_locked_t lk) {
+  if (!lk.transport->_batch) {
+    return A0_MAKE_SYSERR(EPERM);
+  }
+  lk.transport->_batch = false;
 
+  a0_transport_state_t* state = a0_transport_working_page(lk);
+  a0_transport_state_truncate(state, &lk.transport->_batch_state);
+  if (state->seq_high != a0_transport_committed_page(lk)->seq_high) {
+    a0_transport_commit_state(lk);
+    lk.transport->_notify_pending = true;
+  }
+  if (lk.transport->_notify_pending) {
+    a0_transport_notify(lk);
+  }
   return A0_OK;
 }
 
@@ -687,24 +1791,96 @@ a0_err_t a0_transport_used_space(a0_transport_locked_t lk, size_t* out) {
   return A0_OK;
 }
 
+A0_NO_TSAN
+a0_err_t a0_transport_lag(a0_transport_locked_t lk, uint64_t* frames, size_t* bytes) {
+  *frames = 0;
+  *bytes = 0;
+
+  a0_transport_state_t* state = a0_transport_working_page(lk);
+  if (a0_transport_state_empty(state) || lk.transport->_seq >= state->seq_high) {
+    return A0_OK;
+  }
+
+  // Past the head, every remaining frame is ahead of the pointer.
+  bool before_head = lk.transport->_seq < state->seq_low;
+  uint64_t seq = before_head ? state->seq_low - 1 : lk.transport->_seq;
+
+  a0_transport_hdr_t* hdr = a0_transport_header(lk);
+  if (hdr->slot_cnt) {
+    *frames = state->seq_high - seq;
+    *bytes = *frames * a0_transport_slot_stride(lk);
+    return A0_OK;
+  }
+
+  if (lk.transport->_optimistic &&
+      (!a0_transport_optimistic_frame_ok(lk, state->off_tail, state->seq_high) ||
+       (!before_head && !a0_transport_optimistic_frame_ok(lk, lk.transport->_off, seq)))) {
+    return A0_ERR_AGAIN;
+  }
+
+  size_t start = before_head ? state->off_head : a0_transport_frame_end(lk, lk.transport->_off);
+  size_t end = a0_transport_frame_end(lk, state->off_tail);
+  *frames = state->seq_high - seq;
+  if (start <= end) {
+    *bytes = end - start;
+  } else {
+    // Wrapped around the end of the arena.
+    *bytes = (state->high_water_mark - start) + (end - a0_transport_workspace_off());
+  }
+  return A0_OK;
+}
+
 a0_err_t a0_transport_resize(a0_transport_locked_t lk, size_t arena_size) {
+  if (lk.transport->_optimistic) {
+    return A0_MAKE_SYSERR(EPERM);
+  }
   size_t used_space;
   A0_RETURN_ERR_ON_ERR(a0_transport_used_space(lk, &used_space));
   if (arena_size < used_space) {
     return A0_ERR_INVALID_ARG;
   }
+  if (lk.transport->_compact && arena_size > INT32_MAX) {
+    return A0_ERR_INVALID_ARG;
+  }
 
   a0_transport_hdr_t* hdr = a0_transport_header(lk);
+  // Every fixed slot must stay in the arena.
+  if (arena_size < a0_transport_workspace_off() + hdr->slot_cnt * a0_transport_slot_stride(lk)) {
+    return A0_ERR_INVALID_ARG;
+  }
+  // The arena must stay within this connection's mapping. The mapping may
+  // extend past the known size, but cannot move while locked.
+  if (arena_size > lk.transport->_map.size) {
+    a0_buf_t map = lk.transport->_map;
+    A0_RETURN_ERR_ON_ERR(a0_file_map_fit(&map, arena_size));
+    if (map.data != lk.transport->_map.data) {
+      return A0_MAKE_SYSERR(ENOMEM);
+    }
+    lk.transport->_map = map;
+  }
+  // The index moves to the new end of the arena.
+  a0_transport_index_build(lk, arena_size, used_space);
   hdr->arena_size = arena_size;
   return A0_OK;
 }
 
 a0_err_t a0_transport_clear(a0_transport_locked_t lk) {
+  if (lk.transport->_optimistic) {
+    return A0_MAKE_SYSERR(EPERM);
+  }
   a0_transport_state_t* state = a0_transport_working_page(lk);
   state->seq_low = state->seq_high + 1;
   state->off_head = 0;
   state->off_tail = 0;
   state->high_water_mark = a0_transport_workspace_off();
+
+  // The cleared frames will be overwritten, leased or not.
+  a0_transport_hdr_t* hdr = a0_transport_header(lk);
+  for (uint32_t i = 0; i < A0_TRANSPORT_MAX_LEASES; i++) {
+    if (a0_transport_lease_owner(hdr, i)) {
+      hdr->lease_evicted |= 1u << i;
+    }
+  }
   return a0_transport_commit(lk);
 }
 
@@ -755,8 +1931,9 @@ void a0_transport_debugstr(a0_transport_locked_t lk, a0_buf_t* out) {
     size_t off = working_state->off_head;
     bool first = true;
     while (true) {
-      a0_transport_frame_hdr_t* frame_hdr = a0_transport_frame_header(lk, off);
-      uint64_t seq = frame_hdr->seq;
+      a0_transport_frame_view_t frame;
+      a0_transport_frame_decode(lk, off, &frame);
+      uint64_t seq = frame.hdr.seq;
 
       if (!first) {
         fprintf(ss, "    },\n");
@@ -767,20 +1944,16 @@ void a0_transport_debugstr(a0_transport_locked_t lk, a0_buf_t* out) {
       if (seq > committed_state->seq_high) {
         fprintf(ss, "      \"committed\": false,\n");
       }
-      fprintf(ss, "      \"off\": %lu,\n", frame_hdr->off);
-      fprintf(ss, "      \"seq\": %lu,\n", frame_hdr->seq);
-      fprintf(ss, "      \"prev_off\": %lu,\n", frame_hdr->prev_off);
-      fprintf(ss, "      \"next_off\": %lu,\n", frame_hdr->next_off);
-      fprintf(ss, "      \"data_size\": %lu,\n", frame_hdr->data_size);
-      a0_buf_t data = {
-          .data = (uint8_t*)hdr + frame_hdr->off + sizeof(a0_transport_frame_hdr_t),
-          .size = frame_hdr->data_size,
-      };
+      fprintf(ss, "      \"off\": %lu,\n", frame.hdr.off);
+      fprintf(ss, "      \"seq\": %lu,\n", frame.hdr.seq);
+      fprintf(ss, "      \"prev_off\": %lu,\n", frame.hdr.prev_off);
+      fprintf(ss, "      \"next_off\": %lu,\n", frame.hdr.next_off);
+      fprintf(ss, "      \"data_size\": %lu,\n", frame.hdr.data_size);
       fprintf(ss, "      \"data\": \"");
-      write_limited(ss, data);
+      write_limited(ss, frame.data);
       fprintf(ss, "\"\n");
 
-      off = frame_hdr->next_off;
+      off = frame.hdr.next_off;
 
       if (seq == working_state->seq_high) {
         fprintf(ss, "    }\n");
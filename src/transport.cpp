@@ -12,7 +12,9 @@
 #include <exception>
 #include <functional>
 #include <memory>
+#include <vector>
 
+#include "c_opts.hpp"
 #include "c_wrap.hpp"
 
 namespace a0 {
@@ -38,6 +40,13 @@ uint64_t TransportLocked::seq_high() const {
   return ret;
 }
 
+size_t TransportLocked::slot_size() const {
+  CHECK_C;
+  size_t ret;
+  check(a0_transport_slot_size(*c, &ret));
+  return ret;
+}
+
 size_t TransportLocked::used_space() const {
   CHECK_C;
   size_t ret;
@@ -64,6 +73,13 @@ Frame* TransportLocked::frame() const {
   return ret;
 }
 
+FrameView TransportLocked::frame_view() const {
+  CHECK_C;
+  FrameView ret;
+  check(a0_transport_frame_view(*c, &ret));
+  return ret;
+}
+
 void TransportLocked::jump(size_t off) {
   CHECK_C;
   check(a0_transport_jump(*c, off));
@@ -79,6 +95,11 @@ void TransportLocked::jump_tail() {
   check(a0_transport_jump_tail(*c));
 }
 
+void TransportLocked::jump_seq(uint64_t seq) {
+  CHECK_C;
+  check(a0_transport_jump_seq(*c, seq));
+}
+
 bool TransportLocked::has_next() const {
   CHECK_C;
   bool ret;
@@ -110,6 +131,13 @@ Frame* TransportLocked::alloc(size_t size) {
   return ret;
 }
 
+std::vector<Frame*> TransportLocked::alloc_batch(std::vector<size_t> sizes) {
+  CHECK_C;
+  std::vector<Frame*> ret(sizes.size());
+  check(a0_transport_alloc_batch(*c, sizes.data(), sizes.size(), ret.data()));
+  return ret;
+}
+
 bool TransportLocked::alloc_evicts(size_t size) const {
   CHECK_C;
   bool ret;
@@ -122,6 +150,18 @@ void TransportLocked::commit() {
   check(a0_transport_commit(*c));
 }
 
+Lease TransportLocked::lease() {
+  CHECK_C;
+  Lease ret;
+  check(a0_transport_lease(*c, &ret));
+  return ret;
+}
+
+void TransportLocked::lease_release(Lease lease) {
+  CHECK_C;
+  check(a0_transport_lease_release(*c, lease));
+}
+
 void TransportLocked::clear() {
   CHECK_C;
   check(a0_transport_clear(*c));
@@ -162,11 +202,21 @@ void TransportLocked::wait_until(std::function<bool()> fn, TimeMono timeout) {
   check(a0_transport_timedwait(*c, pred(&fn), &*timeout.c));
 }
 
-Transport::Transport(Arena arena) {
+Transport::Options Transport::Options::DEFAULT = {
+    .frame_format = (FrameFormat)A0_TRANSPORT_OPTIONS_DEFAULT.frame_format,
+    .slot_size = A0_TRANSPORT_OPTIONS_DEFAULT.slot_size,
+    .lease_policy = (LeasePolicy)A0_TRANSPORT_OPTIONS_DEFAULT.lease_policy,
+};
+
+Transport::Transport(Arena arena)
+    : Transport(arena, Options::DEFAULT) {}
+
+Transport::Transport(Arena arena, Options opts) {
   set_c(
       &c,
       [&](a0_transport_t* c) {
-        return a0_transport_init(c, *arena.c);
+        auto cto = c_transportopts(opts);
+        return a0_transport_init_options(c, *arena.c, &cto);
       },
       [arena](a0_transport_t*) {});
 }
@@ -183,4 +233,9 @@ TransportLocked Transport::lock() {
       });
 }
 
+void Transport::set_spin(std::chrono::nanoseconds dur) {
+  CHECK_C;
+  check(a0_transport_set_spin(&*c, dur.count()));
+}
+
 }  // namespace a0
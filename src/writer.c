@@ -5,11 +5,17 @@
 #include <a0/inline.h>
 #include <a0/middleware.h>
 #include <a0/packet.h>
+#include <a0/thread_local.h>
 #include <a0/transport.h>
 #include <a0/unused.h>
 #include <a0/writer.h>
 
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "err_macro.h"
 
@@ -17,6 +23,79 @@
 #include "ref_cnt.h"
 #endif
 
+const a0_writer_options_t A0_WRITER_OPTIONS_DEFAULT = {
+    .staged = false,
+};
+
+typedef struct a0_write_action_s {
+  a0_transport_t transport;
+  a0_writer_options_t opts;
+} a0_write_action_t;
+
+// A packet serialized before taking the transport lock, in staged mode.
+//
+// Staging is per thread, so concurrent writes through the same writer do not
+// share it. Only one write may be staged at a time on a given thread. A
+// nested write, from within a middleware, serializes under the lock instead.
+typedef struct a0_writer_stage_s {
+  // Write action that staged the packet. NULL when nothing is staged.
+  a0_write_action_t* owner;
+  // The packet as it was when staged.
+  a0_packet_t pkt;
+  a0_flat_packet_t fpkt;
+  // Grown as needed and reused across writes. Freed when the thread exits.
+  a0_buf_t buf;
+} a0_writer_stage_t;
+
+static A0_THREAD_LOCAL a0_writer_stage_t a0_writer_stage;
+
+static pthread_once_t a0_writer_stage_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t a0_writer_stage_key;
+
+A0_STATIC_INLINE
+void a0_writer_stage_key_init() {
+  pthread_key_create(&a0_writer_stage_key, free);
+}
+
+A0_STATIC_INLINE
+a0_err_t a0_writer_stage_alloc(void* user_data, size_t size, a0_buf_t* out) {
+  a0_buf_t* buf = (a0_buf_t*)user_data;
+  if (buf->size < size) {
+    uint8_t* data = (uint8_t*)realloc(buf->data, size);
+    if (!data) {
+      return A0_MAKE_SYSERR(ENOMEM);
+    }
+    *buf = (a0_buf_t){data, size};
+    pthread_once(&a0_writer_stage_key_once, a0_writer_stage_key_init);
+    pthread_setspecific(a0_writer_stage_key, data);
+  }
+  *out = (a0_buf_t){buf->data, size};
+  return A0_OK;
+}
+
+// Serializes the packet into the thread's staging buffer.
+// Returns false if the packet is to be serialized under the lock instead.
+A0_STATIC_INLINE
+bool a0_writer_stage_packet(a0_write_action_t* action, a0_packet_t pkt) {
+  a0_writer_stage_t* stage = &a0_writer_stage;
+  if (!action->opts.staged || stage->owner) {
+    return false;
+  }
+
+  a0_alloc_t alloc = {
+      .user_data = &stage->buf,
+      .alloc = a0_writer_stage_alloc,
+      .dealloc = NULL,
+  };
+  if (a0_packet_serialize(pkt, alloc, &stage->fpkt)) {
+    return false;
+  }
+
+  stage->owner = action;
+  stage->pkt = pkt;
+  return true;
+}
+
 A0_STATIC_INLINE_RECURSIVE
 a0_err_t a0_writer_write_impl(a0_middleware_chain_node_t node, a0_packet_t* pkt) {
   a0_middleware_t action = node._curr->_action;
@@ -25,6 +104,8 @@ a0_err_t a0_writer_write_impl(a0_middleware_chain_node_t node, a0_packet_t* pkt)
           ._curr = node._curr->_next,
           ._head = node._head,
           ._tlk = node._tlk,
+          ._batch_tlk = node._batch_tlk,
+          ._reservation = node._reservation,
       },
       ._chain_fn = a0_writer_write_impl,
   };
@@ -43,7 +124,7 @@ a0_err_t a0_writer_write_impl(a0_middleware_chain_node_t node, a0_packet_t* pkt)
 }
 
 A0_STATIC_INLINE
-a0_err_t a0_write_action_init(a0_arena_t arena, void** user_data) {
+a0_err_t a0_write_action_init(a0_arena_t arena, a0_writer_options_t opts, void** user_data) {
   a0_transport_t transport;
   A0_RETURN_ERR_ON_ERR(a0_transport_init(&transport, arena));
 
@@ -51,60 +132,125 @@ a0_err_t a0_write_action_init(a0_arena_t arena, void** user_data) {
   A0_ASSERT_OK(a0_ref_cnt_inc(arena.buf.data, NULL), "");
 #endif
 
-  a0_transport_t* heap_transport = (a0_transport_t*)malloc(sizeof(a0_transport_t));
-  *heap_transport = transport;
-  *user_data = heap_transport;
+  a0_write_action_t* action = (a0_write_action_t*)malloc(sizeof(a0_write_action_t));
+  action->transport = transport;
+  action->opts = opts;
+  *user_data = action;
 
   return A0_OK;
 }
 
 A0_STATIC_INLINE
 a0_err_t a0_write_action_close(void* user_data) {
-  a0_transport_t* transport = (a0_transport_t*)user_data;
+  a0_write_action_t* action = (a0_write_action_t*)user_data;
 
 #ifdef DEBUG
   A0_ASSERT_OK(
-      a0_ref_cnt_dec(transport->_arena.buf.data, NULL),
+      a0_ref_cnt_dec(action->transport._arena.buf.data, NULL),
       "Writer closing. User bug detected. Dependent arena was closed prior to writer.");
 #endif
 
-  free(transport);
+  free(action);
 
   return A0_OK;
 }
 
 A0_STATIC_INLINE
 a0_err_t a0_write_action_process(void* user_data, a0_packet_t* pkt, a0_middleware_chain_t chain) {
-  a0_transport_t* transport = (a0_transport_t*)user_data;
+  a0_write_action_t* action = (a0_write_action_t*)user_data;
+  a0_transport_t* transport = &action->transport;
+  a0_transport_locked_t* batch_tlk = chain._node._batch_tlk;
+  // Serialize before locking, unless a batch already holds the lock.
+  // Locked middleware may still add headers.
+  bool staged = !(batch_tlk && batch_tlk->transport == transport) &&
+                !chain._node._reservation &&
+                a0_writer_stage_packet(action, *pkt);
   a0_transport_locked_t tlk;
-  A0_RETURN_ERR_ON_ERR(a0_transport_lock(transport, &tlk));
+  if (batch_tlk && batch_tlk->transport == transport) {
+    // Already locked by an earlier write in the batch.
+    tlk = *batch_tlk;
+  } else {
+    a0_err_t err = a0_transport_lock(transport, &tlk);
+    if (err) {
+      if (staged) {
+        a0_writer_stage.owner = NULL;
+      }
+      return err;
+    }
+    if (batch_tlk && !batch_tlk->transport) {
+      a0_transport_batch_begin(tlk);
+      *batch_tlk = tlk;
+    }
+  }
 
   a0_middleware_chain_node_t next_node = {
       ._curr = chain._node._head,
       ._head = chain._node._head,
       ._tlk = tlk,
+      ._batch_tlk = batch_tlk,
+      ._reservation = chain._node._reservation,
   };
 
-  return a0_writer_write_impl(next_node, pkt);
+  a0_err_t err = a0_writer_write_impl(next_node, pkt);
+  if (staged) {
+    a0_writer_stage.owner = NULL;
+  }
+  return err;
 }
 
 A0_STATIC_INLINE
 a0_err_t a0_write_action_process_locked(void* user_data, a0_transport_locked_t tlk, a0_packet_t* pkt, a0_middleware_chain_t chain) {
-  A0_MAYBE_UNUSED(user_data);
   A0_MAYBE_UNUSED(chain);
 
   a0_alloc_t alloc;
   a0_transport_allocator(&tlk, &alloc);
-  a0_packet_serialize(*pkt, alloc, NULL);
 
-  a0_transport_commit(tlk);
+  a0_writer_reservation_t* reservation = chain._node._reservation;
+  if (reservation) {
+    // The payload must still be the placeholder set by a0_writer_reserve.
+    if (pkt->payload.data || pkt->payload.size != reservation->payload.size) {
+      a0_transport_unlock(tlk);
+      return A0_ERR_INVALID_ARG;
+    }
+
+    a0_flat_packet_t fpkt;
+    a0_err_t err = a0_packet_serialize(*pkt, alloc, &fpkt);
+    if (err) {
+      a0_transport_unlock(tlk);
+      return err;
+    }
+
+    // Left uncommitted and locked until the reservation is resolved.
+    a0_flat_packet_payload(fpkt, &reservation->payload);
+    reservation->_tlk = tlk;
+    return A0_OK;
+  }
+
+  a0_err_t err = A0_ERR_INVALID_ARG;
+  a0_writer_stage_t* stage = &a0_writer_stage;
+  if (stage->owner == user_data) {
+    // Copy the staged packet, with any headers added by locked middleware.
+    // Falls back to a full serialize if the payload or id was replaced.
+    err = a0_packet_reserialize(*pkt, stage->pkt, stage->fpkt, alloc, NULL);
+  }
+  if (err == A0_ERR_INVALID_ARG) {
+    err = a0_packet_serialize(*pkt, alloc, NULL);
+  }
+
+  if (!err) {
+    a0_transport_commit(tlk);
+  }
   a0_transport_unlock(tlk);
 
-  return A0_OK;
+  return err;
 }
 
 a0_err_t a0_writer_init(a0_writer_t* w, a0_arena_t arena) {
-  A0_RETURN_ERR_ON_ERR(a0_write_action_init(arena, &w->_action.user_data));
+  return a0_writer_init_options(w, arena, A0_WRITER_OPTIONS_DEFAULT);
+}
+
+a0_err_t a0_writer_init_options(a0_writer_t* w, a0_arena_t arena, a0_writer_options_t opts) {
+  A0_RETURN_ERR_ON_ERR(a0_write_action_init(arena, opts, &w->_action.user_data));
   w->_action.close = a0_write_action_close;
   w->_action.process = a0_write_action_process;
   w->_action.process_locked = a0_write_action_process_locked;
@@ -152,10 +298,81 @@ a0_err_t a0_writer_write(a0_writer_t* w, a0_packet_t pkt) {
       ._curr = w,
       ._head = w,
       ._tlk = A0_EMPTY,
+      ._batch_tlk = NULL,
+      ._reservation = NULL,
   };
   return a0_writer_write_impl(node, &pkt);
 }
 
+a0_err_t a0_writer_write_batch(a0_writer_t* w, a0_packet_t* pkts, size_t cnt) {
+  a0_transport_locked_t batch_tlk = A0_EMPTY;
+
+  a0_err_t err = A0_OK;
+  for (size_t i = 0; !err && i < cnt; i++) {
+    a0_middleware_chain_node_t node = {
+        ._curr = w,
+        ._head = w,
+        ._tlk = A0_EMPTY,
+        ._batch_tlk = &batch_tlk,
+        ._reservation = NULL,
+    };
+    // Middleware may modify the packet. Leave the caller's copy alone.
+    a0_packet_t pkt = pkts[i];
+    err = a0_writer_write_impl(node, &pkt);
+  }
+
+  if (batch_tlk.transport) {
+    a0_transport_batch_end(batch_tlk);
+    a0_transport_unlock(batch_tlk);
+  }
+
+  return err;
+}
+
+a0_err_t a0_writer_reserve(a0_writer_t* w, a0_packet_t pkt, size_t payload_size, a0_writer_reservation_t* out) {
+  *out = (a0_writer_reservation_t)A0_EMPTY;
+  out->payload.size = payload_size;
+
+  a0_middleware_chain_node_t node = {
+      ._curr = w,
+      ._head = w,
+      ._tlk = A0_EMPTY,
+      ._batch_tlk = NULL,
+      ._reservation = out,
+  };
+  // Placeholder payload. Serialization leaves the space unwritten.
+  pkt.payload = (a0_buf_t){NULL, payload_size};
+  A0_RETURN_ERR_ON_ERR(a0_writer_write_impl(node, &pkt));
+
+  // Middleware, like a0_write_if_empty, may have dropped the packet.
+  if (!out->_tlk.transport) {
+    return A0_ERR_CANCELLED;
+  }
+  return A0_OK;
+}
+
+a0_err_t a0_writer_reservation_commit(a0_writer_reservation_t* reservation) {
+  a0_transport_locked_t tlk = reservation->_tlk;
+  if (!tlk.transport) {
+    return A0_ERR_INVALID_ARG;
+  }
+  *reservation = (a0_writer_reservation_t)A0_EMPTY;
+
+  a0_transport_commit(tlk);
+  return a0_transport_unlock(tlk);
+}
+
+a0_err_t a0_writer_reservation_abort(a0_writer_reservation_t* reservation) {
+  a0_transport_locked_t tlk = reservation->_tlk;
+  if (!tlk.transport) {
+    return A0_ERR_INVALID_ARG;
+  }
+  *reservation = (a0_writer_reservation_t)A0_EMPTY;
+
+  // Unlocking without a commit discards the frame.
+  return a0_transport_unlock(tlk);
+}
+
 a0_err_t a0_writer_wrap(a0_writer_t* in, a0_middleware_t middleware, a0_writer_t* out) {
   out->_action = middleware;
   out->_next = in;
@@ -1,21 +1,33 @@
 #include <a0/arena.hpp>
+#include <a0/buf.hpp>
 #include <a0/middleware.h>
 #include <a0/middleware.hpp>
 #include <a0/packet.hpp>
 #include <a0/writer.h>
 #include <a0/writer.hpp>
 
+#include <cstddef>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "c_opts.hpp"
 #include "c_wrap.hpp"
 
 namespace a0 {
 
-Writer::Writer(Arena arena) {
+Writer::Options Writer::Options::DEFAULT = cpp_writeropts(A0_WRITER_OPTIONS_DEFAULT);
+
+Writer::Writer(Arena arena)
+    : Writer(arena, Options::DEFAULT) {}
+
+Writer::Writer(Arena arena, Options opts) {
   set_c(
       &c,
       [&](a0_writer_t* c) {
-        return a0_writer_init(c, *arena.c);
+        return a0_writer_init_options(c, *arena.c, c_writeropts(opts));
       },
       [arena](a0_writer_t* c) {
         a0_writer_close(c);
@@ -27,6 +39,47 @@ void Writer::write(Packet pkt) {
   check(a0_writer_write(&*c, *pkt.c));
 }
 
+void Writer::write_batch(std::vector<Packet> pkts) {
+  CHECK_C;
+  std::vector<a0_packet_t> c_pkts;
+  c_pkts.reserve(pkts.size());
+  for (auto&& pkt : pkts) {
+    c_pkts.push_back(*pkt.c);
+  }
+  check(a0_writer_write_batch(&*c, c_pkts.data(), c_pkts.size()));
+}
+
+Writer::Reservation Writer::reserve(
+    std::unordered_multimap<std::string, std::string> headers,
+    size_t payload_size) {
+  CHECK_C;
+  auto save = c;
+  Packet pkt(std::move(headers), "");
+  return make_cpp<Reservation>(
+      [&](a0_writer_reservation_t* c) {
+        return a0_writer_reserve(&*save, *pkt.c, payload_size, c);
+      },
+      [save](a0_writer_reservation_t* c) {
+        // Fails harmlessly if already committed or aborted.
+        a0_writer_reservation_abort(c);
+      });
+}
+
+Buf Writer::Reservation::payload() {
+  CHECK_C;
+  return Buf(c->payload.data, c->payload.size);
+}
+
+void Writer::Reservation::commit() {
+  CHECK_C;
+  check(a0_writer_reservation_commit(&*c));
+}
+
+void Writer::Reservation::abort() {
+  CHECK_C;
+  check(a0_writer_reservation_abort(&*c));
+}
+
 void Writer::push(Middleware m) {
   CHECK_C;
   check(a0_writer_push(&*c, *m.c));